@@ -20,3 +20,8 @@ CONFIG(debug, debug|release) {
 SUBDIRS += \
     tests \
 }
+
+# make bench - run broker benchmark, see samples/shvbrokerbench
+bench.commands = cd samples/shvbrokerbench && $(MAKE) bench
+bench.depends = all
+QMAKE_EXTRA_TARGETS += bench
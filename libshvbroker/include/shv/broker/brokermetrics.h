@@ -0,0 +1 @@
+#include "../../../src/brokermetrics.h"
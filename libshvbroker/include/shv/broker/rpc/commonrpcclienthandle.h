@@ -0,0 +1 @@
+#include "../../../../src/rpc/commonrpcclienthandle.h"
@@ -0,0 +1 @@
+#include "../../../../src/rpc/websocket.h"
@@ -8,6 +8,10 @@ with-shvwebsockets {
     DEFINES += WITH_SHV_WEBSOCKETS
 }
 
+with-shvrpctracing {
+    DEFINES += SHV_RPC_TRACING
+}
+
 CONFIG += C++11
 CONFIG += hide_symbols
 
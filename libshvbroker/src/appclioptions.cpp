@@ -12,6 +12,9 @@ AppCliOptions::AppCliOptions()
 	addOption("app.brokerId").setType(cp::RpcValue::Type::String).setNames("--bid", "--broker-id")
 			.setDefaultValue("broker.local")
 			.setComment("Broker ID string for service provider calls");
+	addOption("app.metricsSignalInterval").setType(cp::RpcValue::Type::Int).setNames("--metrics-signal-interval")
+			.setDefaultValue(0)
+			.setComment("Send metrics snapshot as chng signal on .broker/app/metrics every n sec, disabled when set to 0");
 	addOption("locale").setType(cp::RpcValue::Type::String).setNames("--locale").setComment("Application locale").setDefaultValue("system");
 	addOption("server.port").setType(cp::RpcValue::Type::Int).setNames("-p", "--server-port").setComment("Server port").setDefaultValue(cp::IRpcConnection::DEFAULT_RPC_BROKER_PORT_NONSECURED);
 	addOption("server.sslPort").setType(cp::RpcValue::Type::Int).setNames("--sslp", "--server-ssl-port").setComment("Server SSL port").setDefaultValue(cp::IRpcConnection::DEFAULT_RPC_BROKER_PORT_SECURED);
@@ -28,6 +31,20 @@ AppCliOptions::AppCliOptions()
 	addOption("server.ssl.cert").setType(cp::RpcValue::Type::String).setNames("--server-ssl-cert")
 			.setComment("List of SSL certificate files").setDefaultValue("wss.crt");
 	addOption("server.publicIP").setType(cp::RpcValue::Type::String).setNames("--pip", "--server-public-ip").setComment("Server public IP address");
+	addOption("subscriptions.minInterval").setType(cp::RpcValue::Type::Int).setNames("--subs-min-interval")
+			.setDefaultValue(0)
+			.setComment("Default minimal interval in msec between signals with the same path sent to subscriber, "
+						"latest value is sent when interval elapses, disabled when set to 0, can be overridden in subscribe params");
+	addOption("subscriptions.coalesce").setType(cp::RpcValue::Type::Bool).setNames("--subs-coalesce")
+			.setDefaultValue(false)
+			.setComment("Default for sending only the latest signal per path when subscriber send queue is backed up, "
+						"can be overridden in subscribe params");
+	addOption("subscriptions.deadband").setType(cp::RpcValue::Type::Double).setNames("--subs-deadband")
+			.setDefaultValue(0.)
+			.setComment("Default deadband for numeric signal values, disabled when set to 0, can be overridden in subscribe params");
+	addOption("subscriptions.coalesceQueueBytes").setType(cp::RpcValue::Type::Int).setNames("--subs-coalesce-queue-bytes")
+			.setDefaultValue(64 * 1024)
+			.setComment("Subscriber outgoing backlog (send queue and socket buffer) in bytes, above which coalescing subscriptions hold signals");
 	addOption("sqlconfig.enabled").setType(cp::RpcValue::Type::Bool).setNames("--sql-config-enabled")
 			.setComment("SQL config enabled")
 			.setDefaultValue(false);
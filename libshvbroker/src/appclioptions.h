@@ -20,6 +20,7 @@ public:
 
 	CLIOPTION_GETTER_SETTER(std::string, l, setL, ocale)
 	CLIOPTION_GETTER_SETTER2(std::string, "app.brokerId", b, setB, rokerId)
+	CLIOPTION_GETTER_SETTER2(int, "app.metricsSignalInterval", m, setM, etricsSignalInterval)
 	CLIOPTION_GETTER_SETTER2(int, "server.port", s, setS, erverPort)
 	CLIOPTION_GETTER_SETTER2(int, "server.sslPort", s, setS, erverSslPort)
 	CLIOPTION_GETTER_SETTER2(int, "server.discoveryPort", d, setD, iscoveryPort)
@@ -36,6 +37,11 @@ public:
 	//CLIOPTION_GETTER_SETTER2(std::string, "etc.acl.grants", g, setG, rantsFile)
 	//CLIOPTION_GETTER_SETTER2(std::string, "etc.acl.paths", p, setP, athsFile)
 
+	CLIOPTION_GETTER_SETTER2(int, "subscriptions.minInterval", s, setS, ubscriptionsMinInterval)
+	CLIOPTION_GETTER_SETTER2(bool, "subscriptions.coalesce", is, set, SubscriptionsCoalesce)
+	CLIOPTION_GETTER_SETTER2(double, "subscriptions.deadband", s, setS, ubscriptionsDeadband)
+	CLIOPTION_GETTER_SETTER2(int, "subscriptions.coalesceQueueBytes", s, setS, ubscriptionsCoalesceQueueBytes)
+
 	CLIOPTION_GETTER_SETTER2(bool, "sqlconfig.enabled", is, set, SqlConfigEnabled)
 	CLIOPTION_GETTER_SETTER2(std::string, "sqlconfig.driver", s, setS, qlConfigDriver)
 	CLIOPTION_GETTER_SETTER2(std::string, "sqlconfig.database", s, setS, qlConfigDatabase)
@@ -33,13 +33,16 @@
 #include <shv/chainpack/cponwriter.h>
 #include <shv/chainpack/tunnelctl.h>
 #include <shv/chainpack/accessgrant.h>
+#include <shv/chainpack/rpctracer.h>
 
+#include <QDir>
 #include <QFile>
 #include <QSocketNotifier>
 #include <QSqlDatabase>
 #include <QTimer>
 #include <QUdpSocket>
 
+#include <algorithm>
 #include <ctime>
 #include <fstream>
 
@@ -207,6 +210,7 @@ std::vector<cp::MetaMethod> MountsNode::m_metaMethods = {
 };
 
 static const auto SQL_CONFIG_CONN_NAME = QStringLiteral("ShvBrokerDbConfigSqlConnection");
+static constexpr int PENDING_SIGNALS_FLUSH_INTERVAL = 20;
 //static constexpr int SQL_RECONNECT_INTERVAL = 3000;
 BrokerApp::BrokerApp(int &argc, char **argv, AppCliOptions *cli_opts)
 	: Super(argc, argv)
@@ -214,6 +218,13 @@ BrokerApp::BrokerApp(int &argc, char **argv, AppCliOptions *cli_opts)
 {
 	//shvInfo() << "creating SHV BROKER application object ver." << versionString();
 	m_brokerId = m_cliOptions->brokerId();
+	m_defaultSignalPolicy.minInterval = m_cliOptions->subscriptionsMinInterval();
+	m_defaultSignalPolicy.coalesce = m_cliOptions->isSubscriptionsCoalesce();
+	m_defaultSignalPolicy.deadband = m_cliOptions->subscriptionsDeadband();
+	m_signalQueueLimit = static_cast<size_t>(std::max(0, m_cliOptions->subscriptionsCoalesceQueueBytes()));
+	m_pendingSignalsTimer = new QTimer(this);
+	m_pendingSignalsTimer->setInterval(PENDING_SIGNALS_FLUSH_INTERVAL);
+	connect(m_pendingSignalsTimer, &QTimer::timeout, this, &BrokerApp::flushPendingSignals);
 	std::srand(std::time(nullptr));
 #ifdef Q_OS_UNIX
 	//syslog (LOG_INFO, "Server started");
@@ -285,7 +296,11 @@ void BrokerApp::registerLogTopics()
 void BrokerApp::installUnixSignalHandlers()
 {
 	shvInfo() << "installing Unix signals handlers";
+#ifdef SHV_RPC_TRACING
+	for(int sig_num : {SIGTERM, SIGHUP, SIGUSR1}) {
+#else
 	for(int sig_num : {SIGTERM, SIGHUP}) {
+#endif
 		struct sigaction sa;
 
 		sa.sa_handler = BrokerApp::nativeSigHandler;
@@ -323,11 +338,26 @@ void BrokerApp::handlePosixSignals()
 		//QMetaObject::invokeMethod(this, &BrokerApp::reloadConfig, Qt::QueuedConnection); since Qt 5.10
 		QTimer::singleShot(0, this, &BrokerApp::reloadConfigRemountDevices);
 	}
+#ifdef SHV_RPC_TRACING
+	else if(sig_num == SIGUSR1) {
+		shvInfo() << "RPC trace dumped to:" << dumpRpcTrace();
+	}
+#endif
 
 	m_snTerm->setEnabled(true);
 }
 #endif
 
+std::string BrokerApp::dumpRpcTrace(const std::string &file_name)
+{
+	std::string fn = file_name;
+	if(fn.empty())
+		fn = QDir::tempPath().toStdString() + "/shvbroker-trace-" + std::to_string(applicationPid()) + ".json";
+	if(!cp::RpcTracer::dumpChromeTrace(fn))
+		SHV_EXCEPTION("Cannot write RPC trace to file: " + fn);
+	return fn;
+}
+
 rpc::BrokerTcpServer *BrokerApp::tcpServer()
 {
 	if(!m_tcpServer)
@@ -881,6 +911,8 @@ void BrokerApp::onConnectedToMasterBrokerChanged(int connection_id, bool is_conn
 
 void BrokerApp::onRpcDataReceived(int connection_id, shv::chainpack::Rpc::ProtocolType protocol_type, cp::RpcValue::MetaData &&meta, std::string &&data)
 {
+	BrokerMetrics::StageTimer routing_timer(m_metrics, BrokerMetrics::Stage::Routing);
+	SHV_TRACE_SPAN(route_span, "broker.route", connection_id, cp::RpcMessage::requestId(meta).toInt64());
 	cp::RpcMessage::setProtocolType(meta, protocol_type);
 	if(cp::RpcMessage::isRegisterRevCallerIds(meta))
 		cp::RpcMessage::pushRevCallerId(meta, connection_id);
@@ -888,6 +920,8 @@ void BrokerApp::onRpcDataReceived(int connection_id, shv::chainpack::Rpc::Protoc
 		// prepare response for catch block
 		// it cannot be constructed from meta, since meta is moved in the try block
 		shv::chainpack::RpcResponse rsp = cp::RpcResponse::forRequest(meta);
+		// ends when response is sent back to the caller connection
+		SHV_TRACE_ASYNC_BEGIN("broker.request", connection_id, cp::RpcMessage::requestId(meta).toInt64());
 		rpc::ClientConnectionOnBroker *client_connection = clientConnectionById(connection_id);
 		rpc::MasterBrokerConnection *master_broker_connection = masterBrokerConnectionById(connection_id);
 		rpc::CommonRpcClientHandle *connection_handle = client_connection;
@@ -961,6 +995,8 @@ void BrokerApp::onRpcDataReceived(int connection_id, shv::chainpack::Rpc::Protoc
 					logAclResolveM() << "==== resolved path:" << resolved_shv_path << "grant:" << acg.toRpcValue().toCpon();
 				}
 				else {
+					BrokerMetrics::StageTimer acl_timer(m_metrics, BrokerMetrics::Stage::AclResolve);
+					SHV_TRACE_SPAN(acl_span, "broker.acl", connection_id, cp::RpcMessage::requestId(meta).toInt64());
 					acg = accessGrantForRequest(connection_handle, resolved_shv_path, method, cp::RpcMessage::accessGrant(meta));
 				}
 				if(!acg.isValid()) {
@@ -987,6 +1023,7 @@ void BrokerApp::onRpcDataReceived(int connection_id, shv::chainpack::Rpc::Protoc
 				rsp.setError(cp::RpcResponse::Error::create(
 								 cp::RpcResponse::Error::MethodCallException
 								 , e.what()));
+				SHV_TRACE_ASYNC_END("broker.request", connection_id, rsp.requestId().toInt64());
 				connection_handle->sendMessage(rsp);
 			}
 		}
@@ -1036,6 +1073,7 @@ void BrokerApp::onRpcDataReceived(int connection_id, shv::chainpack::Rpc::Protoc
 			}
 			rpc::CommonRpcClientHandle *cch = commonClientConnectionById(caller_id);
 			if(cch) {
+				SHV_TRACE_ASYNC_END("broker.request", caller_id, cp::RpcMessage::requestId(meta).toInt64());
 				cch->sendRawData(std::move(meta), std::move(data));
 			}
 			else {
@@ -1066,8 +1104,13 @@ void BrokerApp::onRpcDataReceived(int connection_id, shv::chainpack::Rpc::Protoc
 			//logSigResolveD() << client_connection->connectionId() << "forwarding signal to client on mount point:" << mp << "as:" << full_shv_path;
 			cp::RpcMessage::setShvPath(meta, full_shv_path);
 			bool sig_sent = sendNotifyToSubscribers(meta, data);
+			if(!sig_sent) {
+				if(rpc::CommonRpcClientHandle *ch = commonClientConnectionById(connection_id))
+					ch->signalCounters().unrouted++;
+			}
 			if(!sig_sent && client_connection && client_connection->isSlaveBrokerConnection()) {
 				logSubscriptionsD() << "Rejecting unsubscribed signal, shv_path:" << full_shv_path << "method:" << cp::RpcMessage::method(meta).asString();
+				client_connection->signalCounters().rejected++;
 				cp::RpcRequest rq;
 				rq.setRequestId(client_connection->nextRequestId());
 				rq.setMethod(cp::Rpc::METH_REJECT_NOT_SUBSCRIBED)
@@ -1087,6 +1130,7 @@ void BrokerApp::onRootNodeSendRpcMesage(const shv::chainpack::RpcMessage &msg)
 		cp::RpcResponse resp(msg);
 		shv::chainpack::RpcValue::Int connection_id = resp.popCallerId();
 		rpc::CommonRpcClientHandle *conn = commonClientConnectionById(connection_id);
+		SHV_TRACE_ASYNC_END("broker.request", connection_id, resp.requestId().toInt64());
 		if(conn)
 			conn->sendMessage(resp);
 		else
@@ -1141,14 +1185,17 @@ bool BrokerApp::sendNotifyToSubscribers(const shv::chainpack::RpcValue::MetaData
 				//shvDebug() << "\t broadcasting to connection id:" << id;
 				const rpc::ClientConnectionOnBroker::Subscription &subs = conn->subscriptionAt((size_t)subs_ix);
 				std::string new_path = conn->toSubscribedPath(subs, shv_path.asString());
+				bool held;
 				if(new_path == shv_path.asString()) {
-					conn->sendRawData(meta_data, std::string(data));
+					held = conn->sendSignal(subs, shv_path.asString(), meta_data, data, m_signalQueueLimit);
 				}
 				else {
 					shv::chainpack::RpcValue::MetaData md2(meta_data);
 					cp::RpcMessage::setShvPath(md2, new_path);
-					conn->sendRawData(md2, std::string(data));
+					held = conn->sendSignal(subs, shv_path.asString(), md2, data, m_signalQueueLimit);
 				}
+				if(held && !m_pendingSignalsTimer->isActive())
+					m_pendingSignalsTimer->start();
 				subs_sent = true;
 			}
 		}
@@ -1156,6 +1203,19 @@ bool BrokerApp::sendNotifyToSubscribers(const shv::chainpack::RpcValue::MetaData
 	return subs_sent;
 }
 
+void BrokerApp::flushPendingSignals()
+{
+	bool pending = false;
+	for(rpc::CommonRpcClientHandle *conn : allClientConnections()) {
+		if(conn->pendingSignalCount() > 0 && conn->isConnectedAndLoggedIn()) {
+			if(conn->flushPendingSignals(m_signalQueueLimit))
+				pending = true;
+		}
+	}
+	if(!pending)
+		m_pendingSignalsTimer->stop();
+}
+
 void BrokerApp::sendNotifyToSubscribers(const std::string &shv_path, const std::string &method, const shv::chainpack::RpcValue &params)
 {
 	//shvWarning() << shv_path << method << params.toPrettyString();
@@ -1179,13 +1239,14 @@ void BrokerApp::sendNotifyToSubscribers(const std::string &shv_path, const std::
 	}
 }
 
-void BrokerApp::addSubscription(int client_id, const std::string &shv_path, const std::string &method)
+void BrokerApp::addSubscription(int client_id, const std::string &shv_path, const std::string &method, const rpc::CommonRpcClientHandle::SignalPolicy &policy)
 {
 	//using ServiceProviderPath = shv::core::utils::ServiceProviderPath;
 	rpc::CommonRpcClientHandle *connection_handle = commonClientConnectionById(client_id);
 	if(!connection_handle)
 		SHV_EXCEPTION("Cannot create subscription, invalid connection ID.");
 	rpc::CommonRpcClientHandle::Subscription subs = connection_handle->createSubscription(shv_path, method);
+	subs.policy = policy;
 	connection_handle->addSubscription(subs);
 	//rpc::ClientConnection *cli = dynamic_cast<rpc::ClientConnection*>(connection_handle);
 	shv::core::utils::ServiceProviderPath spp(subs.localPath);
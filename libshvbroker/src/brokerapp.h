@@ -15,6 +15,8 @@ inline unsigned qHash(const std::string &s) noexcept //Q_DECL_NOEXCEPT_EXPR(noex
 #include "appclioptions.h"
 #include "tunnelsecretlist.h"
 #include "aclmanager.h"
+#include "brokermetrics.h"
+#include "rpc/commonrpcclienthandle.h"
 
 #include <shv/iotqt/node/shvnode.h>
 
@@ -26,6 +28,7 @@ inline unsigned qHash(const std::string &s) noexcept //Q_DECL_NOEXCEPT_EXPR(noex
 #include <set>
 
 class QSocketNotifier;
+class QTimer;
 class QSqlDatabase;
 
 namespace shv { namespace iotqt { namespace node { class ShvNodeTree; }}}
@@ -36,7 +39,7 @@ namespace shv { namespace chainpack { class RpcSignal; }}
 namespace shv {
 namespace broker {
 
-namespace rpc { class WebSocketServer; class BrokerTcpServer; class ClientConnectionOnBroker;  class MasterBrokerConnection; class CommonRpcClientHandle; }
+namespace rpc { class WebSocketServer; class BrokerTcpServer; class ClientConnectionOnBroker;  class MasterBrokerConnection; }
 
 class AclManager;
 
@@ -49,6 +52,7 @@ private:
 	using Super = QCoreApplication;
 	friend class AclManager;
 	friend class MountsNode;
+	friend class BrokerMetricsNode;
 public:
 	BrokerApp(int &argc, char **argv, AppCliOptions* cli_opts);
 	~BrokerApp() Q_DECL_OVERRIDE;
@@ -65,7 +69,10 @@ public:
 
 	rpc::MasterBrokerConnection* mainMasterBrokerConnection() { return masterBrokerConnections().value(0); }
 
-	void addSubscription(int client_id, const std::string &path, const std::string &method);
+	void addSubscription(int client_id, const std::string &path, const std::string &method,
+						 const rpc::CommonRpcClientHandle::SignalPolicy &policy = rpc::CommonRpcClientHandle::SignalPolicy());
+	/// policy from broker config used for subscriptions without own policy params
+	const rpc::CommonRpcClientHandle::SignalPolicy& defaultSignalPolicy() const { return m_defaultSignalPolicy; }
 	bool removeSubscription(int client_id, const std::string &shv_path, const std::string &method);
 	bool rejectNotSubscribedSignal(int client_id, const std::string &path, const std::string &method);
 
@@ -97,6 +104,10 @@ public:
 	void sendNewLogEntryNotify(const std::string &msg);
 
 	const std::string& brokerId() const { return m_brokerId; }
+	BrokerMetrics& metrics() { return m_metrics; }
+	/// write RPC trace events in Chrome trace format, temp dir file is used when file_name is empty
+	/// @return written file name
+	std::string dumpRpcTrace(const std::string &file_name = std::string());
 	iotqt::node::ShvNode * nodeForService(const shv::core::utils::ServiceProviderPath &spp);
 protected:
 	virtual void initDbConfigSqlConnection();
@@ -128,6 +139,7 @@ private:
 
 	void sendNotifyToSubscribers(const std::string &shv_path, const std::string &method, const shv::chainpack::RpcValue &params);
 	bool sendNotifyToSubscribers(const shv::chainpack::RpcValue::MetaData &meta_data, const std::string &data);
+	void flushPendingSignals();
 
 	static std::string brokerClientDirPath(int client_id);
 	static std::string brokerClientAppPath(int client_id);
@@ -152,6 +164,10 @@ protected:
 	UserPathGrantCache m_userPathGrantCache;
 #endif
 	AclManager *m_aclManager = nullptr;
+	BrokerMetrics m_metrics;
+	rpc::CommonRpcClientHandle::SignalPolicy m_defaultSignalPolicy;
+	size_t m_signalQueueLimit = 0;
+	QTimer *m_pendingSignalsTimer = nullptr;
 #ifdef Q_OS_UNIX
 private:
 	// Unix signal handlers.
@@ -1,11 +1,14 @@
 #include "brokerappnode.h"
 
 #include "brokerapp.h"
+#include "brokermetricsnode.h"
 #include "rpc/clientconnectiononbroker.h"
 #include "rpc/masterbrokerconnection.h"
 
 #include <shv/chainpack/metamethod.h>
 #include <shv/chainpack/rpcmessage.h>
+#include <shv/chainpack/rpctracer.h>
+#include <shv/chainpack/rpcvalueview.h>
 //#include <shv/chainpack/rpcdriver.h>
 #include <shv/core/exception.h>
 #include <shv/core/stringview.h>
@@ -67,6 +70,64 @@ public:
 private:
 	std::vector<cp::MetaMethod> m_metaMethods;
 };
+
+#ifdef SHV_RPC_TRACING
+static const char M_TRACE_ENABLED[] = "enabled";
+static const char M_TRACE_SET_ENABLED[] = "setEnabled";
+static const char M_TRACE_SAMPLE_RATE[] = "sampleRate";
+static const char M_TRACE_SET_SAMPLE_RATE[] = "setSampleRate";
+static const char M_TRACE_CLEAR[] = "clear";
+static const char M_TRACE_DUMP[] = "dump";
+class BrokerTraceNode : public shv::iotqt::node::MethodsTableNode
+{
+	using Super = shv::iotqt::node::MethodsTableNode;
+public:
+	BrokerTraceNode(shv::iotqt::node::ShvNode *parent = nullptr)
+		: Super("trace", &m_metaMethods, parent)
+		, m_metaMethods {
+			{cp::Rpc::METH_DIR, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_BROWSE},
+			{cp::Rpc::METH_LS, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_READ},
+			{M_TRACE_ENABLED, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter, cp::Rpc::ROLE_READ},
+			{M_TRACE_SET_ENABLED, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::IsSetter, cp::Rpc::ROLE_SERVICE},
+			{M_TRACE_SAMPLE_RATE, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter, cp::Rpc::ROLE_READ},
+			{M_TRACE_SET_SAMPLE_RATE, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::IsSetter, cp::Rpc::ROLE_SERVICE},
+			{M_TRACE_CLEAR, cp::MetaMethod::Signature::VoidVoid, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_SERVICE},
+			{M_TRACE_DUMP, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_SERVICE},
+		}
+	{ }
+
+	shv::chainpack::RpcValue callMethod(const StringViewList &shv_path, const std::string &method, const shv::chainpack::RpcValue &params) override
+	{
+		if(shv_path.empty()) {
+			if(method == M_TRACE_ENABLED) {
+				return cp::RpcTracer::isEnabled();
+			}
+			if(method == M_TRACE_SET_ENABLED) {
+				cp::RpcTracer::setEnabled(params.toBool());
+				return true;
+			}
+			if(method == M_TRACE_SAMPLE_RATE) {
+				return cp::RpcTracer::sampleRate();
+			}
+			if(method == M_TRACE_SET_SAMPLE_RATE) {
+				cp::RpcTracer::setSampleRate(static_cast<unsigned>(params.toUInt()));
+				return true;
+			}
+			if(method == M_TRACE_CLEAR) {
+				cp::RpcTracer::clear();
+				return true;
+			}
+			if(method == M_TRACE_DUMP) {
+				// file name is optional, broker chooses one in temp dir otherwise
+				return BrokerApp::instance()->dumpRpcTrace(params.isString()? params.asString(): std::string());
+			}
+		}
+		return Super::callMethod(shv_path, method, params);
+	}
+private:
+	std::vector<cp::MetaMethod> m_metaMethods;
+};
+#endif
 }
 
 static const char M_RELOAD_CONFIG[] = "reloadConfig";
@@ -77,6 +138,31 @@ static const char M_GIT_COMMIT[] = "gitCommit";
 static const char M_BROKER_ID[] = "brokerId";
 static const char M_MASTER_BROKER_ID[] = "masterBrokerId";
 
+static bool is_subscription_method(const std::string &method)
+{
+	return method == cp::Rpc::METH_SUBSCRIBE
+			|| method == cp::Rpc::METH_UNSUBSCRIBE
+			|| method == cp::Rpc::METH_REJECT_NOT_SUBSCRIBED;
+}
+
+/// Params is RpcValue or RpcValueView of subscribe params,
+/// policy params override broker config defaults
+template<typename Params>
+static rpc::CommonRpcClientHandle::SignalPolicy subscription_policy(const Params &params)
+{
+	rpc::CommonRpcClientHandle::SignalPolicy ret = BrokerApp::instance()->defaultSignalPolicy();
+	Params v = params.at(cp::Rpc::PAR_MIN_INTERVAL);
+	if(v.isValid())
+		ret.minInterval = v.toInt();
+	v = params.at(cp::Rpc::PAR_COALESCE);
+	if(v.isValid())
+		ret.coalesce = v.toBool();
+	v = params.at(cp::Rpc::PAR_DEADBAND);
+	if(v.isValid())
+		ret.deadband = v.toDouble();
+	return ret;
+}
+
 BrokerAppNode::BrokerAppNode(shv::iotqt::node::ShvNode *parent)
 	: Super("", &m_metaMethods, parent)
 	, m_metaMethods {
@@ -96,6 +182,57 @@ BrokerAppNode::BrokerAppNode(shv::iotqt::node::ShvNode *parent)
 	}
 {
 	new BrokerLogNode(this);
+	new BrokerMetricsNode(this);
+#ifdef SHV_RPC_TRACING
+	new BrokerTraceNode(this);
+#endif
+}
+
+void BrokerAppNode::handleRawRpcRequest(chainpack::RpcValue::MetaData &&meta, std::string &&data)
+{
+	// (un)subscribe is sent by every client on connect, read path and method from the raw params
+	// without decoding the whole message, everything else goes the usual way
+	// including requests with insufficient grant, so they are rejected the same way as decoded ones
+	const cp::RpcValue::String method = cp::RpcMessage::method(meta).toString();
+	if(cp::RpcMessage::shvPath(meta).toString().empty()
+			&& cp::RpcMessage::protocolType(meta) == cp::Rpc::ProtocolType::ChainPack
+			&& is_subscription_method(method)
+			&& isRawRequestGranted(meta, method)) {
+		cp::RpcResponse resp = cp::RpcResponse::forRequest(meta);
+		try {
+			cp::RpcValueView params = cp::RpcValueView(data).at(cp::RpcMessage::MetaType::Key::Params);
+			int client_id = cp::RpcMessage::peekCallerId(meta);
+			resp.setResult(callSubscriptionMethod(method, client_id, params.at(cp::Rpc::PAR_PATH).toString(), params.at(cp::Rpc::PAR_METHOD).toString(),
+												  subscription_policy(params)));
+		}
+		catch (const std::exception &e) {
+			shvError() << "method:" << method << "what:" << e.what();
+			resp.setError(cp::RpcResponse::Error::create(cp::RpcResponse::Error::MethodCallException, e.what()));
+		}
+		rootNode()->emitSendRpcMessage(resp);
+		return;
+	}
+	Super::handleRawRpcRequest(std::move(meta), std::move(data));
+}
+
+bool BrokerAppNode::isRawRequestGranted(const chainpack::RpcValue::MetaData &meta, const std::string &method)
+{
+	const cp::MetaMethod *mm = ShvNode::metaMethod(StringViewList(), method);
+	if(!mm)
+		return false;
+	return grantToAccessLevel(cp::RpcMessage::accessGrant(meta)) >= grantToAccessLevel(mm->accessGrant());
+}
+
+chainpack::RpcValue BrokerAppNode::callSubscriptionMethod(const std::string &method, int client_id, const std::string &path, const std::string &signal_method,
+														   const rpc::CommonRpcClientHandle::SignalPolicy &policy)
+{
+	if(method == cp::Rpc::METH_SUBSCRIBE) {
+		BrokerApp::instance()->addSubscription(client_id, path, signal_method, policy);
+		return true;
+	}
+	if(method == cp::Rpc::METH_UNSUBSCRIBE)
+		return BrokerApp::instance()->removeSubscription(client_id, path, signal_method);
+	return BrokerApp::instance()->rejectNotSubscribedSignal(client_id, path, signal_method);
 }
 
 chainpack::RpcValue BrokerAppNode::callMethodRq(const chainpack::RpcRequest &rq)
@@ -103,30 +240,11 @@ chainpack::RpcValue BrokerAppNode::callMethodRq(const chainpack::RpcRequest &rq)
 	const cp::RpcValue::String shv_path = rq.shvPath().toString();
 	if(shv_path.empty()) {
 		const cp::RpcValue::String method = rq.method().toString();
-		if(method == cp::Rpc::METH_SUBSCRIBE) {
-			const shv::chainpack::RpcValue parms = rq.params();
-			const shv::chainpack::RpcValue::Map &pm = parms.toMap();
-			std::string path = pm.value(cp::Rpc::PAR_PATH).toString();
-			std::string method = pm.value(cp::Rpc::PAR_METHOD).toString();
-			int client_id = rq.peekCallerId();
-			BrokerApp::instance()->addSubscription(client_id, path, method);
-			return true;
-		}
-		if(method == cp::Rpc::METH_UNSUBSCRIBE) {
-			const shv::chainpack::RpcValue parms = rq.params();
-			const shv::chainpack::RpcValue::Map &pm = parms.toMap();
-			std::string path = pm.value(cp::Rpc::PAR_PATH).toString();
-			std::string method = pm.value(cp::Rpc::PAR_METHOD).toString();
-			int client_id = rq.peekCallerId();
-			return BrokerApp::instance()->removeSubscription(client_id, path, method);
-		}
-		if(method == cp::Rpc::METH_REJECT_NOT_SUBSCRIBED) {
+		if(is_subscription_method(method)) {
 			const shv::chainpack::RpcValue parms = rq.params();
 			const shv::chainpack::RpcValue::Map &pm = parms.toMap();
-			std::string path = pm.value(cp::Rpc::PAR_PATH).toString();
-			std::string method = pm.value(cp::Rpc::PAR_METHOD).toString();
-			int client_id = rq.peekCallerId();
-			return BrokerApp::instance()->rejectNotSubscribedSignal(client_id, path, method);
+			return callSubscriptionMethod(method, rq.peekCallerId(), pm.value(cp::Rpc::PAR_PATH).toString(), pm.value(cp::Rpc::PAR_METHOD).toString(),
+										  subscription_policy(parms));
 		}
 		if (method == M_MASTER_BROKER_ID) {
 			auto *conn = BrokerApp::instance()->mainMasterBrokerConnection();
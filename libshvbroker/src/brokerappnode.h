@@ -1,5 +1,7 @@
 #pragma once
 
+#include "rpc/commonrpcclienthandle.h"
+
 #include <shv/iotqt/node/shvnode.h>
 #include <shv/chainpack/rpcvalue.h>
 
@@ -14,8 +16,13 @@ class BrokerAppNode : public shv::iotqt::node::MethodsTableNode
 public:
 	BrokerAppNode(shv::iotqt::node::ShvNode *parent = nullptr);
 
+	void handleRawRpcRequest(chainpack::RpcValue::MetaData &&meta, std::string &&data) override;
 	chainpack::RpcValue callMethodRq(const chainpack::RpcRequest &rq) override;
 	shv::chainpack::RpcValue callMethod(const StringViewList &shv_path, const std::string &method, const shv::chainpack::RpcValue &params) override;
+private:
+	bool isRawRequestGranted(const chainpack::RpcValue::MetaData &meta, const std::string &method);
+	chainpack::RpcValue callSubscriptionMethod(const std::string &method, int client_id, const std::string &path, const std::string &signal_method,
+											   const rpc::CommonRpcClientHandle::SignalPolicy &policy);
 private:
 	std::vector<shv::chainpack::MetaMethod> m_metaMethods;
 };
@@ -0,0 +1,137 @@
+#include "brokermetrics.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace cp = shv::chainpack;
+
+namespace shv {
+namespace broker {
+
+//=================================================================================
+// LatencyHistogram
+//=================================================================================
+constexpr int LatencyHistogram::SUB_BUCKET_BITS;
+constexpr int LatencyHistogram::SUB_BUCKET_COUNT;
+constexpr int LatencyHistogram::MAX_VALUE_BITS;
+constexpr int LatencyHistogram::BUCKET_COUNT;
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+int LatencyHistogram::bucketIndex(int64_t value)
+{
+	if(value < SUB_BUCKET_COUNT)
+		return value < 0? 0: static_cast<int>(value);
+	uint64_t v = static_cast<uint64_t>(value);
+	if(v >= (uint64_t(1) << MAX_VALUE_BITS))
+		v = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+	int msb = 63 - __builtin_clzll(v);
+	int shift = msb - SUB_BUCKET_BITS;
+	int sub = static_cast<int>((v >> shift) & (SUB_BUCKET_COUNT - 1));
+	return (shift + 1) * SUB_BUCKET_COUNT + sub;
+}
+
+int64_t LatencyHistogram::bucketLowerBound(int ix)
+{
+	if(ix < SUB_BUCKET_COUNT)
+		return ix;
+	int shift = ix / SUB_BUCKET_COUNT - 1;
+	int sub = ix % SUB_BUCKET_COUNT;
+	return static_cast<int64_t>(SUB_BUCKET_COUNT + sub) << shift;
+}
+
+void LatencyHistogram::record(int64_t value)
+{
+	if(value < 0)
+		value = 0;
+	m_buckets[static_cast<size_t>(bucketIndex(value))].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(static_cast<uint64_t>(value), std::memory_order_relaxed);
+	int64_t cur = m_min.load(std::memory_order_relaxed);
+	while(value < cur && !m_min.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+	cur = m_max.load(std::memory_order_relaxed);
+	while(value > cur && !m_max.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset()
+{
+	for(auto &b : m_buckets)
+		b.store(0, std::memory_order_relaxed);
+	m_count.store(0, std::memory_order_relaxed);
+	m_sum.store(0, std::memory_order_relaxed);
+	m_min.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+	m_max.store(0, std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::percentile(double p) const
+{
+	uint64_t cnt = count();
+	if(cnt == 0)
+		return 0;
+	p = std::max(0., std::min(1., p));
+	uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(cnt - 1)) + 1;
+	uint64_t acc = 0;
+	for (int i = 0; i < BUCKET_COUNT; ++i) {
+		acc += m_buckets[static_cast<size_t>(i)].load(std::memory_order_relaxed);
+		if(acc >= rank) {
+			int64_t lo = bucketLowerBound(i);
+			int64_t hi = bucketLowerBound(i + 1);
+			int64_t mid = lo + (hi - lo) / 2;
+			// midpoint can be outside recorded range for sparse histograms
+			return std::max(std::min(mid, m_max.load(std::memory_order_relaxed)), m_min.load(std::memory_order_relaxed));
+		}
+	}
+	return m_max.load(std::memory_order_relaxed);
+}
+
+cp::RpcValue LatencyHistogram::toRpcValue() const
+{
+	uint64_t cnt = count();
+	cp::RpcValue::Map ret;
+	ret["unit"] = "ns";
+	ret["count"] = cnt;
+	if(cnt > 0) {
+		ret["min"] = m_min.load(std::memory_order_relaxed);
+		ret["max"] = m_max.load(std::memory_order_relaxed);
+		ret["mean"] = static_cast<int64_t>(m_sum.load(std::memory_order_relaxed) / cnt);
+		ret["p50"] = percentile(0.5);
+		ret["p90"] = percentile(0.9);
+		ret["p99"] = percentile(0.99);
+		ret["p999"] = percentile(0.999);
+	}
+	return ret;
+}
+
+//=================================================================================
+// BrokerMetrics
+//=================================================================================
+const char *BrokerMetrics::stageName(Stage stage)
+{
+	switch (stage) {
+	case Stage::Decode: return "decode";
+	case Stage::AclResolve: return "aclResolve";
+	case Stage::Routing: return "routing";
+	case Stage::Encode: return "encode";
+	case Stage::Count: break;
+	}
+	return "???";
+}
+
+void BrokerMetrics::reset()
+{
+	for(auto &h : m_histograms)
+		h.reset();
+}
+
+cp::RpcValue BrokerMetrics::latencyToRpcValue() const
+{
+	cp::RpcValue::Map ret;
+	for (size_t i = 0; i < m_histograms.size(); ++i)
+		ret[stageName(static_cast<Stage>(i))] = m_histograms[i].toRpcValue();
+	return ret;
+}
+
+}}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "shvbrokerglobal.h"
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+namespace shv {
+namespace broker {
+
+/// Log-linear latency histogram in the HDR histogram style,
+/// every power of two range is split to SUB_BUCKET_COUNT linear buckets, what gives relative error below 12.5%.
+/// Recording is lock-free, it is safe to record from more threads and read snapshot concurrently.
+class SHVBROKER_DECL_EXPORT LatencyHistogram
+{
+public:
+	static constexpr int SUB_BUCKET_BITS = 3;
+	static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	/// values above 2^MAX_VALUE_BITS nsec (~18 min) are clamped
+	static constexpr int MAX_VALUE_BITS = 40;
+	static constexpr int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+public:
+	LatencyHistogram();
+
+	void record(int64_t value);
+	void reset();
+
+	uint64_t count() const {return m_count.load(std::memory_order_relaxed);}
+	/// p in range <0, 1>, returns value approximated by the bucket midpoint
+	int64_t percentile(double p) const;
+	shv::chainpack::RpcValue toRpcValue() const;
+
+	static int bucketIndex(int64_t value);
+	static int64_t bucketLowerBound(int ix);
+private:
+	std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets;
+	std::atomic<uint64_t> m_count;
+	std::atomic<uint64_t> m_sum;
+	std::atomic<int64_t> m_min;
+	std::atomic<int64_t> m_max;
+};
+
+/// Broker wide latency histograms of message processing stages
+class SHVBROKER_DECL_EXPORT BrokerMetrics
+{
+public:
+	enum class Stage {
+		/// meta data decoding of received message
+		Decode = 0,
+		/// BrokerApp::accessGrantForRequest()
+		AclResolve,
+		/// whole dispatch of received message by BrokerApp, including ACL resolution and encoding of forwarded messages
+		Routing,
+		/// meta data encoding and enqueuing of outgoing raw message
+		Encode,
+		Count
+	};
+	static const char* stageName(Stage stage);
+
+	static int64_t nowNsec()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void record(Stage stage, int64_t nsec) {m_histograms[static_cast<size_t>(stage)].record(nsec);}
+	const LatencyHistogram& histogram(Stage stage) const {return m_histograms[static_cast<size_t>(stage)];}
+	void reset();
+
+	/// {stage_name: histogram_summary, ...}
+	shv::chainpack::RpcValue latencyToRpcValue() const;
+
+	/// records time elapsed from construction to destruction
+	class StageTimer
+	{
+	public:
+		StageTimer(BrokerMetrics &metrics, Stage stage) : m_metrics(metrics), m_stage(stage), m_start(nowNsec()) {}
+		~StageTimer() { m_metrics.record(m_stage, nowNsec() - m_start); }
+	private:
+		BrokerMetrics &m_metrics;
+		Stage m_stage;
+		int64_t m_start;
+	};
+private:
+	std::array<LatencyHistogram, static_cast<size_t>(Stage::Count)> m_histograms;
+};
+
+}}
@@ -0,0 +1,118 @@
+#include "brokermetricsnode.h"
+#include "brokerapp.h"
+#include "rpc/commonrpcclienthandle.h"
+
+#include <shv/chainpack/metamethod.h>
+#include <shv/chainpack/rpcmessage.h>
+#include <shv/coreqt/log.h>
+
+#include <QTimer>
+
+namespace cp = shv::chainpack;
+
+namespace shv {
+namespace broker {
+
+static const char M_CONNECTIONS[] = "connections";
+static const char M_LATENCY[] = "latency";
+static const char M_RESET[] = "reset";
+static const char M_SIGNAL_INTERVAL[] = "signalInterval";
+static const char M_SET_SIGNAL_INTERVAL[] = "setSignalInterval";
+
+BrokerMetricsNode::BrokerMetricsNode(shv::iotqt::node::ShvNode *parent)
+	: Super("metrics", &m_metaMethods, parent)
+	, m_metaMethods {
+		{cp::Rpc::METH_DIR, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_BROWSE},
+		{cp::Rpc::METH_LS, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_BROWSE},
+		{cp::Rpc::METH_GET, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter, cp::Rpc::ROLE_SERVICE, "Whole metrics snapshot."},
+		{cp::Rpc::SIG_VAL_CHANGED, cp::MetaMethod::Signature::VoidParam, cp::MetaMethod::Flag::IsSignal, cp::Rpc::ROLE_SERVICE, "Periodic metrics snapshot."},
+		{M_CONNECTIONS, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter, cp::Rpc::ROLE_SERVICE, "Traffic, send queue, signal and subscription counters per connection ID."},
+		{M_LATENCY, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter, cp::Rpc::ROLE_READ, "Latency histograms of decode, ACL resolution, routing and encode stages."},
+		{M_RESET, cp::MetaMethod::Signature::VoidVoid, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_COMMAND},
+		{M_SIGNAL_INTERVAL, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter, cp::Rpc::ROLE_SERVICE},
+		{M_SET_SIGNAL_INTERVAL, cp::MetaMethod::Signature::VoidParam, cp::MetaMethod::Flag::IsSetter, cp::Rpc::ROLE_COMMAND, "Periodic metrics signal interval in sec, 0 disables signal."},
+	}
+{
+	m_signalTimer = new QTimer(this);
+	connect(m_signalTimer, &QTimer::timeout, this, &BrokerMetricsNode::sendMetricsSignal);
+	setSignalInterval(BrokerApp::instance()->cliOptions()->metricsSignalInterval());
+}
+
+int BrokerMetricsNode::signalInterval() const
+{
+	return m_signalTimer->isActive()? m_signalTimer->interval() / 1000: 0;
+}
+
+void BrokerMetricsNode::setSignalInterval(int sec)
+{
+	if(sec > 0) {
+		shvInfo() << "Metrics signal interval set to:" << sec << "sec";
+		m_signalTimer->start(sec * 1000);
+	}
+	else {
+		m_signalTimer->stop();
+	}
+}
+
+shv::chainpack::RpcValue BrokerMetricsNode::connectionsMetrics()
+{
+	cp::RpcValue::Map ret;
+	for(rpc::CommonRpcClientHandle *conn : BrokerApp::instance()->allClientConnections())
+		ret[std::to_string(conn->connectionId())] = conn->metricsToRpcValue();
+	return ret;
+}
+
+shv::chainpack::RpcValue BrokerMetricsNode::snapshot()
+{
+	return cp::RpcValue::Map {
+		{"timestamp", cp::RpcValue::DateTime::now()},
+		{M_CONNECTIONS, connectionsMetrics()},
+		{M_LATENCY, BrokerApp::instance()->metrics().latencyToRpcValue()},
+	};
+}
+
+void BrokerMetricsNode::reset()
+{
+	BrokerApp *app = BrokerApp::instance();
+	for(rpc::CommonRpcClientHandle *conn : app->allClientConnections())
+		conn->resetMetrics();
+	app->metrics().reset();
+}
+
+void BrokerMetricsNode::sendMetricsSignal()
+{
+	cp::RpcSignal sig;
+	sig.setShvPath(shvPath());
+	sig.setMethod(cp::Rpc::SIG_VAL_CHANGED);
+	sig.setParams(snapshot());
+	emitSendRpcMessage(sig);
+}
+
+shv::chainpack::RpcValue BrokerMetricsNode::callMethod(const StringViewList &shv_path, const std::string &method, const shv::chainpack::RpcValue &params)
+{
+	if(shv_path.empty()) {
+		if(method == cp::Rpc::METH_GET) {
+			return snapshot();
+		}
+		if(method == M_CONNECTIONS) {
+			return connectionsMetrics();
+		}
+		if(method == M_LATENCY) {
+			return BrokerApp::instance()->metrics().latencyToRpcValue();
+		}
+		if(method == M_RESET) {
+			reset();
+			return true;
+		}
+		if(method == M_SIGNAL_INTERVAL) {
+			return signalInterval();
+		}
+		if(method == M_SET_SIGNAL_INTERVAL) {
+			setSignalInterval(params.toInt());
+			return true;
+		}
+	}
+	return Super::callMethod(shv_path, method, params);
+}
+
+}}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <shv/iotqt/node/shvnode.h>
+
+class QTimer;
+
+namespace shv {
+namespace broker {
+
+/// .broker/app/metrics node
+/// exposes per connection traffic counters and broker wide latency histograms of message processing stages
+class BrokerMetricsNode : public shv::iotqt::node::MethodsTableNode
+{
+	using Super = shv::iotqt::node::MethodsTableNode;
+public:
+	BrokerMetricsNode(shv::iotqt::node::ShvNode *parent = nullptr);
+
+	shv::chainpack::RpcValue callMethod(const StringViewList &shv_path, const std::string &method, const shv::chainpack::RpcValue &params) override;
+
+	/// periodic metrics signal interval in sec, 0 disables signal
+	int signalInterval() const;
+	void setSignalInterval(int sec);
+private:
+	shv::chainpack::RpcValue connectionsMetrics();
+	shv::chainpack::RpcValue snapshot();
+	void reset();
+	void sendMetricsSignal();
+private:
+	std::vector<shv::chainpack::MetaMethod> m_metaMethods;
+	QTimer *m_signalTimer = nullptr;
+};
+
+}}
@@ -173,6 +173,7 @@ void ClientConnectionOnBroker::sendRawData(const shv::chainpack::RpcValue::MetaD
 				<< "client id:" << connectionId()
 				<< "protocol_type:" << (int)protocolType() << shv::chainpack::Rpc::protocolTypeToString(protocolType())
 				<< RpcDriver::dataToPrettyCpon(shv::chainpack::RpcMessage::protocolType(meta_data), meta_data, data);
+	BrokerMetrics::StageTimer encode_timer(BrokerApp::instance()->metrics(), BrokerMetrics::Stage::Encode);
 	Super::sendRawData(meta_data, std::move(data));
 }
 
@@ -276,6 +277,7 @@ void ClientConnectionOnBroker::onRpcDataReceived(shv::chainpack::Rpc::ProtocolTy
 		}
 		if(m_idleWatchDogTimer)
 			m_idleWatchDogTimer->start();
+		BrokerApp::instance()->metrics().record(BrokerMetrics::Stage::Decode, lastMetaDataDecodeNsec());
 		BrokerApp::instance()->onRpcDataReceived(connectionId(), protocol_type, std::move(md), std::move(msg_data));
 	}
 	catch (std::exception &e) {
@@ -47,6 +47,7 @@ public:
 
 	void sendMessage(const shv::chainpack::RpcMessage &rpc_msg) override;
 	void sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, std::string &&data) override;
+	shv::chainpack::RpcDriver* rpcDriver() override {return this;}
 
 	Subscription createSubscription(const std::string &shv_path, const std::string &method) override;
 	std::string toSubscribedPath(const Subscription &subs, const std::string &signal_path) const override;
@@ -1,6 +1,8 @@
 #include "commonrpcclienthandle.h"
 
 #include <shv/iotqt/node/shvnode.h>
+#include <shv/chainpack/rpcdriver.h>
+#include <shv/chainpack/rpcvalueview.h>
 #include <shv/core/utils/serviceproviderpath.h>
 #include <shv/core/utils/shvpath.h>
 
@@ -9,13 +11,71 @@
 #include <shv/core/stringview.h>
 #include <shv/core/exception.h>
 
+#include <chrono>
+#include <cmath>
+
 #define logSubscriptionsD() nCDebug("Subscr").color(NecroLog::Color::Yellow)
 #define logSigResolveD() nCDebug("SigRes").color(NecroLog::Color::Yellow)
 
+namespace cp = shv::chainpack;
+
 namespace shv {
 namespace broker {
 namespace rpc {
 
+namespace {
+
+int64_t now_msec()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool is_numeric(cp::RpcValue::Type type)
+{
+	return type == cp::RpcValue::Type::Int
+			|| type == cp::RpcValue::Type::UInt
+			|| type == cp::RpcValue::Type::Double
+			|| type == cp::RpcValue::Type::Decimal;
+}
+
+/// ChainPack params are read without decoding the message
+bool signal_numeric_value(const cp::RpcValue::MetaData &meta_data, const std::string &data, double &val)
+{
+	try {
+		cp::Rpc::ProtocolType protocol_type = cp::RpcMessage::protocolType(meta_data);
+		if(protocol_type == cp::Rpc::ProtocolType::ChainPack) {
+			cp::RpcValueView params = cp::RpcValueView(data).at(cp::RpcMessage::MetaType::Key::Params);
+			if(!is_numeric(params.type()))
+				return false;
+			val = params.toDouble();
+			return true;
+		}
+		cp::RpcValue params = cp::RpcDriver::decodeData(protocol_type, data, 0).at(cp::RpcMessage::MetaType::Key::Params);
+		if(!is_numeric(params.type()))
+			return false;
+		val = params.toDouble();
+		return true;
+	}
+	catch (const std::exception &e) {
+		shvWarning() << "Cannot read signal value:" << e.what();
+	}
+	return false;
+}
+
+}
+
+//=====================================================================
+// CommonRpcClientHandle::SignalPolicy
+//=====================================================================
+cp::RpcValue CommonRpcClientHandle::SignalPolicy::toRpcValue() const
+{
+	cp::RpcValue::Map ret;
+	ret[cp::Rpc::PAR_MIN_INTERVAL] = minInterval;
+	ret[cp::Rpc::PAR_COALESCE] = coalesce;
+	ret[cp::Rpc::PAR_DEADBAND] = deadband;
+	return ret;
+}
+
 //=====================================================================
 // CommonRpcClientHandle::Subscription
 //=====================================================================
@@ -132,7 +192,10 @@ unsigned CommonRpcClientHandle::addSubscription(const CommonRpcClientHandle::Sub
 	}
 	else {
 		logSubscriptionsD() << "subscription exists:" << "subscribed path:" << it->subscribedPath << "method:" << it->method;
+		const bool policy_changed = !(it->policy == subs.policy);
 		*it = subs;
+		if(policy_changed)
+			releaseSignalStates(subs);
 		return (it - m_subscriptions.begin());
 	}
 }
@@ -153,6 +216,7 @@ bool CommonRpcClientHandle::removeSubscription(const CommonRpcClientHandle::Subs
 		logSubscriptionsD() << "removed subscription local path:" << it->localPath
 							<< "subscribed path:" << it->subscribedPath << "method:" << it->method;
 		m_subscriptions.erase(it);
+		pruneSignalStates();
 		return true;
 	}
 }
@@ -216,10 +280,161 @@ bool CommonRpcClientHandle::rejectNotSubscribedSignal(const std::string &path, c
 	if(most_explicit_subs_ix >= 0) {
 		logSubscriptionsD() << "\t found subscription:" << m_subscriptions.at(most_explicit_subs_ix).toString();
 		m_subscriptions.erase(m_subscriptions.begin() + most_explicit_subs_ix);
+		pruneSignalStates();
 		return true;
 	}
 	logSubscriptionsD() << "\t not found";
 	return false;
 }
 
+bool CommonRpcClientHandle::sendSignal(const Subscription &subs, const std::string &local_path, const cp::RpcValue::MetaData &meta_data, const std::string &data, size_t queue_limit)
+{
+	const SignalPolicy &policy = subs.policy;
+	if(policy.isEmpty()) {
+		// state might be left by policy of other subscription matching the signal before,
+		// signal held there is superseded by this one
+		if(!m_signalStates.empty()) {
+			auto it = m_signalStates.find(std::make_pair(local_path, cp::RpcMessage::method(meta_data).toString()));
+			if(it != m_signalStates.end()) {
+				if(it->second.isPending) {
+					m_pendingSignalCount--;
+					m_signalCounters.coalesced++;
+				}
+				m_signalStates.erase(it);
+			}
+		}
+		sendRawData(meta_data, std::string(data));
+		return false;
+	}
+	SignalState &st = m_signalStates[std::make_pair(local_path, cp::RpcMessage::method(meta_data).toString())];
+	st.policy = policy;
+	if(policy.deadband > 0) {
+		double val;
+		if(signal_numeric_value(meta_data, data, val)) {
+			if(st.hasLastValue && std::fabs(val - st.lastValue) < policy.deadband) {
+				m_signalCounters.dropped++;
+				return false;
+			}
+			st.lastValue = val;
+			st.hasLastValue = true;
+		}
+	}
+	int64_t now = now_msec();
+	bool hold = (policy.minInterval > 0 && st.lastSentMsec >= 0 && now - st.lastSentMsec < policy.minInterval)
+			|| (policy.coalesce && pendingBytesToWrite() > queue_limit);
+	if(st.isPending) {
+		// held signal is stale now, it will be never encoded
+		m_signalCounters.coalesced++;
+	}
+	if(hold) {
+		if(!st.isPending)
+			m_pendingSignalCount++;
+		st.isPending = true;
+		st.pendingMetaData.reset(new cp::RpcValue::MetaData(meta_data));
+		st.pendingData = data;
+		return true;
+	}
+	if(st.isPending) {
+		st.isPending = false;
+		st.pendingMetaData.reset();
+		st.pendingData = std::string();
+		m_pendingSignalCount--;
+	}
+	st.lastSentMsec = now;
+	sendRawData(meta_data, std::string(data));
+	return false;
+}
+
+bool CommonRpcClientHandle::flushPendingSignals(size_t queue_limit)
+{
+	if(m_pendingSignalCount == 0)
+		return false;
+	int64_t now = now_msec();
+	bool queue_full = pendingBytesToWrite() > queue_limit;
+	for(auto &kv : m_signalStates) {
+		SignalState &st = kv.second;
+		if(!st.isPending)
+			continue;
+		if(st.policy.minInterval > 0 && now - st.lastSentMsec < st.policy.minInterval)
+			continue;
+		if(st.policy.coalesce && queue_full)
+			continue;
+		st.isPending = false;
+		st.lastSentMsec = now;
+		m_pendingSignalCount--;
+		std::string data;
+		data.swap(st.pendingData);
+		std::unique_ptr<cp::RpcValue::MetaData> meta_data = std::move(st.pendingMetaData);
+		sendRawData(*meta_data, std::move(data));
+		queue_full = pendingBytesToWrite() > queue_limit;
+	}
+	return m_pendingSignalCount > 0;
+}
+
+void CommonRpcClientHandle::pruneSignalStates()
+{
+	for(auto it = m_signalStates.begin(); it != m_signalStates.end(); ) {
+		if(isSubscribed(it->first.first, it->first.second) < 0) {
+			if(it->second.isPending)
+				m_pendingSignalCount--;
+			it = m_signalStates.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void CommonRpcClientHandle::releaseSignalStates(const Subscription &subs)
+{
+	for(auto it = m_signalStates.begin(); it != m_signalStates.end(); ) {
+		if(!subs.match(it->first.first, it->first.second)) {
+			++it;
+			continue;
+		}
+		SignalState &st = it->second;
+		if(st.isPending) {
+			m_pendingSignalCount--;
+			std::unique_ptr<cp::RpcValue::MetaData> meta_data = std::move(st.pendingMetaData);
+			sendRawData(*meta_data, std::move(st.pendingData));
+		}
+		it = m_signalStates.erase(it);
+	}
+}
+
+size_t CommonRpcClientHandle::pendingBytesToWrite()
+{
+	shv::chainpack::RpcDriver *driver = rpcDriver();
+	return driver? driver->pendingBytesToWrite(): 0;
+}
+
+shv::chainpack::RpcValue CommonRpcClientHandle::metricsToRpcValue()
+{
+	shv::chainpack::RpcValue::Map ret;
+	ret["userName"] = loggedUserName();
+	if(shv::chainpack::RpcDriver *driver = rpcDriver()) {
+		const shv::chainpack::RpcDriver::TrafficCounters &traffic = driver->trafficCounters();
+		ret["bytesIn"] = traffic.bytesRead;
+		ret["bytesOut"] = traffic.bytesWritten;
+		ret["messagesIn"] = traffic.messagesReceived;
+		ret["messagesOut"] = traffic.messagesSent;
+		ret["sendQueueLength"] = static_cast<uint64_t>(driver->sendQueueLength());
+		ret["sendQueueBytes"] = static_cast<uint64_t>(driver->sendQueueBytes());
+	}
+	ret["signalsUnrouted"] = m_signalCounters.unrouted;
+	ret["signalsRejected"] = m_signalCounters.rejected;
+	ret["signalsCoalesced"] = m_signalCounters.coalesced;
+	ret["signalsDropped"] = m_signalCounters.dropped;
+	ret["signalsPending"] = static_cast<uint64_t>(m_pendingSignalCount);
+	ret["subscriptions"] = static_cast<uint64_t>(subscriptionCount());
+	return ret;
+}
+
+void CommonRpcClientHandle::resetMetrics()
+{
+	if(shv::chainpack::RpcDriver *driver = rpcDriver())
+		driver->resetTrafficCounters();
+	m_signalCounters = SignalCounters();
+}
+
 }}}
@@ -1,21 +1,44 @@
 #pragma once
 
+#include "../shvbrokerglobal.h"
+
 #include <shv/chainpack/rpcmessage.h>
 
+#include <map>
+#include <memory>
+
 namespace shv { namespace core { class StringView; }}
+namespace shv { namespace chainpack { class RpcDriver; }}
 
 namespace shv {
 namespace broker {
 namespace rpc {
 
-class CommonRpcClientHandle
+class SHVBROKER_DECL_EXPORT CommonRpcClientHandle
 {
 public:
+	/// optional limits of signals sent to subscriber, configured in subscribe params or broker config
+	struct SignalPolicy
+	{
+		/// minimal interval in msec between two signals with the same path and method,
+		/// signals coming faster are held and only the latest one is sent when interval elapses
+		int minInterval = 0;
+		/// when send queue is backed up, hold signals and send the latest one per path and method
+		/// after the queue drains
+		bool coalesce = false;
+		/// drop numeric values which differ from the last accepted one less than deadband
+		double deadband = 0;
+
+		bool isEmpty() const {return minInterval <= 0 && !coalesce && deadband <= 0;}
+		bool operator==(const SignalPolicy &o) const {return minInterval == o.minInterval && coalesce == o.coalesce && deadband == o.deadband;}
+		shv::chainpack::RpcValue toRpcValue() const;
+	};
 	struct Subscription
 	{
 		std::string localPath;
 		std::string subscribedPath;
 		std::string method;
+		SignalPolicy policy;
 		//bool isRelative = false;
 
 		Subscription() {}
@@ -48,8 +71,59 @@ public:
 
 	virtual void sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, std::string &&data) = 0;
 	virtual void sendMessage(const shv::chainpack::RpcMessage &rpc_msg) = 0;
+
+	/// driver of connection, its traffic counters and send queue are used for metrics and signal coalescing
+	virtual shv::chainpack::RpcDriver* rpcDriver() {return nullptr;}
+
+	/// send signal matching subs with its policy applied
+	/// @param local_path signal path on this broker, meta_data contain path translated for subscriber
+	/// @param queue_limit outgoing backlog limit (send queue and socket bytes), coalescing subscriptions hold signals above it
+	/// @return true if signal is held to be sent by flushPendingSignals() later
+	bool sendSignal(const Subscription &subs, const std::string &local_path, const shv::chainpack::RpcValue::MetaData &meta_data, const std::string &data, size_t queue_limit);
+	/// send held signals whose interval elapsed, coalescing ones only if outgoing backlog is below queue_limit
+	/// @return true if some signals are still held
+	bool flushPendingSignals(size_t queue_limit);
+	size_t pendingSignalCount() const {return m_pendingSignalCount;}
+
+	struct SignalCounters
+	{
+		/// signal received from this connection was not subscribed by any client
+		uint64_t unrouted = 0;
+		/// not subscribed signal was rejected back to slave broker
+		uint64_t rejected = 0;
+		/// signal for this connection was replaced by newer one before it was sent
+		uint64_t coalesced = 0;
+		/// signal for this connection was filtered out by deadband
+		uint64_t dropped = 0;
+	};
+	SignalCounters& signalCounters() {return m_signalCounters;}
+
+	/// connection traffic, send queue and signal counters snapshot
+	shv::chainpack::RpcValue metricsToRpcValue();
+	void resetMetrics();
+protected:
+	void pruneSignalStates();
+	/// send signals held for subs and forget their state, called when subs policy changes
+	void releaseSignalStates(const Subscription &subs);
+	/// send queue and transport bytes of rpcDriver(), 0 without driver
+	size_t pendingBytesToWrite();
 protected:
 	std::vector<Subscription> m_subscriptions;
+	SignalCounters m_signalCounters;
+private:
+	struct SignalState
+	{
+		int64_t lastSentMsec = -1;
+		double lastValue = 0;
+		bool hasLastValue = false;
+		bool isPending = false;
+		SignalPolicy policy;
+		std::unique_ptr<shv::chainpack::RpcValue::MetaData> pendingMetaData;
+		std::string pendingData;
+	};
+	/// key is local signal path and method
+	std::map<std::pair<std::string, std::string>, SignalState> m_signalStates;
+	size_t m_pendingSignalCount = 0;
 };
 
 }}}
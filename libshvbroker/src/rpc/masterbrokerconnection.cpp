@@ -76,6 +76,7 @@ void MasterBrokerConnection::sendRawData(const shv::chainpack::RpcValue::MetaDat
 				<< "client id:" << connectionId()
 				<< "protocol_type:" << (int)protocolType() << shv::chainpack::Rpc::protocolTypeToString(protocolType())
 				<< RpcDriver::dataToPrettyCpon(shv::chainpack::RpcMessage::protocolType(meta_data), meta_data, data, 0);
+	BrokerMetrics::StageTimer encode_timer(BrokerApp::instance()->metrics(), BrokerMetrics::Stage::Encode);
 	Super::sendRawData(meta_data, std::move(data));
 }
 
@@ -154,6 +155,7 @@ void MasterBrokerConnection::onRpcDataReceived(shv::chainpack::Rpc::ProtocolType
 				Q_EMIT masterBrokerIdReceived(cp::RpcResponse(cp::RpcMessage(rpc_val)));
 			}
 		}
+		BrokerApp::instance()->metrics().record(BrokerMetrics::Stage::Decode, lastMetaDataDecodeNsec());
 		BrokerApp::instance()->onRpcDataReceived(connectionId(), protocol_type, std::move(md), std::move(msg_data));
 	}
 	catch (std::exception &e) {
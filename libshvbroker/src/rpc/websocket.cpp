@@ -2,6 +2,7 @@
 
 #include <shv/coreqt/log.h>
 
+#include <QUrlQuery>
 #include <QWebSocket>
 
 namespace shv {
@@ -13,27 +14,37 @@ WebSocket::WebSocket(QWebSocket *socket, QObject *parent)
 	, m_socket(socket)
 {
 	m_socket->setParent(this);
+	// capacity reserved, so the buffer is not reallocated after every message sent
+	m_writeBuffer.reserve(4096);
 
 	connect(m_socket, &QWebSocket::connected, this, &Socket::connected);
 	connect(m_socket, &QWebSocket::disconnected, this, &Socket::disconnected);
 	connect(m_socket, &QWebSocket::textMessageReceived, this, &WebSocket::onTextMessageReceived);
 	connect(m_socket, &QWebSocket::binaryMessageReceived, this, &WebSocket::onBinaryMessageReceived);
-	connect(m_socket, &QWebSocket::bytesWritten, this, &Socket::bytesWritten);
+	connect(m_socket, &QWebSocket::bytesWritten, this, &WebSocket::onBytesWritten);
 	connect(m_socket, &QWebSocket::stateChanged, this, &Socket::stateChanged);
 	connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), this, &Socket::error);
 	connect(m_socket, &QWebSocket::sslErrors, this, &Socket::sslErrors);
+	// queued, to let the RPC driver write all its pending frames before the batch is sent
+	connect(this, &WebSocket::flushRequested, this, &WebSocket::onFlushRequested, Qt::QueuedConnection);
 }
 
 void WebSocket::connectToHost(const QString &host_name, quint16 port)
 {
 	QUrl url(host_name);
 	url.setPort(port);
+	if(m_messageBatchingEnabled) {
+		QUrlQuery query(url);
+		query.addQueryItem(BATCH_MESSAGES_QUERY_ITEM, QStringLiteral("1"));
+		url.setQuery(query);
+	}
 	shvInfo() << "connecting to:" << url.toString();
 	m_socket->open(url);
 }
 
 void WebSocket::close()
 {
+	flushWriteBuffer();
 	m_socket->close();
 }
 
@@ -64,31 +75,74 @@ quint16 WebSocket::peerPort() const
 
 QByteArray WebSocket::readAll()
 {
-	QByteArray ret = m_readBuffer;
-	m_readBuffer.clear();
+	QByteArray ret;
+	ret.swap(m_readBuffer);
 	return ret;
 }
 
 qint64 WebSocket::write(const char *data, qint64 data_size)
 {
-	QByteArray ba(data, static_cast<int>(data_size));
-	m_writeBuffer.append(ba);
+	m_writeBuffer.append(data, static_cast<int>(data_size));
 	return data_size;
 }
 
+qint64 WebSocket::bytesToWrite() const
+{
+	return m_unsentBytes + m_writeBuffer.size();
+}
+
+void WebSocket::onBytesWritten(qint64 bytes)
+{
+	// reported bytes include WebSocket frame headers
+	m_unsentBytes = qMax<qint64>(0, m_unsentBytes - bytes);
+	emit bytesWritten(bytes);
+}
+
 void WebSocket::writeMessageBegin()
 {
 	shvDebug() << __FUNCTION__;
-	m_writeBuffer.clear();
+	m_isWritingMessage = true;
+	if(!m_messageBatchingEnabled)
+		m_writeBuffer.resize(0);
 }
 
 void WebSocket::writeMessageEnd()
 {
 	shvDebug() << __FUNCTION__ << "message len:" << m_writeBuffer.size() << "\n" << m_writeBuffer;
+	m_isWritingMessage = false;
+	if(!m_messageBatchingEnabled) {
+		flushWriteBuffer();
+		m_socket->flush();
+		return;
+	}
+	if(m_writeBuffer.size() >= MAX_BATCH_SIZE) {
+		flushWriteBuffer();
+	}
+	else {
+		// let the driver write next frame from its queue before the batch is sent
+		emit bytesWritten(0);
+		emit flushRequested(++m_writeSeq);
+	}
+}
+
+void WebSocket::onFlushRequested(quint64 write_seq)
+{
+	// more frames were written after this request, newer one is pending
+	if(write_seq != m_writeSeq)
+		return;
+	flushWriteBuffer();
+}
+
+void WebSocket::flushWriteBuffer()
+{
+	if(m_writeBuffer.isEmpty() || m_isWritingMessage)
+		return;
 	qint64 n = m_socket->sendBinaryMessage(m_writeBuffer);
 	if(n < m_writeBuffer.size())
 		shvError() << "Send message error, only" << n << "bytes written.";
-	m_socket->flush();
+	if(n > 0)
+		m_unsentBytes += n;
+	m_writeBuffer.resize(0);
 }
 
 void WebSocket::ignoreSslErrors()
@@ -99,14 +153,23 @@ void WebSocket::ignoreSslErrors()
 void WebSocket::onTextMessageReceived(const QString &message)
 {
 	shvDebug() << "text message received:" << message;
-	m_readBuffer.append(message.toUtf8());
+	// QWebSocket decodes text frames to QString, UTF-8 bytes are not available without conversion,
+	// converted bytes are not copied again when read buffer is empty
+	if(m_readBuffer.isEmpty())
+		m_readBuffer = message.toUtf8();
+	else
+		m_readBuffer.append(message.toUtf8());
 	emit readyRead();
 }
 
 void WebSocket::onBinaryMessageReceived(const QByteArray &message)
 {
 	shvDebug() << "binary message received:" << message;
-	m_readBuffer.append(message);
+	// implicitly shared, not copied, when read buffer is empty
+	if(m_readBuffer.isEmpty())
+		m_readBuffer = message;
+	else
+		m_readBuffer.append(message);
 	emit readyRead();
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../shvbrokerglobal.h"
+
 #include <shv/iotqt/rpc/socket.h>
 
 class QWebSocket;
@@ -8,14 +10,24 @@ namespace shv {
 namespace broker {
 namespace rpc {
 
-class WebSocket : public shv::iotqt::rpc::Socket
+class SHVBROKER_DECL_EXPORT WebSocket : public shv::iotqt::rpc::Socket
 {
 	Q_OBJECT
 
 	using Super = shv::iotqt::rpc::Socket;
+public:
+	/// URL query item used by client to ask for batched messages
+	static constexpr const char *BATCH_MESSAGES_QUERY_ITEM = "batchMessages";
+	/// batch is sent when it grows over this size even if more RPC frames are pending
+	static constexpr int MAX_BATCH_SIZE = 64 * 1024;
 public:
 	WebSocket(QWebSocket *socket, QObject *parent = nullptr);
 
+	/// RPC frames written in one event loop iteration are sent in one WebSocket message,
+	/// peer must read WebSocket messages as a byte stream of RPC frames
+	bool isMessageBatchingEnabled() const {return m_messageBatchingEnabled;}
+	void setMessageBatchingEnabled(bool b) {m_messageBatchingEnabled = b;}
+
 	void connectToHost(const QString &host_name, quint16 port) override;
 	void close() override;
 	void abort() override;
@@ -25,16 +37,31 @@ public:
 	quint16 peerPort() const override;
 	QByteArray readAll() override;
 	qint64 write(const char *data, qint64 data_size) override;
+	/// QWebSocket does not expose its socket buffer, sent bytes are tracked by bytesWritten()
+	qint64 bytesToWrite() const override;
 	void writeMessageBegin() override;
 	void writeMessageEnd() override;
 	void ignoreSslErrors() override;
+
+	/// emitted after every RPC frame written in batching mode, delivered queued
+	Q_SIGNAL void flushRequested(quint64 write_seq);
 private:
 	void onTextMessageReceived(const QString &message);
 	void onBinaryMessageReceived(const QByteArray &message);
+
+	void onFlushRequested(quint64 write_seq);
+	void onBytesWritten(qint64 bytes);
+	void flushWriteBuffer();
 private:
 	QWebSocket *m_socket = nullptr;
 	QByteArray m_readBuffer;
 	QByteArray m_writeBuffer;
+	bool m_messageBatchingEnabled = false;
+	bool m_isWritingMessage = false;
+	/// incremented by every written RPC frame, pending flush is postponed while it changes
+	quint64 m_writeSeq = 0;
+	/// bytes passed to QWebSocket, but not reported by its bytesWritten() yet
+	qint64 m_unsentBytes = 0;
 };
 
 }}}
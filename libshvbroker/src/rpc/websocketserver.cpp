@@ -10,6 +10,7 @@
 #include <QFile>
 #include <QDir>
 #include <QSslKey>
+#include <QUrlQuery>
 #include <QWebSocket>
 
 namespace shv {
@@ -67,7 +68,10 @@ ClientConnectionOnBroker *WebSocketServer::connectionById(int connection_id)
 
 ClientConnectionOnBroker *WebSocketServer::createServerConnection(QWebSocket *socket, QObject *parent)
 {
-	return new ClientConnectionOnBroker(new WebSocket(socket), parent);
+	WebSocket *ws = new WebSocket(socket);
+	// peer reading WebSocket messages as a byte stream can ask to batch RPC frames
+	ws->setMessageBatchingEnabled(QUrlQuery(socket->requestUrl()).queryItemValue(WebSocket::BATCH_MESSAGES_QUERY_ITEM) == QLatin1String("1"));
+	return new ClientConnectionOnBroker(ws, parent);
 }
 
 void WebSocketServer::onNewConnection()
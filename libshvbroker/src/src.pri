@@ -9,6 +9,8 @@ HEADERS += \
     $$PWD/aclmanagersqlite.h \
     $$PWD/brokeraclnode.h \
     $$PWD/brokerappnode.h \
+    $$PWD/brokermetrics.h \
+    $$PWD/brokermetricsnode.h \
     $$PWD/currentclientshvnode.h \
     $$PWD/shvbrokerglobal.h \
     $$PWD/appclioptions.h \
@@ -30,6 +32,8 @@ SOURCES += \
     $$PWD/brokerapp.cpp \
     $$PWD/aclmanager.cpp \
     $$PWD/brokerappnode.cpp \
+    $$PWD/brokermetrics.cpp \
+    $$PWD/brokermetricsnode.cpp \
     $$PWD/currentclientshvnode.cpp \
     $$PWD/subscriptionsnode.cpp \
     $$PWD/clientconnectionnode.cpp \
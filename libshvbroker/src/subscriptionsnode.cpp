@@ -23,6 +23,7 @@ const char ND_BY_PATH[] = "byPath";
 
 const char METH_PATH[] = "path";
 const char METH_METHOD[] = "method";
+const char METH_POLICY[] = "policy";
 
 std::vector<cp::MetaMethod> meta_methods1 {
 	{cp::Rpc::METH_DIR, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::None},
@@ -32,6 +33,7 @@ std::vector<cp::MetaMethod> meta_methods2 {
 	{cp::Rpc::METH_DIR, cp::MetaMethod::Signature::RetParam, false},
 	{METH_PATH, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter},
 	{METH_METHOD, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter},
+	{METH_POLICY, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter},
 };
 }
 
@@ -85,7 +87,7 @@ shv::iotqt::node::ShvNode::StringList SubscriptionsNode::childNames(const String
 shv::chainpack::RpcValue SubscriptionsNode::callMethod(const StringViewList &shv_path, const std::string &method, const shv::chainpack::RpcValue &params)
 {
 	if(shv_path.size() == 2) {
-		if(method == METH_PATH || method == METH_METHOD) {
+		if(method == METH_PATH || method == METH_METHOD || method == METH_POLICY) {
 			const rpc::ClientConnectionOnBroker::Subscription *subs = nullptr;
 			if(shv_path.at(0) == ND_BY_ID) {
 				subs = &m_client->subscriptionAt(std::stoul(shv_path.at(1).toString()));
@@ -107,6 +109,8 @@ shv::chainpack::RpcValue SubscriptionsNode::callMethod(const StringViewList &shv
 				return subs->localPath;
 			if(method == METH_METHOD)
 				return subs->method;
+			if(method == METH_POLICY)
+				return subs->policy.toRpcValue();
 		}
 	}
 	return Super::callMethod(shv_path, method, params);
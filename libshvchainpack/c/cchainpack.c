@@ -162,9 +162,65 @@ static int bytes_needed(int bit_len)
                     n == 15 -> for future (number of bytes will be specified in next byte)
 */
 
+#if defined(__GNUC__) && __GNUC__ >= 4 && defined(__BYTE_ORDER__) && !defined(CCHAINPACK_NO_VARINT_FAST_PATH)
+#define CCHAINPACK_VARINT_FAST_PATH
+#endif
+
+#ifdef CCHAINPACK_VARINT_FAST_PATH
+
+// longest UInt handled by fast path, head byte + 8 bytes of 64 bit number
+#define VARINT_FAST_PATH_BYTES_MAX 9
+
+static inline uint64_t load_be64(const char *p)
+{
+	uint64_t n;
+	memcpy(&n, p, sizeof(n));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	n = __builtin_bswap64(n);
+#endif
+	return n;
+}
+
+static inline void store_be64(char *p, uint64_t n)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	n = __builtin_bswap64(n);
+#endif
+	memcpy(p, &n, sizeof(n));
+}
+
+// write whole UInt with single 8 bytes store, caller must ensure VARINT_FAST_PATH_BYTES_MAX bytes of buffer space
+static inline int pack_uint_data_fast(char *p, uint64_t num, int byte_cnt, int bit_len)
+{
+	uint64_t head;
+	if(bit_len <= 28) {
+		// byte_cnt - 1 leading ones followed by zero
+		head = (uint64_t)(0xff00 >> (byte_cnt - 1)) & 0xff;
+	}
+	else if(byte_cnt < VARINT_FAST_PATH_BYTES_MAX) {
+		head = 0xf0 | (byte_cnt - 5);
+	}
+	else {
+		*p = (char)(0xf0 | (byte_cnt - 5));
+		store_be64(p + 1, num);
+		return byte_cnt;
+	}
+	// bytes behind byte_cnt are written too, they are overwritten by the next item
+	store_be64(p, (num | (head << (8 * (byte_cnt - 1)))) << (8 * (8 - byte_cnt)));
+	return byte_cnt;
+}
+
+#endif /* CCHAINPACK_VARINT_FAST_PATH */
+
 static void pack_uint_data_helper(ccpcp_pack_context* pack_context, uint64_t num, int bit_len)
 {
 	int byte_cnt = bytes_needed(bit_len);
+#ifdef CCHAINPACK_VARINT_FAST_PATH
+	if(pack_context->err_no == CCPCP_RC_OK && pack_context->end - pack_context->current >= VARINT_FAST_PATH_BYTES_MAX) {
+		pack_context->current += pack_uint_data_fast(pack_context->current, num, byte_cnt, bit_len);
+		return;
+	}
+#endif
 	uint8_t bytes[byte_cnt];
 	int i;
 	for (i = byte_cnt-1; i >= 0; --i) {
@@ -485,6 +541,39 @@ static void unpack_uint(ccpcp_unpack_context* unpack_context, uint64_t *pval, in
 	uint64_t num = 0;
 	int bitlen = 0;
 
+#ifdef CCHAINPACK_VARINT_FAST_PATH
+	if(unpack_context->end - unpack_context->current >= VARINT_FAST_PATH_BYTES_MAX) {
+		// whole UInt is in the buffer, decode it from single 8 bytes load
+		const char *p = unpack_context->current;
+		uint64_t w = load_be64(p);
+		uint8_t head = (uint8_t)(w >> 56);
+		int byte_cnt = 0;
+		if((head & 0xf0) != 0xf0) {
+			// number of leading ones in head is number of bytes following
+			byte_cnt = __builtin_clzll(~w) + 1;
+			bitlen = 7 * byte_cnt;
+			num = (w >> (8 * (8 - byte_cnt))) & (((uint64_t)1 << bitlen) - 1);
+		}
+		else if((head & 0xf) <= 8 - 4) {
+			int bytes_to_read_cnt = (head & 0xf) + 4;
+			byte_cnt = bytes_to_read_cnt + 1;
+			bitlen = bytes_to_read_cnt * 8;
+			num = load_be64(p + 1);
+			if(bytes_to_read_cnt < 8)
+				num >>= 8 * (8 - bytes_to_read_cnt);
+		}
+		if(byte_cnt > 0) {
+			unpack_context->current = p + byte_cnt;
+			if(pval)
+				*pval = num;
+			if(pbitlen)
+				*pbitlen = bitlen;
+			return;
+		}
+		// numbers longer than 64 bits are left to the byte path
+	}
+#endif
+
 	const char *p;
 	UNPACK_TAKE_BYTE();
 	uint8_t head = *p;
@@ -2,6 +2,10 @@ message("including $$PWD")
 
 QT -= core gui
 
+with-shvrpctracing {
+    DEFINES += SHV_RPC_TRACING
+}
+
 CONFIG += C++11
 CONFIG += hide_symbols
 
@@ -1,5 +1,6 @@
 #include "accessgrant.h"
 #include "irpcconnection.h"
+#include "reflect.h"
 
 #include <necrolog.h>
 
@@ -287,6 +288,83 @@ AccessGrant AccessGrant::fromRpcValue(const RpcValue &rpcval)
 	return ret;
 }
 
+// IMap part of user login grant, the other grant types are written as a single value
+SHV_REFLECT_IMAP(AccessGrant,
+	field(AccessGrant::MetaType::Key::Type,
+		[](const C &c) {return static_cast<int>(c.type);},
+		[](C &c, int t) {c.type = static_cast<AccessGrant::Type>(t);}),
+	field(AccessGrant::MetaType::Key::Role, &C::role,
+		[](const C &c) {return c.type != AccessGrant::Type::Role;}),
+	field(AccessGrant::MetaType::Key::AccessLevel, &C::accessLevel,
+		[](const C &c) {return c.type != AccessGrant::Type::AccessLevel;}),
+	field(AccessGrant::MetaType::Key::User,
+		[](const C &c) -> const std::string& {return c.login.user;},
+		[](C &c, std::string &&user) {c.login.user = std::move(user);},
+		[](const C &c) {return c.type != AccessGrant::Type::UserLogin;}),
+	field(AccessGrant::MetaType::Key::Password,
+		[](const C &c) -> const std::string& {return c.login.password;},
+		[](C &c, std::string &&password) {c.login.password = std::move(password);},
+		[](const C &c) {return c.type != AccessGrant::Type::UserLogin;}),
+	field(AccessGrant::MetaType::Key::LoginType,
+		[](const C &c) {return static_cast<int>(c.login.loginType);},
+		[](C &c, int t) {c.login.loginType = static_cast<UserLogin::LoginType>(t);},
+		[](const C &c) {return c.type != AccessGrant::Type::UserLogin;})
+)
+
+void shvWriteChainPack(ChainPackWriter &wr, const AccessGrant &grant)
+{
+	switch (grant.type) {
+	case AccessGrant::Type::Invalid:
+		wr.write_p(nullptr);
+		break;
+	case AccessGrant::Type::AccessLevel:
+		wr.write_p(static_cast<int64_t>(grant.accessLevel));
+		break;
+	case AccessGrant::Type::Role:
+		wr.write_p(grant.role);
+		break;
+	case AccessGrant::Type::UserLogin:
+		AccessGrant::MetaType::registerMetaType();
+		wr.writeMetaBegin();
+		wr.write_p(static_cast<int64_t>(meta::Tag::MetaTypeId));
+		wr.write_p(static_cast<int64_t>(AccessGrant::MetaType::ID));
+		wr.writeContainerEnd();
+		reflect::writeReflected(wr, grant);
+		break;
+	}
+}
+
+void shvReadChainPack(ChainPackReader &rd, AccessGrant &grant)
+{
+	// skip meta-data of user login grant
+	RpcValue::MetaData md;
+	rd.read(md);
+	switch (rd.peekNext()) {
+	case CCPCP_ITEM_NULL:
+		rd.unpackNext();
+		grant = AccessGrant();
+		break;
+	case CCPCP_ITEM_INT:
+	case CCPCP_ITEM_UINT:
+		grant = AccessGrant();
+		grant.type = AccessGrant::Type::AccessLevel;
+		reflect::read(rd, grant.accessLevel);
+		break;
+	case CCPCP_ITEM_STRING:
+		grant = AccessGrant();
+		grant.type = AccessGrant::Type::Role;
+		rd.read_p(grant.role);
+		break;
+	case CCPCP_ITEM_IMAP:
+		grant = AccessGrant();
+		reflect::readReflected(rd, grant);
+		break;
+	default:
+		grant = AccessGrant::fromRpcValue(rd.read());
+		break;
+	}
+}
+
 const char *AccessGrant::typeToString(AccessGrant::Type t)
 {
 	switch (t) {
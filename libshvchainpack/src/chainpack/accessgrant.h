@@ -92,5 +92,12 @@ public:
 	static Type typeFromString(const std::string &s);
 };
 
+class ChainPackWriter;
+class ChainPackReader;
+
+/// writes the same bytes as AccessGrant::toRpcValue(), see reflect.h
+SHVCHAINPACK_DECL_EXPORT void shvWriteChainPack(ChainPackWriter &wr, const AccessGrant &grant);
+SHVCHAINPACK_DECL_EXPORT void shvReadChainPack(ChainPackReader &rd, AccessGrant &grant);
+
 } // namespace chainpack
 } // namespace shv
@@ -19,7 +19,9 @@ SOURCES += \
     $$PWD/metamethod.cpp \
     $$PWD/tunnelctl.cpp \
     $$PWD/irpcconnection.cpp \
-    $$PWD/accessgrant.cpp
+    $$PWD/accessgrant.cpp \
+    $$PWD/rpctracer.cpp \
+    $$PWD/rpcvalueview.cpp
 
 HEADERS += \
     $$PWD/datachange.h \
@@ -42,7 +44,10 @@ HEADERS += \
     $$PWD/metamethod.h \
     $$PWD/tunnelctl.h \
     $$PWD/irpcconnection.h \
-    $$PWD/accessgrant.h
+    $$PWD/accessgrant.h \
+    $$PWD/rpctracer.h \
+    $$PWD/reflect.h \
+    $$PWD/rpcvalueview.h
 
 unix {
 SOURCES += \
@@ -51,3 +56,11 @@ SOURCES += \
 HEADERS += \
     $$PWD/socketrpcdriver.h \
 }
+
+linux {
+SOURCES += \
+    $$PWD/epollreactor.cpp \
+
+HEADERS += \
+    $$PWD/epollreactor.h \
+}
@@ -67,7 +67,10 @@ ChainPackReader::ItemType ChainPackReader::peekNext()
 	const char *p = ccpcp_unpack_peek_byte(&m_inCtx);
 	if(!p)
 		PARSE_EXCEPTION("Parse error: " + std::string(m_inCtx.err_msg) + " at: " + std::to_string(m_inCtx.err_no));
-	cchainpack_pack_packing_schema sch = (cchainpack_pack_packing_schema)(uint8_t)(*p);
+	uint8_t b = (uint8_t)(*p);
+	if(b < 128)
+		return (b & 64)? CCPCP_ITEM_INT: CCPCP_ITEM_UINT; // tiny Int / UInt
+	cchainpack_pack_packing_schema sch = (cchainpack_pack_packing_schema)b;
 	switch(sch) {
 	case CP_Null: return CCPCP_ITEM_NULL;
 	case CP_UInt: return CCPCP_ITEM_UINT;
@@ -75,6 +78,7 @@ ChainPackReader::ItemType ChainPackReader::peekNext()
 	case CP_Double: return CCPCP_ITEM_DOUBLE;
 	case CP_Bool: return CCPCP_ITEM_BOOLEAN;
 	case CP_String: return CCPCP_ITEM_STRING;
+	case CP_Blob: return CCPCP_ITEM_BLOB;
 	case CP_List: return CCPCP_ITEM_LIST;
 	case CP_Map: return CCPCP_ITEM_MAP;
 	case CP_IMap: return CCPCP_ITEM_IMAP;
@@ -101,6 +105,115 @@ uint64_t ChainPackReader::readUIntData(std::istream &in, bool *ok)
 	return rd.readUIntData(ok);
 }
 
+ChainPackReader::ItemType ChainPackReader::unpackScalar()
+{
+	RpcValue::MetaData md;
+	read(md);
+	ItemType t = peekNext();
+	if(t == CCPCP_ITEM_LIST || t == CCPCP_ITEM_MAP || t == CCPCP_ITEM_IMAP) {
+		RpcValue skipped;
+		read(skipped);
+		return CCPCP_ITEM_INVALID;
+	}
+	t = unpackNext();
+	if(t == CCPCP_ITEM_CONTAINER_END)
+		PARSE_EXCEPTION("Unexpected container end.");
+	return t;
+}
+
+void ChainPackReader::read_p(bool &val)
+{
+	if(unpackScalar() == CCPCP_ITEM_BOOLEAN)
+		val = m_inCtx.item.as.Bool;
+}
+
+void ChainPackReader::read_p(int64_t &val)
+{
+	switch(unpackScalar()) {
+	case CCPCP_ITEM_INT: val = m_inCtx.item.as.Int; break;
+	case CCPCP_ITEM_UINT: val = static_cast<int64_t>(m_inCtx.item.as.UInt); break;
+	case CCPCP_ITEM_BOOLEAN: val = m_inCtx.item.as.Bool; break;
+	default: break;
+	}
+}
+
+void ChainPackReader::read_p(uint64_t &val)
+{
+	switch(unpackScalar()) {
+	case CCPCP_ITEM_INT: val = static_cast<uint64_t>(m_inCtx.item.as.Int); break;
+	case CCPCP_ITEM_UINT: val = m_inCtx.item.as.UInt; break;
+	case CCPCP_ITEM_BOOLEAN: val = m_inCtx.item.as.Bool; break;
+	default: break;
+	}
+}
+
+void ChainPackReader::read_p(double &val)
+{
+	switch(unpackScalar()) {
+	case CCPCP_ITEM_DOUBLE: val = m_inCtx.item.as.Double; break;
+	case CCPCP_ITEM_INT: val = static_cast<double>(m_inCtx.item.as.Int); break;
+	case CCPCP_ITEM_UINT: val = static_cast<double>(m_inCtx.item.as.UInt); break;
+	case CCPCP_ITEM_DECIMAL: val = RpcValue::Decimal(m_inCtx.item.as.Decimal.mantisa, m_inCtx.item.as.Decimal.exponent).toDouble(); break;
+	default: break;
+	}
+}
+
+void ChainPackReader::read_p(std::string &val)
+{
+	ItemType t = unpackScalar();
+	if(t != CCPCP_ITEM_STRING && t != CCPCP_ITEM_BLOB)
+		return;
+	ccpcp_string *it = &(m_inCtx.item.as.String);
+	val.clear();
+	while(true) {
+		val.append(it->chunk_start, it->chunk_size);
+		if(it->last_chunk)
+			break;
+		unpackNext();
+		if(m_inCtx.item.type != t)
+			PARSE_EXCEPTION("Unfinished string");
+	}
+}
+
+void ChainPackReader::read_p(RpcValue::DateTime &val)
+{
+	if(unpackScalar() == CCPCP_ITEM_DATE_TIME) {
+		auto *it = &(m_inCtx.item.as.DateTime);
+		val = RpcValue::DateTime::fromMSecsSinceEpoch(it->msecs_since_epoch, it->minutes_from_utc);
+	}
+}
+
+bool ChainPackReader::readContainerBegin(ItemType container_type)
+{
+	if(container_type == CCPCP_ITEM_META) {
+		if(peekNext() != CCPCP_ITEM_META)
+			return false;
+		unpackNext();
+		return true;
+	}
+	RpcValue::MetaData md;
+	read(md);
+	ItemType t = peekNext();
+	if(t == container_type) {
+		unpackNext();
+		return true;
+	}
+	if(t == CCPCP_ITEM_NULL) {
+		unpackNext();
+		return false;
+	}
+	PARSE_EXCEPTION(std::string("Expected ") + itemTypeToString(container_type) + ", got: " + itemTypeToString(t));
+	return false;
+}
+
+bool ChainPackReader::readContainerEnd()
+{
+	if(peekNext() != CCPCP_ITEM_CONTAINER_END)
+		return false;
+	unpackNext();
+	return true;
+}
+
 void ChainPackReader::read(RpcValue &val)
 {
 	//if (m_depth > MAX_RECURSION_DEPTH)
@@ -28,7 +28,24 @@ public:
 	ItemType peekNext();
 	ItemType unpackNext();
 	static const char* itemTypeToString(ItemType it);
+
+	/// Typed readers, they do not create RpcValue.
+	/// Meta-data of read value is skipped,
+	/// null or value of incompatible type leaves value unchanged.
+	void read_p(bool &val);
+	void read_p(int64_t &val);
+	void read_p(uint64_t &val);
+	void read_p(double &val);
+	void read_p(std::string &val);
+	void read_p(RpcValue::DateTime &val);
+	/// reads begin of container_type, meta-data are skipped unless container_type is CCPCP_ITEM_META
+	/// returns false if null or no meta-data is found instead
+	bool readContainerBegin(ItemType container_type);
+	/// returns true and consumes container end if it is next item
+	bool readContainerEnd();
 private:
+	ItemType unpackScalar();
+
 	void parseList(RpcValue &val);
 	void parseMetaData(RpcValue::MetaData &meta_data);
 	void parseMap(RpcValue &val);
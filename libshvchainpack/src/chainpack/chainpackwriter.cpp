@@ -114,6 +114,11 @@ void ChainPackWriter::writeRawData(const std::string &data)
 	ccpcp_pack_copy_bytes(&m_outCtx, data.data(), data.size());
 }
 
+void ChainPackWriter::writeMetaBegin()
+{
+	cchainpack_pack_meta_begin(&m_outCtx);
+}
+
 ChainPackWriter &ChainPackWriter::write_p(std::nullptr_t)
 {
 	cchainpack_pack_null(&m_outCtx);
@@ -174,6 +179,12 @@ ChainPackWriter &ChainPackWriter::write_p(const std::string &value)
 	return *this;
 }
 
+ChainPackWriter &ChainPackWriter::write_p(const char *value)
+{
+	cchainpack_pack_string(&m_outCtx, value, strlen(value));
+	return *this;
+}
+
 ChainPackWriter &ChainPackWriter::write_p(const RpcValue::Blob &value)
 {
 	cchainpack_pack_blob(&m_outCtx, value.data(), value.size());
@@ -29,7 +29,10 @@ public:
 	void writeMapElement(const std::string &key, const RpcValue &val) override;
 	void writeMapElement(RpcValue::Int key, const RpcValue &val) override;
 	void writeRawData(const std::string &data) override;
-private:
+	/// meta-data map begin, close it with writeContainerEnd()
+	void writeMetaBegin();
+
+	/// typed writers, they do not create RpcValue
 	ChainPackWriter& write_p(std::nullptr_t);
 	ChainPackWriter& write_p(bool value);
 	ChainPackWriter& write_p(int32_t value);
@@ -40,6 +43,7 @@ private:
 	ChainPackWriter& write_p(RpcValue::Decimal value);
 	ChainPackWriter& write_p(RpcValue::DateTime value);
 	ChainPackWriter& write_p(const std::string &value);
+	ChainPackWriter& write_p(const char *value);
 	ChainPackWriter& write_p(const RpcValue::Blob &value);
 	ChainPackWriter& write_p(const RpcValue::List &values);
 	//ChainPackWriter& write_p(const RpcValue::Array &values);
@@ -1,4 +1,6 @@
 #include "datachange.h"
+#include "chainpackreader.h"
+#include "chainpackwriter.h"
 
 #include <necrolog.h>
 
@@ -103,6 +105,59 @@ set_meta_data:
 	return DataChange(val, RpcValue::DateTime());
 }
 
+void shvWriteChainPack(ChainPackWriter &wr, const DataChange &data_change)
+{
+	wr.writeMetaBegin();
+	wr.write_p(static_cast<int64_t>(meta::Tag::MetaTypeId));
+	wr.write_p(static_cast<int64_t>(DataChange::MetaType::ID));
+	if(data_change.hasDateTime()) {
+		wr.write_p(static_cast<int64_t>(DataChange::MetaType::Tag::DateTime));
+		wr.write_p(data_change.m_dateTime);
+	}
+	if(data_change.hasShortTime()) {
+		wr.write_p(static_cast<int64_t>(DataChange::MetaType::Tag::ShortTime));
+		wr.write_p(static_cast<uint64_t>(data_change.m_shortTime));
+	}
+	wr.writeContainerEnd();
+	const RpcValue &val = data_change.m_value;
+	if(!val.isValid()) {
+		wr.write_p(nullptr);
+	}
+	else if(val.metaData().isEmpty()) {
+		wr.write(val);
+	}
+	else {
+		wr.writeContainerBegin(RpcValue::Type::List);
+		wr.write(val);
+		wr.writeContainerEnd();
+	}
+}
+
+void shvReadChainPack(ChainPackReader &rd, DataChange &data_change)
+{
+	// meta-data are few ints, value is RpcValue anyway
+	RpcValue::MetaData md;
+	rd.read(md);
+	RpcValue val;
+	rd.read(val);
+	if(md.metaTypeId() != DataChange::MetaType::ID || md.metaTypeNameSpaceId() != meta::GlobalNS::ID) {
+		if(!md.isEmpty())
+			val.setMetaData(std::move(md));
+		data_change = DataChange(val, RpcValue::DateTime());
+		return;
+	}
+	DataChange ret;
+	if(val.isList() && val.toList().size() == 1 && !val.toList()[0].metaData().isEmpty())
+		ret.setValue(val.toList()[0]);
+	else
+		ret.setValue(val);
+	ret.setDateTime(md.value(DataChange::MetaType::Tag::DateTime));
+	ret.setShortTime(md.value(DataChange::MetaType::Tag::ShortTime));
+	ret.setDomain(md.value(DataChange::MetaType::Tag::Domain).asString());
+	ret.setSampleType(md.value(DataChange::MetaType::Tag::SampleType).toInt());
+	data_change = std::move(ret);
+}
+
 RpcValue DataChange::toRpcValue() const
 {
 	RpcValue ret;
@@ -8,6 +8,14 @@
 namespace shv {
 namespace chainpack {
 
+class ChainPackWriter;
+class ChainPackReader;
+class DataChange;
+
+/// writes the same bytes as DataChange::toRpcValue(), see reflect.h
+SHVCHAINPACK_DECL_EXPORT void shvWriteChainPack(ChainPackWriter &wr, const DataChange &data_change);
+SHVCHAINPACK_DECL_EXPORT void shvReadChainPack(ChainPackReader &rd, DataChange &data_change);
+
 class SHVCHAINPACK_DECL_EXPORT DataChange
 {
 public:
@@ -68,6 +76,9 @@ public:
 
 	static DataChange fromRpcValue(const RpcValue &val);
 	RpcValue toRpcValue() const;
+private:
+	friend void shvWriteChainPack(ChainPackWriter &wr, const DataChange &data_change);
+	friend void shvReadChainPack(ChainPackReader &rd, DataChange &data_change);
 private:
 	RpcValue m_value;
 	std::string m_domain;
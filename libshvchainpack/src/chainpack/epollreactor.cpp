@@ -0,0 +1,672 @@
+#include "epollreactor.h"
+#include "exception.h"
+#include "utils.h"
+
+#include <necrolog.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define logReactorD() nCDebug("EpollReactor")
+#define logReactorI() nCInfo("EpollReactor")
+#define logReactorW() nCWarning("EpollReactor")
+#define logRpcRawMsg() nCMessage("RpcRawMsg")
+
+namespace shv {
+namespace chainpack {
+
+namespace {
+
+constexpr uint64_t WAKE_UP_HANDLE = 0;
+constexpr uint32_t SOCKET_EVENTS = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+
+void set_tcp_no_delay(int socket)
+{
+	int flag = 1;
+	::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+bool set_non_blocking(int socket)
+{
+	int flags = ::fcntl(socket, F_GETFL, 0);
+	return flags >= 0 && ::fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+}
+
+//===========================================================================
+// EpollReactor::DecodePool
+//===========================================================================
+class EpollReactor::DecodePool
+{
+public:
+	DecodePool(EpollReactor *reactor, unsigned thread_count)
+		: m_reactor(reactor)
+	{
+		for (unsigned i = 0; i < thread_count; ++i) {
+			m_workers.emplace_back(new Worker());
+			Worker *w = m_workers.back().get();
+			w->thread = std::thread([this, w]() { run(*w); });
+		}
+	}
+	~DecodePool()
+	{
+		for(auto &w : m_workers) {
+			{
+				std::lock_guard<std::mutex> lock(w->mutex);
+				w->stop = true;
+			}
+			w->cond.notify_one();
+		}
+		for(auto &w : m_workers)
+			w->thread.join();
+	}
+
+	unsigned threadCount() const {return static_cast<unsigned>(m_workers.size());}
+
+	void post(uint64_t driver_handle, Rpc::ProtocolType protocol_type, RpcValue::MetaData &&md, std::string &&data)
+	{
+		// all messages of a driver go to the same worker to keep their order
+		Worker &w = *m_workers[driver_handle % m_workers.size()];
+		{
+			std::lock_guard<std::mutex> lock(w.mutex);
+			w.jobs.push_back(Job{driver_handle, protocol_type, std::move(md), std::move(data)});
+		}
+		w.cond.notify_one();
+	}
+private:
+	struct Job
+	{
+		uint64_t driverHandle;
+		Rpc::ProtocolType protocolType;
+		RpcValue::MetaData metaData;
+		std::string data;
+	};
+	struct Worker
+	{
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::deque<Job> jobs;
+		bool stop = false;
+	};
+
+	void run(Worker &w)
+	{
+		while(true) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(w.mutex);
+				w.cond.wait(lock, [&w]() { return w.stop || !w.jobs.empty(); });
+				if(w.stop)
+					return;
+				job = std::move(w.jobs.front());
+				w.jobs.pop_front();
+			}
+			try {
+				RpcValue msg = RpcDriver::decodeData(job.protocolType, job.data, 0);
+				if(msg.isValid()) {
+					msg.setMetaData(std::move(job.metaData));
+					m_reactor->postDecodedMessage(job.driverHandle, std::move(msg));
+				}
+				else {
+					nError() << "Throwing away message with unknown protocol version:" << static_cast<unsigned>(job.protocolType);
+				}
+			}
+			catch (std::exception &e) {
+				nError() << "Decode message error:" << e.what();
+			}
+		}
+	}
+private:
+	EpollReactor *m_reactor;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+//===========================================================================
+// EpollReactor
+//===========================================================================
+constexpr int EpollReactor::MAX_EVENTS;
+
+EpollReactor::EpollReactor(unsigned decode_thread_count)
+{
+	m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+	if(m_epollFd < 0)
+		SHVCHP_EXCEPTION(std::string("epoll_create1 error: ") + ::strerror(errno));
+	m_wakeUpFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(m_wakeUpFd < 0)
+		SHVCHP_EXCEPTION(std::string("eventfd error: ") + ::strerror(errno));
+	epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u64 = WAKE_UP_HANDLE;
+	::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeUpFd, &ev);
+	if(decode_thread_count > 0)
+		m_decodePool.reset(new DecodePool(this, decode_thread_count));
+}
+
+EpollReactor::~EpollReactor()
+{
+	m_decodePool.reset();
+	closeListeners();
+	deletePendingDrivers();
+	while(!m_drivers.empty()) {
+		EpollRpcDriver *driver = m_drivers.begin()->second;
+		driver->m_disconnectedCallback = nullptr;
+		driver->closeConnection();
+	}
+	::close(m_wakeUpFd);
+	::close(m_epollFd);
+}
+
+unsigned EpollReactor::decodeThreadCount() const
+{
+	return m_decodePool? m_decodePool->threadCount(): 0;
+}
+
+void EpollReactor::exec()
+{
+	m_quit = false;
+	while(processEvents(-1))
+		;
+}
+
+bool EpollReactor::processEvents(int timeout_msec)
+{
+	int timer_timeout = fireTimers();
+	int wait_msec = timeout_msec;
+	if(timer_timeout >= 0 && (wait_msec < 0 || timer_timeout < wait_msec))
+		wait_msec = timer_timeout;
+	if(m_quit)
+		return false;
+	epoll_event events[MAX_EVENTS];
+	int n = ::epoll_wait(m_epollFd, events, MAX_EVENTS, wait_msec);
+	if(n < 0 && errno != EINTR) {
+		nError() << "epoll_wait error:" << ::strerror(errno);
+		return false;
+	}
+	for (int i = 0; i < n; ++i) {
+		const uint64_t handle = events[i].data.u64;
+		if(handle == WAKE_UP_HANDLE) {
+			onWakeUp();
+			continue;
+		}
+		// driver can be closed by previous event handler, so always look it up
+		auto it = m_drivers.find(handle);
+		if(it != m_drivers.end()) {
+			it->second->onSocketEvents(events[i].events);
+			continue;
+		}
+		if(m_listeners.count(handle))
+			acceptConnections(handle);
+	}
+	fireTimers();
+	deletePendingDrivers();
+	return !m_quit;
+}
+
+void EpollReactor::quit()
+{
+	m_quit = true;
+	wakeUp();
+}
+
+int EpollReactor::addTimer(int interval_msec, TimerCallback &&callback, bool single_shot)
+{
+	int id = m_nextTimerId++;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(interval_msec);
+	m_timers[id] = Timer{interval_msec, single_shot, std::move(callback), deadline};
+	m_timerQueue.emplace(deadline, id);
+	return id;
+}
+
+void EpollReactor::removeTimer(int timer_id)
+{
+	// queue entry is skipped when timer does not exist anymore
+	m_timers.erase(timer_id);
+}
+
+int EpollReactor::fireTimers()
+{
+	using namespace std::chrono;
+	const steady_clock::time_point now = steady_clock::now();
+	while(!m_timerQueue.empty() && m_timerQueue.begin()->first <= now) {
+		const steady_clock::time_point deadline = m_timerQueue.begin()->first;
+		const int id = m_timerQueue.begin()->second;
+		m_timerQueue.erase(m_timerQueue.begin());
+		auto it = m_timers.find(id);
+		if(it == m_timers.end() || it->second.deadline != deadline)
+			continue;
+		Timer &t = it->second;
+		TimerCallback callback = t.callback;
+		if(t.singleShot) {
+			m_timers.erase(it);
+		}
+		else {
+			t.deadline += milliseconds(t.intervalMsec);
+			if(t.deadline <= now)
+				t.deadline = now + milliseconds(t.intervalMsec);
+			m_timerQueue.emplace(t.deadline, id);
+		}
+		callback();
+	}
+	if(m_timerQueue.empty())
+		return -1;
+	auto msec = duration_cast<milliseconds>(m_timerQueue.begin()->first - steady_clock::now()).count() + 1;
+	return msec < 0? 0: static_cast<int>(msec);
+}
+
+int EpollReactor::listen(const std::string &host, int port, AcceptCallback &&callback)
+{
+	int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(fd < 0) {
+		nError() << "Cannot create listening socket:" << ::strerror(errno);
+		return -1;
+	}
+	int reuse = 1;
+	::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	sockaddr_in addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(static_cast<uint16_t>(port));
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if(!host.empty() && ::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+		nError() << "Invalid listen address:" << host;
+		::close(fd);
+		return -1;
+	}
+	if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+		nError() << "Cannot listen on" << host << "port:" << port << "error:" << ::strerror(errno);
+		::close(fd);
+		return -1;
+	}
+	socklen_t addr_len = sizeof(addr);
+	::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+	uint64_t handle = m_nextHandle++;
+	epoll_event ev;
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.u64 = handle;
+	::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev);
+	m_listeners[handle] = Listener{fd, std::move(callback)};
+	logReactorI() << "listening on port:" << ntohs(addr.sin_port);
+	return ntohs(addr.sin_port);
+}
+
+void EpollReactor::closeListeners()
+{
+	for(const auto &kv : m_listeners) {
+		::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, kv.second.socket, nullptr);
+		::close(kv.second.socket);
+	}
+	m_listeners.clear();
+}
+
+void EpollReactor::acceptConnections(uint64_t listener_handle)
+{
+	while(true) {
+		auto it = m_listeners.find(listener_handle);
+		if(it == m_listeners.end())
+			return;
+		int fd = ::accept4(it->second.socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if(fd < 0) {
+			if(errno == EINTR || errno == ECONNABORTED)
+				continue;
+			if(errno != EAGAIN && errno != EWOULDBLOCK)
+				nError() << "accept error:" << ::strerror(errno);
+			return;
+		}
+		set_tcp_no_delay(fd);
+		logReactorD() << "connection accepted, socket:" << fd;
+		// callback can close listeners
+		AcceptCallback callback = it->second.callback;
+		callback(fd);
+	}
+}
+
+void EpollReactor::deleteLater(EpollRpcDriver *driver)
+{
+	if(std::find(m_driversToDelete.begin(), m_driversToDelete.end(), driver) == m_driversToDelete.end())
+		m_driversToDelete.push_back(driver);
+}
+
+void EpollReactor::deletePendingDrivers()
+{
+	while(!m_driversToDelete.empty()) {
+		std::vector<EpollRpcDriver*> drivers;
+		drivers.swap(m_driversToDelete);
+		for(EpollRpcDriver *driver : drivers)
+			delete driver;
+	}
+}
+
+uint64_t EpollReactor::registerDriver(EpollRpcDriver *driver)
+{
+	uint64_t handle = m_nextHandle++;
+	epoll_event ev;
+	ev.events = SOCKET_EVENTS;
+	ev.data.u64 = handle;
+	if(::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, driver->m_socket, &ev) < 0) {
+		nError() << "epoll_ctl add error:" << ::strerror(errno);
+		return 0;
+	}
+	m_drivers[handle] = driver;
+	return handle;
+}
+
+void EpollReactor::unregisterDriver(EpollRpcDriver *driver)
+{
+	if(driver->m_handle == 0)
+		return;
+	::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, driver->m_socket, nullptr);
+	m_drivers.erase(driver->m_handle);
+}
+
+void EpollReactor::postDecodeJob(uint64_t driver_handle, Rpc::ProtocolType protocol_type, RpcValue::MetaData &&md, std::string &&data)
+{
+	m_decodePool->post(driver_handle, protocol_type, std::move(md), std::move(data));
+}
+
+void EpollReactor::postDecodedMessage(uint64_t driver_handle, RpcValue &&msg)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_decodedMessagesMutex);
+		m_decodedMessages.push_back(DecodedMessage{driver_handle, std::move(msg)});
+	}
+	wakeUp();
+}
+
+void EpollReactor::wakeUp()
+{
+	uint64_t one = 1;
+	while(::write(m_wakeUpFd, &one, sizeof(one)) < 0 && errno == EINTR)
+		;
+}
+
+void EpollReactor::onWakeUp()
+{
+	uint64_t cnt;
+	while(::read(m_wakeUpFd, &cnt, sizeof(cnt)) > 0)
+		;
+	std::deque<DecodedMessage> messages;
+	{
+		std::lock_guard<std::mutex> lock(m_decodedMessagesMutex);
+		messages.swap(m_decodedMessages);
+	}
+	for(const DecodedMessage &dm : messages) {
+		// messages of drivers closed meanwhile are dropped
+		auto it = m_drivers.find(dm.driverHandle);
+		if(it != m_drivers.end())
+			it->second->onDecodedMessage(dm.message);
+	}
+}
+
+//===========================================================================
+// EpollRpcDriver
+//===========================================================================
+constexpr size_t EpollRpcDriver::MIN_READ_BUFFER_SIZE;
+constexpr size_t EpollRpcDriver::DEFAULT_MAX_READ_BUFFER_SIZE;
+constexpr size_t EpollRpcDriver::DEFAULT_WRITE_BUFFER_HIGH_WATERMARK;
+
+EpollRpcDriver::EpollRpcDriver(EpollReactor *reactor)
+	: m_reactor(reactor)
+{
+}
+
+EpollRpcDriver::~EpollRpcDriver()
+{
+	m_disconnectedCallback = nullptr;
+	closeConnection();
+}
+
+bool EpollRpcDriver::connectToHost(const std::string &host, int port)
+{
+	closeConnection();
+	addrinfo hints;
+	std::memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo *addrs = nullptr;
+	int rc = ::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addrs);
+	if(rc != 0) {
+		nError() << "ERROR, cannot resolve host" << host << ::gai_strerror(rc);
+		return false;
+	}
+	int fd = -1;
+	for(addrinfo *ai = addrs; ai; ai = ai->ai_next) {
+		fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+		if(fd < 0)
+			continue;
+		if(::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 || errno == EINPROGRESS)
+			break;
+		::close(fd);
+		fd = -1;
+	}
+	::freeaddrinfo(addrs);
+	if(fd < 0) {
+		nError() << "ERROR, connecting host" << host << "port:" << port;
+		return false;
+	}
+	set_tcp_no_delay(fd);
+	m_socket = fd;
+	// connection result is always reported by the first EPOLLOUT
+	m_state = State::Connecting;
+	m_handle = m_reactor->registerDriver(this);
+	if(m_handle == 0) {
+		::close(m_socket);
+		m_socket = -1;
+		m_state = State::Unconnected;
+		return false;
+	}
+	logReactorI() << "connecting to" << host << "port:" << port;
+	return true;
+}
+
+bool EpollRpcDriver::setSocketDescriptor(int socket)
+{
+	closeConnection();
+	if(!set_non_blocking(socket)) {
+		nError() << "Cannot set socket" << socket << "non-blocking";
+		return false;
+	}
+	m_socket = socket;
+	m_state = State::Connected;
+	m_handle = m_reactor->registerDriver(this);
+	if(m_handle == 0) {
+		m_socket = -1;
+		m_state = State::Unconnected;
+		return false;
+	}
+	return true;
+}
+
+void EpollRpcDriver::closeConnection()
+{
+	if(m_socket < 0)
+		return;
+	const bool was_connected = m_state == State::Connected;
+	m_reactor->unregisterDriver(this);
+	::close(m_socket);
+	m_socket = -1;
+	m_handle = 0;
+	m_state = State::Unconnected;
+	m_writeBuffer.clear();
+	m_writeBufferOffset = 0;
+	clearBuffers();
+	if(was_connected && m_disconnectedCallback)
+		m_disconnectedCallback();
+}
+
+bool EpollRpcDriver::isOpen()
+{
+	return m_socket >= 0;
+}
+
+int64_t EpollRpcDriver::writeBytes(const char *bytes, size_t length)
+{
+	// RpcDriver requires headers to be written at once, so write buffer takes everything,
+	// high watermark is applied when messages are taken from send queue
+	m_writeBuffer.append(bytes, length);
+	m_bytesBuffered += length;
+	return static_cast<int64_t>(length);
+}
+
+void EpollRpcDriver::enqueueDataToSend(MessageData &&chunk_to_enqueue)
+{
+	// message stays in send queue until pumpSendQueue() finds write buffer below high watermark
+	appendToSendQueue(std::move(chunk_to_enqueue));
+	pumpSendQueue();
+}
+
+void EpollRpcDriver::pumpSendQueue()
+{
+	flushWriteBuffer();
+	while(m_socket >= 0 && sendQueueLength() > 0 && pendingWriteBytes() < m_writeBufferHighWatermark) {
+		const uint64_t buffered = m_bytesBuffered;
+		// write next message from send queue
+		writeSendQueue();
+		if(buffered == m_bytesBuffered)
+			break;
+		flushWriteBuffer();
+	}
+}
+
+void EpollRpcDriver::flushWriteBuffer()
+{
+	if(m_state != State::Connected)
+		return;
+	while(m_writeBufferOffset < m_writeBuffer.size()) {
+		ssize_t n = ::send(m_socket, m_writeBuffer.data() + m_writeBufferOffset, m_writeBuffer.size() - m_writeBufferOffset, MSG_NOSIGNAL);
+		if(n > 0) {
+			m_writeBufferOffset += static_cast<size_t>(n);
+			m_bytesWritten += static_cast<uint64_t>(n);
+			continue;
+		}
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		nError() << "Socket write error:" << ::strerror(errno);
+		closeConnection();
+		return;
+	}
+	if(m_writeBufferOffset == m_writeBuffer.size()) {
+		m_writeBuffer.clear();
+		m_writeBufferOffset = 0;
+		// release memory allocated by bursts
+		if(m_writeBuffer.capacity() > 2 * m_writeBufferHighWatermark)
+			std::string().swap(m_writeBuffer);
+	}
+	else if(m_writeBufferOffset > m_writeBuffer.size() / 2) {
+		m_writeBuffer.erase(0, m_writeBufferOffset);
+		m_writeBufferOffset = 0;
+	}
+}
+
+void EpollRpcDriver::onSocketEvents(uint32_t events)
+{
+	if(m_state == State::Connecting) {
+		if(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+			onConnectFinished();
+		if(m_state != State::Connected)
+			return;
+	}
+	if(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+		readSocket();
+	if(m_socket >= 0 && (events & EPOLLOUT))
+		pumpSendQueue();
+}
+
+void EpollRpcDriver::onConnectFinished()
+{
+	int err = 0;
+	socklen_t len = sizeof(err);
+	if(::getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+		err = errno;
+	if(err != 0) {
+		nError() << "ERROR, connect failed:" << ::strerror(err);
+		closeConnection();
+		if(m_connectedCallback)
+			m_connectedCallback(false);
+		return;
+	}
+	m_state = State::Connected;
+	logReactorI() << "... connected, socket:" << m_socket;
+	if(m_connectedCallback)
+		m_connectedCallback(true);
+	pumpSendQueue();
+}
+
+void EpollRpcDriver::readSocket()
+{
+	if(m_readBuffer.empty())
+		m_readBuffer.resize(MIN_READ_BUFFER_SIZE);
+	while(m_socket >= 0) {
+		ssize_t n = ::read(m_socket, m_readBuffer.data(), m_readBuffer.size());
+		if(n > 0) {
+			const size_t len = static_cast<size_t>(n);
+			m_bytesRead += len;
+			std::string bytes(m_readBuffer.data(), len);
+			if(len == m_readBuffer.size()) {
+				m_smallReadCount = 0;
+				if(m_readBuffer.size() < m_maxReadBufferSize)
+					m_readBuffer.resize(std::min(m_readBuffer.size() * 2, m_maxReadBufferSize));
+			}
+			else if(len < m_readBuffer.size() / 4 && m_readBuffer.size() > MIN_READ_BUFFER_SIZE) {
+				if(++m_smallReadCount >= 16) {
+					m_smallReadCount = 0;
+					m_readBuffer.resize(m_readBuffer.size() / 2);
+					m_readBuffer.shrink_to_fit();
+				}
+			}
+			onBytesRead(std::move(bytes));
+			continue;
+		}
+		if(n == 0) {
+			logReactorI() << "connection closed by peer, socket:" << m_socket;
+			closeConnection();
+			return;
+		}
+		if(errno == EINTR)
+			continue;
+		if(errno == EAGAIN || errno == EWOULDBLOCK)
+			return;
+		nError() << "Socket read error:" << ::strerror(errno);
+		closeConnection();
+		return;
+	}
+}
+
+void EpollRpcDriver::onRpcDataReceived(Rpc::ProtocolType protocol_type, RpcValue::MetaData &&md, std::string &&data)
+{
+	if(m_reactor->m_decodePool)
+		m_reactor->postDecodeJob(m_handle, protocol_type, std::move(md), std::move(data));
+	else
+		Super::onRpcDataReceived(protocol_type, std::move(md), std::move(data));
+}
+
+void EpollRpcDriver::onDecodedMessage(const RpcValue &msg)
+{
+	logRpcRawMsg() << RCV_LOG_ARROW << msg.toPrettyString();
+	onRpcValueReceived(msg);
+}
+
+void EpollRpcDriver::onProcessReadDataException(std::exception &e)
+{
+	nError() << "Closing connection after read data error:" << e.what();
+	closeConnection();
+}
+
+}}
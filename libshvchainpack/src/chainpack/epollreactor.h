@@ -0,0 +1,183 @@
+#pragma once
+
+#include "rpcdriver.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace shv {
+namespace chainpack {
+
+class EpollReactor;
+
+/// RpcDriver served by EpollReactor, socket is non-blocking and registered in edge-triggered mode.
+/// Driver must be deleted before its reactor and it must not be deleted from its own callbacks,
+/// use EpollReactor::deleteLater() for that.
+class SHVCHAINPACK_DECL_EXPORT EpollRpcDriver : public RpcDriver
+{
+	using Super = RpcDriver;
+	friend class EpollReactor;
+public:
+	enum class State {Unconnected, Connecting, Connected};
+
+	static constexpr size_t MIN_READ_BUFFER_SIZE = 4 * 1024;
+	static constexpr size_t DEFAULT_MAX_READ_BUFFER_SIZE = 1024 * 1024;
+	static constexpr size_t DEFAULT_WRITE_BUFFER_HIGH_WATERMARK = 1024 * 1024;
+
+	using ConnectedCallback = std::function<void (bool ok)>;
+	using DisconnectedCallback = std::function<void ()>;
+public:
+	explicit EpollRpcDriver(EpollReactor *reactor);
+	~EpollRpcDriver() override;
+
+	/// host name is resolved synchronously, connection is established asynchronously, see setConnectedCallback()
+	/// messages sent before connection is established are delivered after it
+	bool connectToHost(const std::string &host, int port);
+	/// take ownership of connected socket, for example the one passed to EpollReactor::AcceptCallback
+	bool setSocketDescriptor(int socket);
+	void closeConnection();
+
+	State state() const {return m_state;}
+	bool isConnected() const {return m_state == State::Connected;}
+	int socketDescriptor() const {return m_socket;}
+	EpollReactor* reactor() const {return m_reactor;}
+
+	void setConnectedCallback(const ConnectedCallback &callback) {m_connectedCallback = callback;}
+	void setDisconnectedCallback(const DisconnectedCallback &callback) {m_disconnectedCallback = callback;}
+
+	/// read buffer grows twice when filled by single read up to max size and shrinks when mostly empty
+	void setMaxReadBufferSize(size_t n) {m_maxReadBufferSize = n < MIN_READ_BUFFER_SIZE? MIN_READ_BUFFER_SIZE: n;}
+	size_t readBufferSize() const {return m_readBuffer.size();}
+	/// messages are kept in send queue until write buffer drops below high watermark
+	void setWriteBufferHighWatermark(size_t n) {m_writeBufferHighWatermark = n;}
+	size_t pendingWriteBytes() const {return m_writeBuffer.size() - m_writeBufferOffset;}
+	size_t transportBytesToWrite() const override {return pendingWriteBytes();}
+
+	uint64_t bytesRead() const {return m_bytesRead;}
+	uint64_t bytesWritten() const {return m_bytesWritten;}
+protected:
+	bool isOpen() override;
+	void writeMessageBegin() override {}
+	void writeMessageEnd() override {}
+	int64_t writeBytes(const char *bytes, size_t length) override;
+	void enqueueDataToSend(MessageData &&chunk_to_enqueue) override;
+	void onRpcDataReceived(Rpc::ProtocolType protocol_type, RpcValue::MetaData &&md, std::string &&data) override;
+	void onProcessReadDataException(std::exception &e) override;
+private:
+	void onSocketEvents(uint32_t events);
+	void onConnectFinished();
+	void onDecodedMessage(const RpcValue &msg);
+	void readSocket();
+	void flushWriteBuffer();
+	void pumpSendQueue();
+private:
+	EpollReactor *m_reactor;
+	uint64_t m_handle = 0;
+	int m_socket = -1;
+	State m_state = State::Unconnected;
+
+	std::vector<char> m_readBuffer;
+	size_t m_maxReadBufferSize = DEFAULT_MAX_READ_BUFFER_SIZE;
+	unsigned m_smallReadCount = 0;
+
+	std::string m_writeBuffer;
+	size_t m_writeBufferOffset = 0;
+	size_t m_writeBufferHighWatermark = DEFAULT_WRITE_BUFFER_HIGH_WATERMARK;
+	uint64_t m_bytesBuffered = 0;
+
+	uint64_t m_bytesRead = 0;
+	uint64_t m_bytesWritten = 0;
+
+	ConnectedCallback m_connectedCallback;
+	DisconnectedCallback m_disconnectedCallback;
+};
+
+/// Edge-triggered epoll loop driving many EpollRpcDrivers, listening sockets and timers.
+/// Drivers, timers and callbacks are used from the thread calling exec() only, quit() is thread safe.
+/// Received messages can be decoded in worker threads, messages of one driver are always decoded
+/// by the same worker, so they are delivered in order of arrival.
+class SHVCHAINPACK_DECL_EXPORT EpollReactor
+{
+	friend class EpollRpcDriver;
+public:
+	static constexpr int MAX_EVENTS = 256;
+
+	using TimerCallback = std::function<void ()>;
+	/// called for every accepted non-blocking socket, pass it to EpollRpcDriver::setSocketDescriptor()
+	using AcceptCallback = std::function<void (int socket)>;
+public:
+	explicit EpollReactor(unsigned decode_thread_count = 0);
+	~EpollReactor();
+
+	void exec();
+	/// wait for events max timeout_msec, -1 waits forever, returns false when quit() was called
+	bool processEvents(int timeout_msec);
+	void quit();
+
+	int addTimer(int interval_msec, TimerCallback &&callback, bool single_shot = false);
+	void removeTimer(int timer_id);
+
+	/// returns listening port, which is useful for port == 0, or -1 on error
+	int listen(const std::string &host, int port, AcceptCallback &&callback);
+	void closeListeners();
+
+	/// delete driver when current event dispatch is finished
+	void deleteLater(EpollRpcDriver *driver);
+
+	size_t driverCount() const {return m_drivers.size();}
+	unsigned decodeThreadCount() const;
+private:
+	class DecodePool;
+	struct Timer
+	{
+		int intervalMsec;
+		bool singleShot;
+		TimerCallback callback;
+		std::chrono::steady_clock::time_point deadline;
+	};
+	struct Listener
+	{
+		int socket;
+		AcceptCallback callback;
+	};
+	struct DecodedMessage
+	{
+		uint64_t driverHandle;
+		RpcValue message;
+	};
+
+	uint64_t registerDriver(EpollRpcDriver *driver);
+	void unregisterDriver(EpollRpcDriver *driver);
+	void postDecodeJob(uint64_t driver_handle, Rpc::ProtocolType protocol_type, RpcValue::MetaData &&md, std::string &&data);
+	void postDecodedMessage(uint64_t driver_handle, RpcValue &&msg);
+	void wakeUp();
+	void onWakeUp();
+	int fireTimers();
+	void acceptConnections(uint64_t listener_handle);
+	void deletePendingDrivers();
+private:
+	int m_epollFd = -1;
+	int m_wakeUpFd = -1;
+	std::atomic<bool> m_quit{false};
+	uint64_t m_nextHandle = 1;
+	std::map<uint64_t, EpollRpcDriver*> m_drivers;
+	std::map<uint64_t, Listener> m_listeners;
+	std::vector<EpollRpcDriver*> m_driversToDelete;
+
+	std::map<int, Timer> m_timers;
+	std::multimap<std::chrono::steady_clock::time_point, int> m_timerQueue;
+	int m_nextTimerId = 1;
+
+	std::unique_ptr<DecodePool> m_decodePool;
+	std::mutex m_decodedMessagesMutex;
+	std::deque<DecodedMessage> m_decodedMessages;
+};
+
+}}
@@ -1,8 +1,34 @@
 #include "metamethod.h"
+#include "reflect.h"
 
 namespace shv {
 namespace chainpack {
 
+SHV_REFLECT_LIST(MetaMethod,
+	field(0, &C::m_name),
+	field(1, [](const C &c) {return static_cast<unsigned>(c.m_signature);}, [](C &c, unsigned sig) {c.m_signature = static_cast<C::Signature>(sig);}),
+	field(2, &C::m_flags),
+	field(3, &C::m_accessGrant),
+	field(4, &C::m_description)
+)
+
+void shvWriteChainPack(ChainPackWriter &wr, const MetaMethod &method)
+{
+	reflect::writeReflected(wr, method);
+}
+
+void shvReadChainPack(ChainPackReader &rd, MetaMethod &method)
+{
+	// attributes() without any DirAttribute is the method name only
+	if(rd.peekNext() == CCPCP_ITEM_STRING) {
+		std::string name;
+		rd.read_p(name);
+		method = MetaMethod(std::move(name), MetaMethod::Signature::VoidVoid, 0, RpcValue());
+		return;
+	}
+	reflect::readReflected(rd, method);
+}
+
 MetaMethod::Signature MetaMethod::signatureFromString(const std::string &sigstr)
 {
 	if(sigstr == "VoidParam") return Signature::VoidParam;
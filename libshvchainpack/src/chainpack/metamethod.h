@@ -6,6 +6,9 @@
 namespace shv {
 namespace chainpack {
 
+class ChainPackWriter;
+class ChainPackReader;
+
 class SHVCHAINPACK_DECL_EXPORT MetaMethod
 {
 public:
@@ -80,6 +83,8 @@ public:
 
 	static Signature signatureFromString(const std::string &sigstr);
 	static const char* signatureToString(Signature sig);
+
+	template<typename F> friend void shvReflectFields(const MetaMethod*, F &&fn);
 private:
 	std::string m_name;
 	Signature m_signature = Signature::VoidVoid;
@@ -88,5 +93,9 @@ private:
 	std::string m_description;
 };
 
+/// writes the same bytes as attributes() with all DirAttribute bits set, see reflect.h
+SHVCHAINPACK_DECL_EXPORT void shvWriteChainPack(ChainPackWriter &wr, const MetaMethod &method);
+SHVCHAINPACK_DECL_EXPORT void shvReadChainPack(ChainPackReader &rd, MetaMethod &method);
+
 } // namespace chainpack
 } // namespace shv
@@ -0,0 +1,466 @@
+#pragma once
+
+#include "chainpackreader.h"
+#include "chainpackwriter.h"
+
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Declarative ChainPack serialization of C++ types.
+///
+/// Values are written by ChainPackWriter and read by ChainPackReader directly,
+/// without building an intermediate RpcValue tree.
+///
+///   SHV_REFLECT_IMAP(Type, fields...) - written as IMap, field keys are ints
+///   SHV_REFLECT_MAP(Type, fields...)  - written as Map, field keys are strings
+///   SHV_REFLECT_META(Type, fields...) - written as meta-data with string keys, like getLog result header
+///   SHV_REFLECT_LIST(Type, fields...) - written as List, field keys are ignored, omitted field is written as null
+///
+/// Fields are declared as:
+///   field(key, &C::member [, omit])
+///   field(key, getter [, setter [, omit]])
+/// C is an alias of the reflected Type.
+/// getter is callable as (const C&) -> value, setter as (C&, value&&).
+/// A field without a setter is write only.
+/// omit is callable as (const C&) -> bool.
+/// Declare Map and IMap fields in ascending key order to get the same bytes as RpcValue::Map / IMap.
+///
+/// The macro must be used in the namespace of Type, the generated functions are found by ADL.
+/// Private members can be reflected when the class befriends
+///   template<typename F> friend void shvReflectFields(const Type*, F &&fn);
+///
+/// Types with irregular wire format provide their own functions, found by ADL as well:
+///   void shvWriteChainPack(ChainPackWriter &wr, const Type &v);
+///   void shvReadChainPack(ChainPackReader &rd, Type &v);
+/// They take precedence over SHV_REFLECT, so the type can be reflected in its .cpp file only
+/// and the functions can use writeReflected() / readReflected() for the regular part of the format.
+#define SHV_REFLECT_P(Type, kind, ...) \
+	inline constexpr shv::chainpack::reflect::Kind shvReflectKind(const Type*) {return kind;} \
+	template<typename F> \
+	inline void shvReflectFields(const Type*, F &&fn) \
+	{ \
+		using C = Type; \
+		using namespace shv::chainpack::reflect; \
+		fn(__VA_ARGS__); \
+	}
+
+#define SHV_REFLECT_IMAP(Type, ...) SHV_REFLECT_P(Type, shv::chainpack::reflect::Kind::IMap, __VA_ARGS__)
+#define SHV_REFLECT_MAP(Type, ...) SHV_REFLECT_P(Type, shv::chainpack::reflect::Kind::Map, __VA_ARGS__)
+#define SHV_REFLECT_META(Type, ...) SHV_REFLECT_P(Type, shv::chainpack::reflect::Kind::Meta, __VA_ARGS__)
+#define SHV_REFLECT_LIST(Type, ...) SHV_REFLECT_P(Type, shv::chainpack::reflect::Kind::List, __VA_ARGS__)
+
+namespace shv {
+namespace chainpack {
+namespace reflect {
+
+enum class Kind {List, Map, IMap, Meta};
+
+struct Key
+{
+	constexpr Key(int k) : ikey(k), skey(nullptr) {}
+	constexpr Key(const char *k) : ikey(0), skey(k) {}
+
+	int ikey;
+	const char *skey;
+};
+
+struct NeverOmit
+{
+	template<typename C>
+	bool operator()(const C &) const {return false;}
+};
+
+struct NoSetter
+{
+	template<typename C, typename V>
+	void operator()(C &, V &&) const {}
+};
+
+template<typename C, typename M, typename Omit>
+struct MemberField
+{
+	template<typename> using Value = M;
+
+	Key key;
+	M C::*member;
+	Omit omit;
+
+	const M& get(const C &c) const {return c.*member;}
+	// members are read in place, null keeps the current value
+	void read(ChainPackReader &rd, C &c) const;
+};
+
+template<typename Getter, typename Setter, typename Omit>
+struct AccessorField
+{
+	template<typename C> using Value = typename std::decay<decltype(std::declval<const Getter&>()(std::declval<const C&>()))>::type;
+
+	Key key;
+	Getter getter;
+	Setter setter;
+	Omit omit;
+
+	template<typename C>
+	auto get(const C &c) const -> decltype(std::declval<const Getter&>()(c)) {return getter(c);}
+	// value is initialized by getter, so null passes the current value to setter
+	template<typename C>
+	void read(ChainPackReader &rd, C &c) const;
+};
+
+template<typename C, typename M>
+MemberField<C, M, NeverOmit> field(Key key, M C::*member)
+{
+	return MemberField<C, M, NeverOmit>{key, member, NeverOmit()};
+}
+
+template<typename C, typename M, typename Omit>
+MemberField<C, M, Omit> field(Key key, M C::*member, Omit omit)
+{
+	return MemberField<C, M, Omit>{key, member, omit};
+}
+
+template<typename Getter>
+AccessorField<Getter, NoSetter, NeverOmit> field(Key key, Getter getter)
+{
+	return AccessorField<Getter, NoSetter, NeverOmit>{key, getter, NoSetter(), NeverOmit()};
+}
+
+template<typename Getter, typename Setter>
+AccessorField<Getter, Setter, NeverOmit> field(Key key, Getter getter, Setter setter)
+{
+	return AccessorField<Getter, Setter, NeverOmit>{key, getter, setter, NeverOmit()};
+}
+
+template<typename Getter, typename Setter, typename Omit>
+AccessorField<Getter, Setter, Omit> field(Key key, Getter getter, Setter setter, Omit omit)
+{
+	return AccessorField<Getter, Setter, Omit>{key, getter, setter, omit};
+}
+
+template<typename T>
+class IsReflected
+{
+	template<typename U>
+	static auto test(int) -> decltype(shvReflectKind(static_cast<const U*>(nullptr)), std::true_type());
+	template<typename>
+	static std::false_type test(...);
+public:
+	static constexpr bool value = decltype(test<T>(0))::value;
+};
+
+template<typename T>
+class HasCustomCodec
+{
+	template<typename U>
+	static auto test(int) -> decltype(shvWriteChainPack(std::declval<ChainPackWriter&>(), std::declval<const U&>()), std::true_type());
+	template<typename>
+	static std::false_type test(...);
+public:
+	static constexpr bool value = decltype(test<T>(0))::value;
+};
+
+template<typename T>
+void writeReflected(ChainPackWriter &wr, const T &v);
+template<typename T>
+void readReflected(ChainPackReader &rd, T &v);
+
+/// types without specialization use shvWriteChainPack() / shvReadChainPack() found by ADL
+template<typename T, typename Enable = void>
+struct Codec
+{
+	static void write(ChainPackWriter &wr, const T &v) { shvWriteChainPack(wr, v); }
+	static void read(ChainPackReader &rd, T &v) { shvReadChainPack(rd, v); }
+};
+
+template<typename T>
+struct Codec<T, typename std::enable_if<IsReflected<T>::value && !HasCustomCodec<T>::value>::type>
+{
+	static void write(ChainPackWriter &wr, const T &v) { writeReflected(wr, v); }
+	static void read(ChainPackReader &rd, T &v) { readReflected(rd, v); }
+};
+
+template<>
+struct Codec<bool>
+{
+	static void write(ChainPackWriter &wr, bool v) { wr.write_p(v); }
+	static void read(ChainPackReader &rd, bool &v) { rd.read_p(v); }
+};
+
+template<typename T>
+struct Codec<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type>
+{
+	static void write(ChainPackWriter &wr, T v) { wr.write_p(static_cast<int64_t>(v)); }
+	static void read(ChainPackReader &rd, T &v) { int64_t n = v; rd.read_p(n); v = static_cast<T>(n); }
+};
+
+template<typename T>
+struct Codec<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value>::type>
+{
+	static void write(ChainPackWriter &wr, T v) { wr.write_p(static_cast<uint64_t>(v)); }
+	static void read(ChainPackReader &rd, T &v) { uint64_t n = v; rd.read_p(n); v = static_cast<T>(n); }
+};
+
+/// enums are written as Int, the same way as (int)enum_value converted to RpcValue
+template<typename T>
+struct Codec<T, typename std::enable_if<std::is_enum<T>::value>::type>
+{
+	static void write(ChainPackWriter &wr, T v) { wr.write_p(static_cast<int64_t>(v)); }
+	static void read(ChainPackReader &rd, T &v) { int64_t n = static_cast<int64_t>(v); rd.read_p(n); v = static_cast<T>(n); }
+};
+
+template<>
+struct Codec<double>
+{
+	static void write(ChainPackWriter &wr, double v) { wr.write_p(v); }
+	static void read(ChainPackReader &rd, double &v) { rd.read_p(v); }
+};
+
+template<>
+struct Codec<std::string>
+{
+	static void write(ChainPackWriter &wr, const std::string &v) { wr.write_p(v); }
+	static void read(ChainPackReader &rd, std::string &v) { rd.read_p(v); }
+};
+
+template<>
+struct Codec<RpcValue::DateTime>
+{
+	static void write(ChainPackWriter &wr, const RpcValue::DateTime &v) { wr.write_p(v); }
+	static void read(ChainPackReader &rd, RpcValue::DateTime &v) { rd.read_p(v); }
+};
+
+template<>
+struct Codec<RpcValue>
+{
+	static void write(ChainPackWriter &wr, const RpcValue &v) { wr.write(v); }
+	static void read(ChainPackReader &rd, RpcValue &v) { rd.read(v); }
+};
+
+template<>
+struct Codec<RpcValue::List>
+{
+	static void write(ChainPackWriter &wr, const RpcValue::List &v) { wr.write_p(v); }
+	static void read(ChainPackReader &rd, RpcValue::List &v) { RpcValue rv; rd.read(rv); if(rv.isList()) v = rv.toList(); }
+};
+
+template<>
+struct Codec<RpcValue::Map>
+{
+	static void write(ChainPackWriter &wr, const RpcValue::Map &v) { wr.write_p(v); }
+	static void read(ChainPackReader &rd, RpcValue::Map &v) { RpcValue rv; rd.read(rv); if(rv.isMap()) v = rv.toMap(); }
+};
+
+template<>
+struct Codec<RpcValue::IMap>
+{
+	static void write(ChainPackWriter &wr, const RpcValue::IMap &v) { wr.write_p(v); }
+	static void read(ChainPackReader &rd, RpcValue::IMap &v) { RpcValue rv; rd.read(rv); if(rv.isIMap()) v = rv.toIMap(); }
+};
+
+template<typename T>
+struct Codec<std::vector<T>>
+{
+	static void write(ChainPackWriter &wr, const std::vector<T> &v)
+	{
+		wr.writeContainerBegin(RpcValue::Type::List);
+		for(const T &item : v)
+			Codec<T>::write(wr, item);
+		wr.writeContainerEnd();
+	}
+	static void read(ChainPackReader &rd, std::vector<T> &v)
+	{
+		if(!rd.readContainerBegin(CCPCP_ITEM_LIST))
+			return;
+		v.clear();
+		while(!rd.readContainerEnd()) {
+			v.emplace_back();
+			Codec<T>::read(rd, v.back());
+		}
+	}
+};
+
+template<typename C, typename M, typename Omit>
+void MemberField<C, M, Omit>::read(ChainPackReader &rd, C &c) const
+{
+	Codec<M>::read(rd, c.*member);
+}
+
+template<typename Getter, typename Setter, typename Omit>
+template<typename C>
+void AccessorField<Getter, Setter, Omit>::read(ChainPackReader &rd, C &c) const
+{
+	Value<C> val = getter(static_cast<const C&>(c));
+	Codec<Value<C>>::read(rd, val);
+	setter(c, std::move(val));
+}
+
+namespace detail {
+
+template<typename C>
+struct FieldsWriter
+{
+	ChainPackWriter &wr;
+	const C &obj;
+	Kind kind;
+
+	template<typename... F>
+	void operator()(const F&... fields) const
+	{
+		int unused[] = {0, (writeField(fields), 0)...};
+		(void)unused;
+	}
+
+	template<typename F>
+	void writeField(const F &f) const
+	{
+		if(f.omit(obj)) {
+			if(kind == Kind::List)
+				wr.write_p(nullptr);
+			return;
+		}
+		if(kind == Kind::IMap)
+			wr.write_p(static_cast<int64_t>(f.key.ikey));
+		else if(kind == Kind::Map || kind == Kind::Meta)
+			wr.write_p(f.key.skey);
+		using V = typename F::template Value<C>;
+		Codec<V>::write(wr, f.get(obj));
+	}
+};
+
+template<typename C>
+struct FieldsReader
+{
+	ChainPackReader &rd;
+	C &obj;
+	Kind kind;
+	int index;
+	int64_t ikey;
+	const std::string *skey;
+	bool found;
+
+	template<typename... F>
+	void operator()(const F&... fields)
+	{
+		int pos = 0;
+		int unused[] = {0, (readField(fields, pos++), 0)...};
+		(void)unused;
+	}
+
+	template<typename F>
+	void readField(const F &f, int pos)
+	{
+		if(found)
+			return;
+		if(kind == Kind::List) {
+			if(pos != index)
+				return;
+		}
+		else if(skey) {
+			if(!f.key.skey || *skey != f.key.skey)
+				return;
+		}
+		else if(f.key.skey || f.key.ikey != ikey) {
+			return;
+		}
+		found = true;
+		f.read(rd, obj);
+	}
+};
+
+inline ccpcp_item_types containerItemType(Kind kind)
+{
+	switch (kind) {
+	case Kind::List: return CCPCP_ITEM_LIST;
+	case Kind::Map: return CCPCP_ITEM_MAP;
+	case Kind::IMap: return CCPCP_ITEM_IMAP;
+	case Kind::Meta: return CCPCP_ITEM_META;
+	}
+	return CCPCP_ITEM_INVALID;
+}
+
+} // namespace detail
+
+template<typename T>
+void writeReflected(ChainPackWriter &wr, const T &v)
+{
+	constexpr Kind kind = shvReflectKind(static_cast<const T*>(nullptr));
+	switch (kind) {
+	case Kind::List: wr.writeContainerBegin(RpcValue::Type::List); break;
+	case Kind::Map: wr.writeContainerBegin(RpcValue::Type::Map); break;
+	case Kind::IMap: wr.writeContainerBegin(RpcValue::Type::IMap); break;
+	case Kind::Meta: wr.writeMetaBegin(); break;
+	}
+	shvReflectFields(static_cast<const T*>(nullptr), detail::FieldsWriter<T>{wr, v, kind});
+	wr.writeContainerEnd();
+}
+
+template<typename T>
+void readReflected(ChainPackReader &rd, T &v)
+{
+	constexpr Kind kind = shvReflectKind(static_cast<const T*>(nullptr));
+	if(!rd.readContainerBegin(detail::containerItemType(kind)))
+		return;
+	std::string skey;
+	for(int index = 0; !rd.readContainerEnd(); index++) {
+		detail::FieldsReader<T> reader{rd, v, kind, index, 0, nullptr, false};
+		if(kind != Kind::List) {
+			ChainPackReader::ItemType key_type = rd.peekNext();
+			if(key_type == CCPCP_ITEM_STRING) {
+				rd.read_p(skey);
+				reader.skey = &skey;
+			}
+			else if(key_type == CCPCP_ITEM_INT || key_type == CCPCP_ITEM_UINT) {
+				rd.read_p(reader.ikey);
+			}
+			else {
+				throw ChainPackReader::ParseException(std::string("Invalid key type: ") + ChainPackReader::itemTypeToString(key_type), -1);
+			}
+		}
+		shvReflectFields(static_cast<const T*>(nullptr), reader);
+		if(!reader.found) {
+			// unknown and extra fields are skipped
+			RpcValue unused;
+			rd.read(unused);
+		}
+	}
+}
+
+template<typename T>
+void write(ChainPackWriter &wr, const T &v)
+{
+	Codec<T>::write(wr, v);
+}
+
+template<typename T>
+void read(ChainPackReader &rd, T &v)
+{
+	Codec<T>::read(rd, v);
+}
+
+template<typename T>
+std::string toChainPack(const T &v)
+{
+	std::ostringstream out;
+	{
+		ChainPackWriter wr(out);
+		write(wr, v);
+	}
+	return out.str();
+}
+
+template<typename T>
+T fromChainPack(const std::string &data)
+{
+	std::istringstream in(data);
+	ChainPackReader rd(in);
+	T ret;
+	read(rd, ret);
+	return ret;
+}
+
+} // namespace reflect
+} // namespace chainpack
+} // namespace shv
@@ -43,6 +43,9 @@ const char* Rpc::METH_GET_LOG = "getLog";
 const char* Rpc::PAR_PATH = "path";
 const char* Rpc::PAR_METHOD = "method";
 const char* Rpc::PAR_PARAMS = "params";
+const char* Rpc::PAR_MIN_INTERVAL = "minInterval";
+const char* Rpc::PAR_COALESCE = "coalesce";
+const char* Rpc::PAR_DEADBAND = "deadband";
 
 const char* Rpc::SIG_VAL_CHANGED = "chng";
 const char* Rpc::SIG_VAL_FASTCHANGED = "fastchng";
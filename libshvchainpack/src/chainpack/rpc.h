@@ -52,6 +52,9 @@ public:
 	static const char* PAR_PATH;
 	static const char* PAR_METHOD;
 	static const char* PAR_PARAMS;
+	static const char* PAR_MIN_INTERVAL;
+	static const char* PAR_COALESCE;
+	static const char* PAR_DEADBAND;
 
 	static const char* SIG_VAL_CHANGED;
 	static const char* SIG_VAL_FASTCHANGED;
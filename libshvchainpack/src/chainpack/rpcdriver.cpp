@@ -6,11 +6,16 @@
 #include "cponreader.h"
 #include "chainpackwriter.h"
 #include "chainpackreader.h"
+#include "rpctracer.h"
+#include "rpcvalueview.h"
+
+#include "../../c/ccpcp_convert.h"
 
 #include <necrolog.h>
 
 #include <sstream>
 #include <iostream>
+#include <chrono>
 
 #define logRpcRawMsg() nCMessage("RpcRawMsg")
 #define logRpcData() nCMessage("RpcData")
@@ -25,6 +30,33 @@ const char * RpcDriver::RCV_LOG_ARROW = "R==>";
 
 int RpcDriver::s_defaultRpcTimeoutMsec = 5000;
 
+namespace {
+constexpr size_t TRANSCODE_CONTAINER_DEPTH = 64;
+
+void transcode_pack_overflow_handler(ccpcp_pack_context *ctx, size_t size_hint)
+{
+	(void)size_hint;
+	std::string *out = reinterpret_cast<std::string*>(ctx->custom_context);
+	out->append(ctx->start, static_cast<size_t>(ctx->current - ctx->start));
+	ctx->current = ctx->start;
+}
+
+bool pack_format(Rpc::ProtocolType protocol_type, ccpcp_pack_format &format)
+{
+	switch (protocol_type) {
+	case Rpc::ProtocolType::ChainPack:
+		format = CCPCP_ChainPack;
+		return true;
+	case Rpc::ProtocolType::Cpon:
+	case Rpc::ProtocolType::JsonRpc:
+		format = CCPCP_Cpon;
+		return true;
+	default:
+		return false;
+	}
+}
+}
+
 RpcDriver::RpcDriver()
 {
 }
@@ -57,6 +89,7 @@ void RpcDriver::sendRawData(const RpcValue::MetaData &meta_data, std::string &&d
 				<< Utils::toHex(data, 0, 250);
 	using namespace std;
 	//shvLogFuncFrame() << msg.toStdString();
+	SHV_TRACE_SPAN(encode_span, "rpc.encode", traceConnectionId(), RpcMessage::requestId(meta_data).toInt64());
 	std::ostringstream os_packed_meta_data;
 	switch (protocolType()) {
 	case Rpc::ProtocolType::Cpon: {
@@ -76,25 +109,41 @@ void RpcDriver::sendRawData(const RpcValue::MetaData &meta_data, std::string &&d
 		SHVCHP_EXCEPTION("Cannot serialize data without protocol version specified.");
 	}
 	Rpc::ProtocolType packed_data_ver = RpcMessage::protocolType(meta_data);
+	MessageData message_data;
 	if(protocolType() == Rpc::ProtocolType::JsonRpc) {
 		// JSON RPC must be handled separately
 		if(packed_data_ver == Rpc::ProtocolType::Invalid)
 			SHVCHP_EXCEPTION("Cannot serialize to JSON-RPC data without protocol version specified.");
-		// recode data;
-		RpcValue val = decodeData(packed_data_ver, data, 0);
-		val.setMetaData(RpcValue::MetaData(meta_data));
-		enqueueDataToSend(MessageData(codeRpcValue(Rpc::ProtocolType::JsonRpc, val)));
+		std::string json_data;
+		if(packed_data_ver == Rpc::ProtocolType::ChainPack && codeJsonRpcEnvelope(meta_data, data, json_data)) {
+			message_data = MessageData(std::move(json_data));
+		}
+		else {
+			// recode data;
+			RpcValue val = decodeData(packed_data_ver, data, 0);
+			val.setMetaData(RpcValue::MetaData(meta_data));
+			message_data = MessageData(codeRpcValue(Rpc::ProtocolType::JsonRpc, val));
+		}
 	}
 	else {
 		if(packed_data_ver == Rpc::ProtocolType::Invalid || packed_data_ver == protocolType()) {
-			enqueueDataToSend(MessageData(os_packed_meta_data.str(), std::move(data)));
+			message_data = MessageData(os_packed_meta_data.str(), std::move(data));
 		}
 		else {
-			// recode data;
-			RpcValue val = decodeData(packed_data_ver, data, 0);
-			enqueueDataToSend(MessageData(os_packed_meta_data.str(), codeRpcValue(protocolType(), val)));
+			// recode data byte stream to byte stream, fall back to RpcValue on failure
+			std::string recoded_data;
+			if(!transcodeData(packed_data_ver, data.data(), data.size(), protocolType(), recoded_data)) {
+				RpcValue val = decodeData(packed_data_ver, data, 0);
+				recoded_data = codeRpcValue(protocolType(), val);
+			}
+			message_data = MessageData(os_packed_meta_data.str(), std::move(recoded_data));
 		}
 	}
+	SHV_TRACE_SPAN_END(encode_span);
+#ifdef SHV_RPC_TRACING
+	message_data.traceRequestId = RpcMessage::requestId(meta_data).toInt64();
+#endif
+	enqueueDataToSend(std::move(message_data));
 }
 
 RpcMessage RpcDriver::composeRpcMessage(RpcValue::MetaData &&meta_data, const std::string &data, std::string *errmsg)
@@ -119,10 +168,7 @@ void RpcDriver::enqueueDataToSend(RpcDriver::MessageData &&chunk_to_enqueue)
 {
 	/// LOCK_FOR_SEND lock mutex here in the multithreaded environment
 	lockSendQueueGuard();
-	if(!chunk_to_enqueue.empty()) {
-		m_sendQueue.push_back(std::move(chunk_to_enqueue));
-		logWriteQueue() << "===========> write chunk added, new queue len:" << m_sendQueue.size();
-	}
+	appendToSendQueue(std::move(chunk_to_enqueue));
 	if(!isOpen()) {
 		nError() << "write data error, socket is not open!";
 		return;
@@ -133,6 +179,27 @@ void RpcDriver::enqueueDataToSend(RpcDriver::MessageData &&chunk_to_enqueue)
 	unlockSendQueueGuard();
 }
 
+void RpcDriver::appendToSendQueue(RpcDriver::MessageData &&chunk_to_enqueue)
+{
+	if(chunk_to_enqueue.empty())
+		return;
+#ifdef SHV_RPC_TRACING
+	chunk_to_enqueue.traceEnqueueNsec = RpcTracer::isEnabled()? RpcTracer::nowNsec(): 0;
+#endif
+	m_sendQueueBytes += chunk_to_enqueue.size();
+	m_sendQueue.push_back(std::move(chunk_to_enqueue));
+	logWriteQueue() << "===========> write chunk added, new queue len:" << m_sendQueue.size();
+}
+
+void RpcDriver::writeSendQueue()
+{
+	if(!isOpen())
+		return;
+	lockSendQueueGuard();
+	writeQueue();
+	unlockSendQueueGuard();
+}
+
 void RpcDriver::writeQueue()
 {
 	if(m_sendQueue.empty())
@@ -159,6 +226,7 @@ void RpcDriver::writeQueue()
 				SHVCHP_EXCEPTION("Write socket error!");
 			if(len < (int)packet_len_data.length())
 				SHVCHP_EXCEPTION("Design error! Chunk length shall be always written at once to the socket");
+			m_trafficCounters.bytesWritten += static_cast<uint64_t>(len);
 		}
 		{
 			auto len = writeBytes(protocol_type_data.data(), protocol_type_data.length());
@@ -167,6 +235,7 @@ void RpcDriver::writeQueue()
 				SHVCHP_EXCEPTION("Write socket error!");
 			if(len != 1)
 				SHVCHP_EXCEPTION("Design error! Protocol version shall be always written at once to the socket");
+			m_trafficCounters.bytesWritten += static_cast<uint64_t>(len);
 		}
 		m_topMessageDataHeaderWritten = true;
 	}
@@ -188,7 +257,13 @@ void RpcDriver::writeQueue()
 	if(m_topMessageDataBytesWrittenSoFar == chunk.size()) {
 		m_topMessageDataHeaderWritten = false;
 		m_topMessageDataBytesWrittenSoFar = 0;
+		m_sendQueueBytes -= chunk.size();
+#ifdef SHV_RPC_TRACING
+		if(chunk.traceEnqueueNsec > 0)
+			RpcTracer::complete("rpc.sendQueue", traceConnectionId(), chunk.traceRequestId, chunk.traceEnqueueNsec, RpcTracer::nowNsec());
+#endif
 		m_sendQueue.pop_front();
+		m_trafficCounters.messagesSent++;
 		writeMessageEnd();
 		logWriteQueue() << "<=========== write chunk finished, new queue len:" << m_sendQueue.size();
 	}
@@ -203,13 +278,18 @@ int64_t RpcDriver::writeBytes_helper(const std::string &str, size_t from, size_t
 		SHVCHP_EXCEPTION("Write socket error!");
 	if(len == 0)
 		SHVCHP_EXCEPTION("Design error! At least 1 byte of data shall be always written to the socket");
+	m_trafficCounters.bytesWritten += static_cast<uint64_t>(len);
 	return len;
 }
 
 void RpcDriver::onBytesRead(std::string &&bytes)
 {
 	logRpcData().nospace() << __FUNCTION__ << " " << bytes.length() << " bytes of data read:\n" << shv::chainpack::Utils::hexDump(bytes);
-	m_readData += std::string(std::move(bytes));
+	m_trafficCounters.bytesRead += bytes.size();
+	if(m_readData.empty())
+		m_readData = std::move(bytes);
+	else
+		m_readData += bytes;
 	while(true) {
 		auto old_len = m_readData.size();
 		processReadData();
@@ -221,6 +301,7 @@ void RpcDriver::onBytesRead(std::string &&bytes)
 void RpcDriver::clearBuffers()
 {
 	m_sendQueue.clear();
+	m_sendQueueBytes = 0;
 	m_topMessageDataHeaderWritten = false;
 	m_topMessageDataBytesWrittenSoFar = 0;
 	m_readData.clear();
@@ -261,12 +342,19 @@ void RpcDriver::processReadData()
 
 	try {
 		RpcValue::MetaData meta_data;
+		SHV_TRACE_SPAN(decode_span, "rpc.decode", traceConnectionId(), 0);
+		auto decode_start = std::chrono::steady_clock::now();
 		size_t meta_data_end_pos = decodeMetaData(meta_data, protocol_type, read_data, in.tellg());
+		m_lastMetaDataDecodeNsec = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - decode_start).count();
+		SHV_TRACE_SPAN_SET_IDS(decode_span, traceConnectionId(), RpcMessage::requestId(meta_data).toInt64());
+		SHV_TRACE_SPAN_END(decode_span);
 		if(meta_data_end_pos > read_len)
 			throw std::runtime_error("Data header corrupted");
 		std::string msg_data = read_data.substr(meta_data_end_pos, read_len - meta_data_end_pos);
 		logRpcData() << read_len << "bytes of" << m_readData.size() << "processed";
 		m_readData = m_readData.substr(read_len);
+		m_trafficCounters.messagesReceived++;
+		SHV_TRACE_SPAN(receive_span, "rpc.receive", traceConnectionId(), RpcMessage::requestId(meta_data).toInt64());
 		onRpcDataReceived(protocol_type, std::move(meta_data), std::move(msg_data));
 	}
 	catch (std::exception &e) {
@@ -438,6 +526,90 @@ std::string RpcDriver::codeRpcValue(Rpc::ProtocolType protocol_type, const RpcVa
 	return os_packed_data.str();
 }
 
+bool RpcDriver::transcodeData(Rpc::ProtocolType from_protocol, const char *data, size_t size, Rpc::ProtocolType to_protocol, std::string &out)
+{
+	ccpcp_pack_format in_format;
+	ccpcp_pack_format out_format;
+	if(from_protocol == Rpc::ProtocolType::JsonRpc || !pack_format(from_protocol, in_format) || !pack_format(to_protocol, out_format))
+		return false;
+	ccpcp_container_state states[TRANSCODE_CONTAINER_DEPTH];
+	ccpcp_container_stack stack;
+	ccpcp_container_stack_init(&stack, states, TRANSCODE_CONTAINER_DEPTH, nullptr);
+	ccpcp_unpack_context in_ctx;
+	ccpcp_unpack_context_init(&in_ctx, data, size, nullptr, &stack);
+
+	char buff[1024];
+	ccpcp_pack_context out_ctx;
+	ccpcp_pack_context_init(&out_ctx, buff, sizeof(buff), transcode_pack_overflow_handler);
+	out_ctx.custom_context = &out;
+	out_ctx.cpon_options.json_output = (to_protocol == Rpc::ProtocolType::JsonRpc);
+
+	ccpcp_convert(&in_ctx, in_format, &out_ctx, out_format);
+	if(in_ctx.err_no != CCPCP_RC_OK || out_ctx.err_no != CCPCP_RC_OK) {
+		nWarning() << "Transcode" << Rpc::protocolTypeToString(from_protocol) << "->" << Rpc::protocolTypeToString(to_protocol)
+				   << "error:" << in_ctx.err_no << out_ctx.err_no << (in_ctx.err_msg? in_ctx.err_msg: "");
+		return false;
+	}
+	return true;
+}
+
+bool RpcDriver::codeJsonRpcEnvelope(const RpcValue::MetaData &meta_data, const std::string &chainpack_data, std::string &out)
+{
+	bool is_response = RpcMessage::isResponse(meta_data);
+	std::string packed_value;
+	try {
+		RpcValueView body(chainpack_data);
+		if(!body.isIMap())
+			return false;
+		RpcValueView value = body.at(is_response? RpcMessage::MetaType::Key::Result: RpcMessage::MetaType::Key::Params);
+		if(value.isValid()) {
+			size_t offset = static_cast<size_t>(value.data() - chainpack_data.data());
+			if(!transcodeData(Rpc::ProtocolType::ChainPack, value.data(), chainpack_data.size() - offset, Rpc::ProtocolType::JsonRpc, packed_value))
+				return false;
+		}
+		else if(is_response) {
+			// error or void result
+			return false;
+		}
+	}
+	catch (AbstractStreamReader::ParseException &e) {
+		nWarning() << "JSON-RPC envelope data error:" << e.msg();
+		return false;
+	}
+
+	// keys are written in the same order as codeRpcValue() does
+	std::ostringstream os_packed_data;
+	{
+		CponWriterOptions opts;
+		opts.setJsonFormat(true);
+		CponWriter wr(os_packed_data, opts);
+		wr.writeContainerBegin(RpcValue::Type::Map);
+		const RpcValue caller_id = RpcMessage::callerIds(meta_data);
+		if(caller_id.isValid())
+			wr.writeMapElement(Rpc::JSONRPC_CALLER_ID, caller_id);
+		const RpcValue rq_id = RpcMessage::requestId(meta_data);
+		if(rq_id.isValid())
+			wr.writeMapElement(Rpc::JSONRPC_REQUEST_ID, rq_id);
+		if(!is_response) {
+			wr.writeMapElement(Rpc::JSONRPC_METHOD, RpcMessage::method(meta_data));
+			if(!packed_value.empty()) {
+				wr.writeMapKey(Rpc::JSONRPC_PARAMS);
+				wr.writeRawData(packed_value);
+			}
+		}
+		const RpcValue shv_path = RpcMessage::shvPath(meta_data);
+		if(shv_path.isString())
+			wr.writeMapElement(Rpc::JSONRPC_SHV_PATH, shv_path);
+		if(is_response) {
+			wr.writeMapKey(Rpc::JSONRPC_RESULT);
+			wr.writeRawData(packed_value);
+		}
+		wr.writeContainerEnd();
+	}
+	out = os_packed_data.str();
+	return true;
+}
+
 void RpcDriver::onRpcDataReceived(Rpc::ProtocolType protocol_type, RpcValue::MetaData &&md, std::string &&data)
 {
 	//nInfo() << __FILE__ << RCV_LOG_ARROW << md.toStdString() << shv::chainpack::Utils::toHexElided(data, start_pos, 100);
@@ -38,8 +38,33 @@ public:
 	static size_t decodeMetaData(RpcValue::MetaData &meta_data, Rpc::ProtocolType protocol_type, const std::string &data, size_t start_pos);
 	static RpcValue decodeData(Rpc::ProtocolType protocol_type, const std::string &data, size_t start_pos);
 	static std::string codeRpcValue(Rpc::ProtocolType protocol_type, const RpcValue &val);
+	/// recode one value between ChainPack and Cpon byte streams without creating RpcValue,
+	/// JsonRpc as to_protocol means Cpon in JSON format
+	/// returns false if data cannot be transcoded, content of out is undefined then
+	static bool transcodeData(Rpc::ProtocolType from_protocol, const char *data, size_t size, Rpc::ProtocolType to_protocol, std::string &out);
+	/// JSON-RPC envelope of message with ChainPack packed data, params or result are transcoded directly
+	/// returns false for messages which have to be recoded by codeRpcValue(), like errors
+	static bool codeJsonRpcEnvelope(const RpcValue::MetaData &meta_data, const std::string &chainpack_data, std::string &out);
 
 	static std::string dataToPrettyCpon(shv::chainpack::Rpc::ProtocolType protocol_type, const shv::chainpack::RpcValue::MetaData &md, const std::string &data, size_t start_pos = 0, size_t data_len = 0);
+
+	/// cumulative traffic of this driver, counters are updated in the driver thread only
+	struct TrafficCounters
+	{
+		uint64_t bytesRead = 0;
+		uint64_t bytesWritten = 0;
+		uint64_t messagesReceived = 0;
+		uint64_t messagesSent = 0;
+	};
+	const TrafficCounters& trafficCounters() const {return m_trafficCounters;}
+	void resetTrafficCounters() {m_trafficCounters = TrafficCounters();}
+
+	size_t sendQueueLength() const {return m_sendQueue.size();}
+	size_t sendQueueBytes() const {return m_sendQueueBytes;}
+	/// bytes written by driver, but not sent to peer by underlying transport yet
+	virtual size_t transportBytesToWrite() const {return 0;}
+	/// whole outgoing backlog of the connection
+	size_t pendingBytesToWrite() const {return sendQueueBytes() + transportBytesToWrite();}
 protected:
 	struct MessageData
 	{
@@ -50,9 +75,13 @@ protected:
 		MessageData(std::string &&meta_data, std::string &&data) : metaData(std::move(meta_data)), data(std::move(data)) {}
 		MessageData(std::string &&data) : data(std::move(data)) {}
 		MessageData(MessageData &&) = default;
+		MessageData& operator=(MessageData &&) = default;
 
 		bool empty() const {return metaData.empty() && data.empty();}
 		size_t size() const {return metaData.size() + data.size();}
+		// used by RpcTracer only, kept unconditionally to have the same layout with tracing compiled in or out
+		int64_t traceRequestId = 0;
+		int64_t traceEnqueueNsec = 0;
 	};
 protected:
 	virtual bool isOpen() = 0;
@@ -75,13 +104,23 @@ protected:
 
 	/// add data to the output queue, send data from top of the queue
 	virtual void enqueueDataToSend(MessageData &&chunk_to_enqueue);
+	/// add data to the output queue only, drivers pacing writes by themselves
+	/// take queued messages by writeSendQueue() when transport can accept them
+	void appendToSendQueue(MessageData &&chunk_to_enqueue);
+	/// write message from top of the output queue
+	void writeSendQueue();
 
 	virtual void onRpcDataReceived(Rpc::ProtocolType protocol_type, RpcValue::MetaData &&md, std::string &&data);
 	virtual void onRpcValueReceived(const RpcValue &msg);
 	virtual void onProcessReadDataException(std::exception &e) = 0;
+	/// connection ID used to key RpcTracer spans of this driver
+	virtual int traceConnectionId() const {return 0;}
 
 	void lockSendQueueGuard();
 	void unlockSendQueueGuard();
+
+	/// time spent by decoding meta data of the message being processed by onRpcDataReceived()
+	int64_t lastMetaDataDecodeNsec() const {return m_lastMetaDataDecodeNsec;}
 private:
 	void processReadData();
 	void writeQueue();
@@ -89,6 +128,9 @@ private:
 private:
 	MessageReceivedCallback m_messageReceivedCallback = nullptr;
 	std::deque<MessageData> m_sendQueue;
+	size_t m_sendQueueBytes = 0;
+	TrafficCounters m_trafficCounters;
+	int64_t m_lastMetaDataDecodeNsec = 0;
 	bool m_topMessageDataHeaderWritten = false;
 	size_t m_topMessageDataBytesWrittenSoFar = 0;
 	std::string m_readData;
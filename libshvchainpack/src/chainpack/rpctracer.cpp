@@ -0,0 +1,246 @@
+#include "rpctracer.h"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace shv {
+namespace chainpack {
+
+constexpr size_t RpcTracer::DEFAULT_BUFFER_CAPACITY;
+
+namespace {
+
+struct TraceEvent
+{
+	const char *name;
+	char phase;
+	int connectionId;
+	int64_t requestId;
+	int64_t tsNsec;
+	int64_t durNsec;
+};
+
+/// ring buffer of one thread, the spin lock is contended only when buffers are dumped or cleared
+struct ThreadBuffer
+{
+	std::atomic_flag lock = ATOMIC_FLAG_INIT;
+	std::vector<TraceEvent> events;
+	size_t next = 0;
+	bool wrapped = false;
+	int threadId = 0;
+
+	void acquire() { while(lock.test_and_set(std::memory_order_acquire)) {} }
+	void release() { lock.clear(std::memory_order_release); }
+};
+
+std::atomic<bool> s_enabled(false);
+std::atomic<unsigned> s_sampleRate(1);
+std::atomic<size_t> s_bufferCapacity(RpcTracer::DEFAULT_BUFFER_CAPACITY);
+
+// buffers are kept when thread exits, so its events can be still dumped
+std::mutex s_buffersMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> s_buffers;
+
+ThreadBuffer* threadBuffer()
+{
+	thread_local std::shared_ptr<ThreadBuffer> buffer;
+	if(!buffer) {
+		buffer = std::make_shared<ThreadBuffer>();
+		buffer->events.resize(std::max<size_t>(1, s_bufferCapacity.load(std::memory_order_relaxed)));
+		std::lock_guard<std::mutex> guard(s_buffersMutex);
+		s_buffers.push_back(buffer);
+		buffer->threadId = static_cast<int>(s_buffers.size());
+	}
+	return buffer.get();
+}
+
+int processId()
+{
+#ifdef _WIN32
+	return _getpid();
+#else
+	return static_cast<int>(::getpid());
+#endif
+}
+
+void writeJsonString(std::ostream &os, const char *s)
+{
+	os << '"';
+	for(; *s; ++s) {
+		char c = *s;
+		if(c == '"' || c == '\\')
+			os << '\\' << c;
+		else if(static_cast<unsigned char>(c) < 0x20)
+			os << ' ';
+		else
+			os << c;
+	}
+	os << '"';
+}
+
+void writeUsec(std::ostream &os, int64_t nsec)
+{
+	// Chrome trace timestamps are in usec, keep nsec precision in the fraction part
+	os << nsec / 1000 << '.';
+	int64_t frac = nsec % 1000;
+	if(frac < 100)
+		os << '0';
+	if(frac < 10)
+		os << '0';
+	os << frac;
+}
+
+} // namespace
+
+bool RpcTracer::isEnabled()
+{
+	return s_enabled.load(std::memory_order_relaxed);
+}
+
+void RpcTracer::setEnabled(bool b)
+{
+	s_enabled.store(b, std::memory_order_relaxed);
+}
+
+unsigned RpcTracer::sampleRate()
+{
+	return s_sampleRate.load(std::memory_order_relaxed);
+}
+
+void RpcTracer::setSampleRate(unsigned n)
+{
+	s_sampleRate.store(n == 0? 1: n, std::memory_order_relaxed);
+}
+
+void RpcTracer::setBufferCapacity(size_t n)
+{
+	s_bufferCapacity.store(n, std::memory_order_relaxed);
+}
+
+bool RpcTracer::isSampled(int64_t request_id)
+{
+	unsigned rate = sampleRate();
+	if(rate <= 1)
+		return true;
+	if(request_id > 0)
+		return request_id % rate == 0;
+	// messages without request ID, like signals, are sampled by count
+	thread_local unsigned counter = 0;
+	return ++counter % rate == 0;
+}
+
+void RpcTracer::record(const char *name, char phase, int connection_id, int64_t request_id, int64_t ts_nsec, int64_t dur_nsec)
+{
+	ThreadBuffer *buff = threadBuffer();
+	buff->acquire();
+	buff->events[buff->next] = TraceEvent{name, phase, connection_id, request_id, ts_nsec, dur_nsec};
+	if(++buff->next == buff->events.size()) {
+		buff->next = 0;
+		buff->wrapped = true;
+	}
+	buff->release();
+}
+
+void RpcTracer::complete(const char *name, int connection_id, int64_t request_id, int64_t start_nsec, int64_t end_nsec)
+{
+	if(!isEnabled() || !isSampled(request_id))
+		return;
+	record(name, 'X', connection_id, request_id, start_nsec, end_nsec - start_nsec);
+}
+
+void RpcTracer::instant(const char *name, int connection_id, int64_t request_id)
+{
+	if(!isEnabled() || !isSampled(request_id))
+		return;
+	record(name, 'i', connection_id, request_id, nowNsec(), 0);
+}
+
+void RpcTracer::asyncBegin(const char *name, int connection_id, int64_t request_id)
+{
+	if(!isEnabled() || !isSampled(request_id))
+		return;
+	record(name, 'b', connection_id, request_id, nowNsec(), 0);
+}
+
+void RpcTracer::asyncEnd(const char *name, int connection_id, int64_t request_id)
+{
+	if(!isEnabled() || !isSampled(request_id))
+		return;
+	record(name, 'e', connection_id, request_id, nowNsec(), 0);
+}
+
+void RpcTracer::clear()
+{
+	std::lock_guard<std::mutex> guard(s_buffersMutex);
+	for(const auto &buff : s_buffers) {
+		buff->acquire();
+		buff->next = 0;
+		buff->wrapped = false;
+		buff->release();
+	}
+}
+
+std::string RpcTracer::toChromeTraceJson()
+{
+	const int pid = processId();
+	std::ostringstream os;
+	os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+	std::vector<TraceEvent> events;
+	std::lock_guard<std::mutex> guard(s_buffersMutex);
+	for(const auto &buff : s_buffers) {
+		buff->acquire();
+		if(buff->wrapped)
+			events.assign(buff->events.begin() + static_cast<std::ptrdiff_t>(buff->next), buff->events.end());
+		else
+			events.clear();
+		events.insert(events.end(), buff->events.begin(), buff->events.begin() + static_cast<std::ptrdiff_t>(buff->next));
+		int tid = buff->threadId;
+		buff->release();
+		for(const TraceEvent &e : events) {
+			if(!first)
+				os << ',';
+			first = false;
+			os << "\n{\"name\":";
+			writeJsonString(os, e.name);
+			os << ",\"cat\":\"rpc\",\"ph\":\"" << e.phase << "\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"ts\":";
+			writeUsec(os, e.tsNsec);
+			if(e.phase == 'X') {
+				os << ",\"dur\":";
+				writeUsec(os, e.durNsec);
+			}
+			else if(e.phase == 'i') {
+				os << ",\"s\":\"t\"";
+			}
+			else {
+				// async events are paired by id, use the same key for all the processes
+				os << ",\"id\":\"" << e.connectionId << ':' << e.requestId << '"';
+			}
+			os << ",\"args\":{\"connectionId\":" << e.connectionId << ",\"requestId\":" << e.requestId << "}}";
+		}
+	}
+	os << "\n]}\n";
+	return os.str();
+}
+
+bool RpcTracer::dumpChromeTrace(const std::string &file_name)
+{
+	std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+	if(!out)
+		return false;
+	out << toChromeTraceJson();
+	return static_cast<bool>(out);
+}
+
+} // namespace chainpack
+} // namespace shv
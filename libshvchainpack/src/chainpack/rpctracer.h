@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../shvchainpackglobal.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/// Per message latency tracing of the RPC pipeline.
+///
+/// Instrumentation macros are compiled in only when SHV_RPC_TRACING is defined (qmake CONFIG+=with-shvrpctracing),
+/// otherwise they expand to nothing and their arguments are not evaluated.
+/// All the libraries should be built with the same setting.
+/// Even when compiled in, tracing is off until RpcTracer::setEnabled(true) is called.
+///
+/// Spans are keyed by connection ID and request ID, sampling is decided by request ID,
+/// so all the spans of a sampled request are recorded in every process on its way.
+/// Recorded events can be dumped as Chrome trace JSON, which can be opened in Perfetto UI or chrome://tracing.
+#ifdef SHV_RPC_TRACING
+#define SHV_TRACE_SPAN(var, name, connection_id, request_id) shv::chainpack::RpcTracer::Span var(name, connection_id, request_id)
+#define SHV_TRACE_SPAN_SET_IDS(var, connection_id, request_id) var.setIds(connection_id, request_id)
+#define SHV_TRACE_SPAN_END(var) var.end()
+#define SHV_TRACE_INSTANT(name, connection_id, request_id) shv::chainpack::RpcTracer::instant(name, connection_id, request_id)
+#define SHV_TRACE_ASYNC_BEGIN(name, connection_id, request_id) shv::chainpack::RpcTracer::asyncBegin(name, connection_id, request_id)
+#define SHV_TRACE_ASYNC_END(name, connection_id, request_id) shv::chainpack::RpcTracer::asyncEnd(name, connection_id, request_id)
+#else
+#define SHV_TRACE_SPAN(var, name, connection_id, request_id)
+#define SHV_TRACE_SPAN_SET_IDS(var, connection_id, request_id)
+#define SHV_TRACE_SPAN_END(var)
+#define SHV_TRACE_INSTANT(name, connection_id, request_id)
+#define SHV_TRACE_ASYNC_BEGIN(name, connection_id, request_id)
+#define SHV_TRACE_ASYNC_END(name, connection_id, request_id)
+#endif
+
+namespace shv {
+namespace chainpack {
+
+class SHVCHAINPACK_DECL_EXPORT RpcTracer
+{
+public:
+	static constexpr size_t DEFAULT_BUFFER_CAPACITY = 64 * 1024;
+
+	static constexpr bool isCompiledIn()
+	{
+#ifdef SHV_RPC_TRACING
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	static bool isEnabled();
+	static void setEnabled(bool b);
+	/// record every n-th request, 1 records all
+	static unsigned sampleRate();
+	static void setSampleRate(unsigned n);
+	/// event count of every thread ring buffer, applied to buffers created later
+	static void setBufferCapacity(size_t n);
+
+	static int64_t nowNsec()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/// name must be a string literal, event stores just the pointer
+	static void complete(const char *name, int connection_id, int64_t request_id, int64_t start_nsec, int64_t end_nsec);
+	static void instant(const char *name, int connection_id, int64_t request_id);
+	/// async span can start and end in different threads, begin and end are paired by name, connection ID and request ID
+	static void asyncBegin(const char *name, int connection_id, int64_t request_id);
+	static void asyncEnd(const char *name, int connection_id, int64_t request_id);
+
+	static void clear();
+	static std::string toChromeTraceJson();
+	static bool dumpChromeTrace(const std::string &file_name);
+
+	class SHVCHAINPACK_DECL_EXPORT Span
+	{
+	public:
+		Span(const char *name, int connection_id, int64_t request_id)
+			: m_name(name), m_connectionId(connection_id), m_requestId(request_id), m_startNsec(isEnabled()? nowNsec(): 0) {}
+		~Span() { end(); }
+
+		/// IDs are often known after the span is started, sampling is decided when span ends
+		void setIds(int connection_id, int64_t request_id) { m_connectionId = connection_id; m_requestId = request_id; }
+		void end()
+		{
+			if(m_startNsec > 0) {
+				complete(m_name, m_connectionId, m_requestId, m_startNsec, nowNsec());
+				m_startNsec = 0;
+			}
+		}
+	private:
+		const char *m_name;
+		int m_connectionId;
+		int64_t m_requestId;
+		int64_t m_startNsec;
+	};
+private:
+	static bool isSampled(int64_t request_id);
+	static void record(const char *name, char phase, int connection_id, int64_t request_id, int64_t ts_nsec, int64_t dur_nsec);
+};
+
+} // namespace chainpack
+} // namespace shv
@@ -0,0 +1,508 @@
+#include "rpcvalueview.h"
+#include "chainpackreader.h"
+
+#include "../../c/cchainpack.h"
+
+#include <cstring>
+#include <streambuf>
+#include <istream>
+
+namespace shv {
+namespace chainpack {
+
+namespace {
+
+class Scanner
+{
+public:
+	Scanner(const char *data, size_t size, size_t pos)
+		: m_data(data)
+	{
+		ccpcp_unpack_context_init(&m_ctx, data + pos, size - pos, nullptr, nullptr);
+	}
+
+	size_t pos() const { return static_cast<size_t>(m_ctx.current - m_data); }
+	const ccpcp_item& item() const { return m_ctx.item; }
+
+	uint8_t peekByte()
+	{
+		const char *p = ccpcp_unpack_peek_byte(&m_ctx);
+		if(!p)
+			throwError("Unexpected end of data");
+		return static_cast<uint8_t>(*p);
+	}
+	bool atContainerEnd() { return peekByte() == CP_TERM; }
+	ccpcp_item_types next()
+	{
+		cchainpack_unpack_next(&m_ctx);
+		if(m_ctx.err_no != CCPCP_RC_OK)
+			throwError("Parse error: " + std::string(m_ctx.err_msg? m_ctx.err_msg: "") + " code: " + std::to_string(m_ctx.err_no));
+		return m_ctx.item.type;
+	}
+	void skipMetaData()
+	{
+		if(peekByte() == CP_MetaMap) {
+			next();
+			skipContainerRest();
+		}
+	}
+	void skipValue()
+	{
+		skipMetaData();
+		switch (next()) {
+		case CCPCP_ITEM_LIST:
+		case CCPCP_ITEM_MAP:
+		case CCPCP_ITEM_IMAP:
+			skipContainerRest();
+			break;
+		case CCPCP_ITEM_STRING:
+		case CCPCP_ITEM_BLOB:
+			readString(nullptr);
+			break;
+		case CCPCP_ITEM_CONTAINER_END:
+			throwError("Unexpected container end");
+		default:
+			break;
+		}
+	}
+	void skipContainerRest()
+	{
+		for(int depth = 1; depth > 0; ) {
+			switch (next()) {
+			case CCPCP_ITEM_LIST:
+			case CCPCP_ITEM_MAP:
+			case CCPCP_ITEM_IMAP:
+			case CCPCP_ITEM_META:
+				depth++;
+				break;
+			case CCPCP_ITEM_CONTAINER_END:
+				depth--;
+				break;
+			case CCPCP_ITEM_STRING:
+			case CCPCP_ITEM_BLOB:
+				readString(nullptr);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+	/// reads rest of current String or Blob item
+	void readString(std::string *str)
+	{
+		ccpcp_item_types type = m_ctx.item.type;
+		while(true) {
+			const ccpcp_string &it = m_ctx.item.as.String;
+			if(str)
+				str->append(it.chunk_start, it.chunk_size);
+			if(it.last_chunk)
+				break;
+			if(next() != type)
+				throwError("Unfinished string");
+		}
+	}
+	/// reads rest of current String item and compares it with s without copying
+	bool readStringEquals(const std::string &s)
+	{
+		bool eq = true;
+		size_t ix = 0;
+		while(true) {
+			const ccpcp_string &it = m_ctx.item.as.String;
+			if(eq) {
+				eq = ix + it.chunk_size <= s.size() && std::memcmp(s.data() + ix, it.chunk_start, it.chunk_size) == 0;
+				ix += it.chunk_size;
+			}
+			if(it.last_chunk)
+				break;
+			if(next() != CCPCP_ITEM_STRING)
+				throwError("Unfinished string");
+		}
+		return eq && ix == s.size();
+	}
+	[[noreturn]] void throwError(const std::string &msg)
+	{
+		throw ChainPackReader::ParseException("ChainPack view " + msg + " at pos: " + std::to_string(pos()), static_cast<long>(pos()));
+	}
+private:
+	const char *m_data;
+	ccpcp_unpack_context m_ctx;
+};
+
+class ViewStreamBuf : public std::streambuf
+{
+public:
+	ViewStreamBuf(const char *data, size_t size)
+	{
+		char *p = const_cast<char*>(data);
+		setg(p, p, p + size);
+	}
+};
+
+RpcValue::Type type_from_schema(uint8_t b)
+{
+	if(b < 128)
+		return (b & 64)? RpcValue::Type::Int: RpcValue::Type::UInt;
+	switch (b) {
+	case CP_Null: return RpcValue::Type::Null;
+	case CP_UInt: return RpcValue::Type::UInt;
+	case CP_Int: return RpcValue::Type::Int;
+	case CP_Double: return RpcValue::Type::Double;
+	case CP_Bool:
+	case CP_TRUE:
+	case CP_FALSE: return RpcValue::Type::Bool;
+	case CP_Blob: return RpcValue::Type::Blob;
+	case CP_String:
+	case CP_CString: return RpcValue::Type::String;
+	case CP_DateTime:
+	case CP_DateTimeEpoch_depr: return RpcValue::Type::DateTime;
+	case CP_List: return RpcValue::Type::List;
+	case CP_Map: return RpcValue::Type::Map;
+	case CP_IMap: return RpcValue::Type::IMap;
+	case CP_Decimal: return RpcValue::Type::Decimal;
+	default: break;
+	}
+	return RpcValue::Type::Invalid;
+}
+
+bool read_int_key(Scanner &sc, RpcValue::Int &key)
+{
+	switch (sc.next()) {
+	case CCPCP_ITEM_INT: key = static_cast<RpcValue::Int>(sc.item().as.Int); return true;
+	case CCPCP_ITEM_UINT: key = static_cast<RpcValue::Int>(sc.item().as.UInt); return true;
+	default: return false;
+	}
+}
+
+}
+
+//================================================================
+// RpcValueView::const_iterator
+//================================================================
+RpcValueView::const_iterator::const_iterator(const RpcValueView &container, size_t pos)
+	: m_data(container.m_data)
+	, m_size(container.m_size)
+	, m_hasKeys(container.isMap() || container.isIMap())
+	, m_withIndex(container.m_withIndex)
+{
+	load(pos);
+}
+
+void RpcValueView::const_iterator::load(size_t pos)
+{
+	if(pos >= m_size) {
+		m_keyPos = m_size;
+		return;
+	}
+	Scanner sc(m_data, m_size, pos);
+	if(sc.atContainerEnd()) {
+		m_keyPos = m_size;
+		return;
+	}
+	m_keyPos = pos;
+	if(m_hasKeys)
+		sc.skipValue();
+	m_valuePos = sc.pos();
+	sc.skipValue();
+	m_endPos = sc.pos();
+}
+
+RpcValueView RpcValueView::const_iterator::key() const
+{
+	if(!m_hasKeys || m_keyPos >= m_size)
+		return RpcValueView();
+	return RpcValueView(m_data + m_keyPos, m_valuePos - m_keyPos, m_withIndex);
+}
+
+RpcValueView RpcValueView::const_iterator::value() const
+{
+	if(m_keyPos >= m_size)
+		return RpcValueView();
+	return RpcValueView(m_data + m_valuePos, m_endPos - m_valuePos, m_withIndex);
+}
+
+RpcValueView::const_iterator &RpcValueView::const_iterator::operator++()
+{
+	load(m_endPos);
+	return *this;
+}
+
+//================================================================
+// RpcValueView
+//================================================================
+RpcValueView::RpcValueView(const char *data, size_t size, bool with_index)
+	: m_data(data)
+	, m_size(size)
+	, m_withIndex(with_index)
+{
+	if(!data || size == 0)
+		return;
+	Scanner sc(data, size, 0);
+	sc.skipMetaData();
+	m_valuePos = sc.pos();
+	m_type = type_from_schema(sc.peekByte());
+}
+
+size_t RpcValueView::size() const
+{
+	if(!isValid())
+		return 0;
+	Scanner sc(m_data, m_size, 0);
+	sc.skipValue();
+	return sc.pos();
+}
+
+RpcValueView RpcValueView::childView(size_t pos, size_t end_pos) const
+{
+	return RpcValueView(m_data + pos, end_pos - pos, m_withIndex);
+}
+
+RpcValue::MetaData RpcValueView::metaData() const
+{
+	RpcValue::MetaData ret;
+	if(hasMetaData()) {
+		ViewStreamBuf buf(m_data, m_valuePos);
+		std::istream in(&buf);
+		ChainPackReader rd(in);
+		rd.read(ret);
+	}
+	return ret;
+}
+
+RpcValueView RpcValueView::metaValue(RpcValue::Int key) const
+{
+	if(!hasMetaData())
+		return RpcValueView();
+	Scanner sc(m_data, m_valuePos, 0);
+	sc.next();
+	while(!sc.atContainerEnd()) {
+		RpcValue::Int k;
+		bool is_int = sc.peekByte() != CP_String && sc.peekByte() != CP_CString;
+		if(is_int) {
+			is_int = read_int_key(sc, k);
+		}
+		else {
+			sc.next();
+			sc.readString(nullptr);
+		}
+		if(is_int && k == key)
+			return childView(sc.pos(), m_valuePos);
+		sc.skipValue();
+	}
+	return RpcValueView();
+}
+
+RpcValueView RpcValueView::metaValue(const RpcValue::String &key) const
+{
+	if(!hasMetaData())
+		return RpcValueView();
+	Scanner sc(m_data, m_valuePos, 0);
+	sc.next();
+	while(!sc.atContainerEnd()) {
+		bool eq = false;
+		if(sc.next() == CCPCP_ITEM_STRING)
+			eq = sc.readStringEquals(key);
+		if(eq)
+			return childView(sc.pos(), m_valuePos);
+		sc.skipValue();
+	}
+	return RpcValueView();
+}
+
+double RpcValueView::toDouble() const
+{
+	if(!isValid())
+		return 0;
+	Scanner sc(m_data, m_size, m_valuePos);
+	const ccpcp_item &it = sc.item();
+	switch (sc.next()) {
+	case CCPCP_ITEM_DOUBLE: return it.as.Double;
+	case CCPCP_ITEM_INT: return static_cast<double>(it.as.Int);
+	case CCPCP_ITEM_UINT: return static_cast<double>(it.as.UInt);
+	case CCPCP_ITEM_BOOLEAN: return it.as.Bool;
+	case CCPCP_ITEM_DECIMAL: return ccpcp_decimal_to_double(it.as.Decimal.mantisa, it.as.Decimal.exponent);
+	default: return 0;
+	}
+}
+
+int64_t RpcValueView::toInt64() const
+{
+	if(!isValid())
+		return 0;
+	Scanner sc(m_data, m_size, m_valuePos);
+	const ccpcp_item &it = sc.item();
+	switch (sc.next()) {
+	case CCPCP_ITEM_INT: return it.as.Int;
+	case CCPCP_ITEM_UINT: return static_cast<int64_t>(it.as.UInt);
+	case CCPCP_ITEM_BOOLEAN: return it.as.Bool;
+	case CCPCP_ITEM_DOUBLE: return static_cast<int64_t>(it.as.Double);
+	case CCPCP_ITEM_DECIMAL: return static_cast<int64_t>(ccpcp_decimal_to_double(it.as.Decimal.mantisa, it.as.Decimal.exponent));
+	default: return 0;
+	}
+}
+
+uint64_t RpcValueView::toUInt64() const
+{
+	return static_cast<uint64_t>(toInt64());
+}
+
+bool RpcValueView::toBool() const
+{
+	if(!isValid())
+		return false;
+	Scanner sc(m_data, m_size, m_valuePos);
+	const ccpcp_item &it = sc.item();
+	switch (sc.next()) {
+	case CCPCP_ITEM_BOOLEAN: return it.as.Bool;
+	case CCPCP_ITEM_INT: return it.as.Int != 0;
+	case CCPCP_ITEM_UINT: return it.as.UInt != 0;
+	default: return false;
+	}
+}
+
+RpcValue::DateTime RpcValueView::toDateTime() const
+{
+	if(m_type != RpcValue::Type::DateTime)
+		return RpcValue::DateTime();
+	Scanner sc(m_data, m_size, m_valuePos);
+	sc.next();
+	const ccpcp_date_time &dt = sc.item().as.DateTime;
+	return RpcValue::DateTime::fromMSecsSinceEpoch(dt.msecs_since_epoch, dt.minutes_from_utc);
+}
+
+RpcValue::String RpcValueView::toString() const
+{
+	RpcValue::String ret;
+	if(m_type == RpcValue::Type::String || m_type == RpcValue::Type::Blob) {
+		Scanner sc(m_data, m_size, m_valuePos);
+		sc.next();
+		sc.readString(&ret);
+	}
+	return ret;
+}
+
+const RpcValueView::Index &RpcValueView::index() const
+{
+	if(!m_index) {
+		auto *index = new Index();
+		m_index.reset(index);
+		if(isList() || isMap() || isIMap()) {
+			Scanner sc(m_data, m_size, m_valuePos);
+			sc.next();
+			while(!sc.atContainerEnd()) {
+				IndexEntry e{0, std::string(), 0, 0};
+				if(isMap()) {
+					if(sc.next() == CCPCP_ITEM_STRING)
+						sc.readString(&e.skey);
+				}
+				else if(isIMap()) {
+					read_int_key(sc, e.ikey);
+				}
+				else {
+					e.ikey = static_cast<RpcValue::Int>(index->size());
+				}
+				e.valuePos = sc.pos();
+				sc.skipValue();
+				e.endPos = sc.pos();
+				index->push_back(std::move(e));
+			}
+		}
+	}
+	return *m_index;
+}
+
+size_t RpcValueView::count() const
+{
+	if(!(isList() || isMap() || isIMap()))
+		return 0;
+	if(m_withIndex)
+		return index().size();
+	size_t n = 0;
+	for(auto it = begin(); it != end(); ++it)
+		n++;
+	return n;
+}
+
+RpcValueView RpcValueView::at(RpcValue::Int i) const
+{
+	if(!(isList() || isIMap()) || (isList() && i < 0))
+		return RpcValueView();
+	if(m_withIndex) {
+		const Index &ix = index();
+		if(isList())
+			return static_cast<size_t>(i) < ix.size()? childView(ix[static_cast<size_t>(i)].valuePos, ix[static_cast<size_t>(i)].endPos): RpcValueView();
+		for(const IndexEntry &e : ix) {
+			if(e.ikey == i)
+				return childView(e.valuePos, e.endPos);
+		}
+		return RpcValueView();
+	}
+	Scanner sc(m_data, m_size, m_valuePos);
+	sc.next();
+	for(RpcValue::Int n = 0; !sc.atContainerEnd(); n++) {
+		bool found;
+		if(isList()) {
+			found = n == i;
+		}
+		else {
+			RpcValue::Int key;
+			found = read_int_key(sc, key) && key == i;
+		}
+		if(found)
+			return childView(sc.pos(), m_size);
+		sc.skipValue();
+	}
+	return RpcValueView();
+}
+
+RpcValueView RpcValueView::at(const RpcValue::String &key) const
+{
+	if(!isMap())
+		return RpcValueView();
+	if(m_withIndex) {
+		for(const IndexEntry &e : index()) {
+			if(e.skey == key)
+				return childView(e.valuePos, e.endPos);
+		}
+		return RpcValueView();
+	}
+	Scanner sc(m_data, m_size, m_valuePos);
+	sc.next();
+	while(!sc.atContainerEnd()) {
+		bool found = false;
+		if(sc.next() == CCPCP_ITEM_STRING)
+			found = sc.readStringEquals(key);
+		if(found)
+			return childView(sc.pos(), m_size);
+		sc.skipValue();
+	}
+	return RpcValueView();
+}
+
+RpcValueView::const_iterator RpcValueView::begin() const
+{
+	if(!(isList() || isMap() || isIMap()))
+		return end();
+	Scanner sc(m_data, m_size, m_valuePos);
+	sc.next();
+	return const_iterator(*this, sc.pos());
+}
+
+RpcValueView::const_iterator RpcValueView::end() const
+{
+	return const_iterator(*this, m_size);
+}
+
+RpcValue RpcValueView::toRpcValue() const
+{
+	RpcValue ret;
+	if(isValid()) {
+		ViewStreamBuf buf(m_data, m_size);
+		std::istream in(&buf);
+		ChainPackReader rd(in);
+		rd.read(ret);
+	}
+	return ret;
+}
+
+} // namespace chainpack
+} // namespace shv
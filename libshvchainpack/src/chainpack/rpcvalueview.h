@@ -0,0 +1,122 @@
+#pragma once
+
+#include "rpcvalue.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace shv {
+namespace chainpack {
+
+/// Read-only view of ChainPack encoded value.
+///
+/// Nothing is decoded in constructor, items are found by scanning the bytes on access,
+/// unneeded containers are skipped without creating RpcValue.
+/// If with_index is set, offsets of container items are collected on the first at() / count() call,
+/// so repeated random access to the same container does not rescan it.
+/// View does not own the data, they must outlive the view and all the views obtained from it.
+/// Malformed data throws ParseException on access.
+class SHVCHAINPACK_DECL_EXPORT RpcValueView
+{
+public:
+	class SHVCHAINPACK_DECL_EXPORT const_iterator
+	{
+	public:
+		/// key of Map or IMap item, invalid view for List
+		RpcValueView key() const;
+		RpcValueView value() const;
+		RpcValueView operator*() const {return value();}
+
+		const_iterator& operator++();
+		bool operator==(const const_iterator &o) const {return m_keyPos == o.m_keyPos;}
+		bool operator!=(const const_iterator &o) const {return !(*this == o);}
+	private:
+		friend class RpcValueView;
+		const_iterator(const RpcValueView &container, size_t pos);
+		void load(size_t pos);
+	private:
+		const char *m_data = nullptr;
+		size_t m_size = 0;
+		bool m_hasKeys = false;
+		bool m_withIndex = false;
+		size_t m_keyPos = 0;
+		size_t m_valuePos = 0;
+		size_t m_endPos = 0;
+	};
+public:
+	RpcValueView() {}
+	RpcValueView(const char *data, size_t size, bool with_index = false);
+	explicit RpcValueView(const std::string &data, bool with_index = false)
+		: RpcValueView(data.data(), data.size(), with_index) {}
+	RpcValueView(std::string &&data, bool with_index = false) = delete;
+
+	RpcValue::Type type() const {return m_type;}
+	const char* typeName() const {return RpcValue::typeToName(m_type);}
+	bool isValid() const {return m_type != RpcValue::Type::Invalid;}
+	bool isNull() const {return m_type == RpcValue::Type::Null;}
+	bool isInt() const {return m_type == RpcValue::Type::Int;}
+	bool isUInt() const {return m_type == RpcValue::Type::UInt;}
+	bool isString() const {return m_type == RpcValue::Type::String;}
+	bool isList() const {return m_type == RpcValue::Type::List;}
+	bool isMap() const {return m_type == RpcValue::Type::Map;}
+	bool isIMap() const {return m_type == RpcValue::Type::IMap;}
+
+	/// encoded value including meta-data
+	const char* data() const {return m_data;}
+	/// length of encoded value, value is scanned to find it
+	size_t size() const;
+
+	bool hasMetaData() const {return m_valuePos > 0;}
+	RpcValue::MetaData metaData() const;
+	RpcValueView metaValue(RpcValue::Int key) const;
+	RpcValueView metaValue(const RpcValue::String &key) const;
+
+	double toDouble() const;
+	RpcValue::Int toInt() const {return static_cast<RpcValue::Int>(toInt64());}
+	RpcValue::UInt toUInt() const {return static_cast<RpcValue::UInt>(toUInt64());}
+	int64_t toInt64() const;
+	uint64_t toUInt64() const;
+	bool toBool() const;
+	RpcValue::DateTime toDateTime() const;
+	/// String or Blob content
+	RpcValue::String toString() const;
+
+	/// number of List items or Map / IMap key-value pairs
+	size_t count() const;
+	bool has(RpcValue::Int i) const {return at(i).isValid();}
+	bool has(const RpcValue::String &key) const {return at(key).isValid();}
+	/// List item on index i or IMap value of key i
+	RpcValueView at(RpcValue::Int i) const;
+	RpcValueView at(const RpcValue::String &key) const;
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	RpcValue toRpcValue() const;
+private:
+	struct IndexEntry
+	{
+		RpcValue::Int ikey;
+		std::string skey;
+		size_t valuePos;
+		size_t endPos;
+	};
+	using Index = std::vector<IndexEntry>;
+
+	const Index& index() const;
+	RpcValueView childView(size_t pos, size_t end_pos) const;
+private:
+	const char *m_data = nullptr;
+	/// available bytes, views returned by at() are bounded by the end of parent only,
+	/// so the value can be shorter
+	size_t m_size = 0;
+	/// offset of value after meta-data
+	size_t m_valuePos = 0;
+	RpcValue::Type m_type = RpcValue::Type::Invalid;
+	bool m_withIndex = false;
+	mutable std::shared_ptr<const Index> m_index;
+};
+
+} // namespace chainpack
+} // namespace shv
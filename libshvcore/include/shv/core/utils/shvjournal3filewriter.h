@@ -0,0 +1 @@
+#include "../../../../src/utils/shvjournal3filewriter.h"
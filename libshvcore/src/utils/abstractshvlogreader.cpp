@@ -0,0 +1,13 @@
+#include "abstractshvlogreader.h"
+
+namespace shv {
+namespace core {
+namespace utils {
+
+AbstractShvLogReader::~AbstractShvLogReader()
+{
+}
+
+} // namespace utils
+} // namespace core
+} // namespace shv
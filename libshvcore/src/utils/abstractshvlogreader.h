@@ -0,0 +1,26 @@
+#ifndef SHV_CORE_UTILS_ABSTRACTSHVLOGREADER_H
+#define SHV_CORE_UTILS_ABSTRACTSHVLOGREADER_H
+
+#include "../shvcoreglobal.h"
+
+namespace shv {
+namespace core {
+namespace utils {
+
+class ShvJournalEntry;
+
+/// Common interface of all the log and journal readers
+class SHVCORE_DECL_EXPORT AbstractShvLogReader
+{
+public:
+	virtual ~AbstractShvLogReader();
+
+	virtual bool next() = 0;
+	virtual const ShvJournalEntry& entry() = 0;
+};
+
+} // namespace utils
+} // namespace core
+} // namespace shv
+
+#endif // SHV_CORE_UTILS_ABSTRACTSHVLOGREADER_H
@@ -3,6 +3,8 @@
 #include "patternmatcher.h"
 #include "shvjournalfilewriter.h"
 #include "shvjournalfilereader.h"
+#include "shvjournal3filewriter.h"
+#include "shvjournal3filereader.h"
 #include "shvlogheader.h"
 #include "shvpath.h"
 
@@ -16,6 +18,7 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <ctime>
 #include <regex>
 #include <dirent.h>
 #include <sys/types.h>
@@ -84,6 +87,21 @@ static bool mkpath(const std::string &dir_name)
 	return errno == EEXIST && is_dir(dir_name);
 }
 
+static bool dir_state(const std::string &dir_name, ShvFileJournal::JournalDirState &state)
+{
+	SHV_STATBUF st;
+	if(SHV_STAT(dir_name.data(), &st) != 0)
+		return false;
+	state.device = static_cast<uint64_t>(st.st_dev);
+	state.inode = static_cast<uint64_t>(st.st_ino);
+	state.mtimeSec = static_cast<int64_t>(st.st_mtime);
+#ifdef __linux__
+	state.mtimeNsec = static_cast<int64_t>(st.st_mtim.tv_nsec);
+#endif
+	state.recordedSec = static_cast<int64_t>(std::time(nullptr));
+	return true;
+}
+
 static int64_t file_size(const std::string &file_name)
 {
 	SHV_STATBUF st;
@@ -132,6 +150,7 @@ static constexpr size_t SEC_SEP_POS = MIN_SEP_POS + 3;
 static constexpr size_t MSEC_SEP_POS = SEC_SEP_POS + 3;
 
 const std::string ShvFileJournal::FILE_EXT = ".log2";
+const std::string ShvFileJournal::FILE_EXT3 = ".log3";
 
 ShvFileJournal::ShvFileJournal(std::string device_id, ShvFileJournal::SnapShotFn snf)
 	: m_snapShotFn(snf)
@@ -141,6 +160,10 @@ ShvFileJournal::ShvFileJournal(std::string device_id, ShvFileJournal::SnapShotFn
 	setDeviceId(device_id);
 }
 
+ShvFileJournal::~ShvFileJournal()
+{
+}
+
 //void ShvFileJournal::setDefaultAppendLogTSNowFn()
 //{
 //	m_appendLogTSNowFn = []() {return cp::RpcValue::DateTime::now().msecsSinceEpoch();};
@@ -174,6 +197,16 @@ const std::string &ShvFileJournal::journalDir()
 	return m_journalContext.journalDir;
 }
 
+void ShvFileJournal::setFileFormat(ShvFileJournal::FileFormat f)
+{
+	if(f == m_journalContext.fileFormat)
+		return;
+	m_journalContext.fileFormat = f;
+	m_journal3Writer.reset();
+	// force journal dir rescan
+	m_journalContext.journalSize = -1;
+}
+
 void ShvFileJournal::setFileSizeLimit(const std::string &n)
 {
 	setFileSizeLimit(str_to_size(n));
@@ -192,6 +225,7 @@ void ShvFileJournal::append(const ShvJournalEntry &entry)
 	}
 	catch (std::exception &e) {
 		logIShvJournal() << "Append to log failed, journal dir will be read again, SD card might be replaced:" << e.what();
+		m_journal3Writer.reset();
 	}
 	try {
 		ensureJournalDir();
@@ -203,33 +237,9 @@ void ShvFileJournal::append(const ShvJournalEntry &entry)
 	}
 }
 
-void ShvFileJournal::appendThrow(const ShvJournalEntry &entry)
+template<typename Writer>
+void ShvFileJournal::appendToWriter(Writer &wr, int64_t journal_file_start_msec, const ShvJournalEntry &entry)
 {
-	shvLogFuncFrame();// << "last file no:" << lastFileNo();
-
-	checkJournalContext_helper();
-	checkRecentTimeStamp();
-
-	int64_t msec = entry.epochMsec;
-	if(msec == 0)
-		msec = cp::RpcValue::DateTime::now().msecsSinceEpoch(); //m_appendLogTSNowFn();
-	if(msec < m_journalContext.recentTimeStamp)
-		msec = m_journalContext.recentTimeStamp;
-	int64_t journal_file_start_msec = 0;
-	if(m_journalContext.files.empty()) {
-		journal_file_start_msec = msec;
-	}
-	else if(m_journalContext.lastFileSize > m_fileSizeLimit) {
-		/// create new file
-		journal_file_start_msec = msec;
-	}
-	else {
-		journal_file_start_msec = m_journalContext.files[m_journalContext.files.size() - 1];
-	}
-	if(!m_journalContext.files.empty() && journal_file_start_msec < m_journalContext.files[m_journalContext.files.size() - 1])
-		SHV_EXCEPTION("Journal context corrupted!");
-
-	ShvJournalFileWriter wr(journalDir(), journal_file_start_msec, m_journalContext.recentTimeStamp);
 	ssize_t orig_fsz = wr.fileSize();
 	if(orig_fsz == 0) {
 		logMShvJournal() << "New log file:" << wr.fileName() << "created.";
@@ -251,12 +261,61 @@ void ShvFileJournal::appendThrow(const ShvJournalEntry &entry)
 			logMShvJournal() << "SnapShot function not defined";
 		}
 		m_journalContext.files.push_back(journal_file_start_msec);
+		updateJournalDirState();
 	}
 	wr.appendMonotonic(entry);
 	m_journalContext.recentTimeStamp = wr.recentTimeStamp();
 	ssize_t new_fsz = wr.fileSize();
 	m_journalContext.lastFileSize = new_fsz;
 	m_journalContext.journalSize += new_fsz - orig_fsz;
+}
+
+void ShvFileJournal::appendThrow(const ShvJournalEntry &entry)
+{
+	shvLogFuncFrame();// << "last file no:" << lastFileNo();
+
+	checkJournalContext_helper();
+	if(m_journalContext.files.empty() || m_journalContext.lastFileSize > m_fileSizeLimit) {
+		// new file will be created, dir state will be updated then,
+		// check it before, to not overlook changes done by someone else
+		if(!isJournalContextValid()) {
+			logMShvJournal() << "journal dir changed, rescan before new file creation";
+			checkJournalContext_helper(true);
+		}
+	}
+	checkRecentTimeStamp();
+
+	int64_t msec = entry.epochMsec;
+	if(msec == 0)
+		msec = cp::RpcValue::DateTime::now().msecsSinceEpoch(); //m_appendLogTSNowFn();
+	if(msec < m_journalContext.recentTimeStamp)
+		msec = m_journalContext.recentTimeStamp;
+	int64_t journal_file_start_msec = 0;
+	if(m_journalContext.files.empty()) {
+		journal_file_start_msec = msec;
+	}
+	else if(m_journalContext.lastFileSize > m_fileSizeLimit) {
+		/// create new file
+		journal_file_start_msec = msec;
+	}
+	else {
+		journal_file_start_msec = m_journalContext.files[m_journalContext.files.size() - 1];
+	}
+	if(!m_journalContext.files.empty() && journal_file_start_msec < m_journalContext.files[m_journalContext.files.size() - 1])
+		SHV_EXCEPTION("Journal context corrupted!");
+
+	if(m_journalContext.fileFormat == FileFormat::Log3) {
+		// keep log3 writer open, it would start new block on every reopen
+		std::string fn = m_journalContext.fileMsecToFilePath(journal_file_start_msec);
+		if(!m_journal3Writer || m_journal3Writer->fileName() != fn)
+			m_journal3Writer.reset(new ShvJournal3FileWriter(fn));
+		m_journal3Writer->setRecentTimeStamp(m_journalContext.recentTimeStamp);
+		appendToWriter(*m_journal3Writer, journal_file_start_msec, entry);
+	}
+	else {
+		ShvJournalFileWriter wr(journalDir(), journal_file_start_msec, m_journalContext.recentTimeStamp);
+		appendToWriter(wr, journal_file_start_msec, entry);
+	}
 	if(m_journalContext.journalSize > m_journalSizeLimit) {
 		rotateJournal();
 	}
@@ -296,12 +355,24 @@ std::string ShvFileJournal::JournalContext::fileMsecToFileName(int64_t msec)
 	return msecToBaseFileName(msec) + FILE_EXT;
 }
 
+const std::string &ShvFileJournal::JournalContext::fileExtension(ShvFileJournal::FileFormat format)
+{
+	return format == FileFormat::Log3? FILE_EXT3: FILE_EXT;
+}
+
 std::string ShvFileJournal::JournalContext::fileMsecToFilePath(int64_t file_msec) const
 {
-	std::string fn = fileMsecToFileName(file_msec);
+	std::string fn = msecToBaseFileName(file_msec) + fileExtension(fileFormat);
 	return journalDir + '/' + fn;
 }
 
+int64_t ShvFileJournal::JournalContext::findLastEntryDateTime(const std::string &fn) const
+{
+	if(fileFormat == FileFormat::Log3)
+		return ShvJournal3FileReader::findLastEntryDateTime(fn);
+	return ShvFileJournal::findLastEntryDateTime(fn);
+}
+
 void ShvFileJournal::checkJournalContext_helper(bool force)
 {
 	if(!m_journalContext.isConsistent() || force) {
@@ -338,9 +409,10 @@ bool ShvFileJournal::journalDirExists()
 void ShvFileJournal::rotateJournal()
 {
 	logMShvJournal() << "Rotating journal of size:" << m_journalContext.journalSize;
-	updateJournalFiles();
-	size_t file_sz = m_journalContext.files.size();
+	if(!isJournalContextValid())
+		updateJournalFiles();
 	size_t file_cnt = m_journalContext.files.size();
+	size_t deleted_cnt = 0;
 	for(int64_t file_msec : m_journalContext.files) {
 		if(file_cnt == 1) {
 			/// keep at least one file in case of bad limits configuration
@@ -350,11 +422,14 @@ void ShvFileJournal::rotateJournal()
 			break;
 		std::string fn = m_journalContext.fileMsecToFilePath(file_msec);
 		logMShvJournal() << "\t deleting file:" << fn;
+		if(m_journal3Writer && m_journal3Writer->fileName() == fn)
+			m_journal3Writer.reset();
 		m_journalContext.journalSize -= rm_file(fn);
-		file_sz--;
+		deleted_cnt++;
 		file_cnt--;
 	}
-	updateJournalStatus();
+	m_journalContext.files.erase(m_journalContext.files.begin(), m_journalContext.files.begin() + static_cast<ssize_t>(deleted_cnt));
+	updateJournalDirState();
 	logMShvJournal() << "New journal of size:" << m_journalContext.journalSize;
 }
 
@@ -419,6 +494,52 @@ void ShvFileJournal::convertLog1JournalDir()
 	}
 }
 
+void ShvFileJournal::convertLog2JournalDir()
+{
+	const std::string &journal_dir = journalDir();
+	std::vector<std::string> log2_files;
+	DIR *dir;
+	struct dirent *ent;
+	if ((dir = opendir (journal_dir.c_str())) != nullptr) {
+		while ((ent = readdir (dir)) != nullptr) {
+			std::string fn = ent->d_name;
+			if(shv::core::String::endsWith(fn, FILE_EXT))
+				log2_files.push_back(fn.substr(0, fn.size() - FILE_EXT.size()));
+		}
+		closedir (dir);
+	}
+	else {
+		shvError() << "Cannot read content of dir:" << journal_dir;
+		return;
+	}
+	if(log2_files.empty())
+		return;
+	shvInfo() << "======= Journal2 format file(s) found, converting to format 3";
+	m_journal3Writer.reset();
+	for(const std::string &base_fn : log2_files) {
+		std::string fn2 = journal_dir + '/' + base_fn + FILE_EXT;
+		std::string fn3 = journal_dir + '/' + base_fn + FILE_EXT3;
+		shvInfo() << "converting" << fn2 << "->" << fn3;
+		try {
+			convertLog2File(fn2, fn3);
+			rm_file(fn2);
+		}
+		catch (std::exception &e) {
+			shvError() << "cannot convert:" << fn2 << "to:" << fn3 << "error:" << e.what();
+			rm_file(fn3);
+		}
+	}
+	m_journalContext.journalSize = -1;
+}
+
+void ShvFileJournal::convertLog2File(const std::string &log2_file_name, const std::string &log3_file_name)
+{
+	ShvJournalFileReader rd(log2_file_name);
+	ShvJournal3FileWriter wr(log3_file_name);
+	while(rd.next())
+		wr.append(rd.entry());
+}
+
 #ifdef __unix
 #define DIRENT_HAS_TYPE_FIELD
 #endif
@@ -427,9 +548,46 @@ void ShvFileJournal::updateJournalStatus()
 	updateJournalFiles();
 }
 
+void ShvFileJournal::updateJournalDirState()
+{
+	if(!dir_state(m_journalContext.journalDir, m_journalDirState))
+		m_journalDirState = JournalDirState();
+}
+
+bool ShvFileJournal::isJournalContextValid()
+{
+	if(!m_journalContext.isConsistent())
+		return false;
+	JournalDirState st;
+	if(!dir_state(m_journalContext.journalDir, st) || !(st == m_journalDirState) || !m_journalDirState.isValid()) {
+		logMShvJournal() << "journal dir changed";
+		return false;
+	}
+	if(m_journalDirState.isRacy()) {
+		logMShvJournal() << "journal dir state is racy, it cannot be trusted";
+		return false;
+	}
+	// no file was created or deleted, but last file might be appended by someone else
+	if(!m_journalContext.files.empty()) {
+		std::string fn = m_journalContext.fileMsecToFilePath(m_journalContext.files[m_journalContext.files.size() - 1]);
+		int64_t sz = file_size(fn);
+		if(sz < 0)
+			return false;
+		if(sz != m_journalContext.lastFileSize) {
+			logMShvJournal() << "last file size changed:" << m_journalContext.lastFileSize << "->" << sz;
+			m_journalContext.journalSize += sz - m_journalContext.lastFileSize;
+			m_journalContext.lastFileSize = sz;
+			m_journalContext.recentTimeStamp = 0;
+		}
+	}
+	return true;
+}
+
 void ShvFileJournal::updateJournalFiles()
 {
 	logMShvJournal() << "FileShvJournal2::updateJournalFiles()";
+	// state has to be read before dir content to not miss changes done during scan
+	updateJournalDirState();
 	m_journalContext.journalSize = 0;
 	m_journalContext.lastFileSize = 0;
 	m_journalContext.files.clear();
@@ -438,7 +596,7 @@ void ShvFileJournal::updateJournalFiles()
 	struct dirent *ent;
 	if ((dir = opendir (m_journalContext.journalDir.c_str())) != nullptr) {
 		m_journalContext.journalSize = 0;
-		const std::string &ext = FILE_EXT;
+		const std::string &ext = m_journalContext.fileExtension(m_journalContext.fileFormat);
 		while ((ent = readdir (dir)) != nullptr) {
 #ifdef DIRENT_HAS_TYPE_FIELD
 			if(ent->d_type == DT_REG) {
@@ -500,7 +658,7 @@ void ShvFileJournal::checkRecentTimeStamp()
 	}
 	else {
 		std::string fn = m_journalContext.fileMsecToFilePath(m_journalContext.files[m_journalContext.files.size() - 1]);
-		m_journalContext.recentTimeStamp = findLastEntryDateTime(fn);
+		m_journalContext.recentTimeStamp = m_journalContext.findLastEntryDateTime(fn);
 		logMShvJournal() << "setting recent timestamp to last entry in:" << fn
 						 << "to:" << m_journalContext.recentTimeStamp << "epoch msec"
 						 << cp::RpcValue::DateTime::fromMSecsSinceEpoch(m_journalContext.recentTimeStamp).toIsoString();
@@ -601,19 +759,24 @@ int64_t ShvFileJournal::findLastEntryDateTime(const std::string &fn, ssize_t *p_
 
 const ShvFileJournal::JournalContext &ShvFileJournal::checkJournalContext()
 {
+	bool force = false;
 	try {
 		checkJournalContext_helper();
 	}
 	catch (std::exception &e) {
 		logIShvJournal() << "Check journal consistecy failed, journal dir will be read again, SD card might be replaced, error:" << e.what();
+		force = true;
+	}
+	if(force || !isJournalContextValid()) {
+		m_journal3Writer.reset();
+		checkJournalContext_helper(true);
 	}
-	checkJournalContext_helper(true);
 	return m_journalContext;
 }
 
 chainpack::RpcValue ShvFileJournal::getLog(const ShvGetLogParams &params)
 {
-	JournalContext ctx = checkJournalContext();
+	const JournalContext &ctx = checkJournalContext();
 	return getLog(ctx, params);
 }
 
@@ -737,38 +900,52 @@ chainpack::RpcValue ShvFileJournal::getLog(const ShvFileJournal::JournalContext
 		//}
 
 		PatternMatcher pattern_matcher(params);
+		/// returns false when log is complete
+		auto process_entry = [&](const ShvJournalEntry &e) {
+			if(!params.pathPattern.empty()) {
+				logDShvJournal() << "\t MATCHING:" << params.pathPattern << "vs:" << e.path;
+				if(!pattern_matcher.match(e.path, e.domain))
+					return true;
+				logDShvJournal() << "\t\t MATCH";
+			}
+			if(params_since_msec > 0 && e.epochMsec < params_since_msec) {
+				if(params.withSnapshot) {
+					if(e.sampleType == ShvJournalEntry::SampleType::Continuous) {
+						ShvJournalEntry e2 = e;
+						e2.epochMsec = params_since_msec;
+						snapshot[e2.path] = std::move(e2);
+					}
+				}
+				return true;
+			}
+			if(params.withSnapshot)
+				if(!write_snapshot())
+					return false;
+			if(params_until_msec == 0 || e.epochMsec < params_until_msec) { // keep interval open to make log merge simpler
+				return append_log_entry(e);
+			}
+			return false;
+		};
+		const auto first_file_it = file_it;
 		for(; file_it != journal_context.files.end(); file_it++) {
 			std::string fn = journal_context.fileMsecToFilePath(*file_it);
 			logDShvJournal() << "-------- opening file:" << fn;
-			ShvJournalFileReader rd(fn);
-			while(rd.next()) {
-				const ShvJournalEntry &e = rd.entry();
-				if(!params.pathPattern.empty()) {
-					logDShvJournal() << "\t MATCHING:" << params.pathPattern << "vs:" << e.path;
-					if(!pattern_matcher.match(e.path, e.domain))
-						continue;
-					logDShvJournal() << "\t\t MATCH";
+			if(journal_context.fileFormat == FileFormat::Log3) {
+				ShvJournal3FileReader rd(fn);
+				if(file_it == first_file_it && params_since_msec > 0 && !params.withSnapshot) {
+					// snapshot needs all the entries before since, only log without snapshot can skip them
+					rd.seek(params_since_msec);
 				}
-				if(params_since_msec > 0 && e.epochMsec < params_since_msec) {
-					if(params.withSnapshot) {
-						if(e.sampleType == ShvJournalEntry::SampleType::Continuous) {
-							ShvJournalEntry e2 = e;
-							e2.epochMsec = params_since_msec;
-							snapshot[e2.path] = std::move(e2);
-						}
-					}
+				while(rd.next()) {
+					if(!process_entry(rd.entry()))
+						goto log_finish;
 				}
-				else {
-					if(params.withSnapshot)
-						if(!write_snapshot())
-							goto log_finish;
-					if(params_until_msec == 0 || e.epochMsec < params_until_msec) { // keep interval open to make log merge simpler
-						if(!append_log_entry(e))
-							goto log_finish;
-					}
-					else {
+			}
+			else {
+				ShvJournalFileReader rd(fn);
+				while(rd.next()) {
+					if(!process_entry(rd.entry()))
 						goto log_finish;
-					}
 				}
 			}
 		}
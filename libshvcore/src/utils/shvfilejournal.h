@@ -8,11 +8,14 @@
 #include "shvgetlogparams.h"
 
 #include <functional>
+#include <memory>
 
 namespace shv {
 namespace core {
 namespace utils {
 
+class ShvJournal3FileWriter;
+
 class SHVCORE_DECL_EXPORT ShvFileJournal : public AbstractShvJournal
 {
 public:
@@ -21,11 +24,14 @@ public:
 	static constexpr char FIELD_SEPARATOR = '\t';
 	static constexpr char RECORD_SEPARATOR = '\n';
 	static const std::string FILE_EXT;
+	static const std::string FILE_EXT3;
+	enum class FileFormat {Log2, Log3};
 public:
 	using SnapShotFn = std::function<void (std::vector<ShvJournalEntry>&)>;
 	using TSNowFn = std::function<int64_t ()>;
 
 	ShvFileJournal(std::string device_id, SnapShotFn snf);
+	~ShvFileJournal() override;
 
 	void setJournalDir(std::string s);
 	const std::string& journalDir();
@@ -41,6 +47,9 @@ public:
 	void setDeviceId(std::string id) { m_journalContext.deviceId = std::move(id); }
 	std::string deviceType() const { return m_journalContext.deviceType; }
 	void setDeviceType(std::string type) { m_journalContext.deviceType = std::move(type); }
+	/// Log2 is text format, Log3 is binary ChainPack based format, see ShvJournal3FileWriter
+	void setFileFormat(FileFormat f);
+	FileFormat fileFormat() const { return m_journalContext.fileFormat; }
 
 	static int64_t findLastEntryDateTime(const std::string &fn, ssize_t *p_date_time_fpos = nullptr);
 	void append(const ShvJournalEntry &entry) override;
@@ -53,6 +62,9 @@ public:
 	shv::chainpack::RpcValue getSnapShotMap() override;
 
 	void convertLog1JournalDir();
+	/// convert all .log2 files in journal dir to .log3 format, converted .log2 files are deleted
+	void convertLog2JournalDir();
+	static void convertLog2File(const std::string &log2_file_name, const std::string &log3_file_name);
 public:
 	struct TxtColumn
 	{
@@ -76,6 +88,7 @@ public:
 		int64_t lastFileSize = -1;
 		int64_t recentTimeStamp = 0;
 		std::string journalDir;
+		FileFormat fileFormat = FileFormat::Log2;
 
 		std::string deviceId;
 		std::string deviceType;
@@ -86,8 +99,33 @@ public:
 		static int64_t fileNameToFileMsec(const std::string &fn);
 		static std::string msecToBaseFileName(int64_t msec);
 		static std::string fileMsecToFileName(int64_t msec);
+		static const std::string& fileExtension(FileFormat format);
 		std::string fileMsecToFilePath(int64_t file_msec) const;
+		int64_t findLastEntryDateTime(const std::string &fn) const;
+	};
+	struct JournalDirState
+	{
+		uint64_t device = 0;
+		uint64_t inode = 0;
+		int64_t mtimeSec = 0;
+		int64_t mtimeNsec = 0;
+		/// wall clock time when the state was read
+		int64_t recordedSec = 0;
+
+		bool isValid() const {return mtimeSec > 0;}
+		/// dir mtime is too close to the time it was read, another change within mtime granularity would not change it
+		bool isRacy() const {return recordedSec <= mtimeSec + MTIME_GRANULARITY_SEC;}
+		bool operator==(const JournalDirState &o) const
+		{
+			return device == o.device && inode == o.inode && mtimeSec == o.mtimeSec && mtimeNsec == o.mtimeNsec;
+		}
+		/// FAT stores mtime with 2 sec resolution, nanoseconds are read on Linux only
+		static constexpr int64_t MTIME_GRANULARITY_SEC = 2;
 	};
+	/// journal dir is rescanned only if its state differs from the one recorded on last change done by this journal,
+	/// or if the recorded state is racy, it means that the dir was changed less than MTIME_GRANULARITY_SEC before
+	/// the state was recorded, so next change done by someone else might keep the same mtime,
+	/// growth of the last file is detected by its size
 	const JournalContext& checkJournalContext();
 	static shv::chainpack::RpcValue getLog(const JournalContext &journal_context, const ShvGetLogParams &params);
 private:
@@ -97,15 +135,21 @@ private:
 	void rotateJournal();
 	void updateJournalStatus();
 	void updateJournalFiles();
+	void updateJournalDirState();
+	bool isJournalContextValid();
 	//int64_t lastEntryTimeStamp();
 	void checkRecentTimeStamp();
 	void ensureJournalDir();
 	bool journalDirExists();
 
 	void appendThrow(const ShvJournalEntry &entry);
+	template<typename Writer>
+	void appendToWriter(Writer &wr, int64_t journal_file_start_msec, const ShvJournalEntry &entry);
 private:
 	JournalContext m_journalContext;
+	JournalDirState m_journalDirState;
 
+	std::unique_ptr<ShvJournal3FileWriter> m_journal3Writer;
 	SnapShotFn m_snapShotFn;
 	int64_t m_fileSizeLimit = DEFAULT_FILE_SIZE_LIMIT;
 	int64_t m_journalSizeLimit = DEFAULT_JOURNAL_SIZE_LIMIT;
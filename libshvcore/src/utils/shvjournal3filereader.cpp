@@ -0,0 +1,216 @@
+#include "shvjournal3filereader.h"
+#include "shvjournal3filewriter.h"
+
+#include "../exception.h"
+#include "../log.h"
+
+#include <shv/chainpack/chainpackreader.h>
+
+#define logWShvJournal() shvCWarning("ShvJournal")
+#define logDShvJournal() shvCDebug("ShvJournal")
+
+namespace cp = shv::chainpack;
+
+namespace shv {
+namespace core {
+namespace utils {
+
+ShvJournal3FileReader::ShvJournal3FileReader(const std::string &file_name)
+	: m_fileName(file_name)
+{
+	m_ifstream.open(file_name, std::ios::binary);
+	if(!m_ifstream)
+		SHV_EXCEPTION("Cannot open file " + file_name + " for reading.");
+	m_ifstream.seekg(0, std::ios::end);
+	m_fileSize = m_ifstream.tellg();
+	m_ifstream.seekg(0);
+}
+
+ShvJournal3FileReader::~ShvJournal3FileReader()
+{
+}
+
+const std::vector<ShvJournal3FileReader::BlockInfo> &ShvJournal3FileReader::blockIndex()
+{
+	if(m_blockIndexValid)
+		return m_blockIndex;
+	m_blockIndexValid = true;
+	m_blockIndex.clear();
+	int64_t pos = 0;
+	char buff[ShvJournal3FileWriter::BLOCK_HEADER_SIZE];
+	while(pos + static_cast<int64_t>(sizeof(buff)) <= m_fileSize) {
+		m_ifstream.clear();
+		m_ifstream.seekg(pos);
+		m_ifstream.read(buff, sizeof(buff));
+		uint32_t block_len;
+		int64_t block_msec;
+		if(!m_ifstream || !ShvJournal3FileWriter::readBlockHeader(buff, block_len, block_msec)) {
+			logWShvJournal() << m_fileName << "invalid block header at:" << pos;
+			break;
+		}
+		if(block_len == 0 || pos + block_len > m_fileSize)
+			block_len = static_cast<uint32_t>(m_fileSize - pos);
+		m_blockIndex.push_back(BlockInfo{pos, block_len, block_msec});
+		if(block_len < sizeof(buff))
+			break;
+		pos += block_len;
+	}
+	return m_blockIndex;
+}
+
+bool ShvJournal3FileReader::loadBlock(int64_t pos)
+{
+	m_blockReader.reset();
+	char buff[ShvJournal3FileWriter::BLOCK_HEADER_SIZE];
+	if(pos + static_cast<int64_t>(sizeof(buff)) > m_fileSize)
+		return false;
+	m_ifstream.clear();
+	m_ifstream.seekg(pos);
+	m_ifstream.read(buff, sizeof(buff));
+	uint32_t block_len;
+	int64_t block_msec;
+	if(!m_ifstream || !ShvJournal3FileWriter::readBlockHeader(buff, block_len, block_msec)) {
+		logWShvJournal() << m_fileName << "invalid block header at:" << pos;
+		m_nextBlockPos = m_fileSize;
+		return false;
+	}
+	if(block_len == 0 || pos + block_len > m_fileSize)
+		block_len = static_cast<uint32_t>(m_fileSize - pos);
+	if(block_len < sizeof(buff)) {
+		m_nextBlockPos = m_fileSize;
+		return false;
+	}
+	m_blockData.resize(block_len - sizeof(buff));
+	m_ifstream.read(&m_blockData[0], static_cast<std::streamsize>(m_blockData.size()));
+	m_blockData.resize(static_cast<size_t>(m_ifstream.gcount()));
+	m_blockStream.clear();
+	m_blockStream.str(m_blockData);
+	m_blockReader.reset(new cp::ChainPackReader(m_blockStream));
+	m_blockRecentMsec = block_msec;
+	m_pathDict.clear();
+	m_domainDict.clear();
+	m_nextBlockPos = pos + block_len;
+	logDShvJournal() << m_fileName << "block loaded, pos:" << pos << "len:" << block_len;
+	return true;
+}
+
+bool ShvJournal3FileReader::readRecord()
+{
+	using RecordTag = ShvJournal3FileWriter::RecordTag;
+	cp::ChainPackReader &rd = *m_blockReader;
+	auto read_uint = [this, &rd]() {
+		bool ok;
+		uint64_t n = rd.readUIntData(&ok);
+		if(!ok)
+			throw cp::ChainPackReader::ParseException("Truncated record", m_blockStream.tellg());
+		return n;
+	};
+	while(true) {
+		// ChainPackReader does not read ahead between records, so stream position is the record boundary
+		if(m_blockStream.peek() == std::char_traits<char>::eof())
+			return false;
+		unsigned tag = static_cast<unsigned>(read_uint());
+		if(tag == RecordTag::PathDef) {
+			m_pathDict.push_back(rd.read().asString());
+			continue;
+		}
+		if(tag == RecordTag::DomainDef) {
+			m_domainDict.push_back(rd.read().asString());
+			continue;
+		}
+		if((tag & RecordTag::Entry) == 0)
+			throw cp::ChainPackReader::ParseException("Invalid record tag: " + std::to_string(tag), m_blockStream.tellg());
+		uint64_t zz_delta = read_uint();
+		int64_t delta = static_cast<int64_t>(zz_delta >> 1) ^ -static_cast<int64_t>(zz_delta & 1);
+		size_t path_id = read_uint();
+		if(path_id >= m_pathDict.size())
+			throw cp::ChainPackReader::ParseException("Invalid path id: " + std::to_string(path_id), m_blockStream.tellg());
+		m_currentEntry.path = m_pathDict[path_id];
+		if(tag & RecordTag::HasDomain) {
+			size_t domain_id = read_uint();
+			if(domain_id >= m_domainDict.size())
+				throw cp::ChainPackReader::ParseException("Invalid domain id: " + std::to_string(domain_id), m_blockStream.tellg());
+			m_currentEntry.domain = m_domainDict[domain_id];
+		}
+		if(tag & RecordTag::HasShortTime)
+			m_currentEntry.shortTime = static_cast<int>(read_uint());
+		if(tag & RecordTag::HasUserId)
+			m_currentEntry.userId = rd.read().asString();
+		m_currentEntry.sampleType = static_cast<ShvJournalEntry::SampleType>((tag & RecordTag::SampleTypeMask) >> RecordTag::SampleTypeShift);
+		if (m_currentEntry.sampleType == ShvJournalEntry::SampleType::Invalid) {
+			m_currentEntry.sampleType = ShvJournalEntry::SampleType::Continuous;
+		}
+		rd.read(m_currentEntry.value);
+		if(!m_currentEntry.value.isValid())
+			throw cp::ChainPackReader::ParseException("Truncated record value", m_blockStream.tellg());
+		m_blockRecentMsec += delta;
+		m_currentEntry.epochMsec = m_blockRecentMsec;
+		return true;
+	}
+}
+
+bool ShvJournal3FileReader::next()
+{
+	while(true) {
+		m_currentEntry = ShvJournalEntry();
+		if(!m_blockReader) {
+			if(!loadBlock(m_nextBlockPos))
+				return false;
+		}
+		try {
+			if(readRecord())
+				return true;
+		}
+		catch (cp::ChainPackReader::ParseException &e) {
+			logWShvJournal() << m_fileName << "corrupted block, rest of block will be skipped, error:" << e.what();
+		}
+		m_blockReader.reset();
+	}
+}
+
+bool ShvJournal3FileReader::last()
+{
+	const std::vector<BlockInfo> &index = blockIndex();
+	ShvJournalEntry last_entry;
+	// last block might contain corrupted data only
+	for(auto it = index.rbegin(); it != index.rend() && !last_entry.isValid(); ++it) {
+		if(!loadBlock(it->pos))
+			continue;
+		while(next())
+			last_entry = m_currentEntry;
+	}
+	m_blockReader.reset();
+	m_nextBlockPos = m_fileSize;
+	m_currentEntry = std::move(last_entry);
+	return m_currentEntry.isValid();
+}
+
+void ShvJournal3FileReader::seek(int64_t epoch_msec)
+{
+	const std::vector<BlockInfo> &index = blockIndex();
+	m_blockReader.reset();
+	m_nextBlockPos = index.empty()? m_fileSize: index[0].pos;
+	for(const BlockInfo &bi : index) {
+		if(bi.msec >= epoch_msec)
+			break;
+		m_nextBlockPos = bi.pos;
+	}
+}
+
+const ShvJournalEntry &ShvJournal3FileReader::entry()
+{
+	return m_currentEntry;
+}
+
+int64_t ShvJournal3FileReader::findLastEntryDateTime(const std::string &fn)
+{
+	ShvJournal3FileReader rd(fn);
+	if(rd.last())
+		return rd.entry().epochMsec;
+	logWShvJournal() << fn << "File does not contain record with valid date time";
+	return -1;
+}
+
+} // namespace utils
+} // namespace core
+} // namespace shv
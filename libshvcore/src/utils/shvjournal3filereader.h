@@ -0,0 +1,66 @@
+#ifndef SHV_CORE_UTILS_SHVJOURNAL3FILEREADER_H
+#define SHV_CORE_UTILS_SHVJOURNAL3FILEREADER_H
+
+#include "../shvcoreglobal.h"
+#include "shvjournalentry.h"
+#include "abstractshvlogreader.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <sstream>
+
+namespace shv {
+namespace chainpack { class ChainPackReader; }
+namespace core {
+namespace utils {
+
+/// Reader of binary journal file format (.log3), see ShvJournal3FileWriter for format description
+class SHVCORE_DECL_EXPORT ShvJournal3FileReader : public AbstractShvLogReader
+{
+public:
+	ShvJournal3FileReader(const std::string &file_name);
+	~ShvJournal3FileReader() override;
+
+	bool next() override;
+	bool last();
+	/// position reader to the last block starting before epoch_msec,
+	/// next() will return entries of this block and all the following ones
+	void seek(int64_t epoch_msec);
+	const ShvJournalEntry& entry() override;
+
+	static int64_t findLastEntryDateTime(const std::string &fn);
+private:
+	struct BlockInfo
+	{
+		int64_t pos;
+		int64_t length;
+		int64_t msec;
+	};
+	const std::vector<BlockInfo>& blockIndex();
+	bool loadBlock(int64_t pos);
+	bool readRecord();
+private:
+	std::string m_fileName;
+	std::ifstream m_ifstream;
+	int64_t m_fileSize = 0;
+	std::vector<BlockInfo> m_blockIndex;
+	bool m_blockIndexValid = false;
+
+	int64_t m_nextBlockPos = 0;
+	std::string m_blockData;
+	std::istringstream m_blockStream;
+	std::unique_ptr<shv::chainpack::ChainPackReader> m_blockReader;
+	int64_t m_blockRecentMsec = 0;
+	std::vector<std::string> m_pathDict;
+	std::vector<std::string> m_domainDict;
+
+	ShvJournalEntry m_currentEntry;
+};
+
+} // namespace utils
+} // namespace core
+} // namespace shv
+
+#endif // SHV_CORE_UTILS_SHVJOURNAL3FILEREADER_H
@@ -0,0 +1,223 @@
+#include "shvjournal3filewriter.h"
+#include "shvjournal3filereader.h"
+#include "shvjournalentry.h"
+#include "shvfilejournal.h"
+#include "../exception.h"
+#include "../log.h"
+
+#include <shv/chainpack/rpc.h>
+#include <shv/chainpack/chainpackwriter.h>
+
+#define logDShvJournal() shvCDebug("ShvJournal")
+
+namespace cp = shv::chainpack;
+
+namespace shv {
+namespace core {
+namespace utils {
+
+constexpr uint32_t ShvJournal3FileWriter::BLOCK_MAGIC;
+constexpr size_t ShvJournal3FileWriter::BLOCK_HEADER_SIZE;
+constexpr size_t ShvJournal3FileWriter::DEFAULT_BLOCK_SIZE_LIMIT;
+
+ShvJournal3FileWriter::ShvJournal3FileWriter(const std::string &file_name)
+	: m_fileName(file_name)
+{
+	open();
+}
+
+ShvJournal3FileWriter::ShvJournal3FileWriter(const std::string &journal_dir, int64_t journal_start_time, int64_t last_entry_ts)
+	: m_fileName(journal_dir + '/' + ShvFileJournal::JournalContext::msecToBaseFileName(journal_start_time) + ShvFileJournal::FILE_EXT3)
+	, m_recentTimeStamp(last_entry_ts)
+{
+	open();
+}
+
+void ShvJournal3FileWriter::writeBlockHeader(char *buff, uint32_t block_len, int64_t block_msec)
+{
+	auto put = [&buff](uint64_t n, int len) {
+		for (int i = 0; i < len; ++i) {
+			*buff++ = static_cast<char>(n & 0xff);
+			n >>= 8;
+		}
+	};
+	put(BLOCK_MAGIC, 4);
+	put(block_len, 4);
+	put(static_cast<uint64_t>(block_msec), 8);
+}
+
+bool ShvJournal3FileWriter::readBlockHeader(const char *buff, uint32_t &block_len, int64_t &block_msec)
+{
+	auto get = [&buff](int len) {
+		uint64_t n = 0;
+		for (int i = 0; i < len; ++i)
+			n |= static_cast<uint64_t>(static_cast<uint8_t>(*buff++)) << (8 * i);
+		return n;
+	};
+	if(get(4) != BLOCK_MAGIC)
+		return false;
+	block_len = static_cast<uint32_t>(get(4));
+	block_msec = static_cast<int64_t>(get(8));
+	return true;
+}
+
+void ShvJournal3FileWriter::open()
+{
+	{
+		// std::fstream cannot create file in in/out mode
+		std::ofstream f(m_fileName, std::ios::binary | std::ios::out | std::ios::app);
+		if(!f)
+			SHV_EXCEPTION("Cannot open file " + m_fileName + " for writing");
+	}
+	m_out.open(m_fileName, std::ios::binary | std::ios::in | std::ios::out);
+	if(!m_out)
+		SHV_EXCEPTION("Cannot open file " + m_fileName + " for writing");
+	m_out.seekg(0, std::ios::end);
+	int64_t file_size = m_out.tellg();
+	if(file_size > 0) {
+		// find last block and close it, appending always starts a new block
+		// this also covers the case, when last record or block header was not written completely
+		int64_t last_block_pos = -1;
+		int64_t pos = 0;
+		char buff[BLOCK_HEADER_SIZE];
+		while(pos + static_cast<int64_t>(BLOCK_HEADER_SIZE) <= file_size) {
+			m_out.seekg(pos);
+			m_out.read(buff, sizeof(buff));
+			uint32_t block_len;
+			int64_t block_msec;
+			if(!m_out || !readBlockHeader(buff, block_len, block_msec))
+				break;
+			last_block_pos = pos;
+			if(block_len == 0)
+				break;
+			pos += block_len;
+		}
+		m_out.clear();
+		if(last_block_pos < 0)
+			SHV_EXCEPTION("File " + m_fileName + " is not a journal file of version 3");
+		m_blockPos = last_block_pos;
+		m_blockSize = file_size - last_block_pos;
+		closeBlock();
+	}
+	m_out.seekp(0, std::ios::end);
+}
+
+void ShvJournal3FileWriter::closeBlock()
+{
+	if(m_blockPos < 0)
+		return;
+	char buff[BLOCK_HEADER_SIZE];
+	writeBlockHeader(buff, static_cast<uint32_t>(m_blockSize), 0);
+	m_out.seekp(m_blockPos + 4);
+	m_out.write(buff + 4, 4);
+	m_out.seekp(0, std::ios::end);
+	m_blockPos = -1;
+}
+
+void ShvJournal3FileWriter::startBlock(int64_t msec)
+{
+	closeBlock();
+	m_blockPos = m_out.tellp();
+	char buff[BLOCK_HEADER_SIZE];
+	writeBlockHeader(buff, 0, msec);
+	m_out.write(buff, sizeof(buff));
+	m_blockSize = BLOCK_HEADER_SIZE;
+	m_blockRecentMsec = msec;
+	m_pathDict.clear();
+	m_domainDict.clear();
+	logDShvJournal() << m_fileName << "new block at:" << m_blockPos;
+}
+
+ssize_t ShvJournal3FileWriter::fileSize()
+{
+	return m_out.tellp();
+}
+
+void ShvJournal3FileWriter::appendMonotonic(const ShvJournalEntry &entry)
+{
+	ssize_t fsz = fileSize();
+	if(m_recentTimeStamp == 0) {
+		if(fsz == 0)
+			m_recentTimeStamp = ShvFileJournal::JournalContext::fileNameToFileMsec(m_fileName);
+		else
+			m_recentTimeStamp = ShvJournal3FileReader::findLastEntryDateTime(m_fileName);
+	}
+	int64_t msec = entry.epochMsec;
+	if(msec == 0)
+		msec = cp::RpcValue::DateTime::now().msecsSinceEpoch();
+	if(msec < m_recentTimeStamp)
+		msec = m_recentTimeStamp;
+	append(msec, entry);
+}
+
+void ShvJournal3FileWriter::append(const ShvJournalEntry &entry)
+{
+	int64_t msec = entry.epochMsec;
+	if(msec == 0)
+		msec = cp::RpcValue::DateTime::now().msecsSinceEpoch();
+	append(msec, entry);
+}
+
+void ShvJournal3FileWriter::encodeEntry(int64_t msec, const ShvJournalEntry &entry)
+{
+	m_recordBuffer.str(std::string());
+	cp::ChainPackWriter wr(m_recordBuffer);
+	auto dict_id = [&wr](std::map<std::string, unsigned> &dict, RecordTag::Enum def_tag, const std::string &s) {
+		auto it = dict.find(s);
+		if(it != dict.end())
+			return it->second;
+		unsigned id = static_cast<unsigned>(dict.size());
+		dict[s] = id;
+		wr.writeUIntData(def_tag);
+		wr.write(cp::RpcValue(s));
+		return id;
+	};
+	unsigned path_id = dict_id(m_pathDict, RecordTag::PathDef, entry.path);
+	unsigned flags = RecordTag::Entry;
+	unsigned domain_id = 0;
+	if(!entry.domain.empty()) {
+		flags |= RecordTag::HasDomain;
+		domain_id = dict_id(m_domainDict, RecordTag::DomainDef, entry.domain == cp::Rpc::SIG_VAL_CHANGED? ShvJournalEntry::DOMAIN_VAL_CHANGE: entry.domain);
+	}
+	if(entry.shortTime >= 0)
+		flags |= RecordTag::HasShortTime;
+	if(!entry.userId.empty())
+		flags |= RecordTag::HasUserId;
+	flags |= (static_cast<unsigned>(entry.sampleType) << RecordTag::SampleTypeShift) & RecordTag::SampleTypeMask;
+	int64_t delta = msec - m_blockRecentMsec;
+	wr.writeUIntData(flags);
+	wr.writeUIntData((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+	wr.writeUIntData(path_id);
+	if(flags & RecordTag::HasDomain)
+		wr.writeUIntData(domain_id);
+	if(flags & RecordTag::HasShortTime)
+		wr.writeUIntData(static_cast<uint64_t>(entry.shortTime));
+	if(flags & RecordTag::HasUserId)
+		wr.write(cp::RpcValue(entry.userId));
+	wr.write(entry.value);
+	wr.flush();
+}
+
+void ShvJournal3FileWriter::append(int64_t msec, const ShvJournalEntry &entry)
+{
+	if(m_blockPos < 0)
+		startBlock(msec);
+	encodeEntry(msec, entry);
+	if(m_blockSize > static_cast<int64_t>(BLOCK_HEADER_SIZE)
+			&& m_blockSize + static_cast<int64_t>(m_recordBuffer.tellp()) > static_cast<int64_t>(m_blockSizeLimit)) {
+		startBlock(msec);
+		encodeEntry(msec, entry);
+	}
+	const std::string rec = m_recordBuffer.str();
+	m_out.write(rec.data(), static_cast<std::streamsize>(rec.size()));
+	m_out.flush();
+	if(!m_out)
+		SHV_EXCEPTION("Cannot write to file " + m_fileName);
+	m_blockSize += static_cast<int64_t>(rec.size());
+	m_blockRecentMsec = msec;
+	m_recentTimeStamp = msec;
+}
+
+} // namespace utils
+} // namespace core
+} // namespace shv
@@ -0,0 +1,92 @@
+#ifndef SHV_CORE_UTILS_SHVJOURNAL3FILEWRITER_H
+#define SHV_CORE_UTILS_SHVJOURNAL3FILEWRITER_H
+
+#include "../shvcoreglobal.h"
+
+#include <map>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+namespace shv {
+namespace core {
+namespace utils {
+
+class ShvJournalEntry;
+
+/// Binary journal file format (.log3)
+///
+/// File is a sequence of blocks, every block starts with fixed size header:
+///   uint32 magic, uint32 block length (0 for last block which is open for appending), int64 block start msec
+/// all header fields are little endian.
+/// Header is followed by records, every record starts with ChainPack UInt tag.
+///   PathDef: ChainPack String, defines next path id in block
+///   DomainDef: ChainPack String, defines next domain id in block
+///   Entry: tag contains flags, followed by UInt zig-zag encoded msec delta to previous entry in block,
+///          UInt path id, [UInt domain id], [UInt short time], [String user id], ChainPack value
+/// Path and domain dictionaries are block scoped, so every block can be read without reading the blocks before it.
+/// Block length is patched when the next block is started, what allows readers to hop over blocks when seeking.
+class SHVCORE_DECL_EXPORT ShvJournal3FileWriter
+{
+public:
+	static constexpr uint32_t BLOCK_MAGIC = 0x334a5653; // "SVJ3"
+	static constexpr size_t BLOCK_HEADER_SIZE = 16;
+	static constexpr size_t DEFAULT_BLOCK_SIZE_LIMIT = 64 * 1024;
+
+	struct RecordTag
+	{
+		enum Enum : unsigned {
+			PathDef = 1,
+			DomainDef,
+			Entry = 0x40,
+		};
+		enum EntryFlag : unsigned {
+			HasDomain = 1 << 0,
+			HasShortTime = 1 << 1,
+			HasUserId = 1 << 2,
+			SampleTypeShift = 3,
+			SampleTypeMask = 3 << SampleTypeShift,
+		};
+	};
+public:
+	ShvJournal3FileWriter(const std::string &file_name);
+	ShvJournal3FileWriter(const std::string &journal_dir, int64_t journal_start_time, int64_t last_entry_ts);
+
+	void appendMonotonic(const ShvJournalEntry &entry);
+	void append(const ShvJournalEntry &entry);
+
+	ssize_t fileSize();
+	const std::string& fileName() const { return m_fileName; }
+	int64_t recentTimeStamp() const { return m_recentTimeStamp; }
+	void setRecentTimeStamp(int64_t ts) { m_recentTimeStamp = ts; }
+
+	void setBlockSizeLimit(size_t n) { m_blockSizeLimit = n; }
+	size_t blockSizeLimit() const { return m_blockSizeLimit; }
+
+	static void writeBlockHeader(char *buff, uint32_t block_len, int64_t block_msec);
+	static bool readBlockHeader(const char *buff, uint32_t &block_len, int64_t &block_msec);
+private:
+	void open();
+	void append(int64_t msec, const ShvJournalEntry &entry);
+	void startBlock(int64_t msec);
+	void closeBlock();
+	void encodeEntry(int64_t msec, const ShvJournalEntry &entry);
+private:
+	std::string m_fileName;
+	std::fstream m_out;
+	int64_t m_recentTimeStamp = 0;
+	size_t m_blockSizeLimit = DEFAULT_BLOCK_SIZE_LIMIT;
+
+	int64_t m_blockPos = -1;
+	int64_t m_blockSize = 0;
+	int64_t m_blockRecentMsec = 0;
+	std::map<std::string, unsigned> m_pathDict;
+	std::map<std::string, unsigned> m_domainDict;
+	std::ostringstream m_recordBuffer;
+};
+
+} // namespace utils
+} // namespace core
+} // namespace shv
+
+#endif // SHV_CORE_UTILS_SHVJOURNAL3FILEWRITER_H
@@ -2,6 +2,9 @@
 #include "shvlogheader.h"
 #include "shvlogtypeinfo.h"
 
+#include <shv/chainpack/reflect.h>
+#include <shv/chainpack/rpc.h>
+
 namespace shv {
 namespace core {
 namespace utils {
@@ -45,6 +48,109 @@ chainpack::RpcValue ShvJournalEntry::toRpcValueMap() const
 	return m;
 }
 
+// keys are sorted like in RpcValue::Map
+SHV_REFLECT_MAP(ShvJournalEntry,
+	field("domain", &C::domain, [](const C &c) {return c.domain.empty();}),
+	field("epochMsec", &C::epochMsec),
+	field("path", &C::path, [](const C &c) {return c.path.empty();}),
+	field("sampleType",
+		[](const C &c) {return ShvLogTypeDescr::sampleTypeToString(c.sampleType);},
+		[](C &c, std::string &&s) {c.sampleType = ShvLogTypeDescr::sampleTypeFromString(s);},
+		[](const C &c) {return c.sampleType == ShvLogTypeDescr::SampleType::Continuous;}),
+	field("shortTime", &C::shortTime, [](const C &c) {return c.shortTime == ShvJournalEntry::NO_SHORT_TIME;}),
+	field("timestamp",
+		[](const C &c) {return c.dateTime();},
+		[](C &c, chainpack::RpcValue::DateTime &&dt) {if(c.epochMsec == 0) c.epochMsec = dt.msecsSinceEpoch();},
+		[](const C &c) {return c.epochMsec <= 0;}),
+	field("userId", &C::userId, [](const C &c) {return c.userId.empty();}),
+	field("value", &C::value, [](const C &c) {return !c.value.isValid();})
+)
+
+void shvWriteChainPack(chainpack::ChainPackWriter &wr, const ShvJournalEntry &entry)
+{
+	chainpack::reflect::writeReflected(wr, entry);
+}
+
+void shvReadChainPack(chainpack::ChainPackReader &rd, ShvJournalEntry &entry)
+{
+	chainpack::reflect::readReflected(rd, entry);
+}
+
+void shvWriteChainPack(chainpack::ChainPackWriter &wr, const ShvGetLogRow &row)
+{
+	const ShvJournalEntry &e = row.entry;
+	wr.writeContainerBegin(chainpack::RpcValue::Type::List);
+	wr.write_p(e.dateTime());
+	if(row.pathId > 0)
+		wr.write_p(static_cast<int64_t>(row.pathId));
+	else
+		wr.write_p(e.path);
+	wr.write(e.value);
+	if(e.shortTime == ShvJournalEntry::NO_SHORT_TIME)
+		wr.write_p(nullptr);
+	else
+		wr.write_p(static_cast<int64_t>(e.shortTime));
+	if(e.domain.empty() || e.domain == chainpack::Rpc::SIG_VAL_CHANGED)
+		wr.write_p(nullptr);
+	else
+		wr.write_p(e.domain);
+	wr.write_p(static_cast<int64_t>(e.sampleType));
+	if(e.userId.empty())
+		wr.write_p(nullptr);
+	else
+		wr.write_p(e.userId);
+	wr.writeContainerEnd();
+}
+
+void shvReadChainPack(chainpack::ChainPackReader &rd, ShvGetLogRow &row)
+{
+	using Column = ShvLogHeader::Column;
+	row = ShvGetLogRow();
+	if(!rd.readContainerBegin(CCPCP_ITEM_LIST))
+		return;
+	ShvJournalEntry &e = row.entry;
+	for(int column = 0; !rd.readContainerEnd(); column++) {
+		switch (column) {
+		case Column::Timestamp: {
+			chainpack::RpcValue::DateTime dt;
+			rd.read_p(dt);
+			e.epochMsec = dt.msecsSinceEpoch();
+			break;
+		}
+		case Column::Path:
+			if(rd.peekNext() == CCPCP_ITEM_STRING)
+				rd.read_p(e.path);
+			else
+				chainpack::reflect::read(rd, row.pathId);
+			break;
+		case Column::Value:
+			rd.read(e.value);
+			break;
+		case Column::ShortTime:
+			chainpack::reflect::read(rd, e.shortTime);
+			if(e.shortTime < 0)
+				e.shortTime = ShvJournalEntry::NO_SHORT_TIME;
+			break;
+		case Column::Domain:
+			rd.read_p(e.domain);
+			break;
+		case Column::SampleType:
+			chainpack::reflect::read(rd, e.sampleType);
+			if(e.sampleType == ShvJournalEntry::SampleType::Invalid)
+				e.sampleType = ShvJournalEntry::SampleType::Continuous;
+			break;
+		case Column::UserId:
+			rd.read_p(e.userId);
+			break;
+		default: {
+			chainpack::RpcValue unused;
+			rd.read(unused);
+			break;
+		}
+		}
+	}
+}
+
 chainpack::DataChange ShvJournalEntry::toDataChange() const
 {
 	shv::chainpack::DataChange ret(value, chainpack::RpcValue::DateTime::fromMSecsSinceEpoch(epochMsec), shortTime);
@@ -8,6 +8,7 @@
 #include <shv/chainpack/datachange.h>
 
 namespace shv {
+namespace chainpack { class ChainPackWriter; class ChainPackReader; }
 namespace core {
 namespace utils {
 
@@ -76,6 +77,19 @@ public:
 	shv::chainpack::DataChange toDataChange() const;
 };
 
+/// getLog result row, path is written as pathId if it is greater than 0, see ShvLogHeader::Column
+struct SHVCORE_DECL_EXPORT ShvGetLogRow
+{
+	ShvJournalEntry entry;
+	int pathId = 0;
+};
+
+/// write the same bytes as ShvJournalEntry::toRpcValueMap() and getLog row, see shv/chainpack/reflect.h
+SHVCORE_DECL_EXPORT void shvWriteChainPack(shv::chainpack::ChainPackWriter &wr, const ShvJournalEntry &entry);
+SHVCORE_DECL_EXPORT void shvReadChainPack(shv::chainpack::ChainPackReader &rd, ShvJournalEntry &entry);
+SHVCORE_DECL_EXPORT void shvWriteChainPack(shv::chainpack::ChainPackWriter &wr, const ShvGetLogRow &row);
+SHVCORE_DECL_EXPORT void shvReadChainPack(shv::chainpack::ChainPackReader &rd, ShvGetLogRow &row);
+
 } // namespace utils
 } // namespace core
 } // namespace shv
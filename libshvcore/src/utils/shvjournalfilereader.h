@@ -4,6 +4,7 @@
 #include "../shvcoreglobal.h"
 #include "shvjournalentry.h"
 #include "shvlogtypeinfo.h"
+#include "abstractshvlogreader.h"
 
 #include <string>
 #include <fstream>
@@ -14,14 +15,14 @@ namespace utils {
 
 class ShvLogHeader;
 
-class SHVCORE_DECL_EXPORT ShvJournalFileReader
+class SHVCORE_DECL_EXPORT ShvJournalFileReader : public AbstractShvLogReader
 {
 public:
 	ShvJournalFileReader(const std::string &file_name);
 
-	bool next();
+	bool next() override;
 	bool last();
-	const ShvJournalEntry& entry();
+	const ShvJournalEntry& entry() override;
 private:
 	std::string m_fileName;
 	std::ifstream m_ifstream;
@@ -5,6 +5,7 @@
 
 #include "shvlogheader.h"
 #include "shvjournalentry.h"
+#include "abstractshvlogreader.h"
 
 #include <shv/chainpack/chainpackreader.h>
 
@@ -18,15 +19,15 @@ namespace utils {
 
 class ShvJournalEntry;
 
-class SHVCORE_DECL_EXPORT ShvLogFileReader
+class SHVCORE_DECL_EXPORT ShvLogFileReader : public AbstractShvLogReader
 {
 public:
 	ShvLogFileReader(shv::chainpack::ChainPackReader *reader);
 	ShvLogFileReader(const std::string &file_name);
-	~ShvLogFileReader();
+	~ShvLogFileReader() override;
 
-	bool next();
-	const ShvJournalEntry& entry();
+	bool next() override;
+	const ShvJournalEntry& entry() override;
 
 	const ShvLogHeader &logHeader() const {return m_logHeader;}
 private:
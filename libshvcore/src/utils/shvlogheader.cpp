@@ -3,6 +3,8 @@
 #include "../stringview.h"
 #include "../exception.h"
 
+#include <shv/chainpack/reflect.h>
+
 #include <algorithm>
 
 namespace shv {
@@ -95,6 +97,67 @@ chainpack::RpcValue::MetaData ShvLogHeader::toMetaData() const
 	return md;
 }
 
+// meta-data keys are sorted like in RpcValue::Map
+SHV_REFLECT_META(ShvLogHeader,
+	field("dateTime", &C::m_dateTime, [](const C &c) {return !c.m_dateTime.isValid();}),
+	field("device",
+		[](const C &c) -> chainpack::RpcValue::Map {
+			chainpack::RpcValue::Map device;
+			if(!c.m_deviceId.empty())
+				device["id"] = c.m_deviceId;
+			if(!c.m_deviceType.empty())
+				device["type"] = c.m_deviceType;
+			return device;
+		},
+		[](C &c, chainpack::RpcValue::Map &&device) {
+			c.m_deviceId = device.value("id").asString();
+			c.m_deviceType = device.value("type").asString();
+		},
+		[](const C &c) {return c.m_deviceId.empty() && c.m_deviceType.empty();}),
+	field("fields", &C::m_fields, [](const C &c) {return c.m_fields.empty();}),
+	field("logParams",
+		[](const C &c) {return c.m_logParams.toRpcValue(false);},
+		[](C &c, chainpack::RpcValue &&params) {c.m_logParams = ShvGetLogParams::fromRpcValue(params);}),
+	field("logVersion", &C::m_logVersion),
+	field("pathsDict", &C::m_pathDict, [](const C &c) {return c.m_pathDict.empty();}),
+	field("recordCount", &C::m_recordCount),
+	field("recordCountLimit", &C::m_recordCountLimit),
+	field("recordCountLimitHit", &C::m_recordCountLimitHit),
+	field("since", &C::m_since, [](const C &c) {return !c.m_since.isValid();}),
+	field("typeInfo",
+		[](const C &c) {return c.typeInfo().toRpcValue();},
+		[](C &c, chainpack::RpcValue &&ti) {
+			if(ti.isMap())
+				c.m_typeInfos[ShvLogHeader::EMPTY_PREFIX_KEY] = ShvLogTypeInfo::fromRpcValue(ti);
+		},
+		[](const C &c) {return !(c.m_typeInfos.size() == 1 && c.m_typeInfos.count(ShvLogHeader::EMPTY_PREFIX_KEY));}),
+	field("typeInfos",
+		[](const C &c) -> chainpack::RpcValue::Map {
+			chainpack::RpcValue::Map m;
+			for(const auto &kv : c.m_typeInfos)
+				m[kv.first] = kv.second.toRpcValue();
+			return m;
+		},
+		[](C &c, chainpack::RpcValue::Map &&m) {
+			for(const auto &kv : m)
+				c.m_typeInfos[kv.first] = ShvLogTypeInfo::fromRpcValue(kv.second);
+		},
+		[](const C &c) {return c.m_typeInfos.empty() || (c.m_typeInfos.size() == 1 && c.m_typeInfos.count(ShvLogHeader::EMPTY_PREFIX_KEY));}),
+	field("until", &C::m_until, [](const C &c) {return !c.m_until.isValid();}),
+	field(ShvGetLogParams::KEY_WITH_PATHS_DICT, &C::m_withPathsDict),
+	field(ShvGetLogParams::KEY_WITH_SNAPSHOT, &C::m_withSnapShot)
+)
+
+void shvWriteChainPack(chainpack::ChainPackWriter &wr, const ShvLogHeader &header)
+{
+	chainpack::reflect::writeReflected(wr, header);
+}
+
+void shvReadChainPack(chainpack::ChainPackReader &rd, ShvLogHeader &header)
+{
+	chainpack::reflect::readReflected(rd, header);
+}
+
 const ShvLogTypeInfo &ShvLogHeader::typeInfo(const std::string &path_prefix) const
 {
 	auto it = m_typeInfos.find(path_prefix);
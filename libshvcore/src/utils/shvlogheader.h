@@ -10,6 +10,7 @@
 #include <shv/chainpack/rpcvalue.h>
 
 namespace shv {
+namespace chainpack { class ChainPackWriter; class ChainPackReader; }
 namespace core {
 class StringViewList;
 namespace utils {
@@ -68,10 +69,16 @@ public:
 	void setTypeInfo(ShvLogTypeInfo &&ti, const std::string &path_prefix = EMPTY_PREFIX_KEY);
 	void setTypeInfo(const ShvLogTypeInfo &ti, const std::string &path_prefix = EMPTY_PREFIX_KEY);
 	//void clearTypeInfo();
+
+	template<typename F> friend void shvReflectFields(const ShvLogHeader*, F &&fn);
 private:
 	std::map<std::string, ShvLogTypeInfo> m_typeInfos;
 };
 
+/// write the same bytes as ShvLogHeader::toMetaData(), see shv/chainpack/reflect.h
+SHVCORE_DECL_EXPORT void shvWriteChainPack(shv::chainpack::ChainPackWriter &wr, const ShvLogHeader &header);
+SHVCORE_DECL_EXPORT void shvReadChainPack(shv::chainpack::ChainPackReader &rd, ShvLogHeader &header);
+
 } // namespace utils
 } // namespace core
 } // namespace shv
@@ -0,0 +1,115 @@
+#include "shvlogmergereader.h"
+
+#include "../exception.h"
+
+#include <algorithm>
+
+namespace shv {
+namespace core {
+namespace utils {
+
+namespace {
+struct HeapGreater
+{
+	template<typename T>
+	bool operator()(const T &a, const T &b) const
+	{
+		if(a.epochMsec == b.epochMsec)
+			return a.sourceIndex > b.sourceIndex;
+		return a.epochMsec > b.epochMsec;
+	}
+};
+}
+
+ShvLogMergeReader::ShvLogMergeReader()
+{
+}
+
+void ShvLogMergeReader::addSource(AbstractShvLogReader *reader, const std::string &path_prefix)
+{
+	if(m_initialized)
+		SHV_EXCEPTION("Sources cannot be added after the reading started.");
+	Source src;
+	src.reader = reader;
+	src.pathPrefix = path_prefix;
+	m_sources.push_back(std::move(src));
+}
+
+void ShvLogMergeReader::pushSource(size_t source_index)
+{
+	m_heap.push_back(HeapItem{m_sources[source_index].reader->entry().epochMsec, source_index});
+	std::push_heap(m_heap.begin(), m_heap.end(), HeapGreater());
+}
+
+bool ShvLogMergeReader::isDuplicateSnapshotRecord(Source &src, const ShvJournalEntry &e)
+{
+	if(e.path == ShvJournalEntry::PATH_SNAPSHOT_BEGIN) {
+		src.inSnapshot = true;
+		return true;
+	}
+	if(e.path == ShvJournalEntry::PATH_SNAPSHOT_END) {
+		src.inSnapshot = false;
+		return true;
+	}
+	auto it = m_recentValues.find(e.path);
+	if(it == m_recentValues.end()) {
+		m_recentValues[e.path] = e.value;
+		return false;
+	}
+	if(src.inSnapshot && it->second == e.value)
+		return true;
+	it->second = e.value;
+	return false;
+}
+
+bool ShvLogMergeReader::next()
+{
+	if(!m_initialized) {
+		m_initialized = true;
+		m_heap.reserve(m_sources.size());
+		for (size_t i = 0; i < m_sources.size(); ++i) {
+			if(m_sources[i].reader->next())
+				pushSource(i);
+		}
+	}
+	while(true) {
+		// advance source of recently returned entry lazily, the entry is referenced until next() call
+		if(m_hasCurrentSource) {
+			m_hasCurrentSource = false;
+			if(m_sources[m_currentSource].reader->next())
+				pushSource(m_currentSource);
+		}
+		m_currentEntry = nullptr;
+		if(m_heap.empty())
+			return false;
+		std::pop_heap(m_heap.begin(), m_heap.end(), HeapGreater());
+		m_currentSource = m_heap.back().sourceIndex;
+		m_heap.pop_back();
+		m_hasCurrentSource = true;
+
+		Source &src = m_sources[m_currentSource];
+		const ShvJournalEntry &e = src.reader->entry();
+		if(src.pathPrefix.empty() || e.domain == ShvJournalEntry::DOMAIN_SHV_SYSTEM) {
+			m_currentEntry = &e;
+		}
+		else {
+			m_prefixedEntry = e;
+			m_prefixedEntry.path = src.pathPrefix + '/' + e.path;
+			m_currentEntry = &m_prefixedEntry;
+		}
+		if(m_isSnapshotDedup && isDuplicateSnapshotRecord(src, *m_currentEntry))
+			continue;
+		return true;
+	}
+}
+
+const ShvJournalEntry &ShvLogMergeReader::entry()
+{
+	if(m_currentEntry)
+		return *m_currentEntry;
+	return m_prefixedEntry = ShvJournalEntry();
+}
+
+} // namespace utils
+} // namespace core
+} // namespace shv
@@ -0,0 +1,62 @@
+#ifndef SHV_CORE_UTILS_SHVLOGMERGEREADER_H
+#define SHV_CORE_UTILS_SHVLOGMERGEREADER_H
+
+#include "../shvcoreglobal.h"
+#include "abstractshvlogreader.h"
+#include "shvjournalentry.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace shv {
+namespace core {
+namespace utils {
+
+/// Streaming k-way merge of any number of time ordered log readers.
+/// Entries with the same timestamp are returned in the order of sources.
+/// Sources are not owned by merge reader and they must outlive it.
+class SHVCORE_DECL_EXPORT ShvLogMergeReader : public AbstractShvLogReader
+{
+public:
+	ShvLogMergeReader();
+
+	/// path_prefix is prepended to all the paths except the ones with DOMAIN_SHV_SYSTEM
+	void addSource(AbstractShvLogReader *reader, const std::string &path_prefix = std::string());
+	/// skip SNAPSHOT_BEGIN/END markers and snapshot records not changing last returned value of the path
+	void setSnapshotDedup(bool b) { m_isSnapshotDedup = b; }
+	bool isSnapshotDedup() const { return m_isSnapshotDedup; }
+
+	bool next() override;
+	const ShvJournalEntry& entry() override;
+private:
+	struct Source
+	{
+		AbstractShvLogReader *reader;
+		std::string pathPrefix;
+		bool inSnapshot = false;
+	};
+	struct HeapItem
+	{
+		int64_t epochMsec;
+		size_t sourceIndex;
+	};
+	void pushSource(size_t source_index);
+	bool isDuplicateSnapshotRecord(Source &src, const ShvJournalEntry &e);
+private:
+	std::vector<Source> m_sources;
+	std::vector<HeapItem> m_heap;
+	bool m_initialized = false;
+	bool m_isSnapshotDedup = false;
+	size_t m_currentSource = 0;
+	bool m_hasCurrentSource = false;
+	const ShvJournalEntry *m_currentEntry = nullptr;
+	ShvJournalEntry m_prefixedEntry;
+	std::map<std::string, shv::chainpack::RpcValue> m_recentValues;
+};
+
+} // namespace utils
+} // namespace core
+} // namespace shv
+
+#endif // SHV_CORE_UTILS_SHVLOGMERGEREADER_H
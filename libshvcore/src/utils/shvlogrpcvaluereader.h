@@ -3,6 +3,7 @@
 
 #include "shvlogheader.h"
 #include "shvjournalentry.h"
+#include "abstractshvlogreader.h"
 
 namespace shv {
 namespace core {
@@ -10,13 +11,13 @@ namespace utils {
 
 class ShvJournalEntry;
 
-class SHVCORE_DECL_EXPORT ShvLogRpcValueReader
+class SHVCORE_DECL_EXPORT ShvLogRpcValueReader : public AbstractShvLogReader
 {
 public:
 	ShvLogRpcValueReader(const shv::chainpack::RpcValue &log, bool throw_exceptions = false);
 
-	bool next();
-	const ShvJournalEntry& entry() { return m_currentEntry; }
+	bool next() override;
+	const ShvJournalEntry& entry() override { return m_currentEntry; }
 
 	const ShvLogHeader &logHeader() const {return m_logHeader;}
 private:
@@ -1,5 +1,6 @@
 HEADERS += \
     $$PWD/abstractshvjournal.h \
+    $$PWD/abstractshvlogreader.h \
     $$PWD/crypt.h \
     $$PWD/serviceproviderpath.h \
     $$PWD/shvfilejournal.h \
@@ -7,7 +8,10 @@ HEADERS += \
     $$PWD/shvjournalentry.h \
     $$PWD/shvjournalfilereader.h \
     $$PWD/shvjournalfilewriter.h \
+    $$PWD/shvjournal3filereader.h \
+    $$PWD/shvjournal3filewriter.h \
     $$PWD/shvlogfilereader.h \
+    $$PWD/shvlogmergereader.h \
     $$PWD/shvlogheader.h \
     $$PWD/shvlogrpcvaluereader.h \
     $$PWD/shvlogtypeinfo.h \
@@ -20,6 +24,7 @@ HEADERS += \
 
 SOURCES += \
     $$PWD/abstractshvjournal.cpp \
+    $$PWD/abstractshvlogreader.cpp \
     $$PWD/crypt.cpp \
     $$PWD/serviceproviderpath.cpp \
     $$PWD/shvfilejournal.cpp \
@@ -27,7 +32,10 @@ SOURCES += \
     $$PWD/shvjournalentry.cpp \
     $$PWD/shvjournalfilereader.cpp \
     $$PWD/shvjournalfilewriter.cpp \
+    $$PWD/shvjournal3filereader.cpp \
+    $$PWD/shvjournal3filewriter.cpp \
     $$PWD/shvlogfilereader.cpp \
+    $$PWD/shvlogmergereader.cpp \
     $$PWD/shvlogheader.cpp \
     $$PWD/shvlogrpcvaluereader.cpp \
     $$PWD/shvlogtypeinfo.cpp \
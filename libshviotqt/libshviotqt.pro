@@ -3,6 +3,10 @@ message("including $$PWD")
 QT += network
 QT -= gui
 
+with-shvrpctracing {
+    DEFINES += SHV_RPC_TRACING
+}
+
 CONFIG += C++11
 CONFIG += hide_symbols
 
@@ -6,6 +6,10 @@
 #include <shv/core/stringview.h>
 #include <shv/coreqt/log.h>
 
+#include <QCryptographicHash>
+
+#include <array>
+
 namespace cp = shv::chainpack;
 
 namespace shv {
@@ -14,12 +18,97 @@ namespace node {
 
 static const char M_SIZE[] = "size";
 static const char M_READ[] = "read";
+static const char M_SHA1[] = "sha1";
+static const char M_CRC32[] = "crc32";
 static const char M_WRITE[] = "write";
+static const char M_APPEND[] = "append";
 static const char M_DELETE[] = "delete";
 static const char M_MKFILE[] = "mkfile";
 static const char M_MKDIR[] = "mkdir";
 static const char M_RMDIR[] = "rmdir";
 
+static const char KEY_OFFSET[] = "offset";
+static const char KEY_SIZE[] = "size";
+
+static constexpr qint64 HASH_CHUNK_SIZE = 64 * 1024;
+
+namespace {
+
+/// params: null for whole file or {"offset": n, "size": n}, both keys are optional
+/// size is -1 when it is not requested and file size is not known, file is read until EOF then
+void read_range_params(const cp::RpcValue &params, const QFile &f, qint64 &offset, qint64 &size)
+{
+	offset = 0;
+	size = -1;
+	if(params.isMap()) {
+		const cp::RpcValue::Map &m = params.asMap();
+		offset = m.value(KEY_OFFSET, 0).toInt64();
+		if(m.hasKey(KEY_SIZE))
+			size = m.value(KEY_SIZE).toInt64();
+	}
+	else if(params.isValid() && !params.isNull()) {
+		SHV_EXCEPTION("Invalid params, {\"offset\": n, \"size\": n} expected.");
+	}
+	const qint64 file_size = f.size();
+	// sequential and pseudo files (FIFOs, /proc, /sys) report size 0
+	if(f.isSequential() || file_size == 0) {
+		if(offset < 0)
+			SHV_EXCEPTION("Invalid offset: " + std::to_string(offset));
+		return;
+	}
+	if(offset < 0 || offset > file_size)
+		SHV_EXCEPTION("Invalid offset: " + std::to_string(offset) + ", file size: " + std::to_string(file_size));
+	if(size < 0 || size > file_size - offset)
+		size = file_size - offset;
+}
+
+void seek_file(QFile &f, qint64 offset)
+{
+	if(!f.isSequential()) {
+		if(!f.seek(offset))
+			SHV_EXCEPTION("Cannot seek to offset " + std::to_string(offset) + " in file " + f.fileName().toStdString());
+		return;
+	}
+	char buff[4096];
+	while(offset > 0) {
+		qint64 n = f.read(buff, qMin<qint64>(offset, sizeof(buff)));
+		if(n < 0)
+			SHV_EXCEPTION("Cannot read file " + f.fileName().toStdString() + ", error: " + f.errorString().toStdString());
+		if(n == 0)
+			break;
+		offset -= n;
+	}
+}
+
+void write_content(QFile &f, const cp::RpcValue &content)
+{
+	if(!(content.isString() || content.isBlob()))
+		SHV_EXCEPTION("Cannot write to file " + f.fileName().toStdString() + ". String or Blob content expected.");
+	auto bytes = content.asBytes();
+	qint64 n = f.write(reinterpret_cast<const char*>(bytes.first), static_cast<qint64>(bytes.second));
+	if(n != static_cast<qint64>(bytes.second))
+		SHV_EXCEPTION("Cannot write to file " + f.fileName().toStdString() + ", error: " + f.errorString().toStdString());
+}
+
+uint32_t crc32_update(uint32_t crc, const char *data, qint64 len)
+{
+	static const std::array<uint32_t, 256> table = []() {
+		std::array<uint32_t, 256> t;
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; ++k)
+				c = (c & 1)? 0xedb88320u ^ (c >> 1): c >> 1;
+			t[i] = c;
+		}
+		return t;
+	}();
+	for (qint64 i = 0; i < len; ++i)
+		crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+}
+
 LocalFSNode::LocalFSNode(const QString &root_path, Super *parent)
 	: Super(parent)
 	, m_rootDir(root_path)
@@ -32,11 +121,17 @@ chainpack::RpcValue LocalFSNode::callMethod(const ShvNode::StringViewList &shv_p
 		return ndSize(QString::fromStdString(shv_path.join('/')));
 	}
 	else if(method == M_READ) {
-		return ndRead(QString::fromStdString(shv_path.join('/')));
+		return ndRead(QString::fromStdString(shv_path.join('/')), params);
+	}
+	else if(method == M_SHA1 || method == M_CRC32) {
+		return ndHash(QString::fromStdString(shv_path.join('/')), method, params);
 	}
 	else if(method == M_WRITE) {
 		return ndWrite(QString::fromStdString(shv_path.join('/')), params);
 	}
+	else if(method == M_APPEND) {
+		return ndAppend(QString::fromStdString(shv_path.join('/')), params);
+	}
 	else if(method == M_DELETE) {
 		return ndDelete(QString::fromStdString(shv_path.join('/')));
 	}
@@ -94,8 +189,11 @@ static std::vector<cp::MetaMethod> meta_methods_file {
 	{cp::Rpc::METH_DIR, cp::MetaMethod::Signature::RetParam, 0, cp::Rpc::ROLE_BROWSE},
 	{cp::Rpc::METH_LS, cp::MetaMethod::Signature::RetParam, 0, cp::Rpc::ROLE_BROWSE},
 	{M_SIZE, cp::MetaMethod::Signature::RetVoid, 0, cp::Rpc::ROLE_BROWSE},
-	{M_READ, cp::MetaMethod::Signature::RetVoid, 0, cp::Rpc::ROLE_READ},
+	{M_READ, cp::MetaMethod::Signature::RetParam, 0, cp::Rpc::ROLE_READ},
+	{M_SHA1, cp::MetaMethod::Signature::RetParam, 0, cp::Rpc::ROLE_READ},
+	{M_CRC32, cp::MetaMethod::Signature::RetParam, 0, cp::Rpc::ROLE_READ},
 	{M_WRITE, cp::MetaMethod::Signature::RetParam, 0, cp::Rpc::ROLE_WRITE},
+	{M_APPEND, cp::MetaMethod::Signature::RetParam, 0, cp::Rpc::ROLE_WRITE},
 	{M_DELETE, cp::MetaMethod::Signature::RetVoid, 0, cp::Rpc::ROLE_SERVICE}
 };
 
@@ -154,40 +252,104 @@ cp::RpcValue LocalFSNode::ndSize(const QString &path)
 	return (unsigned)ndFileInfo(path).size();
 }
 
-chainpack::RpcValue LocalFSNode::ndRead(const QString &path)
+chainpack::RpcValue LocalFSNode::ndRead(const QString &path, const chainpack::RpcValue &methods_params)
 {
 	QFile f(m_rootDir.absolutePath() + '/' + path);
-	if(f.open(QFile::ReadOnly)) {
+	if(!f.open(QFile::ReadOnly))
+		SHV_EXCEPTION("Cannot open file " + f.fileName().toStdString() + " for reading.");
+	qint64 offset, size;
+	read_range_params(methods_params, f, offset, size);
+	cp::RpcValue::Blob blob;
+	if(size < 0) {
+		seek_file(f, offset);
 		QByteArray ba = f.readAll();
 		return cp::RpcValue::Blob(ba.constData(), ba.constData() + ba.size());
 	}
-	SHV_EXCEPTION("Cannot open file " + f.fileName().toStdString() + " for reading.");
+	// file of unknown size cannot be mapped
+	if(size > 0 && m_memoryMappedReadEnabled && offset + size <= f.size()) {
+		if(uchar *data = f.map(offset, size)) {
+			blob.assign(data, data + size);
+			f.unmap(data);
+			return cp::RpcValue(std::move(blob));
+		}
+		shvWarning() << "Cannot map file:" << f.fileName() << "error:" << f.errorString() << "falling back to read.";
+	}
+	if(size > 0) {
+		blob.resize(static_cast<size_t>(size));
+		seek_file(f, offset);
+		qint64 n = f.read(reinterpret_cast<char*>(blob.data()), size);
+		if(n < 0)
+			SHV_EXCEPTION("Cannot read file " + f.fileName().toStdString() + ", error: " + f.errorString().toStdString());
+		blob.resize(static_cast<size_t>(n));
+	}
+	return cp::RpcValue(std::move(blob));
+}
+
+chainpack::RpcValue LocalFSNode::ndHash(const QString &path, const std::string &method, const chainpack::RpcValue &methods_params)
+{
+	QFile f(m_rootDir.absolutePath() + '/' + path);
+	if(!f.open(QFile::ReadOnly))
+		SHV_EXCEPTION("Cannot open file " + f.fileName().toStdString() + " for reading.");
+	qint64 offset, size;
+	read_range_params(methods_params, f, offset, size);
+	seek_file(f, offset);
+	const bool is_sha1 = (method == M_SHA1);
+	QCryptographicHash sha1(QCryptographicHash::Sha1);
+	uint32_t crc = 0xffffffff;
+	// size < 0 means read until EOF
+	QByteArray buff(static_cast<int>(size < 0? HASH_CHUNK_SIZE: qMin(size, HASH_CHUNK_SIZE)), Qt::Uninitialized);
+	while(size != 0) {
+		qint64 n = f.read(buff.data(), size < 0? buff.size(): qMin<qint64>(size, buff.size()));
+		if(n < 0)
+			SHV_EXCEPTION("Cannot read file " + f.fileName().toStdString() + ", error: " + f.errorString().toStdString());
+		if(n == 0)
+			break;
+		if(is_sha1)
+			sha1.addData(buff.constData(), static_cast<int>(n));
+		else
+			crc = crc32_update(crc, buff.constData(), n);
+		if(size > 0)
+			size -= n;
+	}
+	if(is_sha1)
+		return sha1.result().toHex().toStdString();
+	return cp::RpcValue(static_cast<unsigned>(crc ^ 0xffffffff));
 }
 
 chainpack::RpcValue LocalFSNode::ndWrite(const QString &path, const chainpack::RpcValue &methods_params)
 {
 	QFile f(m_rootDir.absolutePath() + '/' + path);
 
-	if (methods_params.isString()){
+	if (methods_params.isString() || methods_params.isBlob()){
 		if(f.open(QFile::WriteOnly)) {
-			const chainpack::RpcValue::String &content = methods_params.asString();
-			f.write(content.data(), content.size());
+			write_content(f, methods_params);
 			return true;
 		}
 		SHV_EXCEPTION("Cannot open file " + f.fileName().toStdString() + " for writing.");
 	}
 	else if (methods_params.isList()){
-		chainpack::RpcValue::List params = methods_params.toList();
+		const chainpack::RpcValue::List &params = methods_params.asList();
 
 		if (params.size() != 2){
 			SHV_EXCEPTION("Cannot write to file " + f.fileName().toStdString() + ". Invalid parameters count.");
 		}
-		chainpack::RpcValue::Map flags = params[1].toMap();
+		const chainpack::RpcValue::Map &flags = params[1].asMap();
+		if(flags.hasKey(KEY_OFFSET)) {
+			// chunk written at offset, file is not truncated
+			qint64 offset = flags.value(KEY_OFFSET).toInt64();
+			if(!f.open(QFile::ReadWrite))
+				SHV_EXCEPTION("Cannot open file " + f.fileName().toStdString() + " for writing.");
+			if(offset < 0 || offset > f.size())
+				SHV_EXCEPTION("Invalid offset: " + std::to_string(offset) + ", file size: " + std::to_string(f.size()));
+			if(!f.seek(offset))
+				SHV_EXCEPTION("Cannot seek to offset " + std::to_string(offset) + " in file " + f.fileName().toStdString());
+			write_content(f, params[0]);
+			return true;
+		}
 		QFile::OpenMode open_mode = (flags.value("append").toBool()) ? QFile::Append : QFile::WriteOnly;
 
 		if(f.open(open_mode)) {
-			const chainpack::RpcValue::String &content = params[0].toString();
-			f.write(content.data(), content.size());
+			write_content(f, params[0]);
 			return true;
 		}
 		SHV_EXCEPTION("Cannot open file " + f.fileName().toStdString() + " for writing.");
@@ -199,6 +361,15 @@ chainpack::RpcValue LocalFSNode::ndWrite(const QString &path, const chainpack::R
 	return false;
 }
 
+chainpack::RpcValue LocalFSNode::ndAppend(const QString &path, const chainpack::RpcValue &methods_params)
+{
+	QFile f(m_rootDir.absolutePath() + '/' + path);
+	if(!f.open(QFile::Append))
+		SHV_EXCEPTION("Cannot open file " + f.fileName().toStdString() + " for writing.");
+	write_content(f, methods_params);
+	return true;
+}
+
 chainpack::RpcValue LocalFSNode::ndDelete(const QString &path)
 {
 	QFile file (m_rootDir.absolutePath() + '/' + path);
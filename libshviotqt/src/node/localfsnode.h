@@ -24,19 +24,26 @@ public:
 
 	size_t methodCount(const StringViewList &shv_path) override;
 	const shv::chainpack::MetaMethod* metaMethod(const StringViewList &shv_path, size_t ix) override;
+
+	/// read chunks using QFile::map() instead of QFile::read(), file data are copied to the reply directly from page cache
+	void setMemoryMappedReadEnabled(bool b) { m_memoryMappedReadEnabled = b; }
+	bool isMemoryMappedReadEnabled() const { return m_memoryMappedReadEnabled; }
 private:
 	bool isDir(const ShvNode::StringViewList &shv_path) const;
 
 	QFileInfo ndFileInfo(const QString &path);
 	chainpack::RpcValue ndSize(const QString &path);
-	chainpack::RpcValue ndRead(const QString &path);
+	chainpack::RpcValue ndRead(const QString &path, const chainpack::RpcValue &methods_params);
+	chainpack::RpcValue ndHash(const QString &path, const std::string &method, const chainpack::RpcValue &methods_params);
 	chainpack::RpcValue ndWrite(const QString &path, const chainpack::RpcValue &methods_params);
+	chainpack::RpcValue ndAppend(const QString &path, const chainpack::RpcValue &methods_params);
 	chainpack::RpcValue ndDelete(const QString &path);
 	chainpack::RpcValue ndMkfile(const QString &path, const shv::chainpack::RpcValue &methods_params);
 	chainpack::RpcValue ndMkdir(const QString &path, const shv::chainpack::RpcValue &methods_params);
 	chainpack::RpcValue ndRmdir(const QString &path, bool recursively);
 protected:
 	QDir m_rootDir;
+	bool m_memoryMappedReadEnabled = false;
 };
 
 } // namespace node
@@ -2,12 +2,14 @@ HEADERS += \
     $$PWD/shvnodetree.h \
     $$PWD/shvnode.h \
     $$PWD/localfsnode.h \
+    $$PWD/usercommandauditsink.h \
     #$$PWD/shvtreenode.h
 
 SOURCES += \
     $$PWD/shvnodetree.cpp \
     $$PWD/shvnode.cpp \
     $$PWD/localfsnode.cpp \
+    $$PWD/usercommandauditsink.cpp \
     #$$PWD/shvtreenode.cpp
 
 
@@ -1,4 +1,5 @@
 #include "shvnode.h"
+#include "usercommandauditsink.h"
 #include "../utils.h"
 
 #include <shv/core/utils/shvfilejournal.h>
@@ -11,6 +12,7 @@
 #include <shv/chainpack/cponreader.h>
 #include <shv/chainpack/cponwriter.h>
 #include <shv/chainpack/accessgrant.h>
+#include <shv/chainpack/rpctracer.h>
 #include <shv/core/stringview.h>
 #include <shv/core/exception.h>
 #include <shv/core/stringview.h>
@@ -19,8 +21,10 @@
 
 #include <QTimer>
 #include <QFile>
+#include <QChildEvent>
 #include <cstring>
 #include <fstream>
+#include <typeinfo>
 
 namespace cp = shv::chainpack;
 
@@ -38,6 +42,9 @@ ShvNode::ShvNode(ShvNode *parent)
 	: QObject(parent)
 {
 	shvDebug() << __FUNCTION__ << this;
+	// ChildAdded event was sent before this object became ShvNode, index it here
+	if(parent)
+		parent->addToChildIndex(this);
 }
 
 ShvNode::ShvNode(const std::string &node_id, ShvNode *parent)
@@ -55,6 +62,10 @@ ShvNode::~ShvNode()
 	}
 	setParentNode(nullptr);
 	*/
+	// parent is not ShvNode anymore when it is deleting its children
+	ShvNode *pnd = parentNode();
+	if(pnd)
+		pnd->removeFromChildIndex(this, m_nodeId);
 }
 
 ShvNode *ShvNode::parentNode() const
@@ -64,7 +75,8 @@ ShvNode *ShvNode::parentNode() const
 
 ShvNode *ShvNode::childNode(const ShvNode::String &name, bool throw_exc) const
 {
-	ShvNode *nd = findChild<ShvNode*>(QString::fromStdString(name), Qt::FindDirectChildrenOnly);
+	auto it = m_childIndex.find(name);
+	ShvNode *nd = (it == m_childIndex.end())? nullptr: it->second;
 	if(throw_exc && !nd)
 		SHV_EXCEPTION("Child node id: " + name + " doesn't exist, parent node: " + shvPath());
 	return nd;
@@ -79,32 +91,107 @@ void ShvNode::setNodeId(ShvNode::String &&n)
 {
 	setObjectName(QString::fromStdString(n));
 	shvDebug() << __FUNCTION__ << this << n;
+	ShvNode *pnd = parentNode();
+	if(pnd)
+		pnd->removeFromChildIndex(this, m_nodeId);
 	m_nodeId = std::move(n);
+	invalidateShvPath();
+	if(pnd)
+		pnd->addToChildIndex(this);
 }
 
 void ShvNode::setNodeId(const ShvNode::String &n)
 {
-	setObjectName(QString::fromStdString(n));
-	shvDebug() << __FUNCTION__ << this << n;
-	m_nodeId = n;
+	setNodeId(String(n));
 }
 
-shv::core::utils::ShvPath ShvNode::shvPath() const
+void ShvNode::addToChildIndex(ShvNode *nd)
 {
-	shv::core::utils::ShvPath ret;
-	const ShvNode *nd = this;
-	while(nd) {
-		if(!nd->isRootNode()) {
-			if(!ret.empty())
-				ret = '/' + ret;
-			ret = nd->nodeId() + ret;
+	auto range = m_childIndex.equal_range(nd->m_nodeId);
+	for(auto it = range.first; it != range.second; ++it)
+		if(it->second == nd)
+			return;
+	if(range.first != range.second)
+		shvWarning() << "Duplicate child node id:" << nd->m_nodeId << "parent node:" << shvPath();
+	m_childIndex.emplace(nd->m_nodeId, nd);
+	nd->invalidateShvPath();
+	invalidateLsDirCache();
+}
+
+void ShvNode::removeFromChildIndex(ShvNode *nd, const String &node_id)
+{
+	auto range = m_childIndex.equal_range(node_id);
+	for(auto it = range.first; it != range.second; ++it) {
+		if(it->second == nd) {
+			m_childIndex.erase(it);
+			nd->invalidateShvPath();
+			invalidateLsDirCache();
+			return;
+		}
+	}
+}
+
+void ShvNode::childEvent(QChildEvent *event)
+{
+	// children created by ShvNode constructor are indexed there, these events cover QObject::setParent() calls
+	// ShvNode children being destroyed remove itself in ~ShvNode, when they are not ShvNode anymore
+	if(event->added()) {
+		ShvNode *nd = qobject_cast<ShvNode*>(event->child());
+		if(nd)
+			addToChildIndex(nd);
+	}
+	else if(event->removed()) {
+		ShvNode *nd = qobject_cast<ShvNode*>(event->child());
+		if(nd)
+			removeFromChildIndex(nd, nd->m_nodeId);
+	}
+	QObject::childEvent(event);
+}
+
+const shv::core::utils::ShvPath &ShvNode::shvPath() const
+{
+	if(!m_isShvPathValid) {
+		if(isRootNode()) {
+			m_shvPath.clear();
 		}
 		else {
-			break;
+			ShvNode *pnd = parentNode();
+			if(pnd && !pnd->shvPath().empty()) {
+				m_shvPath = pnd->shvPath();
+				m_shvPath += '/';
+				m_shvPath += nodeId();
+			}
+			else {
+				m_shvPath = nodeId();
+			}
 		}
-		nd = nd->parentNode();
+		m_isShvPathValid = true;
 	}
-	return ret;
+	return m_shvPath;
+}
+
+void ShvNode::invalidateShvPath()
+{
+	// valid path of any node implies valid path of its parent,
+	// so subtree with invalid root cannot contain valid paths
+	if(!m_isShvPathValid)
+		return;
+	m_isShvPathValid = false;
+	for(const auto &kv : m_childIndex)
+		kv.second->invalidateShvPath();
+}
+
+void ShvNode::setLsDirCacheEnabled(bool b)
+{
+	m_isLsDirCacheEnabled = b;
+	m_lsDirCache.clear();
+}
+
+void ShvNode::invalidateLsDirCache()
+{
+	// ls with attributes contains hasChildren() of children, changes are propagated to parents
+	for(ShvNode *nd = this; nd; nd = nd->parentNode())
+		nd->m_lsDirCache.clear();
 }
 
 void ShvNode::deleteIfEmptyWithParents()
@@ -122,45 +209,65 @@ void ShvNode::deleteIfEmptyWithParents()
 	}
 }
 
+bool ShvNode::isOnePassDispatchEnabled() const
+{
+	// plain ShvNode cannot reimplement request handlers
+	return m_isOnePassDispatchEnabled || typeid(*this) == typeid(ShvNode);
+}
+
+ShvNode *ShvNode::resolveRequestNode(const StringViewList &shv_path, const std::string &method, size_t &path_ix)
+{
+	ShvNode *nd = this;
+	path_ix = 0;
+	while(true) {
+		if(nd->metaMethod(shv_path.mid(path_ix), method))
+			return nd;
+		if(path_ix == shv_path.size())
+			return nullptr;
+		ShvNode *child = nd->childNode(shv_path[path_ix].toString(), !shv::core::Exception::Throw);
+		if(!child)
+			return nullptr;
+		nd = child;
+		path_ix++;
+		if(!nd->isOnePassDispatchEnabled())
+			return nd;
+	}
+}
+
 void ShvNode::handleRawRpcRequest(cp::RpcValue::MetaData &&meta, std::string &&data)
 {
 	shvLogFuncFrame() << "node:" << nodeId() << "meta:" << meta.toPrettyString();
+	SHV_TRACE_SPAN(dispatch_span, "node.dispatch", cp::RpcMessage::peekCallerId(meta), cp::RpcMessage::requestId(meta).toInt64());
 	const chainpack::RpcValue::String method = cp::RpcMessage::method(meta).toString();
 	const chainpack::RpcValue::String shv_path_str = cp::RpcMessage::shvPath(meta).toString();
 	core::StringViewList shv_path = shv::core::utils::ShvPath::split(shv_path_str);
 	cp::RpcResponse resp = cp::RpcResponse::forRequest(meta);
 	try {
-		const chainpack::MetaMethod *mm = metaMethod(shv_path, method);
-		if(mm) {
-			std::string errmsg;
-			cp::RpcMessage rpc_msg = cp::RpcDriver::composeRpcMessage(std::move(meta), data, &errmsg);
-			if(!errmsg.empty())
-				SHV_EXCEPTION(errmsg);
-
-			cp::RpcRequest rq(rpc_msg);
-			chainpack::RpcValue ret_val = processRpcRequest(rq);
-			if(ret_val.isValid()) {
-				resp.setResult(ret_val);
-			}
+		// resolve whole path in one pass, shv path in meta is rewritten just once
+		size_t path_ix;
+		ShvNode *nd = resolveRequestNode(shv_path, method, path_ix);
+		if(!nd) {
+			core::utils::ShvPath path = shvPath();
+			if(!path.empty() && !shv_path_str.empty())
+				path += '/';
+			path += shv_path_str;
+			SHV_EXCEPTION("Method: '" + method + "' on path '" + path + "' doesn't exist");
 		}
-		else {
-			if(shv_path.empty()) {
-				SHV_EXCEPTION("Method: '" + method + "' on path '" + shvPath() + "' doesn't exist");
-			}
-			else {
-				//int client_id = cp::RpcMessage::peekCallerId(meta);
-				ShvNode *nd = childNode(shv_path.at(0).toString());
-				if(nd) {
-					std::string new_path = core::StringView::join(++shv_path.begin(), shv_path.end(), '/');
-					//cp::RpcValue::MetaData meta2(meta);
-					cp::RpcMessage::setShvPath(meta, new_path);
-					nd->handleRawRpcRequest(std::move(meta), std::move(data));
-					return;
-				}
-				else {
-					SHV_EXCEPTION("Method: '" + method + "' on path '" + shvPath() + '/' + shv_path_str + "' doesn't exist");
-				}
-			}
+		if(path_ix > 0)
+			cp::RpcMessage::setShvPath(meta, core::StringView::join(shv_path.begin() + static_cast<ssize_t>(path_ix), shv_path.end(), '/'));
+		if(nd != this && !nd->isOnePassDispatchEnabled()) {
+			nd->handleRawRpcRequest(std::move(meta), std::move(data));
+			return;
+		}
+		std::string errmsg;
+		cp::RpcMessage rpc_msg = cp::RpcDriver::composeRpcMessage(std::move(meta), data, &errmsg);
+		if(!errmsg.empty())
+			SHV_EXCEPTION(errmsg);
+
+		cp::RpcRequest rq(rpc_msg);
+		chainpack::RpcValue ret_val = nd->processRpcRequest(rq);
+		if(ret_val.isValid()) {
+			resp.setResult(ret_val);
 		}
 	}
 	catch (const chainpack::RpcException &e) {
@@ -190,35 +297,30 @@ void ShvNode::handleRpcRequest(const chainpack::RpcRequest &rq)
 	core::StringViewList shv_path = shv::core::utils::ShvPath::split(shv_path_str);
 	cp::RpcResponse resp = cp::RpcResponse::forRequest(rq);
 	try {
-		const chainpack::MetaMethod *mm = metaMethod(shv_path, method);
-		if(mm) {
-			chainpack::RpcValue ret_val = processRpcRequest(rq);
-			if(ret_val.isValid()) {
-				resp.setResult(ret_val);
+		size_t path_ix;
+		ShvNode *nd = resolveRequestNode(shv_path, method, path_ix);
+		if(!nd) {
+			core::utils::ShvPath path = shvPath();
+			if(!path.empty() && !shv_path_str.empty())
+				path += '/';
+			path += shv_path_str;
+			SHV_EXCEPTION("Method: '" + method + "' on path '" + path + "' doesn't exist");
+		}
+		chainpack::RpcValue ret_val;
+		if(path_ix > 0) {
+			chainpack::RpcRequest rq2(rq);
+			rq2.setShvPath(core::StringView::join(shv_path.begin() + static_cast<ssize_t>(path_ix), shv_path.end(), '/'));
+			if(!nd->isOnePassDispatchEnabled()) {
+				nd->handleRpcRequest(rq2);
+				return;
 			}
+			ret_val = nd->processRpcRequest(rq2);
 		}
 		else {
-			if(shv_path.empty()) {
-				SHV_EXCEPTION("Method: '" + method + "' on path '" + shvPath() + "' doesn't exist");
-			}
-			else {
-				ShvNode *nd = childNode(shv_path.at(0).toString(), !shv::core::Exception::Throw);
-				if(nd) {
-					std::string new_path = core::StringView::join(++shv_path.begin(), shv_path.end(), '/');
-					chainpack::RpcRequest rq2(rq);
-					//cp::RpcValue::MetaData meta2(meta);
-					rq2.setShvPath(new_path);
-					nd->handleRpcRequest(rq2);
-					return;
-				}
-				else {
-					core::utils::ShvPath path = shvPath();
-					if(!path.empty() && !shv_path_str.empty())
-						path += '/';
-					path += shv_path_str;
-					SHV_EXCEPTION("Method: '" + method + "' on path '" + path + "' doesn't exist");
-				}
-			}
+			ret_val = processRpcRequest(rq);
+		}
+		if(ret_val.isValid()) {
+			resp.setResult(ret_val);
 		}
 	}
 	catch (const chainpack::RpcException &e) {
@@ -254,6 +356,17 @@ chainpack::RpcValue ShvNode::processRpcRequest(const chainpack::RpcRequest &rq)
 		SHV_EXCEPTION(std::string("Call method: '") + method + "' on path '" + shvPath() + '/' + rq.shvPath().toString() + "' permission denied, grant: " + rq_grant.toCpon() + " required: " + mm_grant.toCpon());
 
 	if(mm_access_level >= cp::MetaMethod::AccessLevel::Write) {
+		ShvNode *root = rootNode();
+		if(root && root->m_userCommandAuditSink) {
+			UserCommandAuditSink::Command cmd;
+			cmd.epochMsec = cp::RpcValue::DateTime::now().msecsSinceEpoch();
+			cmd.shvPath = shvPath();
+			cmd.method = method;
+			cmd.params = rq.params();
+			cmd.userId = rq.userId().toString();
+			root->m_userCommandAuditSink->enqueue(std::move(cmd));
+			return callMethodRq(rq);
+		}
 		shv::core::utils::ShvJournalEntry e(shvPath()
 											, method + '(' + rq.params().toCpon() + ')'
 											, shv::core::utils::ShvJournalEntry::DOMAIN_SHV_COMMAND
@@ -297,11 +410,10 @@ ShvNode::StringList ShvNode::childNames(const StringViewList &shv_path)
 	shvLogFuncFrame() << "node:" << nodeId() << "shv_path:" << shv_path.join('/');
 	ShvNode::StringList ret;
 	if(shv_path.empty()) {
-		for (ShvNode *nd : ownChildren()) {
+		for (ShvNode *nd : ownChildren())
 			ret.push_back(nd->nodeId());
-			if(m_isSortedChildren)
-				std::sort(ret.begin(), ret.end());
-		}
+		if(m_isSortedChildren)
+			std::sort(ret.begin(), ret.end());
 	}
 	else if(shv_path.size() == 1) {
 		ShvNode *nd = childNode(shv_path.at(0).toString(), !shv::core::Exception::Throw);
@@ -423,6 +535,8 @@ chainpack::RpcValue ShvNode::ls(const StringViewList &shv_path, const chainpack:
 	return chainpack::RpcValue{ret};
 }
 
+static constexpr size_t LS_DIR_CACHE_MAX_SIZE = 1024;
+
 static std::vector<cp::MetaMethod> meta_methods {
 	{cp::Rpc::METH_DIR, cp::MetaMethod::Signature::RetParam, 0, cp::Rpc::ROLE_BROWSE},
 	{cp::Rpc::METH_LS, cp::MetaMethod::Signature::RetParam, 0, cp::Rpc::ROLE_BROWSE},
@@ -466,10 +580,19 @@ ShvNode::StringList ShvNode::methodNames(const StringViewList &shv_path)
 
 chainpack::RpcValue ShvNode::callMethod(const ShvNode::StringViewList &shv_path, const std::string &method, const chainpack::RpcValue &params)
 {
-	if(method == cp::Rpc::METH_DIR)
-		return dir(shv_path, params);
-	if(method == cp::Rpc::METH_LS)
-		return ls(shv_path, params);
+	if(method == cp::Rpc::METH_DIR || method == cp::Rpc::METH_LS) {
+		if(!m_isLsDirCacheEnabled)
+			return (method == cp::Rpc::METH_DIR)? dir(shv_path, params): ls(shv_path, params);
+		std::string key = method + ':' + shv_path.join('/') + ':' + params.toCpon();
+		auto it = m_lsDirCache.find(key);
+		if(it != m_lsDirCache.end())
+			return it->second;
+		cp::RpcValue ret = (method == cp::Rpc::METH_DIR)? dir(shv_path, params): ls(shv_path, params);
+		if(m_lsDirCache.size() >= LS_DIR_CACHE_MAX_SIZE)
+			m_lsDirCache.clear();
+		m_lsDirCache.emplace(std::move(key), ret);
+		return ret;
+	}
 
 	SHV_EXCEPTION("Invalid method: " + method + " on path: " + shv_path.join('/'));
 }
@@ -511,6 +634,11 @@ void ShvNode::emitSendRpcMessage(const chainpack::RpcMessage &msg)
 	}
 }
 
+void ShvNode::setUserCommandAuditSink(UserCommandAuditSink *sink)
+{
+	m_userCommandAuditSink.reset(sink);
+}
+
 void ShvNode::emitLogUserCommand(const shv::core::utils::ShvJournalEntry &e)
 {
 	if(isRootNode()) {
@@ -743,6 +871,7 @@ void RpcValueMapNode::setValueOnPath(const shv::iotqt::node::ShvNode::StringView
 			SHV_EXCEPTION("Invalid path: " + shv_path.join('/'));
 	}
 	v.set(shv_path.at(shv_path.size() - 1).toString(), val);
+	invalidateLsDirCache();
 }
 
 bool RpcValueMapNode::isDir(const shv::iotqt::node::ShvNode::StringViewList &shv_path)
@@ -1096,6 +1225,7 @@ void ValueProxyShvNode::onShvValueChanged(int value_id, chainpack::RpcValue val)
 void ValueProxyShvNode::addMetaMethod(chainpack::MetaMethod &&mm)
 {
 	m_extraMetaMethods.push_back(std::move(mm));
+	invalidateLsDirCache();
 }
 
 static std::map<int, std::vector<size_t>> method_indexes = {
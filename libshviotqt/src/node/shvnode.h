@@ -7,15 +7,18 @@
 #include <shv/chainpack/rpcmessage.h>
 #include <shv/core/stringview.h>
 #include <shv/core/utils.h>
+#include <shv/core/utils/shvpath.h>
 
 #include <QObject>
 #include <QMetaProperty>
 
 #include <cstddef>
+#include <memory>
+#include <unordered_map>
 
 //namespace shv { namespace chainpack { class MetaMethod; }}
 //namespace shv { namespace chainpack { class MetaMethod; class RpcValue; class RpcMessage; class RpcRequest; }}
-namespace shv { namespace core { namespace utils { class ShvPath; class ShvJournalEntry; }}}
+namespace shv { namespace core { namespace utils { class ShvJournalEntry; }}}
 
 
 namespace shv {
@@ -26,6 +29,7 @@ namespace utils { class ShvPath; }
 namespace node {
 
 class ShvRootNode;
+class UserCommandAuditSink;
 
 class SHVIOTQT_DECL_EXPORT ShvNode : public QObject
 {
@@ -50,7 +54,8 @@ public:
 	void setNodeId(String &&n);
 	void setNodeId(const String &n);
 
-	shv::core::utils::ShvPath shvPath() const;
+	/// absolute path of node, cached until node or some of its parents is renamed or reparented
+	const shv::core::utils::ShvPath& shvPath() const;
 	//static StringViewList splitShvPath(const std::string &shv_path) { return StringView{shv_path}.split(SHV_PATH_DELIM, SHV_PATH_QUOTE); }
 	//static String joinShvPath(const StringViewList &shv_path);
 
@@ -58,8 +63,20 @@ public:
 	virtual void emitSendRpcMessage(const shv::chainpack::RpcMessage &msg);
 	void emitLogUserCommand(const shv::core::utils::ShvJournalEntry &e);
 
+	/// user commands are passed to sink installed on root node instead of emitting logUserCommand(),
+	/// node takes ownership of sink
+	void setUserCommandAuditSink(UserCommandAuditSink *sink);
+	UserCommandAuditSink* userCommandAuditSink() const {return m_userCommandAuditSink.get();}
+
 	void setSortedChildren(bool b) {m_isSortedChildren = b;}
 
+	/// remember ls and dir results, suitable for nodes with static methods and children
+	/// node is responsible to call invalidateLsDirCache() when methods or virtual children change
+	/// real children changes invalidate cache automatically
+	void setLsDirCacheEnabled(bool b);
+	bool isLsDirCacheEnabled() const {return m_isLsDirCacheEnabled;}
+	void invalidateLsDirCache();
+
 	void deleteIfEmptyWithParents();
 
 	bool isRootNode() const {return m_isRootNode;}
@@ -93,11 +110,32 @@ public:
 	Q_SIGNAL void sendRpcMessage(const shv::chainpack::RpcMessage &msg);
 	Q_SIGNAL void logUserCommand(const shv::core::utils::ShvJournalEntry &e);
 
+protected:
+	void childEvent(QChildEvent *event) override;
 protected:
 	bool m_isRootNode = false;
+	/// request dispatch resolves path through this node in one pass without calling its
+	/// handleRawRpcRequest() / handleRpcRequest(), plain ShvNode instances are always resolved so,
+	/// set only in classes which do not reimplement them, subclass reimplementing them must clear it
+	bool m_isOnePassDispatchEnabled = false;
+private:
+	bool isOnePassDispatchEnabled() const;
+	/// walks down the tree until the node handling method on shv_path or node without one pass dispatch is found,
+	/// path_ix is set to the index of the first shv_path item relative to returned node
+	ShvNode* resolveRequestNode(const StringViewList &shv_path, const std::string &method, size_t &path_ix);
+	void addToChildIndex(ShvNode *nd);
+	void removeFromChildIndex(ShvNode *nd, const String &node_id);
+	void invalidateShvPath();
 private:
 	String m_nodeId;
 	bool m_isSortedChildren = true;
+	mutable shv::core::utils::ShvPath m_shvPath;
+	mutable bool m_isShvPathValid = false;
+	bool m_isLsDirCacheEnabled = false;
+	std::unordered_map<std::string, shv::chainpack::RpcValue> m_lsDirCache;
+	/// direct ShvNode children by node ID, maintained on construction, reparent, rename and destruction
+	std::unordered_multimap<String, ShvNode*> m_childIndex;
+	std::unique_ptr<UserCommandAuditSink> m_userCommandAuditSink;
 };
 
 /// helper class to save lines when creating root node
@@ -156,7 +194,7 @@ public:
 
 	void commitChanges() {saveValues();}
 
-	void clearValuesCache() {m_valuesLoaded = false;}
+	void clearValuesCache() {m_valuesLoaded = false; invalidateLsDirCache();}
 
 	Q_SIGNAL void configSaved();
 protected:
@@ -45,7 +45,7 @@ ShvNode *ShvNodeTree::mkdir(const ShvNode::StringViewList &path)
 
 ShvNode *ShvNodeTree::cd(const ShvNode::String &path)
 {
-	std::string path_rest;
+	ShvNode::StringViewList path_rest;
 	ShvNode::StringViewList lst = core::utils::ShvPath::split(path);
 	ShvNode *nd = mdcd(lst, false, &path_rest);
 	if(path_rest.empty())
@@ -57,20 +57,28 @@ ShvNode *ShvNodeTree::cd(const ShvNode::String &path, ShvNode::String *path_rest
 {
 	ShvNode::StringViewList lst = core::utils::ShvPath::split(path);
 	//shvWarning() << path << "->" << shv::core::String::join(lst, '-');
-	return mdcd(lst, false, path_rest);
+	if(!path_rest)
+		return mdcd(lst, false, nullptr);
+	ShvNode::StringViewList rest;
+	ShvNode *nd = mdcd(lst, false, &rest);
+	*path_rest = rest.join('/');
+	return nd;
 }
 
-ShvNode *ShvNodeTree::mdcd(const ShvNode::StringViewList &path, bool create_dirs, ShvNode::String *path_rest)
+ShvNode *ShvNodeTree::cd(const ShvNode::StringViewList &path, ShvNode::StringViewList *path_rest)
+{
+	return mdcd(path, false, path_rest);
+}
+
+ShvNode *ShvNodeTree::mdcd(const ShvNode::StringViewList &path, bool create_dirs, ShvNode::StringViewList *path_rest)
 {
 	ShvNode *ret = m_root;
 	size_t ix;
 	for (ix = 0; ix < path.size(); ++ix) {
-		const shv::core::StringView &s = path[ix];
-		ShvNode *nd2 = ret->childNode(s.toString(), !shv::core::Exception::Throw);
+		ShvNode *nd2 = ret->childNode(path[ix].toString(), !shv::core::Exception::Throw);
 		if(nd2 == nullptr) {
 			if(create_dirs) {
-				ret = new ShvNode(ret);
-				ret->setNodeId(path[ix].toString());
+				ret = new ShvNode(path[ix].toString(), ret);
 			}
 			else {
 				break;
@@ -80,10 +88,8 @@ ShvNode *ShvNodeTree::mdcd(const ShvNode::StringViewList &path, bool create_dirs
 			ret = nd2;
 		}
 	}
-	if(path_rest) {
-		auto path2 = ShvNode::StringViewList(path.begin() + ix, path.end());
-		*path_rest = shv::core::String::join(path2, '/');
-	}
+	if(path_rest)
+		*path_rest = path.mid(ix);
 	return ret;
 }
 
@@ -24,11 +24,13 @@ public:
 	ShvNode* mkdir(const ShvNode::StringViewList &path);
 	ShvNode* cd(const ShvNode::String &path);
 	ShvNode* cd(const ShvNode::String &path, ShvNode::String *path_rest);
+	/// path_rest views refer to the same string as path
+	ShvNode* cd(const ShvNode::StringViewList &path, ShvNode::StringViewList *path_rest);
 	bool mount(const ShvNode::String &path, ShvNode *node);
 
 	std::string dumpTree();
 protected:
-	ShvNode* mdcd(const ShvNode::StringViewList &path, bool create_dirs, ShvNode::String *path_rest);
+	ShvNode* mdcd(const ShvNode::StringViewList &path, bool create_dirs, ShvNode::StringViewList *path_rest);
 protected:
 	//std::map<std::string, ShvNode*> m_root;
 	ShvNode* m_root = nullptr;
@@ -0,0 +1,148 @@
+#include "usercommandauditsink.h"
+
+#include <shv/coreqt/log.h>
+
+namespace cp = shv::chainpack;
+
+namespace shv {
+namespace iotqt {
+namespace node {
+
+constexpr size_t UserCommandAuditSink::DEFAULT_MAX_QUEUE_SIZE;
+constexpr int64_t UserCommandAuditSink::DEFAULT_COALESCE_INTERVAL_MSEC;
+
+UserCommandAuditSink::UserCommandAuditSink(WriteEntriesFn write_fn, size_t max_queue_size, int64_t coalesce_interval_msec)
+	: m_writeEntriesFn(std::move(write_fn))
+	, m_maxQueueSize(max_queue_size)
+	, m_coalesceIntervalMsec(coalesce_interval_msec)
+{
+	// thread must be started after all the members are initialized
+	m_thread = std::thread(&UserCommandAuditSink::run, this);
+}
+
+UserCommandAuditSink::~UserCommandAuditSink()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_queueNotEmpty.notify_one();
+	m_thread.join();
+}
+
+bool UserCommandAuditSink::enqueue(Command &&cmd)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(m_queue.size() >= m_maxQueueSize) {
+			m_overflowCount++;
+			return false;
+		}
+		m_queue.push_back(std::move(cmd));
+		m_enqueuedCount++;
+	}
+	m_queueNotEmpty.notify_one();
+	return true;
+}
+
+void UserCommandAuditSink::flush()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	const int64_t enqueued_count = m_enqueuedCount;
+	m_batchWritten.wait(lock, [this, enqueued_count]() { return m_processedCount >= enqueued_count; });
+}
+
+int64_t UserCommandAuditSink::overflowCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_overflowCount;
+}
+
+int64_t UserCommandAuditSink::coalescedCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_coalescedCount;
+}
+
+int64_t UserCommandAuditSink::writtenCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_writtenCount;
+}
+
+shv::core::utils::ShvJournalEntry UserCommandAuditSink::commandToEntry(const Command &cmd)
+{
+	shv::core::utils::ShvJournalEntry e(cmd.shvPath
+										, cmd.method + '(' + cmd.params.toCpon() + ')'
+										, shv::core::utils::ShvJournalEntry::DOMAIN_SHV_COMMAND
+										, shv::core::utils::ShvJournalEntry::NO_SHORT_TIME
+										, cp::DataChange::SampleType::Discrete
+										, cmd.epochMsec);
+	e.userId = cmd.userId;
+	return e;
+}
+
+bool UserCommandAuditSink::isSameCommand(const Command &c1, const Command &c2) const
+{
+	return c1.shvPath == c2.shvPath
+			&& c1.method == c2.method
+			&& c1.userId == c2.userId
+			&& c1.params == c2.params;
+}
+
+void UserCommandAuditSink::run()
+{
+	std::deque<Command> batch;
+	std::vector<shv::core::utils::ShvJournalEntry> entries;
+	while(true) {
+		int64_t overflow_count;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_queueNotEmpty.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+			if(m_queue.empty())
+				return;
+			batch.swap(m_queue);
+			overflow_count = m_overflowCount;
+		}
+		if(overflow_count > m_reportedOverflowCount) {
+			shvWarning() << "User command audit queue overflow," << (overflow_count - m_reportedOverflowCount) << "commands dropped.";
+			m_reportedOverflowCount = overflow_count;
+		}
+		entries.clear();
+		int64_t coalesced_count = 0;
+		for(Command &cmd : batch) {
+			if(m_hasLastCommand
+					&& cmd.epochMsec - m_lastCommandRepeatMsec <= m_coalesceIntervalMsec
+					&& isSameCommand(cmd, m_lastCommand)) {
+				m_lastCommandRepeatMsec = cmd.epochMsec;
+				coalesced_count++;
+				continue;
+			}
+			entries.push_back(commandToEntry(cmd));
+			m_lastCommandRepeatMsec = cmd.epochMsec;
+			m_lastCommand = std::move(cmd);
+			m_hasLastCommand = true;
+		}
+		const int64_t processed_count = static_cast<int64_t>(batch.size());
+		batch.clear();
+		if(!entries.empty() && m_writeEntriesFn) {
+			try {
+				m_writeEntriesFn(entries);
+			}
+			catch (std::exception &e) {
+				shvError() << "Write user command audit entries error:" << e.what();
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_processedCount += processed_count;
+			m_coalescedCount += coalesced_count;
+			m_writtenCount += static_cast<int64_t>(entries.size());
+		}
+		m_batchWritten.notify_all();
+	}
+}
+
+} // namespace node
+} // namespace iotqt
+} // namespace shv
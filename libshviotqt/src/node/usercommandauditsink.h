@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../shviotqtglobal.h"
+
+#include <shv/chainpack/rpcvalue.h>
+#include <shv/core/utils/shvjournalentry.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace shv {
+namespace iotqt {
+namespace node {
+
+/// Batched asynchronous consumer of user commands (calls of methods with write access level and higher)
+///
+/// ShvNode::processRpcRequest() just enqueues raw command with params RpcValue, which is implicitly shared,
+/// commands are formatted to ShvJournalEntry in the sink thread and passed to write function in batches.
+/// Identical consecutive commands are coalesced to the first of them, if they follow each other within coalesce interval.
+/// Queue is bounded, commands exceeding its size are dropped and counted.
+class SHVIOTQT_DECL_EXPORT UserCommandAuditSink
+{
+public:
+	static constexpr size_t DEFAULT_MAX_QUEUE_SIZE = 10000;
+	static constexpr int64_t DEFAULT_COALESCE_INTERVAL_MSEC = 1000;
+
+	struct Command
+	{
+		int64_t epochMsec = 0;
+		std::string shvPath;
+		std::string method;
+		shv::chainpack::RpcValue params;
+		std::string userId;
+	};
+	/// called in sink thread
+	using WriteEntriesFn = std::function<void (const std::vector<shv::core::utils::ShvJournalEntry> &entries)>;
+public:
+	explicit UserCommandAuditSink(WriteEntriesFn write_fn
+								  , size_t max_queue_size = DEFAULT_MAX_QUEUE_SIZE
+								  , int64_t coalesce_interval_msec = DEFAULT_COALESCE_INTERVAL_MSEC);
+	/// writes all queued commands
+	~UserCommandAuditSink();
+
+	/// returns false if queue is full and command was dropped
+	bool enqueue(Command &&cmd);
+	/// blocks until all the commands enqueued so far are written
+	void flush();
+
+	int64_t overflowCount() const;
+	int64_t coalescedCount() const;
+	int64_t writtenCount() const;
+
+	static shv::core::utils::ShvJournalEntry commandToEntry(const Command &cmd);
+private:
+	void run();
+	bool isSameCommand(const Command &c1, const Command &c2) const;
+private:
+	WriteEntriesFn m_writeEntriesFn;
+	size_t m_maxQueueSize;
+	int64_t m_coalesceIntervalMsec;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_queueNotEmpty;
+	std::condition_variable m_batchWritten;
+	std::deque<Command> m_queue;
+	bool m_stop = false;
+	int64_t m_enqueuedCount = 0;
+	int64_t m_processedCount = 0;
+	int64_t m_overflowCount = 0;
+	int64_t m_coalescedCount = 0;
+	int64_t m_writtenCount = 0;
+
+	/// accessed from sink thread only
+	Command m_lastCommand;
+	bool m_hasLastCommand = false;
+	int64_t m_lastCommandRepeatMsec = 0;
+	int64_t m_reportedOverflowCount = 0;
+
+	std::thread m_thread;
+};
+
+} // namespace node
+} // namespace iotqt
+} // namespace shv
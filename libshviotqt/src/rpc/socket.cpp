@@ -87,6 +87,11 @@ qint64 TcpSocket::write(const char *data, qint64 max_size)
 	return m_socket->write(data, max_size);
 }
 
+qint64 TcpSocket::bytesToWrite() const
+{
+	return m_socket->bytesToWrite();
+}
+
 void TcpSocket::writeMessageEnd()
 {
 	/// direct flush in QSslSocket call can cause readyRead() emit
@@ -33,6 +33,8 @@ public:
 
 	virtual QByteArray readAll() = 0;
 	virtual qint64 write(const char *data, qint64 max_size) = 0;
+	/// written data not sent to the peer yet
+	virtual qint64 bytesToWrite() const = 0;
 	//virtual bool flush() = 0;
 	virtual void writeMessageBegin() = 0;
 	virtual void writeMessageEnd() = 0;
@@ -66,6 +68,7 @@ public:
 	quint16 peerPort() const override;
 	QByteArray readAll() override;
 	qint64 write(const char *data, qint64 max_size) override;
+	qint64 bytesToWrite() const override;
 	//bool flush() override;
 	void writeMessageBegin() override {}
 	void writeMessageEnd() override;
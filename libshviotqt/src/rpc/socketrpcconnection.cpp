@@ -141,6 +141,13 @@ int64_t SocketRpcConnection::writeBytes(const char *bytes, size_t length)
 	return socket()->write(bytes, length);
 }
 
+size_t SocketRpcConnection::transportBytesToWrite() const
+{
+	if(!m_socket)
+		return 0;
+	return static_cast<size_t>(qMax<qint64>(0, m_socket->bytesToWrite()));
+}
+
 void SocketRpcConnection::writeMessageBegin()
 {
 	if(m_socket)
@@ -52,6 +52,7 @@ protected:
 	// RpcDriver interface
 	bool isOpen() Q_DECL_OVERRIDE;
 	int64_t writeBytes(const char *bytes, size_t length) Q_DECL_OVERRIDE;
+	size_t transportBytesToWrite() const override;
 	void writeMessageBegin() override;
 	void writeMessageEnd() override;
 	//bool flush() Q_DECL_OVERRIDE;
@@ -62,6 +63,7 @@ protected:
 
 	void onRpcValueReceived(const shv::chainpack::RpcValue &rpc_val) override;
 	void onProcessReadDataException(std::exception &e) override {Q_UNUSED(e) abortSocket();}
+	int traceConnectionId() const override {return connectionId();}
 protected:
 	Socket *m_socket = nullptr;
 };
@@ -0,0 +1 @@
+#include "../../../../src/svgscene/sceneindex.h"
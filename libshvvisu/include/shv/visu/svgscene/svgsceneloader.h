@@ -0,0 +1 @@
+#include "../../../../src/svgscene/svgsceneloader.h"
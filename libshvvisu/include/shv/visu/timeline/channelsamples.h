@@ -0,0 +1 @@
+#include "../../../../src/timeline/channelsamples.h"
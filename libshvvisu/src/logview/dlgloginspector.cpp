@@ -120,6 +120,7 @@ DlgLogInspector::DlgLogInspector(QWidget *parent) :
 	m_logSortFilterProxy = new shv::visu::logview::LogSortFilterProxyModel(this);
 	m_logSortFilterProxy->setShvPathColumn(LogModel::ColPath);
 	m_logSortFilterProxy->setValueColumn(LogModel::ColValue);
+	m_logSortFilterProxy->setSortRole(LogModel::SortRole);
 	m_logSortFilterProxy->setSourceModel(m_logModel);
 	ui->tblData->setModel(m_logSortFilterProxy);
 	ui->tblData->setSortingEnabled(false);
@@ -182,6 +183,7 @@ DlgLogInspector::DlgLogInspector(QWidget *parent) :
 
 	//shvInfo() << qobject_cast<QWidget*>(ui->graphView->widget());
 	m_graph = new tl::Graph(this);
+	m_graph->setAsyncSamplesRendering(true);
 	m_graph->setModel(m_graphModel);
 	m_graphWidget->setGraph(m_graph);
 
@@ -3,12 +3,32 @@
 #include <shv/core/utils/shvfilejournal.h>
 #include <shv/core/log.h>
 
+#include <cstring>
+#include <map>
+
 namespace cp = shv::chainpack;
 
 namespace shv {
 namespace visu {
 namespace logview {
 
+namespace {
+/// numbers are sorted before other values, double bits are mapped to unsigned keeping the order
+QString value_sort_key(const cp::RpcValue &value, const QString &display_string)
+{
+	if(value.isInt() || value.isUInt() || value.isDouble() || value.isDecimal()) {
+		double d = value.toDouble();
+		uint64_t u;
+		std::memcpy(&u, &d, sizeof(u));
+		u = (u & (uint64_t(1) << 63))? ~u: u | (uint64_t(1) << 63);
+		return QLatin1Char('0') + QStringLiteral("%1").arg(static_cast<qulonglong>(u), 16, 16, QLatin1Char('0')).toUpper();
+	}
+	if(value.isString())
+		return QLatin1Char('1') + QString::fromStdString(value.asString());
+	return QLatin1Char('1') + display_string;
+}
+}
+
 //============================================================
 // MemoryJournalLogModel
 //============================================================
@@ -21,6 +41,7 @@ LogModel::LogModel(QObject *parent)
 void LogModel::setTimeZone(const QTimeZone &tz)
 {
 	m_timeZone = tz;
+	m_displayCache[ColDateTime] = QVector<QString>(rowCount());
 	auto ix1 = index(0, ColDateTime);
 	auto ix2 = index(rowCount() - 1, ColDateTime);
 	emit dataChanged(ix1, ix2);
@@ -30,13 +51,62 @@ void LogModel::setLog(const shv::chainpack::RpcValue &log)
 {
 	beginResetModel();
 	m_log = log;
+	decodeLog();
 	endResetModel();
 }
 
-int LogModel::rowCount(const QModelIndex &) const
+void LogModel::decodeLog()
 {
+	m_rows.clear();
+	m_paths.clear();
+	for(auto &cache : m_displayCache)
+		cache.clear();
+
 	const shv::chainpack::RpcValue::List &lst = m_log.toList();
-	return (int)lst.size();
+	static std::string KEY_PATHS_DICT = shv::core::utils::ShvFileJournal::KEY_PATHS_DICT;
+	const chainpack::RpcValue::IMap &dict = m_log.metaValue(KEY_PATHS_DICT).toIMap();
+	std::map<std::string, int> path_ids;
+	std::map<int, int> dict_path_ids;
+	auto path_id = [this, &path_ids](const std::string &path) {
+		auto it = path_ids.find(path);
+		if(it != path_ids.end())
+			return it->second;
+		int id = m_paths.count();
+		m_paths << QString::fromStdString(path);
+		path_ids[path] = id;
+		return id;
+	};
+	m_rows.resize(lst.size());
+	for (size_t i = 0; i < lst.size(); ++i) {
+		const shv::chainpack::RpcValue::List &cells = lst[i].toList();
+		Row &row = m_rows[i];
+		row.msec = cells.value(ColDateTime).toDateTime().msecsSinceEpoch();
+		const shv::chainpack::RpcValue &path = cells.value(ColPath);
+		if ((path.type() == cp::RpcValue::Type::UInt) || (path.type() == cp::RpcValue::Type::Int)) {
+			int dict_id = path.toInt();
+			auto it = dict_path_ids.find(dict_id);
+			if(it == dict_path_ids.end()) {
+				auto it2 = dict.find(dict_id);
+				it = dict_path_ids.emplace(dict_id, path_id(it2 == dict.end()? std::string(): it2->second.asString())).first;
+			}
+			row.pathId = it->second;
+		}
+		else {
+			row.pathId = path_id(path.asString());
+		}
+		row.value = cells.value(ColValue);
+		row.shortTime = cells.value(ColShortTime);
+		row.domain = cells.value(ColDomain);
+		row.sampleType = cells.value(ColSampleType).toInt();
+		row.userId = cells.value(ColUserId);
+	}
+	for(auto &cache : m_displayCache)
+		cache.resize(rowCount());
+}
+
+int LogModel::rowCount(const QModelIndex &) const
+{
+	return static_cast<int>(m_rows.size());
 }
 
 QVariant LogModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -57,37 +127,68 @@ QVariant LogModel::headerData(int section, Qt::Orientation orientation, int role
 	return Super::headerData(section, orientation, role);
 }
 
+QString LogModel::displayString(int row_ix, int column) const
+{
+	const Row &row = m_rows[static_cast<size_t>(row_ix)];
+	switch (column) {
+	case ColPath:
+		return m_paths.value(row.pathId);
+	case ColSampleType:
+		return QString::fromUtf8(cp::DataChange::sampleTypeToString(static_cast<cp::DataChange::SampleType>(row.sampleType)));
+	default:
+		break;
+	}
+	QString &cached = m_displayCache[column][row_ix];
+	if(cached.isNull()) {
+		switch (column) {
+		case ColDateTime: {
+			QDateTime dt = QDateTime::fromMSecsSinceEpoch(row.msec);
+			dt = dt.toTimeZone(m_timeZone);
+			cached = dt.toString(Qt::ISODateWithMs);
+			break;
+		}
+		case ColValue:
+			cached = QString::fromStdString(row.value.toCpon());
+			break;
+		case ColShortTime:
+			cached = QString::fromStdString(row.shortTime.toCpon());
+			break;
+		case ColDomain:
+			cached = QString::fromStdString(row.domain.toCpon());
+			break;
+		case ColUserId:
+			cached = QString::fromStdString(row.userId.toCpon());
+			break;
+		}
+		// empty string must not be null, not to be formatted again
+		if(cached.isNull())
+			cached = QString("");
+	}
+	return cached;
+}
+
 QVariant LogModel::data(const QModelIndex &index, int role) const
 {
 	if(index.isValid() && index.row() < rowCount()) {
+		const Row &row = m_rows[static_cast<size_t>(index.row())];
 		if(role == Qt::DisplayRole) {
-			const shv::chainpack::RpcValue::List &lst = m_log.toList();
-			shv::chainpack::RpcValue row = lst.value((unsigned)index.row());
-			shv::chainpack::RpcValue val = row.toList().value((unsigned)index.column());
-			if(index.column() == ColDateTime) {
-				int64_t msec = val.toDateTime().msecsSinceEpoch();
-				if(msec == 0)
-					return QVariant();
-				QDateTime dt = QDateTime::fromMSecsSinceEpoch(msec);
-				dt = dt.toTimeZone(m_timeZone);
-				return dt.toString(Qt::ISODateWithMs);
-			}
-			else if(index.column() == ColPath) {
-				if ((val.type() == cp::RpcValue::Type::UInt) || (val.type() == cp::RpcValue::Type::Int)) {
-					static std::string KEY_PATHS_DICT = shv::core::utils::ShvFileJournal::KEY_PATHS_DICT;
-					const chainpack::RpcValue::IMap &dict = m_log.metaValue(KEY_PATHS_DICT).toIMap();
-					auto it = dict.find(val.toInt());
-					if(it != dict.end())
-						val = it->second;
-					return QString::fromStdString(val.asString());
-				}
-				return QString::fromStdString(val.asString());
-			}
-			else if(index.column() == ColSampleType) {
-				int t = val.toInt();
-				return QString::fromUtf8(cp::DataChange::sampleTypeToString((cp::DataChange::SampleType)t));
+			if(index.column() == ColDateTime && row.msec == 0)
+				return QVariant();
+			return displayString(index.row(), index.column());
+		}
+		else if(role == SortRole) {
+			switch (index.column()) {
+			case ColDateTime:
+				return static_cast<qint64>(row.msec);
+			case ColValue:
+				return value_sort_key(row.value, row.value.isString()? QString(): displayString(index.row(), index.column()));
+			case ColShortTime:
+				return row.shortTime.isValid() && !row.shortTime.isNull()? QVariant(row.shortTime.toInt()): QVariant(-1);
+			case ColSampleType:
+				return row.sampleType;
+			default:
+				return displayString(index.row(), index.column());
 			}
-			return QString::fromStdString(val.toCpon());
 		}
 	}
 	return QVariant();
@@ -7,6 +7,9 @@
 
 #include <QAbstractTableModel>
 #include <QTimeZone>
+#include <QVector>
+
+#include <vector>
 
 namespace shv {
 namespace visu {
@@ -19,6 +22,9 @@ class SHVVISU_DECL_EXPORT LogModel : public QAbstractTableModel
 	using Super = QAbstractTableModel;
 public:
 	enum {ColDateTime = 0, ColPath, ColValue, ColShortTime, ColDomain, ColSampleType, ColUserId,  ColCnt};
+	/// raw typed cell value, msec since epoch for date time,
+	/// value column returns string key for all types, numbers are ordered numerically before other values
+	enum {SortRole = Qt::UserRole + 1};
 public:
 	LogModel(QObject *parent = nullptr);
 
@@ -31,9 +37,34 @@ public:
 	int columnCount(const QModelIndex & = QModelIndex()) const override {return ColCnt;}
 	QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
 	QVariant data(const QModelIndex &index, int role) const override;
+
+	/// paths are resolved to ids on setLog(), id indexes pathAt()
+	int pathId(int row) const { return m_rows[static_cast<size_t>(row)].pathId; }
+	int pathCount() const { return m_paths.count(); }
+	const QString& pathAt(int path_id) const { return m_paths[path_id]; }
+protected:
+	/// log row decoded once in setLog()
+	struct Row
+	{
+		int64_t msec = 0;
+		int pathId = 0;
+		shv::chainpack::RpcValue value;
+		shv::chainpack::RpcValue shortTime;
+		shv::chainpack::RpcValue domain;
+		int sampleType = 0;
+		shv::chainpack::RpcValue userId;
+	};
+	void decodeLog();
+	QString displayString(int row, int column) const;
 protected:
 	shv::chainpack::RpcValue m_log;
 	QTimeZone m_timeZone;
+
+	std::vector<Row> m_rows;
+	QVector<QString> m_paths;
+	/// display strings formatted on demand, null string means not formatted yet
+	/// path and sample type columns are formatted from m_paths and sample type names
+	mutable QVector<QString> m_displayCache[ColCnt];
 };
 
 }}}
@@ -1,21 +1,170 @@
 #include "logsortfilterproxymodel.h"
+#include "logmodel.h"
 
 #include <shv/core/log.h>
 
+#include <QRunnable>
+#include <QTimer>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 namespace shv {
 namespace visu {
 namespace logview {
 
+constexpr int LogSortFilterProxyModel::FILTER_CHUNK_SIZE;
+constexpr int LogSortFilterProxyModel::INCREMENTAL_INVALIDATE_MSEC;
+
+namespace {
+/// LogModel columns displayed as Cpon of log row cell, text index can be built from log snapshot for them
+bool is_cpon_text_column(int column)
+{
+	switch (column) {
+	case LogModel::ColValue:
+	case LogModel::ColShortTime:
+	case LogModel::ColDomain:
+	case LogModel::ColUserId:
+		return true;
+	default:
+		return false;
+	}
+}
+}
+
+/// value column texts built on demand by filter threads, chunk by chunk
+/// log is implicitly shared snapshot of LogModel data, so index stays valid even if model is reset meanwhile
+struct LogSortFilterProxyModel::TextIndex
+{
+	shv::chainpack::RpcValue log;
+	std::vector<int> pathIds;
+	std::vector<QString> valueText;
+	std::vector<QString> valueTextLower;
+	int valueColumn;
+	std::unique_ptr<std::once_flag[]> chunkBuilt;
+
+	TextIndex(const LogModel *model, int value_column)
+		: log(model->log())
+		, valueColumn(value_column)
+	{
+		const int row_cnt = model->rowCount();
+		pathIds.resize(static_cast<size_t>(row_cnt));
+		for (int i = 0; i < row_cnt; ++i)
+			pathIds[static_cast<size_t>(i)] = model->pathId(i);
+		valueText.resize(pathIds.size());
+		valueTextLower.resize(pathIds.size());
+		chunkBuilt.reset(new std::once_flag[static_cast<size_t>(row_cnt / FILTER_CHUNK_SIZE + 1)]);
+	}
+	int rowCount() const { return static_cast<int>(pathIds.size()); }
+	void buildChunk(int chunk_ix)
+	{
+		std::call_once(chunkBuilt[static_cast<size_t>(chunk_ix)], [this, chunk_ix]() {
+			const shv::chainpack::RpcValue::List &rows = log.toList();
+			const int end = qMin(rowCount(), (chunk_ix + 1) * FILTER_CHUNK_SIZE);
+			for (int i = chunk_ix * FILTER_CHUNK_SIZE; i < end; ++i) {
+				const size_t ix = static_cast<size_t>(i);
+				QString s = QString::fromStdString(rows[ix].toList().value(static_cast<size_t>(valueColumn)).toCpon());
+				valueTextLower[ix] = s.toLower();
+				valueText[ix] = std::move(s);
+			}
+		});
+	}
+};
+
+/// filter inputs captured when filtering starts
+struct LogSortFilterProxyModel::FilterContext
+{
+	int generation = 0;
+	std::atomic<bool> cancelled{false};
+	QBitArray acceptedPathIds;
+	QBitArray textMatchingPathIds;
+	timeline::FullTextFilter fulltextFilter;
+	QString lowerPattern;
+	bool isMatchValue = false;
+	std::shared_ptr<TextIndex> textIndex;
+
+	bool isTextIndexNeeded() const { return isMatchValue && !fulltextFilter.pattern().isEmpty(); }
+	bool rowAccepted(int row) const
+	{
+		const size_t ix = static_cast<size_t>(row);
+		const int path_id = textIndex->pathIds[ix];
+		if(!acceptedPathIds.testBit(path_id))
+			return false;
+		if(fulltextFilter.pattern().isEmpty() || textMatchingPathIds.testBit(path_id))
+			return true;
+		if(!isMatchValue)
+			return false;
+		if(fulltextFilter.isRegularExpression())
+			return fulltextFilter.matches(textIndex->valueText[ix]);
+		if(fulltextFilter.isCaseSensitive())
+			return textIndex->valueText[ix].contains(fulltextFilter.pattern());
+		return textIndex->valueTextLower[ix].contains(lowerPattern);
+	}
+};
+
+class LogSortFilterProxyModel::FilterJob : public QRunnable
+{
+public:
+	FilterJob(LogSortFilterProxyModel *model, const std::shared_ptr<FilterContext> &ctx, int chunk_ix)
+		: m_model(model)
+		, m_context(ctx)
+		, m_chunkIx(chunk_ix)
+	{}
+
+	void run() override
+	{
+		const FilterContext &ctx = *m_context;
+		if(ctx.cancelled)
+			return;
+		if(ctx.isTextIndexNeeded())
+			ctx.textIndex->buildChunk(m_chunkIx);
+		const int begin = m_chunkIx * FILTER_CHUNK_SIZE;
+		const int end = qMin(ctx.textIndex->rowCount(), begin + FILTER_CHUNK_SIZE);
+		QBitArray accepted_rows(end - begin);
+		for (int i = begin; i < end; ++i) {
+			if((i & 1023) == 0 && ctx.cancelled)
+				return;
+			if(ctx.rowAccepted(i))
+				accepted_rows.setBit(i - begin);
+		}
+		emit m_model->filterChunkReady(ctx.generation, begin, accepted_rows);
+	}
+private:
+	LogSortFilterProxyModel *m_model;
+	std::shared_ptr<FilterContext> m_context;
+	int m_chunkIx;
+};
+
 LogSortFilterProxyModel::LogSortFilterProxyModel(QObject *parent) :
 	Super(parent)
 {
+	connect(this, &LogSortFilterProxyModel::filterChunkReady, this, &LogSortFilterProxyModel::onFilterChunkReady, Qt::QueuedConnection);
+}
+
+LogSortFilterProxyModel::~LogSortFilterProxyModel()
+{
+	cancelFiltering();
+	m_filterPool.waitForDone();
+}
 
+void LogSortFilterProxyModel::setSourceModel(QAbstractItemModel *source_model)
+{
+	// disconnect own connection only, QSortFilterProxyModel needs its connections to clean up old source
+	disconnect(m_sourceModelAboutToBeResetConnection);
+	onSourceModelReset();
+	// filter state must be dropped before QSortFilterProxyModel refilters reset source,
+	// it happens in its own modelReset handler, so connect to modelAboutToBeReset
+	if(source_model)
+		m_sourceModelAboutToBeResetConnection = connect(source_model, &QAbstractItemModel::modelAboutToBeReset, this, &LogSortFilterProxyModel::onSourceModelReset);
+	Super::setSourceModel(source_model);
 }
 
 void LogSortFilterProxyModel::setChannelFilter(const shv::visu::timeline::ChannelFilter &filter)
 {
 	m_channelFilter = filter;
-	invalidateFilter();
+	m_isPathIndexValid = false;
+	startFiltering();
 }
 
 void LogSortFilterProxyModel::setShvPathColumn(int column)
@@ -26,15 +175,57 @@ void LogSortFilterProxyModel::setShvPathColumn(int column)
 void LogSortFilterProxyModel::setValueColumn(int column)
 {
 	m_valueColumn = column;
+	m_textIndex.reset();
 }
 
 void LogSortFilterProxyModel::setFulltextFilter(const timeline::FullTextFilter &filter)
 {
 	m_fulltextFilter = filter;
-	invalidateFilter();
+	m_isPathIndexValid = false;
+	startFiltering();
 }
 
-bool LogSortFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
+LogModel *LogSortFilterProxyModel::logModel() const
+{
+	return qobject_cast<LogModel*>(sourceModel());
+}
+
+bool LogSortFilterProxyModel::isIndexedFilter() const
+{
+	return m_shvPathColumn == LogModel::ColPath && logModel() && (m_valueColumn < 0 || is_cpon_text_column(m_valueColumn));
+}
+
+void LogSortFilterProxyModel::updatePathIndex() const
+{
+	const LogModel *m = logModel();
+	const int path_cnt = m->pathCount();
+	if(m_isPathIndexValid && m_acceptedPathIds.size() == path_cnt)
+		return;
+	m_isPathIndexValid = true;
+	m_acceptedPathIds = QBitArray(path_cnt);
+	m_textMatchingPathIds = QBitArray(path_cnt);
+	for (int i = 0; i < path_cnt; ++i) {
+		const QString &path = m->pathAt(i);
+		m_acceptedPathIds.setBit(i, m_channelFilter.isPathMatch(path));
+		m_textMatchingPathIds.setBit(i, m_fulltextFilter.matches(path));
+	}
+}
+
+bool LogSortFilterProxyModel::logRowAccepted(int source_row) const
+{
+	const LogModel *m = logModel();
+	updatePathIndex();
+	const int path_id = m->pathId(source_row);
+	if(!m_acceptedPathIds.testBit(path_id))
+		return false;
+	if(m_fulltextFilter.pattern().isEmpty() || m_textMatchingPathIds.testBit(path_id))
+		return true;
+	if(m_valueColumn < 0)
+		return false;
+	return m_fulltextFilter.matches(m->data(m->index(source_row, m_valueColumn), Qt::DisplayRole).toString());
+}
+
+bool LogSortFilterProxyModel::itemRowAccepted(int source_row, const QModelIndex &source_parent) const
 {
 	bool row_accepted = false;
 	if (m_shvPathColumn >= 0) {
@@ -56,4 +247,92 @@ bool LogSortFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex
 	return row_accepted;
 }
 
+bool LogSortFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
+{
+	if(!isIndexedFilter())
+		return itemRowAccepted(source_row, source_parent);
+	if(m_isAcceptedRowsValid && source_row < m_acceptedRows.size())
+		return m_acceptedRows.testBit(source_row);
+	bool row_accepted = logRowAccepted(source_row);
+	if(source_row >= m_acceptedRows.size())
+		m_acceptedRows.resize(sourceModel()->rowCount());
+	m_acceptedRows.setBit(source_row, row_accepted);
+	return row_accepted;
+}
+
+void LogSortFilterProxyModel::startFiltering()
+{
+	cancelFiltering();
+	if(!isIndexedFilter()) {
+		invalidateFilter();
+		return;
+	}
+	const LogModel *m = logModel();
+	updatePathIndex();
+	if(!m_textIndex)
+		m_textIndex = std::make_shared<TextIndex>(m, m_valueColumn);
+	auto ctx = std::make_shared<FilterContext>();
+	ctx->generation = ++m_filterGeneration;
+	ctx->acceptedPathIds = m_acceptedPathIds;
+	ctx->textMatchingPathIds = m_textMatchingPathIds;
+	ctx->fulltextFilter = m_fulltextFilter;
+	ctx->lowerPattern = m_fulltextFilter.pattern().toLower();
+	ctx->isMatchValue = m_valueColumn >= 0;
+	ctx->textIndex = m_textIndex;
+	m_filterContext = ctx;
+
+	const int row_cnt = m_textIndex->rowCount();
+	// rows not evaluated yet keep previous result until their chunk is done
+	m_acceptedRows.resize(row_cnt);
+	m_isAcceptedRowsValid = true;
+	const int chunk_cnt = (row_cnt + FILTER_CHUNK_SIZE - 1) / FILTER_CHUNK_SIZE;
+	m_pendingFilterChunks = chunk_cnt;
+	if(chunk_cnt == 0) {
+		invalidateFilter();
+		emit filteringFinished();
+		return;
+	}
+	for (int i = 0; i < chunk_cnt; ++i)
+		m_filterPool.start(new FilterJob(this, ctx, i));
+}
+
+void LogSortFilterProxyModel::cancelFiltering()
+{
+	if(m_filterContext) {
+		m_filterContext->cancelled = true;
+		m_filterContext.reset();
+	}
+	m_pendingFilterChunks = 0;
+}
+
+void LogSortFilterProxyModel::onFilterChunkReady(int filter_generation, int first_row, const QBitArray &accepted_rows)
+{
+	if(filter_generation != m_filterGeneration || m_pendingFilterChunks <= 0)
+		return;
+	for (int i = 0; i < accepted_rows.size(); ++i)
+		m_acceptedRows.setBit(first_row + i, accepted_rows.testBit(i));
+	if(--m_pendingFilterChunks == 0) {
+		m_filterContext.reset();
+		invalidateFilter();
+		emit filteringFinished();
+	}
+	else if(!m_isInvalidateScheduled) {
+		m_isInvalidateScheduled = true;
+		QTimer::singleShot(INCREMENTAL_INVALIDATE_MSEC, this, [this]() {
+			m_isInvalidateScheduled = false;
+			if(m_pendingFilterChunks > 0)
+				invalidateFilter();
+		});
+	}
+}
+
+void LogSortFilterProxyModel::onSourceModelReset()
+{
+	cancelFiltering();
+	m_textIndex.reset();
+	m_isPathIndexValid = false;
+	m_isAcceptedRowsValid = false;
+	m_acceptedRows.clear();
+}
+
 }}}
@@ -4,19 +4,34 @@
 #include "../timeline/channelfilter.h"
 #include "../timeline/fulltextfilter.h"
 
+#include <QBitArray>
 #include <QSortFilterProxyModel>
+#include <QThreadPool>
+
+#include <memory>
 
 namespace shv {
 namespace visu {
 namespace logview {
 
+class LogModel;
+
+/// If source model is LogModel, filter is evaluated on path ids and prebuilt value text index
+/// in parallel chunks in a thread pool, results are swapped in incrementally.
+/// Other source models are filtered by QSortFilterProxyModel on GUI thread.
 class SHVVISU_DECL_EXPORT LogSortFilterProxyModel : public QSortFilterProxyModel
 {
 	Q_OBJECT
 
 	using Super = QSortFilterProxyModel;
+public:
+	static constexpr int FILTER_CHUNK_SIZE = 16 * 1024;
+	static constexpr int INCREMENTAL_INVALIDATE_MSEC = 100;
 public:
 	explicit LogSortFilterProxyModel(QObject *parent = nullptr);
+	~LogSortFilterProxyModel() override;
+
+	void setSourceModel(QAbstractItemModel *source_model) override;
 
 	void setChannelFilter(const shv::visu::timeline::ChannelFilter &filter);
 	void setShvPathColumn(int column);
@@ -25,11 +40,46 @@ public:
 
 	bool filterAcceptsRow(int source_rrow, const QModelIndex &source_parent) const override;
 
+	bool isFiltering() const { return m_pendingFilterChunks > 0; }
+	Q_SIGNAL void filteringFinished();
+	/// emitted from filter threads
+	Q_SIGNAL void filterChunkReady(int filter_generation, int first_row, const QBitArray &accepted_rows);
+private:
+	struct TextIndex;
+	struct FilterContext;
+	class FilterJob;
+
+	LogModel* logModel() const;
+	bool isIndexedFilter() const;
+	void updatePathIndex() const;
+	bool logRowAccepted(int source_row) const;
+	bool itemRowAccepted(int source_row, const QModelIndex &source_parent) const;
+
+	void startFiltering();
+	void cancelFiltering();
+	void onFilterChunkReady(int filter_generation, int first_row, const QBitArray &accepted_rows);
+	void onSourceModelReset();
 private:
 	shv::visu::timeline::ChannelFilter m_channelFilter;
 	shv::visu::timeline::FullTextFilter m_fulltextFilter;
 	int m_shvPathColumn = -1;
 	int m_valueColumn = -1;
+
+	/// channel filter and fulltext filter evaluated for every LogModel path id
+	mutable QBitArray m_acceptedPathIds;
+	mutable QBitArray m_textMatchingPathIds;
+	mutable bool m_isPathIndexValid = false;
+	/// filter result for every source row, rows are evaluated on demand until the first parallel filtering
+	mutable QBitArray m_acceptedRows;
+	bool m_isAcceptedRowsValid = false;
+
+	std::shared_ptr<TextIndex> m_textIndex;
+	std::shared_ptr<FilterContext> m_filterContext;
+	int m_filterGeneration = 0;
+	int m_pendingFilterChunks = 0;
+	bool m_isInvalidateScheduled = false;
+	QThreadPool m_filterPool;
+	QMetaObject::Connection m_sourceModelAboutToBeResetConnection;
 };
 
 }}}
@@ -1,5 +1,6 @@
 ﻿#include "saxhandler.h"
 
+#include "sceneindex.h"
 #include "types.h"
 #include "log.h"
 #include "simpletextitem.h"
@@ -13,6 +14,7 @@
 #include <QtMath>
 #include <QFontMetrics>
 #include <QSet>
+#include <QElapsedTimer>
 
 #define logSvgW() shvCWarning("svg")
 #define logSvgM() shvCMessage("svg")
@@ -915,11 +917,8 @@ SaxHandler::~SaxHandler()
 
 void SaxHandler::load(QXmlStreamReader *data, bool skip_definitions)
 {
-	m_skipDefinitions = skip_definitions;
-	m_xml = data;
-	m_defaultPen = QPen(Qt::black, 1, Qt::SolidLine, Qt::FlatCap, Qt::SvgMiterJoin);
-	m_defaultPen.setMiterLimit(4);
-	parse();
+	startApply(parse(data, skip_definitions));
+	applyNextItems(-1);
 	/*
 	QGraphicsRectItem *it = new QGraphicsRectItem();
 	it->setRect(m_scene->sceneRect());
@@ -928,74 +927,146 @@ void SaxHandler::load(QXmlStreamReader *data, bool skip_definitions)
 	*/
 }
 
-void SaxHandler::parse()
+SaxHandler::ParsedSvgPtr SaxHandler::parse(QXmlStreamReader *xml, bool skip_definitions)
 {
-	m_xml->setNamespaceProcessing(false);
-	bool done = false;
+	auto *ret = new ParsedSvg();
+	QStack<CssAttributes> style_stack;
+	xml->setNamespaceProcessing(false);
 
-	while (!m_xml->atEnd() && !done) {
-		switch (m_xml->readNext()) {
+	while (!xml->atEnd()) {
+		switch (xml->readNext()) {
 		case QXmlStreamReader::StartElement:
 		{
-			SvgElement el(m_xml->name().toString());
+			ParsedSvg::Node node(ParsedSvg::Node::Type::StartElement);
+			SvgElement &el = node.element;
+			el.name = xml->name().toString();
 			if(el.name == QLatin1String("defs")) {
-				if (m_skipDefinitions) {
-					m_xml->skipCurrentElement();
+				if (skip_definitions) {
+					xml->skipCurrentElement();
 					continue;
 				}
 			}
-			el.xmlAttributes = parseXmlAttributes(m_xml->attributes());
-			logSvgD() << QString(m_elementStack.count(), '-') << ">" << "+ start element:" << el.name << "id:" << el.xmlAttributes.value("id");
-			if(!m_elementStack.isEmpty())
-				el.styleAttributes = m_elementStack.last().styleAttributes;
+			el.xmlAttributes = parseXmlAttributes(xml->attributes());
+			// implicitly shared with parent element until style attribute changes some value
+			if(!style_stack.isEmpty())
+				el.styleAttributes = style_stack.top();
 			mergeCSSAttributes(el.styleAttributes, QStringLiteral("style"), el.xmlAttributes);
-			m_elementStack.push(el);
-			bool is_item_created = startElement();
-			m_elementStack.last().itemCreated = is_item_created;
+			style_stack.push(el.styleAttributes);
+			ret->nodes.append(node);
 			break;
 		}
 		case QXmlStreamReader::EndElement:
 		{
-			SvgElement svg_element = m_elementStack.pop();
-			logSvgD() << QString(m_elementStack.count(), '-') << ">" << "- end element:" << m_xml->name() << "item created:" << svg_element.itemCreated;
-			if(svg_element.itemCreated && m_topLevelItem) {
-				//logSvgI() << "m_topLevelItem:" << m_topLevelItem << typeid (*m_topLevelItem).name() << svg_element.name;
-				installVisuController(m_topLevelItem, svg_element);
-				m_topLevelItem = m_topLevelItem->parentItem();
-			}
+			if(!style_stack.isEmpty())
+				style_stack.pop();
+			ParsedSvg::Node node(ParsedSvg::Node::Type::EndElement);
+			node.element.name = xml->name().toString();
+			ret->nodes.append(node);
 			break;
 		}
 		case QXmlStreamReader::Characters:
 		{
-			logSvgD() << "characters element:" << m_xml->text();// << typeid (*m_topLevelItem).name();
-			if(SimpleTextItem *text_item = dynamic_cast<SimpleTextItem*>(m_topLevelItem)) {
-				QString text = text_item->text();
-				if(!text.isEmpty())
-					text += '\n';
-				logSvgD() << text_item->text() << "+" << m_xml->text().toString();
-				text_item->setText(text + m_xml->text().toString());
-			}
-			else if(QGraphicsTextItem *text_item = dynamic_cast<QGraphicsTextItem*>(m_topLevelItem)) {
-				QString text = text_item->toPlainText();
-				if(!text.isEmpty())
-					text += '\n';
-				text_item->setPlainText(text + m_xml->text());
-				//nInfo() << text_item->toPlainText();
-			}
-			else {
-				logSvgD() << "characters are not part of text item, will be ignored";
-				//nWarning() << "top:" << m_topLevelItem << (m_topLevelItem? typeid (*m_topLevelItem).name(): "NULL");
-			}
+			ParsedSvg::Node node(ParsedSvg::Node::Type::Characters);
+			node.text = xml->text().toString();
+			ret->nodes.append(node);
 			break;
 		}
 		case QXmlStreamReader::ProcessingInstruction:
-			logSvgD() << "ProcessingInstruction:" << m_xml->processingInstructionTarget() << m_xml->processingInstructionData();
+			logSvgD() << "ProcessingInstruction:" << xml->processingInstructionTarget() << xml->processingInstructionData();
 			//processingInstruction(xml->processingInstructionTarget().toString(), xml->processingInstructionData().toString());
 			break;
 		default:
 			break;
 		}
 	}
+	return ParsedSvgPtr(ret);
+}
+
+void SaxHandler::startApply(const ParsedSvgPtr &parsed_svg)
+{
+	m_defaultPen = QPen(Qt::black, 1, Qt::SolidLine, Qt::FlatCap, Qt::SvgMiterJoin);
+	m_defaultPen.setMiterLimit(4);
+	m_sceneIndex = SceneIndex::forScene(m_scene);
+	// scene might be cleared since last load, index must not hold deleted items
+	m_sceneIndex->rebuild();
+	// previous apply might be cancelled in the middle of document
+	m_elementStack.clear();
+	m_topLevelItem = nullptr;
+	m_parsedSvg = parsed_svg;
+	m_nextNodeIndex = 0;
+}
+
+bool SaxHandler::applyNextItems(int time_slice_msec)
+{
+	if(!m_parsedSvg)
+		return true;
+	QElapsedTimer elapsed;
+	elapsed.start();
+	const QVector<ParsedSvg::Node> &nodes = m_parsedSvg->nodes;
+	while(m_nextNodeIndex < nodes.count()) {
+		applyNode(nodes[m_nextNodeIndex++]);
+		if(time_slice_msec >= 0 && (m_nextNodeIndex % 64) == 0 && elapsed.elapsed() >= time_slice_msec)
+			return false;
+	}
+	m_parsedSvg.reset();
+	m_nextNodeIndex = 0;
+	return true;
+}
+
+int SaxHandler::parsedNodeCount() const
+{
+	return m_parsedSvg? m_parsedSvg->nodes.count(): 0;
+}
+
+void SaxHandler::applyNode(const ParsedSvg::Node &node)
+{
+	switch (node.type) {
+	case ParsedSvg::Node::Type::StartElement:
+	{
+		const SvgElement &el = node.element;
+		logSvgD() << QString(m_elementStack.count(), '-') << ">" << "+ start element:" << el.name << "id:" << el.xmlAttributes.value("id");
+		m_elementStack.push(el);
+		bool is_item_created = startElement();
+		m_elementStack.last().itemCreated = is_item_created;
+		break;
+	}
+	case ParsedSvg::Node::Type::EndElement:
+	{
+		if(m_elementStack.isEmpty())
+			break;
+		SvgElement svg_element = m_elementStack.pop();
+		logSvgD() << QString(m_elementStack.count(), '-') << ">" << "- end element:" << node.element.name << "item created:" << svg_element.itemCreated;
+		if(svg_element.itemCreated && m_topLevelItem) {
+			//logSvgI() << "m_topLevelItem:" << m_topLevelItem << typeid (*m_topLevelItem).name() << svg_element.name;
+			installVisuController(m_topLevelItem, svg_element);
+			m_topLevelItem = m_topLevelItem->parentItem();
+		}
+		break;
+	}
+	case ParsedSvg::Node::Type::Characters:
+	{
+		logSvgD() << "characters element:" << node.text;// << typeid (*m_topLevelItem).name();
+		if(SimpleTextItem *text_item = dynamic_cast<SimpleTextItem*>(m_topLevelItem)) {
+			QString text = text_item->text();
+			if(!text.isEmpty())
+				text += '\n';
+			logSvgD() << text_item->text() << "+" << node.text;
+			text_item->setText(text + node.text);
+		}
+		else if(QGraphicsTextItem *text_item = dynamic_cast<QGraphicsTextItem*>(m_topLevelItem)) {
+			QString text = text_item->toPlainText();
+			if(!text.isEmpty())
+				text += '\n';
+			text_item->setPlainText(text + node.text);
+			//nInfo() << text_item->toPlainText();
+		}
+		else {
+			logSvgD() << "characters are not part of text item, will be ignored";
+			//nWarning() << "top:" << m_topLevelItem << (m_topLevelItem? typeid (*m_topLevelItem).name(): "NULL");
+		}
+		break;
+	}
+	}
 }
 
 bool SaxHandler::startElement()
@@ -1207,15 +1278,23 @@ XmlAttributes SaxHandler::parseXmlAttributes(const QXmlStreamAttributes &attribu
 
 void SaxHandler::mergeCSSAttributes(CssAttributes &css_attributes, const QString &attr_name, const XmlAttributes &xml_attributes)
 {
+	auto attr_it = xml_attributes.constFind(attr_name);
+	if(attr_it == xml_attributes.constEnd())
+		return;
 #if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
-	QStringList css = xml_attributes.value(attr_name).split(';', QString::SkipEmptyParts);
+	QStringList css = attr_it.value().split(';', QString::SkipEmptyParts);
 #else
-	QStringList css = xml_attributes.value(attr_name).split(';', Qt::SkipEmptyParts);
+	QStringList css = attr_it.value().split(';', Qt::SkipEmptyParts);
 #endif
-	for(QString ss : css) {
+	for(const QString &ss : css) {
 		int ix = ss.indexOf(':');
 		if(ix > 0) {
-			css_attributes[ss.mid(0, ix).trimmed()] = ss.mid(ix + 1).trimmed();
+			// css_attributes are shared with parent element, detach only when value really changes
+			const QString key = ss.mid(0, ix).trimmed();
+			const QString val = ss.mid(ix + 1).trimmed();
+			auto it = css_attributes.constFind(key);
+			if(it == css_attributes.constEnd() || it.value() != val)
+				css_attributes[key] = val;
 		}
 	}
 }
@@ -1413,6 +1492,8 @@ void SaxHandler::addItem(QGraphicsItem *it)
 	else {
 		it->setParentItem(m_topLevelItem);
 	}
+	if(m_sceneIndex)
+		m_sceneIndex->addItem(it);
 	m_topLevelItem = it;
 }
 
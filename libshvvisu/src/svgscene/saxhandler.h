@@ -5,6 +5,9 @@
 #include <QPen>
 #include <QMap>
 #include <QStack>
+#include <QVector>
+
+#include <memory>
 
 class QXmlStreamReader;
 class QXmlStreamAttributes;
@@ -18,6 +21,8 @@ namespace shv {
 namespace visu {
 namespace svgscene {
 
+class SceneIndex;
+
 using XmlAttributes = Types::XmlAttributes;
 using CssAttributes = Types::CssAttributes;
 
@@ -34,12 +39,37 @@ public:
 		SvgElement() {}
 		SvgElement(const QString &n, bool created = false) : name(n), itemCreated(created) {}
 	};
+	/// SVG elements in document order with resolved CSS attributes, graphics items are not created yet
+	struct ParsedSvg
+	{
+		struct Node
+		{
+			enum class Type {StartElement, EndElement, Characters};
+
+			Type type;
+			SvgElement element;
+			QString text;
+
+			Node(Type t = Type::Characters) : type(t) {}
+		};
+		QVector<Node> nodes;
+	};
+	using ParsedSvgPtr = std::shared_ptr<const ParsedSvg>;
 public:
 	SaxHandler(QGraphicsScene *scene);
 	virtual ~SaxHandler();
 
 	void load(QXmlStreamReader *data, bool is_skip_definitions = false);
 
+	/// can be called from any thread
+	static ParsedSvgPtr parse(QXmlStreamReader *xml, bool is_skip_definitions = false);
+	/// create graphics items of parsed_svg by subsequent applyNextItems() calls
+	void startApply(const ParsedSvgPtr &parsed_svg);
+	/// create items for time_slice_msec at least, all of them if time_slice_msec < 0, returns true when done
+	bool applyNextItems(int time_slice_msec);
+	int appliedNodeCount() const { return m_nextNodeIndex; }
+	int parsedNodeCount() const;
+
 	static QString point2str(QPointF r);
 	static QString rect2str(QRectF r);
 protected:
@@ -48,10 +78,11 @@ protected:
 	virtual void setXmlAttributes(QGraphicsItem *git, const SvgElement &el);
 
 	QGraphicsScene *m_scene;
+	SceneIndex *m_sceneIndex = nullptr;
 private:
-	void parse();
-	XmlAttributes parseXmlAttributes(const QXmlStreamAttributes &attributes);
-	void mergeCSSAttributes(CssAttributes &css_attributes, const QString &attr_name, const XmlAttributes &xml_attributes);
+	static XmlAttributes parseXmlAttributes(const QXmlStreamAttributes &attributes);
+	static void mergeCSSAttributes(CssAttributes &css_attributes, const QString &attr_name, const XmlAttributes &xml_attributes);
+	void applyNode(const ParsedSvg::Node &node);
 
 	void setTransform(QGraphicsItem *it, const QString &str_val);
 	void setStyle(QAbstractGraphicsShapeItem *it, const CssAttributes &attributes);
@@ -66,11 +97,12 @@ private:
 
 	//QGraphicsItemGroup *m_topLevelGroup = nullptr;
 	QGraphicsItem *m_topLevelItem = nullptr;
-	QXmlStreamReader *m_xml = nullptr;
 	QPen m_defaultPen;
-	bool m_skipDefinitions = false;
+	ParsedSvgPtr m_parsedSvg;
+	int m_nextNodeIndex = 0;
 };
 
 }}}
 
 Q_DECLARE_METATYPE(shv::visu::svgscene::XmlAttributes)
+Q_DECLARE_METATYPE(shv::visu::svgscene::SaxHandler::ParsedSvgPtr)
@@ -0,0 +1,167 @@
+#include "sceneindex.h"
+#include "saxhandler.h"
+#include "visucontroller.h"
+
+#include <QGraphicsItem>
+#include <QGraphicsScene>
+#include <QSet>
+#include <QTimer>
+
+namespace shv {
+namespace visu {
+namespace svgscene {
+
+SceneIndex::SceneIndex(QGraphicsScene *scene)
+	: Super(scene)
+{
+}
+
+SceneIndex *SceneIndex::fromScene(const QGraphicsScene *scene)
+{
+	if(!scene)
+		return nullptr;
+	return scene->findChild<SceneIndex*>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+SceneIndex *SceneIndex::forScene(QGraphicsScene *scene)
+{
+	SceneIndex *index = fromScene(scene);
+	if(!index)
+		index = new SceneIndex(scene);
+	return index;
+}
+
+void SceneIndex::addItem(QGraphicsItem *it)
+{
+	const XmlAttributes attrs = qvariant_cast<XmlAttributes>(it->data(Types::DataKey::XmlAttributes));
+	for(auto kv = attrs.constBegin(); kv != attrs.constEnd(); ++kv) {
+		m_attributeItems[kv.key()].append(it);
+		m_attributeValueItems[kv.key()][kv.value()].append(it);
+	}
+}
+
+void SceneIndex::clear()
+{
+	m_attributeItems.clear();
+	m_attributeValueItems.clear();
+}
+
+void SceneIndex::rebuild()
+{
+	clear();
+	auto *scene = qobject_cast<QGraphicsScene*>(parent());
+	if(!scene)
+		return;
+	// ascending stacking order lists parents before children and siblings in insertion order
+	const QList<QGraphicsItem*> scene_items = scene->items(Qt::AscendingOrder);
+	for(QGraphicsItem *it : scene_items)
+		addItem(it);
+}
+
+bool SceneIndex::isIndexed(const QString &attr_name) const
+{
+	if(attr_name.isEmpty())
+		return false;
+	return attr_name == Types::ATTR_ID
+			|| attr_name == Types::ATTR_CHILD_ID
+			|| attr_name.startsWith(QLatin1String("shv"))
+			|| m_attributeItems.contains(attr_name);
+}
+
+const SceneIndex::ItemList &SceneIndex::items(const QString &attr_name, const QString &attr_value) const
+{
+	static const ItemList empty_list;
+	if(attr_value.isEmpty()) {
+		auto it = m_attributeItems.constFind(attr_name);
+		return it == m_attributeItems.constEnd()? empty_list: it.value();
+	}
+	auto it = m_attributeValueItems.constFind(attr_name);
+	if(it == m_attributeValueItems.constEnd())
+		return empty_list;
+	auto it2 = it.value().constFind(attr_value);
+	return it2 == it.value().constEnd()? empty_list: it2.value();
+}
+
+QGraphicsItem *SceneIndex::itemById(const QString &id) const
+{
+	const ItemList &lst = items(Types::ATTR_ID, id);
+	return lst.isEmpty()? nullptr: lst.first();
+}
+
+void SceneIndex::addVisuController(VisuController *controller)
+{
+	if(controller->shvPath().isEmpty())
+		return;
+	QVector<VisuController*> &lst = m_controllers[controller->shvPath()];
+	if(!lst.contains(controller))
+		lst.append(controller);
+}
+
+void SceneIndex::removeVisuController(VisuController *controller)
+{
+	for(auto it = m_controllers.begin(); it != m_controllers.end(); ) {
+		it.value().removeAll(controller);
+		if(it.value().isEmpty())
+			it = m_controllers.erase(it);
+		else
+			++it;
+	}
+}
+
+QVector<VisuController *> SceneIndex::visuControllers(const QString &shv_path) const
+{
+	return m_controllers.value(shv_path);
+}
+
+int SceneIndex::applyValue(const QString &shv_path, const chainpack::RpcValue &value)
+{
+	auto it = m_controllers.constFind(shv_path);
+	if(it == m_controllers.constEnd())
+		return 0;
+	for(VisuController *controller : it.value())
+		controller->applyValue(value);
+	return it.value().count();
+}
+
+void SceneIndex::applyValueChanges(const ValueChanges &changes)
+{
+	// scene collects dirty regions of all updated items and repaints them in one pass
+	QSet<QString> applied_paths;
+	int controller_cnt = 0;
+	for (int i = changes.count() - 1; i >= 0; --i) {
+		const QString &path = changes[i].first;
+		if(applied_paths.contains(path))
+			continue;
+		applied_paths.insert(path);
+		controller_cnt += applyValue(path, changes[i].second);
+	}
+	emit valueChangesApplied(controller_cnt);
+}
+
+void SceneIndex::queueValueChange(const QString &shv_path, const chainpack::RpcValue &value)
+{
+	if(!m_controllers.contains(shv_path))
+		return;
+	if(!m_pendingValues.contains(shv_path))
+		m_pendingPaths.append(shv_path);
+	m_pendingValues[shv_path] = value;
+	if(!m_isFlushScheduled) {
+		m_isFlushScheduled = true;
+		QTimer::singleShot(0, this, &SceneIndex::flushValueChanges);
+	}
+}
+
+void SceneIndex::flushValueChanges()
+{
+	m_isFlushScheduled = false;
+	if(m_pendingPaths.isEmpty())
+		return;
+	int controller_cnt = 0;
+	for(const QString &path : m_pendingPaths)
+		controller_cnt += applyValue(path, m_pendingValues.value(path));
+	m_pendingPaths.clear();
+	m_pendingValues.clear();
+	emit valueChangesApplied(controller_cnt);
+}
+
+}}}
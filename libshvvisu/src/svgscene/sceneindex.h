@@ -0,0 +1,73 @@
+#pragma once
+
+#include "types.h"
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QVector>
+
+class QGraphicsItem;
+class QGraphicsScene;
+
+namespace shv {
+namespace visu {
+namespace svgscene {
+
+class VisuController;
+
+/// Index of graphics items created by SaxHandler and of visu controllers living in one scene.
+/// Index is a child object of the scene, items are kept in document order.
+/// Index is rebuilt from items present in scene by SaxHandler::startApply(),
+/// call rebuild() when items are removed from scene out of SVG load.
+class SHVVISU_DECL_EXPORT SceneIndex : public QObject
+{
+	Q_OBJECT
+
+	using Super = QObject;
+public:
+	using ItemList = QVector<QGraphicsItem*>;
+	using ValueChanges = QVector<QPair<QString, shv::chainpack::RpcValue>>;
+public:
+	explicit SceneIndex(QGraphicsScene *scene);
+
+	static SceneIndex* fromScene(const QGraphicsScene *scene);
+	static SceneIndex* forScene(QGraphicsScene *scene);
+
+	/// index item by attributes stored in Types::DataKey::XmlAttributes
+	void addItem(QGraphicsItem *it);
+	void clear();
+	/// forget removed items and index items currently present in scene
+	void rebuild();
+
+	/// attributes stored by SaxHandler::setXmlAttributes() are always indexed
+	bool isIndexed(const QString &attr_name) const;
+	/// items having attribute attr_name with value attr_value, any value if attr_value is empty
+	const ItemList& items(const QString &attr_name, const QString &attr_value = QString()) const;
+	QGraphicsItem* itemById(const QString &id) const;
+
+	void addVisuController(VisuController *controller);
+	void removeVisuController(VisuController *controller);
+	QVector<VisuController*> visuControllers(const QString &shv_path) const;
+
+	/// only the last value of every shv path is applied, every affected controller is updated once
+	void applyValueChanges(const ValueChanges &changes);
+	/// changes queued during one event loop pass are applied together by flushValueChanges()
+	void queueValueChange(const QString &shv_path, const shv::chainpack::RpcValue &value);
+	void flushValueChanges();
+
+	Q_SIGNAL void valueChangesApplied(int controller_count);
+private:
+	int applyValue(const QString &shv_path, const shv::chainpack::RpcValue &value);
+private:
+	QHash<QString, ItemList> m_attributeItems;
+	QHash<QString, QHash<QString, ItemList>> m_attributeValueItems;
+	QHash<QString, QVector<VisuController*>> m_controllers;
+	QVector<QString> m_pendingPaths;
+	QHash<QString, shv::chainpack::RpcValue> m_pendingValues;
+	bool m_isFlushScheduled = false;
+};
+
+}}}
@@ -4,7 +4,9 @@ SOURCES += \
     $$PWD/types.cpp \
     $$PWD/visucontroller.cpp \
     $$PWD/saxhandler.cpp \
-    $$PWD/simpletextitem.cpp
+    $$PWD/sceneindex.cpp \
+    $$PWD/simpletextitem.cpp \
+    $$PWD/svgsceneloader.cpp
 
 HEADERS += \
     $$PWD/groupitem.h \
@@ -13,5 +15,7 @@ HEADERS += \
     $$PWD/types.h \
     $$PWD/visucontroller.h \
     $$PWD/saxhandler.h \
-    $$PWD/simpletextitem.h
+    $$PWD/sceneindex.h \
+    $$PWD/simpletextitem.h \
+    $$PWD/svgsceneloader.h
 
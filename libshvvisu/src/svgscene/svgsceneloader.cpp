@@ -0,0 +1,179 @@
+#include "svgsceneloader.h"
+#include "log.h"
+
+#include <QCache>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QTimer>
+#include <QXmlStreamReader>
+
+#define logSvgW() shvCWarning("svg")
+#define logSvgD() shvCDebug("svg")
+
+namespace shv {
+namespace visu {
+namespace svgscene {
+
+constexpr int SvgSceneLoader::DEFAULT_TIME_SLICE_MSEC;
+constexpr int SvgSceneLoader::DEFAULT_CACHE_MAX_NODE_COUNT;
+
+namespace {
+
+QMutex s_cacheMutex;
+
+QCache<QByteArray, SaxHandler::ParsedSvgPtr>& parsedSvgCache()
+{
+	static QCache<QByteArray, SaxHandler::ParsedSvgPtr> cache(SvgSceneLoader::DEFAULT_CACHE_MAX_NODE_COUNT);
+	return cache;
+}
+
+SaxHandler::ParsedSvgPtr cachedSvg(const QByteArray &key)
+{
+	QMutexLocker locker(&s_cacheMutex);
+	SaxHandler::ParsedSvgPtr *ptr = parsedSvgCache().object(key);
+	return ptr? *ptr: SaxHandler::ParsedSvgPtr();
+}
+
+void insertCachedSvg(const QByteArray &key, const SaxHandler::ParsedSvgPtr &parsed_svg)
+{
+	QMutexLocker locker(&s_cacheMutex);
+	parsedSvgCache().insert(key, new SaxHandler::ParsedSvgPtr(parsed_svg), qMax(1, parsed_svg->nodes.count()));
+}
+
+}
+
+class SvgSceneLoader::ParseJob : public QRunnable
+{
+public:
+	ParseJob(SvgSceneLoader *loader, int load_serial, const QString &file_name, const QByteArray &svg_data, bool is_skip_definitions)
+		: m_loader(loader)
+		, m_loadSerial(load_serial)
+		, m_fileName(file_name)
+		, m_svgData(svg_data)
+		, m_isSkipDefinitions(is_skip_definitions)
+	{}
+
+	void run() override
+	{
+		if(!m_fileName.isEmpty()) {
+			QFile file(m_fileName);
+			if(!file.open(QFile::ReadOnly)) {
+				emit m_loader->svgParsed(m_loadSerial, SaxHandler::ParsedSvgPtr(), "Cannot open file " + m_fileName + " for reading.");
+				return;
+			}
+			m_svgData = file.readAll();
+		}
+		QByteArray key = QCryptographicHash::hash(m_svgData, QCryptographicHash::Sha1);
+		key.append(m_isSkipDefinitions? '1': '0');
+		SaxHandler::ParsedSvgPtr parsed_svg = cachedSvg(key);
+		QString error_message;
+		if(parsed_svg) {
+			logSvgD() << "parsed SVG found in cache:" << m_fileName;
+		}
+		else {
+			QXmlStreamReader xml(m_svgData);
+			parsed_svg = SaxHandler::parse(&xml, m_isSkipDefinitions);
+			if(xml.hasError())
+				error_message = "SVG parse error: " + xml.errorString() + " line: " + QString::number(xml.lineNumber());
+			else
+				insertCachedSvg(key, parsed_svg);
+		}
+		emit m_loader->svgParsed(m_loadSerial, parsed_svg, error_message);
+	}
+private:
+	SvgSceneLoader *m_loader;
+	int m_loadSerial;
+	QString m_fileName;
+	QByteArray m_svgData;
+	bool m_isSkipDefinitions;
+};
+
+SvgSceneLoader::SvgSceneLoader(SaxHandler *handler, QObject *parent)
+	: Super(parent)
+	, m_handler(handler)
+{
+	qRegisterMetaType<SaxHandler::ParsedSvgPtr>();
+	m_parsePool.setMaxThreadCount(1);
+	connect(this, &SvgSceneLoader::svgParsed, this, &SvgSceneLoader::onSvgParsed, Qt::QueuedConnection);
+}
+
+SvgSceneLoader::~SvgSceneLoader()
+{
+	cancel();
+	m_parsePool.waitForDone();
+}
+
+void SvgSceneLoader::loadFile(const QString &file_name, bool is_skip_definitions)
+{
+	startLoad(file_name, QByteArray(), is_skip_definitions);
+}
+
+void SvgSceneLoader::loadData(const QByteArray &svg_data, bool is_skip_definitions)
+{
+	startLoad(QString(), svg_data, is_skip_definitions);
+}
+
+void SvgSceneLoader::cancel()
+{
+	m_loadSerial++;
+	m_isLoading = false;
+}
+
+void SvgSceneLoader::setCacheMaxNodeCount(int node_count)
+{
+	QMutexLocker locker(&s_cacheMutex);
+	parsedSvgCache().setMaxCost(node_count);
+}
+
+void SvgSceneLoader::clearCache()
+{
+	QMutexLocker locker(&s_cacheMutex);
+	parsedSvgCache().clear();
+}
+
+void SvgSceneLoader::startLoad(const QString &file_name, const QByteArray &svg_data, bool is_skip_definitions)
+{
+	cancel();
+	m_isLoading = true;
+	m_parsePool.start(new ParseJob(this, m_loadSerial, file_name, svg_data, is_skip_definitions));
+}
+
+void SvgSceneLoader::onSvgParsed(int load_serial, const SaxHandler::ParsedSvgPtr &parsed_svg, const QString &error_message)
+{
+	if(load_serial != m_loadSerial)
+		return;
+	if(!error_message.isEmpty()) {
+		logSvgW() << error_message;
+		emit error(error_message);
+	}
+	if(!parsed_svg) {
+		m_isLoading = false;
+		emit finished();
+		return;
+	}
+	m_handler->startApply(parsed_svg);
+	applyNextSlice(load_serial);
+}
+
+void SvgSceneLoader::applyNextSlice(int load_serial)
+{
+	if(load_serial != m_loadSerial)
+		return;
+	const int node_count = m_handler->parsedNodeCount();
+	bool done = m_handler->applyNextItems(m_timeSliceMsec);
+	if(done) {
+		emit progress(node_count, node_count);
+		m_isLoading = false;
+		emit finished();
+		return;
+	}
+	emit progress(m_handler->appliedNodeCount(), node_count);
+	QTimer::singleShot(0, this, [this, load_serial]() {
+		applyNextSlice(load_serial);
+	});
+}
+
+}}}
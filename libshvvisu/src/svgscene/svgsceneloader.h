@@ -0,0 +1,59 @@
+#pragma once
+
+#include "saxhandler.h"
+
+#include <QObject>
+#include <QThreadPool>
+
+namespace shv {
+namespace visu {
+namespace svgscene {
+
+/// Loads SVG in background, XML is parsed and CSS resolved in a worker thread,
+/// graphics items are then created by SaxHandler in time slices on GUI thread.
+/// Parsed SVGs are cached by content hash, so reopening the same file skips parsing.
+class SHVVISU_DECL_EXPORT SvgSceneLoader : public QObject
+{
+	Q_OBJECT
+
+	using Super = QObject;
+public:
+	static constexpr int DEFAULT_TIME_SLICE_MSEC = 20;
+	static constexpr int DEFAULT_CACHE_MAX_NODE_COUNT = 1000 * 1000;
+public:
+	/// handler must outlive the loader
+	explicit SvgSceneLoader(SaxHandler *handler, QObject *parent = nullptr);
+	~SvgSceneLoader() override;
+
+	void setTimeSlice(int msec) { m_timeSliceMsec = msec; }
+	int timeSlice() const { return m_timeSliceMsec; }
+
+	void loadFile(const QString &file_name, bool is_skip_definitions = false);
+	void loadData(const QByteArray &svg_data, bool is_skip_definitions = false);
+	/// pending load is abandoned, items created so far stay in scene
+	void cancel();
+	bool isLoading() const { return m_isLoading; }
+
+	static void setCacheMaxNodeCount(int node_count);
+	static void clearCache();
+
+	Q_SIGNAL void progress(int applied_node_count, int node_count);
+	Q_SIGNAL void finished();
+	Q_SIGNAL void error(const QString &message);
+	/// emitted from parser thread
+	Q_SIGNAL void svgParsed(int load_serial, const shv::visu::svgscene::SaxHandler::ParsedSvgPtr &parsed_svg, const QString &error_message);
+private:
+	class ParseJob;
+
+	void startLoad(const QString &file_name, const QByteArray &svg_data, bool is_skip_definitions);
+	void onSvgParsed(int load_serial, const SaxHandler::ParsedSvgPtr &parsed_svg, const QString &error_message);
+	void applyNextSlice(int load_serial);
+private:
+	SaxHandler *m_handler;
+	int m_timeSliceMsec = DEFAULT_TIME_SLICE_MSEC;
+	int m_loadSerial = 0;
+	bool m_isLoading = false;
+	QThreadPool m_parsePool;
+};
+
+}}}
@@ -39,10 +39,24 @@ VisuController::VisuController(QGraphicsItem *graphics_item, QObject *parent)
 	setObjectName(id());
 	setShvType(graphics_item->data(Types::DataKey::ShvType).toString());
 	setShvPath(graphics_item->data(Types::DataKey::ShvPath).toString());
+	m_sceneIndex = SceneIndex::fromScene(graphics_item->scene());
+	if(m_sceneIndex)
+		m_sceneIndex->addVisuController(this);
 	//for(auto key : attrs.keys())
 	//	shvDebug() << key << "->" << attrs.value(key);
 }
 
+VisuController::~VisuController()
+{
+	if(m_sceneIndex)
+		m_sceneIndex->removeVisuController(this);
+}
+
+void VisuController::applyValue(const chainpack::RpcValue &value)
+{
+	Q_UNUSED(value)
+}
+
 QString VisuController::graphicsItemAttributeValue(const QGraphicsItem *it, const QString &attr_name, const QString &default_value)
 {
 	svgscene::XmlAttributes attrs = qvariant_cast<svgscene::XmlAttributes>(it->data(Types::DataKey::XmlAttributes));
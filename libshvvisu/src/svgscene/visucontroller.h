@@ -1,12 +1,14 @@
 #pragma once 
 
 #include "saxhandler.h"
+#include "sceneindex.h"
 #include "types.h"
 
 #include <shv/core/utils.h>
 
 #include <QObject>
 #include <QGraphicsItem>
+#include <QPointer>
 
 namespace shv {
 namespace visu {
@@ -23,6 +25,10 @@ class SHVVISU_DECL_EXPORT VisuController : public QObject
 	SHV_FIELD_IMPL(QString, s, S, hvPath)
 public:
 	VisuController(QGraphicsItem *graphics_item, QObject *parent = nullptr);
+	~VisuController() override;
+
+	/// called by SceneIndex for value changes of shvPath(), reimplement to update graphics items
+	virtual void applyValue(const shv::chainpack::RpcValue &value);
 protected:
 	static QString graphicsItemAttributeValue(const QGraphicsItem *it, const QString &attr_name, const QString &default_value = QString());
 	static QString graphicsItemCssAttributeValue(const QGraphicsItem *it, const QString &attr_name, const QString &default_value = QString());
@@ -38,6 +44,23 @@ protected:
 	{
 		if(!parent_it)
 			return nullptr;
+		if(const SceneIndex *index = SceneIndex::fromScene(parent_it->scene())) {
+			if(index->isIndexed(attr_name)) {
+				for(QGraphicsItem *it : index->items(attr_name, attr_value)) {
+					if(T tit = dynamic_cast<T>(it)) {
+						if(parent_it->isAncestorOf(it))
+							return tit;
+					}
+				}
+				// items added to scene out of SaxHandler are not indexed, walk the tree
+			}
+		}
+		return findChildGraphicsItemInTree<T>(parent_it, attr_name, attr_value);
+	}
+private:
+	template<typename T>
+	static T findChildGraphicsItemInTree(const QGraphicsItem *parent_it, const QString &attr_name, const QString &attr_value)
+	{
 		for(QGraphicsItem *it : parent_it->childItems()) {
 			if(T tit = dynamic_cast<T>(it)) {
 				if(attr_name.isEmpty()) {
@@ -55,7 +78,7 @@ protected:
 					}
 				}
 			}
-			T tit = findChildGraphicsItem<T>(it, attr_name, attr_value);
+			T tit = findChildGraphicsItemInTree<T>(it, attr_name, attr_value);
 			if(tit)
 				return tit;
 		}
@@ -63,6 +86,7 @@ protected:
 	}
 protected:
 	QGraphicsItem *m_graphicsItem;
+	QPointer<SceneIndex> m_sceneIndex;
 };
 
 }}}
@@ -0,0 +1,292 @@
+#include "channelsamples.h"
+#include "graphmodel.h"
+
+#include <algorithm>
+
+namespace shv {
+namespace visu {
+namespace timeline {
+
+constexpr int ChannelSamples::LOD_BUCKET_SIZE_SHIFT;
+constexpr int ChannelSamples::LOD_BUCKET_SIZE;
+constexpr int ChannelSamples::CURSOR_WALK_LIMIT;
+
+void ChannelSamples::LodBucket::merge(const ChannelSamples::LodBucket &o)
+{
+	lastTime = o.lastTime;
+	last = o.last;
+	min = qMin(min, o.min);
+	max = qMax(max, o.max);
+	isNumeric = isNumeric && o.isNumeric;
+}
+
+QVariant ChannelSamples::valueAt(int ix) const
+{
+	switch (m_valueType) {
+	case ValueType::Double:
+		return m_values[ix].d;
+	case ValueType::Int:
+		if(m_intMetaTypeId == QMetaType::Int)
+			return static_cast<int>(m_values[ix].i);
+		if(m_intMetaTypeId == QMetaType::UInt)
+			return static_cast<uint>(m_values[ix].i);
+		return m_values[ix].i;
+	case ValueType::Bool:
+		return m_values[ix].b;
+	case ValueType::Variant:
+		return m_variants[ix];
+	case ValueType::Invalid:
+		break;
+	}
+	return QVariant();
+}
+
+bool ChannelSamples::isNativeMetaType(int meta_type_id) const
+{
+	switch (m_valueType) {
+	case ValueType::Double:
+		return meta_type_id == QMetaType::Double;
+	case ValueType::Int:
+		return meta_type_id == QMetaType::Int || meta_type_id == QMetaType::UInt || meta_type_id == QMetaType::LongLong;
+	case ValueType::Bool:
+		return meta_type_id == QMetaType::Bool;
+	default:
+		return false;
+	}
+}
+
+double ChannelSamples::valueToDouble(int ix, int meta_type_id, bool *ok) const
+{
+	if(m_valueType == ValueType::Variant || !(meta_type_id == QMetaType::UnknownType || isNativeMetaType(meta_type_id)))
+		return GraphModel::valueToDouble(valueAt(ix), meta_type_id, ok);
+	if(ok)
+		*ok = true;
+	switch (m_valueType) {
+	case ValueType::Double:
+		return m_values[ix].d;
+	case ValueType::Int:
+		return m_values[ix].i;
+	case ValueType::Bool:
+		return m_values[ix].b? 1: 0;
+	default:
+		return 0;
+	}
+}
+
+int ChannelSamples::lessOrEqualIndex(timemsec_t time) const
+{
+	const timemsec_t *begin = m_times.constData();
+	const timemsec_t *end = begin + m_times.count();
+	return static_cast<int>(std::upper_bound(begin, end, time) - begin) - 1;
+}
+
+int ChannelSamples::lessOrEqualIndex(timemsec_t time, int cursor_ix) const
+{
+	const int cnt = count();
+	if(cnt == 0 || time < m_times[0])
+		return -1;
+	if(cursor_ix >= 0 && cursor_ix < cnt) {
+		int ix = cursor_ix;
+		for (int i = 0; i < CURSOR_WALK_LIMIT; ++i) {
+			if(m_times[ix] <= time) {
+				if(ix + 1 == cnt || m_times[ix + 1] > time)
+					return ix;
+				ix++;
+			}
+			else {
+				// ix > 0, since m_times[0] <= time
+				ix--;
+			}
+		}
+	}
+	return lodLessOrEqualIndex(time);
+}
+
+int ChannelSamples::lodLessOrEqualIndex(timemsec_t time) const
+{
+	// every LOD level has at most LOD_BUCKET_SIZE buckets under one bucket of upper level,
+	// so descending the pyramid costs LOD_BUCKET_SIZE comparisons per level at most
+	const int cnt = count();
+	int begin = 0;
+	int end = cnt;
+	for (int level = m_lodLevels.count() - 1; level >= 0; --level) {
+		const LodLevel &lod_level = m_lodLevels[level];
+		const int shift = LOD_BUCKET_SIZE_SHIFT * (level + 1);
+		const int bix_end = qMin(((end - 1) >> shift) + 1, lod_level.count());
+		int bix = begin >> shift;
+		while(bix + 1 < bix_end && lod_level[bix + 1].firstTime <= time)
+			bix++;
+		begin = bix << shift;
+		end = qMin(cnt, (bix + 1) << shift);
+	}
+	const timemsec_t *times = m_times.constData();
+	return static_cast<int>(std::upper_bound(times + begin, times + end, time) - times) - 1;
+}
+
+YRange ChannelSamples::yRange(int meta_type_id) const
+{
+	YRange ret;
+	auto add_samples = [this, meta_type_id, &ret](int ix1, int ix2) {
+		for (int i = ix1; i < ix2; ++i) {
+			bool ok;
+			double d = valueToDouble(i, meta_type_id, &ok);
+			if(ok) {
+				ret.min = qMin(ret.min, d);
+				ret.max = qMax(ret.max, d);
+			}
+		}
+	};
+	const int cnt = count();
+	if(m_lodLevels.isEmpty() || meta_type_id != m_lodMetaTypeId) {
+		add_samples(0, cnt);
+		return ret;
+	}
+	const int shift = LOD_BUCKET_SIZE_SHIFT * m_lodLevels.count();
+	const LodLevel &top_level = m_lodLevels.last();
+	for (int i = 0; i < top_level.count(); ++i) {
+		const LodBucket &b = top_level[i];
+		if(b.isNumeric) {
+			ret.min = qMin(ret.min, b.min);
+			ret.max = qMax(ret.max, b.max);
+		}
+		else {
+			add_samples(i << shift, qMin((i + 1) << shift, cnt));
+		}
+	}
+	return ret;
+}
+
+void ChannelSamples::setLodMetaTypeId(int meta_type_id)
+{
+	if(meta_type_id == m_lodMetaTypeId)
+		return;
+	m_lodMetaTypeId = meta_type_id;
+	m_lodLevels.clear();
+	for (int i = 0; i < count(); ++i)
+		appendLodSample(i);
+}
+
+const ChannelSamples::LodBucket *ChannelSamples::lodBucket(int ix, int ix_end, timemsec_t max_span, int meta_type_id, int *sample_count) const
+{
+	if(meta_type_id != m_lodMetaTypeId)
+		return nullptr;
+	for (int level = m_lodLevels.count() - 1; level >= 0; --level) {
+		const int shift = LOD_BUCKET_SIZE_SHIFT * (level + 1);
+		const int size = 1 << shift;
+		if((ix & (size - 1)) != 0 || ix + size > ix_end)
+			continue;
+		const LodBucket &b = m_lodLevels[level][ix >> shift];
+		if(b.isNumeric && b.lastTime - b.firstTime <= max_span) {
+			if(sample_count)
+				*sample_count = size;
+			return &b;
+		}
+	}
+	return nullptr;
+}
+
+void ChannelSamples::appendLodSample(int ix)
+{
+	auto sample_bucket = [this](int i) {
+		bool ok;
+		double d = valueToDouble(i, m_lodMetaTypeId, &ok);
+		return LodBucket(timeAt(i), d, ok);
+	};
+	const int level_cnt = m_lodLevels.count();
+	// next level is created when its second bucket begins
+	if(ix == (int64_t{1} << (LOD_BUCKET_SIZE_SHIFT * (level_cnt + 1)))) {
+		LodBucket b;
+		if(level_cnt == 0) {
+			b = sample_bucket(0);
+			for (int i = 1; i < ix; ++i)
+				b.merge(sample_bucket(i));
+		}
+		else {
+			const LodLevel &lower_level = m_lodLevels.last();
+			b = lower_level[0];
+			for (int i = 1; i < lower_level.count(); ++i)
+				b.merge(lower_level[i]);
+		}
+		m_lodLevels.append(LodLevel{b});
+	}
+	const LodBucket sb = sample_bucket(ix);
+	for (int level = 0; level < m_lodLevels.count(); ++level) {
+		LodLevel &lod_level = m_lodLevels[level];
+		int bix = ix >> (LOD_BUCKET_SIZE_SHIFT * (level + 1));
+		if(bix < lod_level.count())
+			lod_level[bix].merge(sb);
+		else
+			lod_level.append(sb);
+	}
+}
+
+void ChannelSamples::append(Sample &&sample)
+{
+	const int meta_type_id = sample.value.userType();
+	if(m_valueType == ValueType::Invalid) {
+		switch (meta_type_id) {
+		case QMetaType::Double:
+			m_valueType = ValueType::Double;
+			break;
+		case QMetaType::Int:
+		case QMetaType::UInt:
+		case QMetaType::LongLong:
+			m_valueType = ValueType::Int;
+			m_intMetaTypeId = meta_type_id;
+			break;
+		case QMetaType::Bool:
+			m_valueType = ValueType::Bool;
+			break;
+		default:
+			m_valueType = ValueType::Variant;
+			break;
+		}
+	}
+	else if(m_valueType != ValueType::Variant) {
+		bool same_type = (m_valueType == ValueType::Int)? (meta_type_id == m_intMetaTypeId): isNativeMetaType(meta_type_id);
+		if(!same_type)
+			convertToVariant();
+	}
+	m_times.append(sample.time);
+	TypedValue tv;
+	switch (m_valueType) {
+	case ValueType::Double:
+		tv.d = sample.value.toDouble();
+		m_values.append(tv);
+		break;
+	case ValueType::Int:
+		tv.i = sample.value.toLongLong();
+		m_values.append(tv);
+		break;
+	case ValueType::Bool:
+		tv.b = sample.value.toBool();
+		m_values.append(tv);
+		break;
+	default:
+		m_variants.append(std::move(sample.value));
+		break;
+	}
+	appendLodSample(m_times.count() - 1);
+}
+
+void ChannelSamples::clear()
+{
+	m_times.clear();
+	m_values.clear();
+	m_variants.clear();
+	m_lodLevels.clear();
+	m_valueType = ValueType::Invalid;
+	m_intMetaTypeId = QMetaType::UnknownType;
+}
+
+void ChannelSamples::convertToVariant()
+{
+	m_variants.reserve(m_times.capacity());
+	for (int i = 0; i < m_values.count(); ++i)
+		m_variants.append(valueAt(i));
+	m_values.clear();
+	m_values.squeeze();
+	m_valueType = ValueType::Variant;
+}
+
+}}}
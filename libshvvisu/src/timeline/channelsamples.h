@@ -0,0 +1,105 @@
+#pragma once
+
+#include "sample.h"
+#include "../shvvisuglobal.h"
+
+#include <QVariant>
+#include <QVector>
+
+namespace shv {
+namespace visu {
+namespace timeline {
+
+/// Columnar storage of one channel samples
+///
+/// Times are kept in contiguous int64 column, values in typed column of doubles, integers or bools,
+/// what costs 16 bytes per sample.
+/// Column type is given by the first sample value, if some later value has different type,
+/// values are moved to QVariant column, which is used also for maps, strings, etc.
+///
+/// All the columns are implicitly shared, copy of ChannelSamples is cheap snapshot,
+/// which can be passed to rendering threads.
+class SHVVISU_DECL_EXPORT ChannelSamples
+{
+public:
+	enum class ValueType {Invalid, Double, Int, Bool, Variant};
+
+	/// Level of detail bucket, aggregates LOD_BUCKET_SIZE^level consecutive samples
+	/// lets the graph draw and compute y-range in O(pixels) instead of O(samples)
+	struct SHVVISU_DECL_EXPORT LodBucket
+	{
+		timemsec_t firstTime = 0;
+		timemsec_t lastTime = 0;
+		double first = 0;
+		double last = 0;
+		double min = 0;
+		double max = 0;
+		/// all aggregated samples are convertible to double
+		bool isNumeric = true;
+
+		LodBucket() {}
+		LodBucket(timemsec_t t, double d, bool is_numeric)
+			: firstTime(t), lastTime(t), first(d), last(d), min(d), max(d), isNumeric(is_numeric) {}
+		void merge(const LodBucket &o);
+	};
+	static constexpr int LOD_BUCKET_SIZE_SHIFT = 4;
+	static constexpr int LOD_BUCKET_SIZE = 1 << LOD_BUCKET_SIZE_SHIFT;
+	/// max number of steps cursor walks from its recent position before LOD index is used
+	static constexpr int CURSOR_WALK_LIMIT = 16;
+public:
+	ChannelSamples() {}
+
+	int count() const { return m_times.count(); }
+	bool isEmpty() const { return m_times.isEmpty(); }
+	ValueType valueType() const { return m_valueType; }
+
+	const timemsec_t* timeData() const { return m_times.constData(); }
+	timemsec_t timeAt(int ix) const { return m_times[ix]; }
+	timemsec_t lastTime() const { return m_times.last(); }
+	QVariant valueAt(int ix) const;
+	Sample sampleAt(int ix) const { return Sample(m_times[ix], valueAt(ix)); }
+	/// typed columns are converted without QVariant, meta_type_id has the same meaning as in GraphModel::valueToDouble()
+	double valueToDouble(int ix, int meta_type_id, bool *ok) const;
+
+	int lessOrEqualIndex(timemsec_t time) const;
+	/// same as lessOrEqualIndex(time), walks locally from cursor_ix, what is cheap for small time deltas,
+	/// large jumps are resolved using LOD pyramid
+	int lessOrEqualIndex(timemsec_t time, int cursor_ix) const;
+	YRange yRange(int meta_type_id) const;
+
+	/// LOD values are converted to double using this meta type, see GraphModel::valueToDouble(),
+	/// LOD pyramid is rebuilt when it changes
+	int lodMetaTypeId() const { return m_lodMetaTypeId; }
+	void setLodMetaTypeId(int meta_type_id);
+	/// Returns the largest LOD bucket starting at sample ix, ending before ix_end and lasting at most max_span msec,
+	/// sample_count is set to the number of samples it aggregates.
+	/// Returns nullptr if there is no such bucket or LOD is built for other meta type, sample ix should be used directly then.
+	const LodBucket* lodBucket(int ix, int ix_end, timemsec_t max_span, int meta_type_id, int *sample_count) const;
+
+	void append(Sample &&sample);
+	void clear();
+private:
+	void convertToVariant();
+	bool isNativeMetaType(int meta_type_id) const;
+	void appendLodSample(int ix);
+	int lodLessOrEqualIndex(timemsec_t time) const;
+private:
+	union TypedValue
+	{
+		double d;
+		qint64 i;
+		bool b;
+	};
+	QVector<timemsec_t> m_times;
+	ValueType m_valueType = ValueType::Invalid;
+	/// QVariant type of values in Int column
+	int m_intMetaTypeId = QMetaType::UnknownType;
+	QVector<TypedValue> m_values;
+	QVector<QVariant> m_variants;
+	/// LOD pyramid, level 1 is stored at index 0
+	using LodLevel = QVector<LodBucket>;
+	QVector<LodLevel> m_lodLevels;
+	int m_lodMetaTypeId = QMetaType::UnknownType;
+};
+
+}}}
@@ -11,6 +11,7 @@
 #include <QLabel>
 #include <QMouseEvent>
 #include <QPainterPath>
+#include <QRunnable>
 
 #include <cmath>
 
@@ -41,10 +42,12 @@ Graph::Graph(QObject *parent)
 	m_cornerCellButtonBox->setObjectName("cornerCellButtonBox");
 	m_cornerCellButtonBox->setAutoRaise(false);
 	connect(m_cornerCellButtonBox, &GraphButtonBox::buttonClicked, this, &Graph::onButtonBoxClicked);
+	connect(this, &Graph::samplesImageRendered, this, &Graph::onSamplesImageRendered, Qt::QueuedConnection);
 }
 
 Graph::~Graph()
 {
+	m_samplesRenderPool.waitForDone();
 	clearChannels();
 }
 
@@ -133,6 +136,7 @@ void Graph::resetChannelsRanges()
 
 void Graph::clearChannels()
 {
+	clearSamplesCache();
 	qDeleteAll(m_channels);
 	m_channels.clear();
 }
@@ -277,12 +281,40 @@ int Graph::timeToPos(timemsec_t time) const
 	return time2pos? time2pos(time): 0;
 }
 
+int Graph::cursorSampleIndex(const GraphChannel *ch, timemsec_t time) const
+{
+	const GraphModel *m = model();
+	int ix;
+	if(m->isChannelSamplesAccessEnabled())
+		ix = m->channelSamples(ch->modelIndex()).lessOrEqualIndex(time, ch->m_cursorSampleIndex);
+	else
+		ix = m->lessOrEqualIndex(ch->modelIndex(), time);
+	if(ix >= 0)
+		ch->m_cursorSampleIndex = ix;
+	return ix;
+}
+
+ChannelSamples Graph::channelSamplesSnapshot(int model_ix, const XRange &xrange) const
+{
+	const GraphModel *m = model();
+	if(m->isChannelSamplesAccessEnabled())
+		return m->channelSamples(model_ix);
+	// samples drawn by draw_channel_samples() only
+	ChannelSamples ret;
+	ret.setLodMetaTypeId(m->channelInfo(model_ix).metaTypeId);
+	const int ix1 = qMax(m->lessOrEqualIndex(model_ix, xrange.min), 0);
+	const int ix2 = qMin(m->lessOrEqualIndex(model_ix, xrange.max) + 2, m->count(model_ix) - 1);
+	for (int i = ix1; i <= ix2; ++i)
+		ret.append(m->sampleAt(model_ix, i));
+	return ret;
+}
+
 Sample Graph::timeToSample(int channel_ix, timemsec_t time) const
 {
-	GraphModel *m = model();
+	const GraphModel *m = model();
 	const GraphChannel *ch = channelAt(channel_ix);
 	int model_ix = ch->modelIndex();
-	int ix1 = m->lessOrEqualIndex(model_ix, time);
+	int ix1 = cursorSampleIndex(ch, time);
 	if(ix1 < 0)
 		return Sample();
 	int interpolation = ch->m_effectiveStyle.interpolation();
@@ -313,26 +345,21 @@ Sample Graph::timeToSample(int channel_ix, timemsec_t time) const
 
 Sample Graph::nearestSample(int channel_ix, timemsec_t time) const
 {
-	GraphModel *m = model();
+	const GraphModel *m = model();
 	const GraphChannel *ch = channelAt(channel_ix);
 	int model_ix = ch->modelIndex();
-	int ix1 = m->lessOrEqualIndex(model_ix, time);
+	int ix1 = cursorSampleIndex(ch, time);
 
-	Sample s1;
-	Sample s2;
-	if (ix1 >= 0) {
-		s1 = m->sampleAt(model_ix, ix1);
+	if (ix1 + 1 >= m->count(model_ix)) {
+		return ix1 < 0? Sample(): m->sampleAt(model_ix, ix1);
 	}
-	if (ix1 + 1 == m->count(model_ix)) {
-		return s1;
-	}
-	s2 = m->sampleAt(model_ix, ix1 + 1);
-	if (s1.isValid() && time - s1.time < s2.time - time) {
-		return s1;
-	}
-	else {
-		return s2;
+	Sample s2 = m->sampleAt(model_ix, ix1 + 1);
+	if (ix1 >= 0) {
+		Sample s1 = m->sampleAt(model_ix, ix1);
+		if(time - s1.time < s2.time - time)
+			return s1;
 	}
+	return s2;
 }
 
 Sample Graph::posToData(const QPoint &pos) const
@@ -919,7 +946,10 @@ void Graph::draw(QPainter *painter, const QRect &dirty_rect, const QRect &view_r
 		if(dirty_rect.intersects(ch->graphAreaRect())) {
 			drawBackground(painter, i);
 			drawGrid(painter, i);
-			drawSamples(painter, i);
+			if(m_isAsyncSamplesRendering)
+				drawSamplesCached(painter, i);
+			else
+				drawSamples(painter, i);
 			drawCrossHair(painter, i);
 			drawCurrentTime(painter, i);
 		}
@@ -1451,25 +1481,20 @@ QString Graph::rectToString(const QRect &r)
 	return s.arg(r.x()).arg(r.y()).arg(r.width()).arg(r.height());
 }
 
-void Graph::drawSamples(QPainter *painter, int channel_ix, const DataRect &src_rect, const QRect &dest_rect, const GraphChannel::Style &channel_style)
-{
-	//shvLogFuncFrame() << "channel:" << channel_ix;
-	const GraphChannel *ch = channelAt(channel_ix);
-	int model_ix = ch->modelIndex();
-	QRect rect = dest_rect.isEmpty()? ch->graphDataGridRect(): dest_rect;
-	GraphChannel::Style ch_style = channel_style.isEmpty()? ch->m_effectiveStyle: channel_style;
+namespace {
 
-	XRange xrange;
-	YRange yrange;
-	if(!src_rect.isValid()) {
-		xrange = xRangeZoom();
-		yrange = ch->yRangeZoom();
-	}
-	else {
-		xrange = src_rect.xRange;
-		yrange = src_rect.yRange;
-	}
-	auto sample2point = dataToPointFn(DataRect{xrange, yrange}, rect);
+/// Draws samples without touching Graph or GraphModel, so it can be called from render threads.
+void draw_channel_samples(QPainter *painter
+		, const ChannelSamples &samples
+		, int channel_meta_type_id
+		, const Graph::DataRect &src_rect
+		, const QRect &rect
+		, const GraphChannel::Style &ch_style
+		, double line_width
+		, int arrow_width)
+{
+	const XRange &xrange = src_rect.xRange;
+	auto sample2point = Graph::dataToPointFn(src_rect, rect);
 
 	if(!sample2point)
 		return;
@@ -1479,10 +1504,7 @@ void Graph::drawSamples(QPainter *painter, int channel_ix, const DataRect &src_r
 	QPen pen;
 	QColor line_color = ch_style.color();
 	pen.setColor(line_color);
-	{
-		double d = ch_style.lineWidth();
-		pen.setWidthF(u2pxf(d));
-	}
+	pen.setWidthF(line_width);
 	pen.setCapStyle(Qt::FlatCap);
 	QPen steps_join_pen = pen;
 	steps_join_pen.setWidthF(pen.widthF() / 4);
@@ -1502,19 +1524,13 @@ void Graph::drawSamples(QPainter *painter, int channel_ix, const DataRect &src_r
 		//line_area_color.setHsv(line_area_color.hslHue(), line_area_color.hsvSaturation() / 2, line_area_color.lightness());
 	}
 
-	int channel_meta_type_id = channelMetaTypeId(channel_ix);
-	GraphModel *graph_model = model();
-	int ix1 = graph_model->lessOrEqualIndex(model_ix, xrange.min);
+	int ix1 = samples.lessOrEqualIndex(xrange.min);
 	//ix1--; // draw one more sample to correctly display connection line to the first one in the zoom window
 	if(ix1 < 0)
 		ix1 = 0;
-	int ix2 = graph_model->lessOrEqualIndex(model_ix, xrange.max) + 1;
+	int ix2 = samples.lessOrEqualIndex(xrange.max) + 1;
 	ix2++; // draw one more sample to correctly display (n-1)th one
-	//const GraphModel::ChannelInfo &chinfo = graph_model->channelInfo(channel_ix);
-	int samples_cnt = graph_model->count(model_ix);
-	shvDebug() << graph_model->channelShvPath(channel_ix) << "range:" << xrange.min << xrange.max;
-	shvDebug() << "\t" << channel_ix
-			   << "from:" << ix1 << "to:" << ix2 << "cnt:" << (ix2 - ix1) << "of:" << samples_cnt;
+	int samples_cnt = samples.count();
 	constexpr int NO_X = std::numeric_limits<int>::min();
 	struct OnePixelPoints {
 		int x = NO_X;
@@ -1523,25 +1539,19 @@ void Graph::drawSamples(QPainter *painter, int channel_ix, const DataRect &src_r
 		int maxY = std::numeric_limits<int>::min();
 	};
 	OnePixelPoints current_px, recent_px;
-	for (int i = ix1; i <= ix2 && i <= samples_cnt; ++i) {
-		// sample is drawn one step behind, so one more loop is needed
-		const Sample s = (i < samples_cnt)? graph_model->sampleAt(model_ix, i): Sample();
-		if (interpolation == GraphChannel::Style::Interpolation::None) {
-			QPoint sample_point = sample2point(Sample{s.time, 0}, channel_meta_type_id); // <- this can be computed ahead
-			int arrow_width = u2px(1);
-			painter->drawLine(sample_point.x(), clip_rect.y() + clip_rect.height() / 2, sample_point.x(), clip_rect.y() + clip_rect.height());
-			QPainterPath path;
-			path.moveTo(sample_point.x() - arrow_width / 2, clip_rect.y() + clip_rect.height() - arrow_width / 2);
-			path.lineTo(sample_point.x() + arrow_width / 2, clip_rect.y() + clip_rect.height() - arrow_width / 2);
-			path.lineTo(sample_point.x(), clip_rect.y() + clip_rect.height());
-			path.lineTo(sample_point.x() - arrow_width / 2, clip_rect.y() + clip_rect.height() - arrow_width / 2);
-			path.closeSubpath();
-			painter->fillPath(path, painter->pen().color());
-			continue;
-		}
-
-		const QPoint sample_point = sample2point(s, channel_meta_type_id);
-		//shvDebug() << i << "t:" << s.time << "x:" << sample_point.x() << "y:" << sample_point.y();
+	const int zero_y = sample2point(Sample{qMax<timemsec_t>(xrange.min, 1), 0}, QMetaType::Double).y();
+	auto draw_arrow = [painter, &clip_rect, arrow_width](int x) {
+		painter->drawLine(x, clip_rect.y() + clip_rect.height() / 2, x, clip_rect.y() + clip_rect.height());
+		QPainterPath path;
+		path.moveTo(x - arrow_width / 2, clip_rect.y() + clip_rect.height() - arrow_width / 2);
+		path.lineTo(x + arrow_width / 2, clip_rect.y() + clip_rect.height() - arrow_width / 2);
+		path.lineTo(x, clip_rect.y() + clip_rect.height());
+		path.lineTo(x - arrow_width / 2, clip_rect.y() + clip_rect.height() - arrow_width / 2);
+		path.closeSubpath();
+		painter->fillPath(path, painter->pen().color());
+	};
+	auto draw_point = [&](const QPoint &sample_point) {
+		//shvDebug() << "x:" << sample_point.x() << "y:" << sample_point.y();
 		//shvDebug() << "\t recent x:" << recent_px.x << " current x:" << current_px.x;
 		if(sample_point.x() == current_px.x) {
 			current_px.minY = qMin(current_px.minY, sample_point.y());
@@ -1559,8 +1569,7 @@ void Graph::drawSamples(QPainter *painter, int channel_ix, const DataRect &src_r
 					if(recent_px.x != NO_X) {
 						QPoint pa{recent_px.x, recent_px.lastY};
 						if(line_area_color.isValid()) {
-							QPoint p0 = sample2point(Sample{s.time, 0}, channel_meta_type_id); // <- this can be computed ahead
-							p0.setX(drawn_point.x());
+							QPoint p0{drawn_point.x(), zero_y};
 							painter->fillRect(QRect{pa + QPoint{1, 0}, p0}, line_area_color);
 						}
 						QPoint pb{drawn_point.x(), recent_px.lastY};
@@ -1576,8 +1585,7 @@ void Graph::drawSamples(QPainter *painter, int channel_ix, const DataRect &src_r
 					if(recent_px.x != NO_X) {
 						QPoint pa{recent_px.x, recent_px.lastY};
 						if(line_area_color.isValid()) {
-							QPoint p0 = sample2point(Sample{s.time, 0}, channel_meta_type_id);
-							p0.setX(drawn_point.x());
+							QPoint p0{drawn_point.x(), zero_y};
 							QPainterPath pp;
 							pp.moveTo(pa);
 							pp.lineTo(drawn_point);
@@ -1595,10 +1603,213 @@ void Graph::drawSamples(QPainter *painter, int channel_ix, const DataRect &src_r
 			current_px.minY = current_px.maxY = sample_point.y();
 		}
 		current_px.lastY = sample_point.y();
+	};
+	// samples lasting less than one pixel are taken from LOD pyramid as first, min, max, last
+	const timemsec_t px_span = xrange.interval() / qMax(rect.width(), 1);
+	const int last_ix = qMin(ix2, samples_cnt - 1);
+	for (int i = ix1; i <= last_ix; ) {
+		int bucket_sample_cnt = 1;
+		const ChannelSamples::LodBucket *bucket = samples.lodBucket(i, last_ix + 1, px_span, channel_meta_type_id, &bucket_sample_cnt);
+		if(bucket) {
+			i += bucket_sample_cnt;
+			if (interpolation == GraphChannel::Style::Interpolation::None) {
+				draw_arrow(sample2point(Sample{bucket->firstTime, 0}, QMetaType::Double).x());
+				draw_arrow(sample2point(Sample{bucket->lastTime, 0}, QMetaType::Double).x());
+				continue;
+			}
+			draw_point(sample2point(Sample{bucket->firstTime, bucket->first}, QMetaType::Double));
+			draw_point(sample2point(Sample{bucket->firstTime, bucket->min}, QMetaType::Double));
+			draw_point(sample2point(Sample{bucket->firstTime, bucket->max}, QMetaType::Double));
+			draw_point(sample2point(Sample{bucket->lastTime, bucket->last}, QMetaType::Double));
+			continue;
+		}
+		const int ix = i++;
+		const timemsec_t t = samples.timeAt(ix);
+		if (interpolation == GraphChannel::Style::Interpolation::None) {
+			draw_arrow(sample2point(Sample{t, 0}, QMetaType::Double).x());
+			continue;
+		}
+		if(samples.valueType() == ChannelSamples::ValueType::Variant) {
+			draw_point(sample2point(samples.sampleAt(ix), channel_meta_type_id));
+		}
+		else {
+			bool ok;
+			double d = samples.valueToDouble(ix, channel_meta_type_id, &ok);
+			draw_point(ok? sample2point(Sample{t, d}, QMetaType::Double): QPoint());
+		}
+	}
+	// sample is drawn one step behind, invalid point flushes the last one
+	if(ix2 >= samples_cnt && interpolation != GraphChannel::Style::Interpolation::None)
+		draw_point(QPoint());
+	painter->restore();
+}
+
+class SamplesRenderJob : public QRunnable
+{
+public:
+	SamplesRenderJob(Graph *graph, int channel_ix, int render_serial
+					 , const ChannelSamples &samples, int meta_type_id
+					 , const Graph::DataRect &src_rect, const QRect &rect, const GraphChannel::Style &style
+					 , double line_width, int arrow_width, qreal device_pixel_ratio)
+		: m_graph(graph)
+		, m_channelIx(channel_ix)
+		, m_renderSerial(render_serial)
+		, m_samples(samples)
+		, m_metaTypeId(meta_type_id)
+		, m_srcRect(src_rect)
+		, m_rect(rect)
+		, m_style(style)
+		, m_lineWidth(line_width)
+		, m_arrowWidth(arrow_width)
+		, m_devicePixelRatio(device_pixel_ratio)
+	{}
+
+	void run() override
+	{
+		// keep lines on the rect edges, they are clipped to the line width margins in draw_channel_samples()
+		const int margin = static_cast<int>(std::ceil(m_lineWidth)) + 1;
+		const QRect image_rect = m_rect.adjusted(0, -margin, 0, margin);
+		QImage image(image_rect.size() * m_devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+		image.setDevicePixelRatio(m_devicePixelRatio);
+		image.fill(Qt::transparent);
+		{
+			QPainter painter(&image);
+			painter.translate(-image_rect.topLeft());
+			draw_channel_samples(&painter, m_samples, m_metaTypeId, m_srcRect, m_rect, m_style, m_lineWidth, m_arrowWidth);
+		}
+		emit m_graph->samplesImageRendered(m_channelIx, m_renderSerial, image, image_rect.topLeft());
+	}
+private:
+	Graph *m_graph;
+	int m_channelIx;
+	int m_renderSerial;
+	// implicitly shared snapshot, model can append samples meanwhile
+	ChannelSamples m_samples;
+	int m_metaTypeId;
+	Graph::DataRect m_srcRect;
+	QRect m_rect;
+	GraphChannel::Style m_style;
+	double m_lineWidth;
+	int m_arrowWidth;
+	qreal m_devicePixelRatio;
+};
+
+}
+
+void Graph::drawSamples(QPainter *painter, int channel_ix, const DataRect &src_rect, const QRect &dest_rect, const GraphChannel::Style &channel_style)
+{
+	//shvLogFuncFrame() << "channel:" << channel_ix;
+	const GraphChannel *ch = channelAt(channel_ix);
+	int model_ix = ch->modelIndex();
+	QRect rect = dest_rect.isEmpty()? ch->graphDataGridRect(): dest_rect;
+	GraphChannel::Style ch_style = channel_style.isEmpty()? ch->m_effectiveStyle: channel_style;
+
+	DataRect drect = src_rect;
+	if(!drect.isValid()) {
+		drect.xRange = xRangeZoom();
+		drect.yRange = ch->yRangeZoom();
+	}
+	shvDebug() << model()->channelShvPath(model_ix) << "range:" << drect.xRange.min << drect.xRange.max;
+	draw_channel_samples(painter, channelSamplesSnapshot(model_ix, drect.xRange), channelMetaTypeId(channel_ix)
+						 , drect, rect, ch_style, u2pxf(ch_style.lineWidth()), u2px(1));
+}
+
+void Graph::drawSamplesCached(QPainter *painter, int channel_ix)
+{
+	GraphChannel *ch = channelAt(channel_ix);
+	const int model_ix = ch->modelIndex();
+	const GraphModel *m = model();
+	auto &cache = ch->m_samplesCache;
+
+	GraphChannel::SamplesImageKey key;
+	key.xRange = xRangeZoom();
+	key.yRange = ch->yRangeZoom();
+	key.rect = ch->graphDataGridRect();
+	key.sampleCount = m->count(model_ix);
+	key.lastSampleTime = (key.sampleCount > 0)? m->sampleAt(model_ix, key.sampleCount - 1).time: 0;
+	key.metaTypeId = channelMetaTypeId(channel_ix);
+	key.style = ch->m_effectiveStyle;
+	key.devicePixelRatio = painter->device()->devicePixelRatioF();
+
+	if(!key.xRange.isValid() || !key.yRange.isValid() || key.rect.isEmpty())
+		return;
+
+	if(cache.key != key && !cache.isRenderPending) {
+		// at most one job per channel, next one is started when it is done
+		cache.isRenderPending = true;
+		cache.pendingKey = key;
+		m_samplesRenderPool.start(new SamplesRenderJob(this, channel_ix, m_samplesRenderSerial
+							   , channelSamplesSnapshot(model_ix, key.xRange), key.metaTypeId
+							   , DataRect{key.xRange, key.yRange}, key.rect, key.style
+							   , u2pxf(key.style.lineWidth()), u2px(1), key.devicePixelRatio));
+	}
+	if(cache.image.isNull())
+		return;
+	painter->save();
+	painter->setClipRect(key.rect.adjusted(0, cache.imageOrigin.y() - key.rect.top(), 0, key.rect.top() - cache.imageOrigin.y()));
+	if(cache.key == key) {
+		painter->drawImage(cache.imageOrigin, cache.image);
+	}
+	else {
+		// stale image mapped to the current ranges is shown until the new one is rendered
+		const GraphChannel::SamplesImageKey &old_key = cache.key;
+		if(old_key.xRange.interval() > 0 && key.xRange.interval() > 0 && !old_key.yRange.isEmpty() && !key.yRange.isEmpty()) {
+			const QRect &r = key.rect;
+			auto time2x = [&key, &r](timemsec_t t) {
+				return r.left() + static_cast<double>(t - key.xRange.min) * r.width() / key.xRange.interval();
+			};
+			auto value2y = [&key, &r](double v) {
+				return r.bottom() - (v - key.yRange.min) * r.height() / key.yRange.interval();
+			};
+			QRectF target(QPointF{time2x(old_key.xRange.min), value2y(old_key.yRange.max)}
+						  , QPointF{time2x(old_key.xRange.max), value2y(old_key.yRange.min)});
+			const QRectF image_rect(cache.imageOrigin, cache.image.size() / cache.image.devicePixelRatio());
+			const double sx = target.width() / old_key.rect.width();
+			const double sy = target.height() / old_key.rect.height();
+			target.setLeft(target.left() + (image_rect.left() - old_key.rect.left()) * sx);
+			target.setTop(target.top() + (image_rect.top() - old_key.rect.top()) * sy);
+			target.setWidth(image_rect.width() * sx);
+			target.setHeight(image_rect.height() * sy);
+			painter->drawImage(target, cache.image);
+		}
 	}
 	painter->restore();
 }
 
+void Graph::onSamplesImageRendered(int channel_ix, int render_serial, const QImage &image, const QPoint &image_origin)
+{
+	if(render_serial != m_samplesRenderSerial)
+		return;
+	GraphChannel *ch = channelAt(channel_ix, !shv::core::Exception::Throw);
+	if(!ch)
+		return;
+	auto &cache = ch->m_samplesCache;
+	cache.isRenderPending = false;
+	cache.image = image;
+	cache.imageOrigin = image_origin;
+	cache.key = cache.pendingKey;
+	emit presentationDirty(ch->graphAreaRect());
+}
+
+void Graph::clearSamplesCache()
+{
+	m_samplesRenderSerial++;
+	for(GraphChannel *ch : m_channels) {
+		ch->m_samplesCache.image = QImage();
+		ch->m_samplesCache.key = GraphChannel::SamplesImageKey();
+		ch->m_samplesCache.isRenderPending = false;
+	}
+}
+
+void Graph::setAsyncSamplesRendering(bool b)
+{
+	if(b == m_isAsyncSamplesRendering)
+		return;
+	m_isAsyncSamplesRendering = b;
+	clearSamplesCache();
+	emit presentationDirty(rect());
+}
+
 void Graph::drawCrossHair(QPainter *painter, int channel_ix)
 {
 	if(!crossHairPos().isValid())
@@ -1609,7 +1820,7 @@ void Graph::drawCrossHair(QPainter *painter, int channel_ix)
 	const GraphChannel *ch = channelAt(channel_ix);
 	if(ch->graphDataGridRect().left() >= crossbar_pos.x() || ch->graphDataGridRect().right() <= crossbar_pos.y())
 		return;
-	shvMessage() << "drawCrossHair:" << ch->shvPath();
+	shvDebug() << "drawCrossHair:" << ch->shvPath();
 	painter->save();
 	QColor color = m_effectiveStyle.colorCrossBar();
 	if(channel_ix == crossHairPos().channelIndex) {
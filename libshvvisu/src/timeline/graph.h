@@ -1,6 +1,7 @@
 #pragma once
 
 #include "channelfilter.h"
+#include "channelsamples.h"
 #include "graphchannel.h"
 #include "graphbuttonbox.h"
 #include "sample.h"
@@ -16,6 +17,7 @@
 #include <QFont>
 #include <QPixmap>
 #include <QRect>
+#include <QThreadPool>
 #include <QTimeZone>
 
 namespace shv {
@@ -160,6 +162,12 @@ public:
 	void makeLayout(const QRect &pref_rect);
 	void draw(QPainter *painter, const QRect &dirty_rect, const QRect &view_rect);
 
+	/// Channel samples are rendered to per channel images in background threads,
+	/// paint event then only blits them and draws overlays (cross hair, current time, selection).
+	/// It is off by default, since drawSamples() overrides of subclasses are not called when it is on.
+	bool isAsyncSamplesRendering() const { return m_isAsyncSamplesRendering; }
+	void setAsyncSamplesRendering(bool b);
+
 	int u2px(double u) const;
 	double u2pxf(double u) const;
 	double px2u(int px) const;
@@ -180,6 +188,8 @@ public:
 	Q_SIGNAL void channelContextMenuRequest(int channel_index, const QPoint &mouse_pos);
 	void emitChannelContextMenuRequest(int channel_index, const QPoint &mouse_pos) { emit channelContextMenuRequest(channel_index, mouse_pos); }
 	Q_SIGNAL void graphContextMenuRequest(const QPoint &mouse_pos);
+	/// emitted from render thread
+	Q_SIGNAL void samplesImageRendered(int channel_ix, int render_serial, const QImage &image, const QPoint &image_origin);
 
 	static QString rectToString(const QRect &r);
 protected:
@@ -187,12 +197,17 @@ protected:
 	//void onModelXRangeChanged(const timeline::XRange &range);
 
 	void clearMiniMapCache();
+	void clearSamplesCache();
 
 	void drawRectText(QPainter *painter, const QRect &rect, const QString &text, const QFont &font, const QColor &color, const QColor &background = QColor());
 	void drawCenteredRectText(QPainter *painter, const QPoint &top_center, const QString &text, const QFont &font, const QColor &color, const QColor &background = QColor());
 
 	QVector<int> visibleChannels();
 	int maximizedChannelIndex();
+	/// lessOrEqualIndex using channel cursor cache
+	int cursorSampleIndex(const GraphChannel *ch, timemsec_t time) const;
+	/// samples of model channel needed to draw xrange, model accessors are used if model does not enable direct access
+	ChannelSamples channelSamplesSnapshot(int model_ix, const XRange &xrange) const;
 
 	bool isChannelFlat(GraphChannel *ch);
 
@@ -209,6 +224,7 @@ protected:
 			, const DataRect &src_rect = DataRect()
 			, const QRect &dest_rect = QRect()
 			, const GraphChannel::Style &channel_style = GraphChannel::Style());
+	void drawSamplesCached(QPainter *painter, int channel_ix);
 	virtual void drawCrossHair(QPainter *painter, int channel_ix);
 	virtual void drawSelection(QPainter *painter);
 	virtual void drawCurrentTime(QPainter *painter, int channel_ix);
@@ -221,6 +237,7 @@ protected:
 	void moveSouthFloatingBarBottom(int bottom);
 protected:
 	void onButtonBoxClicked(int button_id);
+	void onSamplesImageRendered(int channel_ix, int render_serial, const QImage &image, const QPoint &image_origin);
 protected:
 	GraphModel *m_model = nullptr;
 
@@ -270,6 +287,11 @@ protected:
 
 	QPixmap m_miniMapCache;
 	GraphButtonBox *m_cornerCellButtonBox = nullptr;
+
+	bool m_isAsyncSamplesRendering = false;
+	/// incremented when channels are cleared, images rendered for previous channels are discarded
+	int m_samplesRenderSerial = 0;
+	QThreadPool m_samplesRenderPool;
 };
 
 }}}
@@ -9,6 +9,7 @@
 
 #include <QVariantMap>
 #include <QColor>
+#include <QImage>
 #include <QRect>
 #include <QObject>
 
@@ -118,6 +119,43 @@ protected:
 	Style m_style;
 	Style m_effectiveStyle;
 	int m_modelIndex = 0;
+	/// index of sample found by recent time lookup, cross hair moves mostly by few samples
+	mutable int m_cursorSampleIndex = -1;
+
+	/// everything the rendered samples image depends on
+	struct SamplesImageKey
+	{
+		XRange xRange;
+		YRange yRange;
+		QRect rect;
+		int sampleCount = -1;
+		timemsec_t lastSampleTime = 0;
+		int metaTypeId = 0;
+		Style style;
+		qreal devicePixelRatio = 1;
+
+		bool operator==(const SamplesImageKey &o) const
+		{
+			return xRange.min == o.xRange.min && xRange.max == o.xRange.max
+					&& yRange.min == o.yRange.min && yRange.max == o.yRange.max
+					&& rect == o.rect
+					&& sampleCount == o.sampleCount
+					&& lastSampleTime == o.lastSampleTime
+					&& metaTypeId == o.metaTypeId
+					&& devicePixelRatio == o.devicePixelRatio
+					&& style == o.style;
+		}
+		bool operator!=(const SamplesImageKey &o) const { return !(*this == o); }
+	};
+	struct
+	{
+		QImage image;
+		/// image top left corner, image is higher than key.rect by line width margins
+		QPoint imageOrigin;
+		SamplesImageKey key;
+		SamplesImageKey pendingKey;
+		bool isRenderPending = false;
+	} m_samplesCache;
 };
 
 } // namespace timeline
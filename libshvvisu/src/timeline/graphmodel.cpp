@@ -3,6 +3,8 @@
 #include <shv/chainpack/rpcvalue.h>
 #include <shv/coreqt/log.h>
 
+#include <typeinfo>
+
 namespace shv {
 namespace visu {
 namespace timeline {
@@ -29,7 +31,7 @@ int GraphModel::count(int channel) const
 
 Sample GraphModel::sampleAt(int channel, int ix) const
 {
-	return m_samples.at(channel).at(ix);
+	return m_samples.at(channel).sampleAt(ix);
 }
 
 Sample GraphModel::sampleValue(int channel, int ix) const
@@ -62,12 +64,15 @@ XRange GraphModel::xRange(int channel_ix) const
 
 YRange GraphModel::yRange(int channel_ix) const
 {
+	if(channel_ix < 0 || channel_ix >= channelCount())
+		return YRange();
+	const int meta_type_id = channelInfo(channel_ix).metaTypeId;
+	if(isChannelSamplesAccessEnabled())
+		return m_samples.at(channel_ix).yRange(meta_type_id);
 	YRange ret;
-	auto mtid = channelInfo(channel_ix).metaTypeId;
 	for (int i = 0; i < count(channel_ix); ++i) {
-		QVariant v = sampleAt(channel_ix, i).value;
 		bool ok;
-		double d = valueToDouble(v, mtid, &ok);
+		double d = valueToDouble(sampleAt(channel_ix, i).value, meta_type_id, &ok);
 		if(ok) {
 			ret.min = qMin(ret.min, d);
 			ret.max = qMax(ret.max, d);
@@ -76,6 +81,11 @@ YRange GraphModel::yRange(int channel_ix) const
 	return ret;
 }
 
+bool GraphModel::isChannelSamplesAccessEnabled() const
+{
+	return m_isChannelSamplesAccessEnabled || typeid(*this) == typeid(GraphModel);
+}
+
 double GraphModel::valueToDouble(const QVariant v, int meta_type_id, bool *ok)
 {
 	if(ok)
@@ -108,31 +118,9 @@ double GraphModel::valueToDouble(const QVariant v, int meta_type_id, bool *ok)
 
 int GraphModel::lessOrEqualIndex(int channel, timemsec_t time) const
 {
-	if(channel < 0 || channel > channelCount())
+	if(channel < 0 || channel >= channelCount())
 		return -1;
-
-	int first = 0;
-	int cnt = count(channel);
-	bool found = false;
-	while (cnt > 0) {
-		int step = cnt / 2;
-		int pivot = first + step;
-		if (sampleAt(channel, pivot).time <= time) {
-			first = pivot;
-			if(step)
-				cnt -= step;
-			else
-				cnt = 0;
-			found = true;
-		}
-		else {
-			cnt = step;
-			found = false;
-		}
-	};
-	int ret = found? first: -1;
-	//shvInfo() << time << "-->" << ret;
-	return ret;
+	return m_samples.at(channel).lessOrEqualIndex(time);
 }
 
 void GraphModel::beginAppendValues()
@@ -151,6 +139,7 @@ void GraphModel::endAppendValues()
 		if(chi.metaTypeId == QMetaType::UnknownType) {
 			chi.metaTypeId = guessMetaType(i);
 		}
+		m_samples[i].setLodMetaTypeId(chi.metaTypeId);
 	}
 }
 
@@ -165,17 +154,18 @@ void GraphModel::appendValue(int channel, Sample &&sample)
 		return;
 	}
 	ChannelSamples &dat = m_samples[channel];
-	if(!dat.isEmpty() && dat.last().time > sample.time) {
+	if(!dat.isEmpty() && dat.lastTime() > sample.time) {
 		shvWarning() << channelInfo(channel).shvPath << "channel:" << channel
 					 << "ignoring value with lower timestamp than last value (check possibly wrong short-time correction):"
-					 << dat.last().time << shv::chainpack::RpcValue::DateTime::fromMSecsSinceEpoch(dat.last().time).toIsoString()
+					 << dat.lastTime() << shv::chainpack::RpcValue::DateTime::fromMSecsSinceEpoch(dat.lastTime()).toIsoString()
 					 << "val:"
 					 << sample.time << shv::chainpack::RpcValue::DateTime::fromMSecsSinceEpoch(sample.time).toIsoString();
 		return;
 	}
 	//m_appendSince = qMin(sampleAt.time, m_appendSince);
 	//m_appendUntil = qMax(sampleAt.time, m_appendUntil);
-	dat.push_back(std::move(sample));
+	dat.setLodMetaTypeId(channelInfo(channel).metaTypeId);
+	dat.append(std::move(sample));
 }
 
 void GraphModel::appendValueShvPath(const std::string &shv_path, Sample &&sample)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "channelsamples.h"
 #include "graph.h"
 #include "sample.h"
 
@@ -45,6 +46,8 @@ public:
 		//QString caption() const { return name.isEmpty()? shvPath: name; }
 	};
 
+	using LodBucket = ChannelSamples::LodBucket;
+
 	SHV_FIELD_BOOL_IMPL2(a, A, utoCreateChannels, true)
 
 public:
@@ -72,6 +75,20 @@ public:
 
 	virtual int lessOrEqualIndex(int channel, timemsec_t time) const;
 
+	/// direct access to typed sample columns, without bounds check
+	/// it is consistent with count(), sampleAt() and lessOrEqualIndex() only if isChannelSamplesAccessEnabled()
+	const ChannelSamples& channelSamples(int channel) const { return m_samples.at(channel); }
+	/// true for GraphModel and for subclasses setting m_isChannelSamplesAccessEnabled
+	bool isChannelSamplesAccessEnabled() const;
+
+	/// Returns the largest LOD bucket starting at sample ix, ending before ix_end and lasting at most max_span msec,
+	/// sample_count is set to the number of samples it aggregates.
+	/// Returns nullptr if there is no such bucket, sample ix should be used directly then.
+	const LodBucket* lodBucket(int channel, int ix, int ix_end, timemsec_t max_span, int *sample_count) const
+	{
+		return m_samples.at(channel).lodBucket(ix, ix_end, max_span, channelInfo(channel).metaTypeId, sample_count);
+	}
+
 	virtual void beginAppendValues();
 	virtual void endAppendValues();
 	virtual void appendValue(int channel, Sample &&sample);
@@ -87,7 +104,9 @@ public:
 protected:
 	virtual int guessMetaType(int channel_ix);
 protected:
-	using ChannelSamples = QVector<Sample>;
+	/// subclasses which do not reimplement count(), sampleAt() and lessOrEqualIndex() can set it
+	/// to let Graph read channelSamples() directly
+	bool m_isChannelSamplesAccessEnabled = false;
 	QVector<ChannelSamples> m_samples;
 	QVector<ChannelInfo> m_channelsInfo;
 	XRange m_begginAppendXRange;
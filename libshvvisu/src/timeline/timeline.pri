@@ -3,6 +3,7 @@ HEADERS += \
     $$PWD/channelfilterdialog.h \
     $$PWD/channelfiltermodel.h \
     $$PWD/channelfiltersortfilterproxymodel.h \
+    $$PWD/channelsamples.h \
     $$PWD/graphbuttonbox.h \
     $$PWD/graphchannel.h \
     $$PWD/graphmodel.h \
@@ -17,6 +18,7 @@ SOURCES += \
     $$PWD/channelfilterdialog.cpp \
     $$PWD/channelfiltermodel.cpp \
     $$PWD/channelfiltersortfilterproxymodel.cpp \
+    $$PWD/channelsamples.cpp \
     $$PWD/graphbuttonbox.cpp \
     $$PWD/graphchannel.cpp \
     $$PWD/graphmodel.cpp \
@@ -0,0 +1,64 @@
+message("including $$PWD")
+
+isEmpty(SHV_PROJECT_TOP_BUILDDIR) {
+        SHV_PROJECT_TOP_BUILDDIR = $$OUT_PWD/../..
+}
+else {
+        message ( SHV_PROJECT_TOP_BUILDDIR is not empty and set to $$SHV_PROJECT_TOP_BUILDDIR )
+        message ( This is obviously done in file $$SHV_PROJECT_TOP_SRCDIR/.qmake.conf )
+}
+message ( SHV_PROJECT_TOP_BUILDDIR == '$$SHV_PROJECT_TOP_BUILDDIR' )
+
+LIBSHV_SRC_DIR = $$PWD/../..
+
+QT -= gui
+QT += core network
+
+with-shvwebsockets {
+	QT += websockets
+	DEFINES += WITH_SHV_WEBSOCKETS
+	# client side websocket transport is not exported from libshvbroker
+	SOURCES += $$LIBSHV_SRC_DIR/libshvbroker/src/rpc/websocket.cpp
+	HEADERS += $$LIBSHV_SRC_DIR/libshvbroker/src/rpc/websocket.h
+}
+
+CONFIG += c++11
+
+TEMPLATE = app
+TARGET = shvbrokerbench
+
+DESTDIR = $$SHV_PROJECT_TOP_BUILDDIR/bin
+unix:LIBDIR = $$SHV_PROJECT_TOP_BUILDDIR/lib
+win32:LIBDIR = $$SHV_PROJECT_TOP_BUILDDIR/bin
+
+DEFINES += SAMPLE_BROKER_CONFIG_DIR=$$PWD/../sampleshvbroker/etc/shv/shvbroker
+
+LIBS += \
+        -L$$LIBDIR \
+
+LIBS += \
+    -lnecrolog \
+    -lshvchainpack \
+    -lshvcore \
+    -lshvcoreqt \
+    -lshviotqt \
+
+unix {
+        LIBS += \
+                -Wl,-rpath,\'\$\$ORIGIN/../lib\'
+}
+
+INCLUDEPATH += \
+    $$LIBSHV_SRC_DIR/3rdparty/necrolog/include \
+    $$LIBSHV_SRC_DIR/libshvchainpack/include \
+    $$LIBSHV_SRC_DIR/libshvcore/include \
+    $$LIBSHV_SRC_DIR/libshvcoreqt/include \
+    $$LIBSHV_SRC_DIR/libshviotqt/include \
+
+include (src/src.pri)
+
+# make bench - run benchmark with default parameters against spawned sampleshvbroker,
+# available also in top level build directory
+bench.commands = $$DESTDIR/$$TARGET
+bench.depends = $$DESTDIR/$$TARGET
+QMAKE_EXTRA_TARGETS += bench
@@ -0,0 +1,54 @@
+#include "appclioptions.h"
+
+#include <shv/core/utils.h>
+
+namespace cp = shv::chainpack;
+
+AppCliOptions::AppCliOptions()
+{
+	addOption("bench.devices").setType(cp::RpcValue::Type::Int).setNames("--devices")
+			.setComment("Number of simulated devices, mounted on test/bench/devN.")
+			.setDefaultValue(10);
+	addOption("bench.nodesPerDevice").setType(cp::RpcValue::Type::Int).setNames("--nodes")
+			.setComment("Number of value nodes in every simulated device tree.")
+			.setDefaultValue(100);
+	addOption("bench.signalInterval").setType(cp::RpcValue::Type::Int).setNames("--signal-interval")
+			.setComment("Every device sends one value change signal per signal-interval [msec], 0 disables signals.")
+			.setDefaultValue(10);
+	addOption("bench.valueType").setType(cp::RpcValue::Type::String).setNames("--value-type")
+			.setComment("Type of simulated node values [int | double | string | map].")
+			.setDefaultValue("int");
+	addOption("bench.subscribers").setType(cp::RpcValue::Type::Int).setNames("--subscribers")
+			.setComment("Number of HMI clients subscribed to all device value changes.")
+			.setDefaultValue(5);
+	addOption("bench.requesters").setType(cp::RpcValue::Type::Int).setNames("--requesters")
+			.setComment("Number of clients calling get on device nodes.")
+			.setDefaultValue(2);
+	addOption("bench.requestDepth").setType(cp::RpcValue::Type::Int).setNames("--request-depth")
+			.setComment("Number of requests every requester keeps in flight.")
+			.setDefaultValue(1);
+	addOption("bench.clientTransport").setType(cp::RpcValue::Type::String).setNames("--client-transport")
+			.setComment("Transport used by subscriber and requester clients [tcp | ws], devices always use tcp.")
+			.setDefaultValue("tcp");
+	addOption("bench.duration").setType(cp::RpcValue::Type::Int).setNames("--duration")
+			.setComment("Measurement duration [sec].")
+			.setDefaultValue(10);
+	addOption("bench.warmup").setType(cp::RpcValue::Type::Int).setNames("--warmup")
+			.setComment("Warm-up period before measurement is started [sec].")
+			.setDefaultValue(2);
+	addOption("broker.exe").setType(cp::RpcValue::Type::String).setNames("--broker-exe")
+			.setComment("Broker executable to spawn, default is sampleshvbroker next to this executable, "
+						"set to 'none' to connect to already running broker.");
+	addOption("broker.configDir").setType(cp::RpcValue::Type::String).setNames("--broker-config-dir")
+			.setComment("Config dir of spawned broker.")
+			.setDefaultValue(SHV_EXPAND_AND_QUOTE(SAMPLE_BROKER_CONFIG_DIR));
+	addOption("broker.wsPort").setType(cp::RpcValue::Type::Int).setNames("--broker-ws-port")
+			.setComment("Broker web socket port.")
+			.setDefaultValue(3777);
+	addOption("broker.pid").setType(cp::RpcValue::Type::Int).setNames("--broker-pid")
+			.setComment("PID of already running broker, used to report broker CPU and RSS when broker is not spawned.")
+			.setDefaultValue(0);
+
+	setUser("poweruser");
+	setPassword("weakpassword");
+}
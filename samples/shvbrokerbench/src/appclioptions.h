@@ -0,0 +1,26 @@
+#pragma once
+
+#include <shv/iotqt/rpc/clientappclioptions.h>
+
+class AppCliOptions : public shv::iotqt::rpc::ClientAppCliOptions
+{
+private:
+	using Super = shv::iotqt::rpc::ClientAppCliOptions;
+public:
+	AppCliOptions();
+
+	CLIOPTION_GETTER_SETTER2(int, "bench.devices", d, setD, evices)
+	CLIOPTION_GETTER_SETTER2(int, "bench.nodesPerDevice", n, setN, odesPerDevice)
+	CLIOPTION_GETTER_SETTER2(int, "bench.signalInterval", s, setS, ignalInterval)
+	CLIOPTION_GETTER_SETTER2(std::string, "bench.valueType", v, setV, alueType)
+	CLIOPTION_GETTER_SETTER2(int, "bench.subscribers", s, setS, ubscribers)
+	CLIOPTION_GETTER_SETTER2(int, "bench.requesters", r, setR, equesters)
+	CLIOPTION_GETTER_SETTER2(int, "bench.requestDepth", r, setR, equestDepth)
+	CLIOPTION_GETTER_SETTER2(std::string, "bench.clientTransport", c, setC, lientTransport)
+	CLIOPTION_GETTER_SETTER2(int, "bench.duration", d, setD, uration)
+	CLIOPTION_GETTER_SETTER2(int, "bench.warmup", w, setW, armup)
+	CLIOPTION_GETTER_SETTER2(std::string, "broker.exe", b, setB, rokerExe)
+	CLIOPTION_GETTER_SETTER2(std::string, "broker.configDir", b, setB, rokerConfigDir)
+	CLIOPTION_GETTER_SETTER2(int, "broker.wsPort", b, setB, rokerWsPort)
+	CLIOPTION_GETTER_SETTER2(int, "broker.pid", b, setB, rokerPid)
+};
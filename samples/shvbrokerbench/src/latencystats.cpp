@@ -0,0 +1,56 @@
+#include "latencystats.h"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <sstream>
+
+void LatencyStats::merge(const LatencyStats &other)
+{
+	m_samples.insert(m_samples.end(), other.m_samples.begin(), other.m_samples.end());
+	if(!other.m_samples.empty())
+		m_isSorted = false;
+}
+
+void LatencyStats::finalize()
+{
+	if(!m_isSorted) {
+		std::sort(m_samples.begin(), m_samples.end());
+		m_isSorted = true;
+	}
+}
+
+int64_t LatencyStats::percentile(double p) const
+{
+	assert(m_isSorted);
+	if(m_samples.empty())
+		return 0;
+	p = std::max(0., std::min(1., p));
+	size_t ix = static_cast<size_t>(p * static_cast<double>(m_samples.size() - 1) + 0.5);
+	return m_samples[ix];
+}
+
+double LatencyStats::mean() const
+{
+	if(m_samples.empty())
+		return 0;
+	return static_cast<double>(std::accumulate(m_samples.begin(), m_samples.end(), int64_t(0))) / static_cast<double>(m_samples.size());
+}
+
+int64_t LatencyStats::max() const
+{
+	return percentile(1);
+}
+
+std::string LatencyStats::toString() const
+{
+	std::ostringstream os;
+	os << "count: " << count()
+	   << " mean: " << static_cast<int64_t>(mean())
+	   << " p50: " << percentile(0.5)
+	   << " p99: " << percentile(0.99)
+	   << " p999: " << percentile(0.999)
+	   << " max: " << max()
+	   << " [usec]";
+	return os.str();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+
+/// Collects latency samples [usec], computes percentiles after finalize()
+class LatencyStats
+{
+public:
+	static int64_t nowUsec()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void add(int64_t usec) { m_samples.push_back(usec); m_isSorted = false; }
+	void merge(const LatencyStats &other);
+	void clear() { m_samples.clear(); m_isSorted = true; }
+	size_t count() const { return m_samples.size(); }
+	/// sorts samples, must be called after the last add() or merge() before percentiles are read
+	void finalize();
+
+	/// p in range <0, 1>
+	int64_t percentile(double p) const;
+	double mean() const;
+	int64_t max() const;
+
+	std::string toString() const;
+private:
+	std::vector<int64_t> m_samples;
+	bool m_isSorted = true;
+};
@@ -0,0 +1,49 @@
+#include "shvbrokerbenchapp.h"
+#include "appclioptions.h"
+
+#include <shv/chainpack/rpcmessage.h>
+
+#include <shv/coreqt/log.h>
+
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication::setOrganizationName("Elektroline");
+	QCoreApplication::setOrganizationDomain("elektroline.cz");
+	QCoreApplication::setApplicationName("shvbrokerbench");
+	QCoreApplication::setApplicationVersion("0.0.1");
+
+	std::vector<std::string> shv_args = NecroLog::setCLIOptions(argc, argv);
+
+	AppCliOptions cli_opts;
+	cli_opts.parse(shv_args);
+	if(cli_opts.isParseError()) {
+		for(const std::string &err : cli_opts.parseErrors())
+			shvError() << err;
+		return EXIT_FAILURE;
+	}
+	if(cli_opts.isAppBreak()) {
+		if(cli_opts.isHelp()) {
+			cli_opts.printHelp(std::cout);
+		}
+		return EXIT_SUCCESS;
+	}
+	for(const std::string &s : cli_opts.unusedArguments()) {
+		shvWarning() << "Undefined argument:" << s;
+	}
+
+	if(!cli_opts.loadConfigFile()) {
+		return EXIT_FAILURE;
+	}
+
+	shv::chainpack::RpcMessage::registerMetaTypes();
+
+	shvInfo() << "Starting SHV broker benchmark, PID:" << QCoreApplication::applicationPid() << "build:" << __DATE__ << __TIME__;
+
+	ShvBrokerBenchApp a(argc, argv, &cli_opts);
+	int ret = a.exec();
+	shvInfo() << "bye ...";
+
+	return ret;
+}
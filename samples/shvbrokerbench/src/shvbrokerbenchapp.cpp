@@ -0,0 +1,350 @@
+#include "shvbrokerbenchapp.h"
+#include "appclioptions.h"
+#include "simdevice.h"
+#include "simclient.h"
+#include "latencystats.h"
+
+#include <shv/iotqt/rpc/clientconnection.h>
+#include <shv/coreqt/log.h>
+
+#include <QProcess>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QFileInfo>
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+static constexpr int BROKER_PROBE_INTERVAL_MSEC = 100;
+static constexpr int BROKER_PROBE_MAX_COUNT = 100;
+static constexpr int CONNECT_TIMEOUT_MSEC = 30000;
+
+ShvBrokerBenchApp::ShvBrokerBenchApp(int &argc, char **argv, AppCliOptions* cli_opts)
+	: Super(argc, argv)
+	, m_cliOptions(cli_opts)
+{
+	// reconnect would hide broker failures during measurement
+	m_cliOptions->setReconnectInterval(0);
+
+	for (int i = 0; i < cli_opts->devices(); ++i) {
+		SimDevice *dev = new SimDevice(i, cli_opts, this);
+		connect(dev, &SimDevice::brokerConnectedChanged, this, &ShvBrokerBenchApp::checkConnected);
+		m_devices.push_back(dev);
+	}
+	for (int i = 0; i < cli_opts->subscribers(); ++i) {
+		SimClient *cl = new SimClient(SimClient::Kind::Subscriber, i, cli_opts, this);
+		connect(cl, &SimClient::readyChanged, this, &ShvBrokerBenchApp::checkConnected);
+		m_subscribers.push_back(cl);
+	}
+	for (int i = 0; i < cli_opts->requesters(); ++i) {
+		SimClient *cl = new SimClient(SimClient::Kind::Requester, i, cli_opts, this);
+		connect(cl, &SimClient::readyChanged, this, &ShvBrokerBenchApp::checkConnected);
+		m_requesters.push_back(cl);
+	}
+	QTimer::singleShot(0, this, &ShvBrokerBenchApp::startBroker);
+}
+
+ShvBrokerBenchApp::~ShvBrokerBenchApp()
+{
+	if(m_brokerProcess && m_brokerProcess->state() != QProcess::NotRunning) {
+		m_brokerProcess->kill();
+		m_brokerProcess->waitForFinished(1000);
+	}
+}
+
+bool ShvBrokerBenchApp::readProcStats(int64_t pid, ProcStats &stats)
+{
+#ifdef Q_OS_LINUX
+	if(pid <= 0)
+		return false;
+	const std::string proc_dir = "/proc/" + std::to_string(pid);
+	{
+		std::ifstream is(proc_dir + "/stat");
+		std::string line;
+		if(!std::getline(is, line))
+			return false;
+		// comm field might contain spaces, fields are counted after closing parenthesis
+		size_t pos = line.rfind(')');
+		if(pos == std::string::npos)
+			return false;
+		std::istringstream fields(line.substr(pos + 2));
+		std::string field;
+		int64_t utime = 0, stime = 0;
+		// state is field 3, utime 14, stime 15
+		for (int i = 3; i <= 15 && fields >> field; ++i) {
+			if(i == 14)
+				utime = std::stoll(field);
+			else if(i == 15)
+				stime = std::stoll(field);
+		}
+		stats.cpuTicks = utime + stime;
+	}
+	{
+		std::ifstream is(proc_dir + "/status");
+		std::string line;
+		while(std::getline(is, line)) {
+			if(line.compare(0, 6, "VmRSS:") == 0)
+				stats.rssKb = std::stoll(line.substr(6));
+			else if(line.compare(0, 6, "VmHWM:") == 0)
+				stats.peakRssKb = std::stoll(line.substr(6));
+		}
+	}
+	return true;
+#else
+	Q_UNUSED(pid)
+	Q_UNUSED(stats)
+	return false;
+#endif
+}
+
+void ShvBrokerBenchApp::startBroker()
+{
+	std::string exe = m_cliOptions->brokerExe();
+	if(exe == "none") {
+		m_brokerPid = m_cliOptions->brokerPid();
+		shvInfo() << "Using running broker on port:" << m_cliOptions->serverPort() << "PID:" << m_brokerPid;
+		waitForBroker();
+		return;
+	}
+	if(exe.empty())
+		exe = QCoreApplication::applicationDirPath().toStdString() + "/sampleshvbroker";
+	if(!QFileInfo(QString::fromStdString(exe)).isExecutable()) {
+		abortBenchmark("Broker executable: " + exe + " not found.");
+		return;
+	}
+	QStringList args {
+		"--config-dir", QString::fromStdString(m_cliOptions->brokerConfigDir()),
+		"--config", "shvbroker",
+		"-p", QString::number(m_cliOptions->serverPort()),
+		"--server-ws-port", QString::number(m_cliOptions->brokerWsPort()),
+	};
+	m_brokerProcess = new QProcess(this);
+	m_brokerProcess->setStandardOutputFile(QProcess::nullDevice());
+	m_brokerProcess->setStandardErrorFile(QProcess::nullDevice());
+	connect(m_brokerProcess, &QProcess::started, this, [this]() {
+		m_brokerPid = m_brokerProcess->processId();
+		shvInfo() << "Broker started, PID:" << m_brokerPid;
+		waitForBroker();
+	});
+	connect(m_brokerProcess, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this, [this](int exit_code, QProcess::ExitStatus) {
+		if(m_phase != Phase::Finished)
+			abortBenchmark("Broker exited unexpectedly, exit code: " + std::to_string(exit_code));
+	});
+	shvInfo() << "Starting broker:" << exe << args.join(' ');
+	m_brokerProcess->start(QString::fromStdString(exe), args);
+}
+
+void ShvBrokerBenchApp::waitForBroker()
+{
+	// broker needs some time to open its server socket after process start
+	QTcpSocket *probe = new QTcpSocket(this);
+	connect(probe, &QTcpSocket::connected, this, [this, probe]() {
+		probe->abort();
+		probe->deleteLater();
+		openDevices();
+	});
+	connect(probe, static_cast<void (QTcpSocket::*)(QAbstractSocket::SocketError)>(&QTcpSocket::error), this, [this, probe](QAbstractSocket::SocketError) {
+		probe->deleteLater();
+		if(++m_brokerProbeCount > BROKER_PROBE_MAX_COUNT) {
+			abortBenchmark("Broker is not listening on port: " + std::to_string(m_cliOptions->serverPort()));
+			return;
+		}
+		QTimer::singleShot(BROKER_PROBE_INTERVAL_MSEC, this, &ShvBrokerBenchApp::waitForBroker);
+	});
+	probe->connectToHost(QString::fromStdString(m_cliOptions->serverHost()), static_cast<quint16>(m_cliOptions->serverPort()));
+}
+
+void ShvBrokerBenchApp::openDevices()
+{
+	shvInfo() << "Connecting" << m_devices.size() << "devices";
+	m_phase = Phase::ConnectingDevices;
+	for(SimDevice *dev : m_devices)
+		dev->open();
+	QTimer::singleShot(CONNECT_TIMEOUT_MSEC, this, [this]() {
+		if(m_phase == Phase::ConnectingDevices || m_phase == Phase::ConnectingClients)
+			abortBenchmark("Timeout while connecting to broker.");
+	});
+	checkConnected();
+}
+
+void ShvBrokerBenchApp::openClients()
+{
+	shvInfo() << "Connecting" << m_subscribers.size() << "subscribers and" << m_requesters.size() << "requesters";
+	m_phase = Phase::ConnectingClients;
+	for(SimClient *cl : m_subscribers)
+		cl->open();
+	for(SimClient *cl : m_requesters)
+		cl->open();
+	checkConnected();
+}
+
+void ShvBrokerBenchApp::checkConnected()
+{
+	if(m_phase == Phase::ConnectingDevices) {
+		for(SimDevice *dev : m_devices)
+			if(!dev->isBrokerConnected())
+				return;
+		openClients();
+	}
+	else if(m_phase == Phase::ConnectingClients) {
+		for(SimClient *cl : m_subscribers)
+			if(!cl->isReady())
+				return;
+		for(SimClient *cl : m_requesters)
+			if(!cl->isReady())
+				return;
+		startLoad();
+	}
+	else if(m_phase == Phase::Warmup || m_phase == Phase::Measurement) {
+		bool all_connected = true;
+		for(SimDevice *dev : m_devices)
+			all_connected = all_connected && dev->isBrokerConnected();
+		for(SimClient *cl : m_subscribers)
+			all_connected = all_connected && cl->isReady();
+		for(SimClient *cl : m_requesters)
+			all_connected = all_connected && cl->isReady();
+		if(!all_connected)
+			abortBenchmark("Broker connection lost during benchmark.");
+	}
+}
+
+void ShvBrokerBenchApp::startLoad()
+{
+	shvInfo() << "All clients connected, warming up for" << m_cliOptions->warmup() << "sec";
+	m_phase = Phase::Warmup;
+	for(SimDevice *dev : m_devices)
+		dev->startSignals();
+	for(SimClient *cl : m_requesters)
+		cl->startRequests();
+	QTimer::singleShot(m_cliOptions->warmup() * 1000, this, &ShvBrokerBenchApp::startMeasurement);
+}
+
+void ShvBrokerBenchApp::startMeasurement()
+{
+	if(m_phase != Phase::Warmup)
+		return;
+	shvInfo() << "Measuring for" << m_cliOptions->duration() << "sec";
+	m_phase = Phase::Measurement;
+	for(SimDevice *dev : m_devices)
+		dev->resetCounters();
+	for(SimClient *cl : m_subscribers)
+		cl->resetCounters();
+	for(SimClient *cl : m_requesters)
+		cl->resetCounters();
+	m_brokerStatsStart = ProcStats();
+	readProcStats(m_brokerPid, m_brokerStatsStart);
+	m_selfStatsStart = ProcStats();
+	readProcStats(QCoreApplication::applicationPid(), m_selfStatsStart);
+	m_measurementStartUsec = LatencyStats::nowUsec();
+	QTimer::singleShot(m_cliOptions->duration() * 1000, this, &ShvBrokerBenchApp::finishMeasurement);
+}
+
+void ShvBrokerBenchApp::finishMeasurement()
+{
+	if(m_phase != Phase::Measurement)
+		return;
+	double elapsed_sec = static_cast<double>(LatencyStats::nowUsec() - m_measurementStartUsec) / 1e6;
+	m_phase = Phase::Finished;
+	for(SimDevice *dev : m_devices)
+		dev->stopSignals();
+	for(SimClient *cl : m_requesters)
+		cl->stopRequests();
+	printReport(elapsed_sec);
+	shutdown(EXIT_SUCCESS);
+}
+
+void ShvBrokerBenchApp::printReport(double elapsed_sec)
+{
+	int64_t sent_signals = 0;
+	int64_t handled_requests = 0;
+	for(SimDevice *dev : m_devices) {
+		sent_signals += dev->sentSignalCount();
+		handled_requests += dev->handledRequestCount();
+	}
+	LatencyStats fanout;
+	int64_t delivered_signals = 0;
+	for(SimClient *cl : m_subscribers) {
+		fanout.merge(cl->latencyStats());
+		delivered_signals += cl->receivedCount();
+	}
+	LatencyStats rtt;
+	int64_t responses = 0;
+	int64_t errors = 0;
+	for(SimClient *cl : m_requesters) {
+		rtt.merge(cl->latencyStats());
+		responses += cl->receivedCount();
+		errors += cl->errorCount();
+	}
+	fanout.finalize();
+	rtt.finalize();
+	auto rate = [elapsed_sec](int64_t n) {
+		return static_cast<int64_t>(static_cast<double>(n) / elapsed_sec);
+	};
+
+	std::ostream &os = std::cout;
+	os << "======================================================================================\n";
+	os << "Broker benchmark, duration: " << std::fixed << std::setprecision(2) << elapsed_sec << " sec\n";
+	os << "devices: " << m_devices.size()
+	   << " nodes/device: " << m_cliOptions->nodesPerDevice()
+	   << " signal interval: " << m_cliOptions->signalInterval() << " msec"
+	   << " value type: " << m_cliOptions->valueType()
+	   << " subscribers: " << m_subscribers.size()
+	   << " requesters: " << m_requesters.size() << " x " << m_cliOptions->requestDepth()
+	   << " client transport: " << m_cliOptions->clientTransport()
+	   << " protocol: " << m_cliOptions->protocolType() << "\n";
+	os << "--------------------------------------------------------------------------------------\n";
+	os << "signals sent:        " << sent_signals << " (" << rate(sent_signals) << " msg/s)\n";
+	os << "signals delivered:   " << delivered_signals << " (" << rate(delivered_signals) << " msg/s)"
+	   << " expected: " << sent_signals * static_cast<int64_t>(m_subscribers.size()) << "\n";
+	os << "fan-out latency:     " << fanout.toString() << "\n";
+	os << "requests completed:  " << responses << " (" << rate(responses) << " rq/s)"
+	   << " errors: " << errors << " handled by devices: " << handled_requests << "\n";
+	os << "request RTT:         " << rtt.toString() << "\n";
+	ProcStats broker_stats;
+	if(readProcStats(m_brokerPid, broker_stats)) {
+#ifdef Q_OS_LINUX
+		double ticks_per_sec = static_cast<double>(::sysconf(_SC_CLK_TCK));
+		ProcStats self_stats;
+		readProcStats(QCoreApplication::applicationPid(), self_stats);
+		auto cpu_percent = [ticks_per_sec, elapsed_sec](int64_t ticks) {
+			return 100. * static_cast<double>(ticks) / ticks_per_sec / elapsed_sec;
+		};
+		os << "broker CPU:          " << cpu_percent(broker_stats.cpuTicks - m_brokerStatsStart.cpuTicks) << " %"
+		   << " RSS: " << broker_stats.rssKb << " kB peak RSS: " << broker_stats.peakRssKb << " kB\n";
+		os << "load generator CPU:  " << cpu_percent(self_stats.cpuTicks - m_selfStatsStart.cpuTicks) << " %"
+		   << " (results are skewed when it is close to 100 %)\n";
+#endif
+	}
+	else {
+		os << "broker CPU and RSS:  not available\n";
+	}
+	os << "======================================================================================" << std::endl;
+}
+
+void ShvBrokerBenchApp::abortBenchmark(const std::string &reason)
+{
+	if(m_phase == Phase::Finished)
+		return;
+	m_phase = Phase::Finished;
+	shvError() << "Benchmark aborted:" << reason;
+	shutdown(EXIT_FAILURE);
+}
+
+void ShvBrokerBenchApp::shutdown(int exit_code)
+{
+	for(SimClient *cl : m_subscribers)
+		cl->rpcConnection()->abort();
+	for(SimClient *cl : m_requesters)
+		cl->rpcConnection()->abort();
+	for(SimDevice *dev : m_devices)
+		dev->rpcConnection()->abort();
+	if(m_brokerProcess && m_brokerProcess->state() != QProcess::NotRunning)
+		m_brokerProcess->terminate();
+	QTimer::singleShot(0, this, [this, exit_code]() { exit(exit_code); });
+}
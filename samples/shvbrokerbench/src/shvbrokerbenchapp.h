@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QCoreApplication>
+
+#include <vector>
+
+class AppCliOptions;
+class SimDevice;
+class SimClient;
+class QProcess;
+
+class ShvBrokerBenchApp : public QCoreApplication
+{
+	Q_OBJECT
+private:
+	using Super = QCoreApplication;
+public:
+	ShvBrokerBenchApp(int &argc, char **argv, AppCliOptions* cli_opts);
+	~ShvBrokerBenchApp() Q_DECL_OVERRIDE;
+
+	AppCliOptions* cliOptions() {return m_cliOptions;}
+private:
+	enum class Phase {StartingBroker, ConnectingDevices, ConnectingClients, Warmup, Measurement, Finished};
+
+	struct ProcStats
+	{
+		int64_t cpuTicks = 0;
+		int64_t rssKb = 0;
+		int64_t peakRssKb = 0;
+	};
+	static bool readProcStats(int64_t pid, ProcStats &stats);
+
+	void startBroker();
+	void waitForBroker();
+	void openDevices();
+	void openClients();
+	void checkConnected();
+	void startLoad();
+	void startMeasurement();
+	void finishMeasurement();
+	void printReport(double elapsed_sec);
+	void abortBenchmark(const std::string &reason);
+	void shutdown(int exit_code);
+private:
+	AppCliOptions* m_cliOptions;
+	Phase m_phase = Phase::StartingBroker;
+	QProcess *m_brokerProcess = nullptr;
+	int64_t m_brokerPid = 0;
+	int m_brokerProbeCount = 0;
+
+	std::vector<SimDevice*> m_devices;
+	std::vector<SimClient*> m_subscribers;
+	std::vector<SimClient*> m_requesters;
+
+	int64_t m_measurementStartUsec = 0;
+	ProcStats m_brokerStatsStart;
+	ProcStats m_selfStatsStart;
+};
@@ -0,0 +1,141 @@
+#include "simclient.h"
+#include "simdevice.h"
+#include "appclioptions.h"
+
+#include <shv/iotqt/rpc/clientconnection.h>
+#include <shv/coreqt/log.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#ifdef WITH_SHV_WEBSOCKETS
+#include "../../../libshvbroker/src/rpc/websocket.h"
+#include <QWebSocket>
+#endif
+
+namespace cp = shv::chainpack;
+namespace si = shv::iotqt;
+
+SimClient::SimClient(Kind kind, int client_index, AppCliOptions *cli_opts, QObject *parent)
+	: QObject(parent)
+	, m_kind(kind)
+	, m_clientIndex(client_index)
+	, m_cliOptions(cli_opts)
+{
+	m_rpcConnection = new si::rpc::ClientConnection(this);
+	m_rpcConnection->setCliOptions(cli_opts);
+	if(cli_opts->clientTransport() == "ws") {
+#ifdef WITH_SHV_WEBSOCKETS
+		// ClientConnection::open() creates TCP socket only if none is set
+		auto *ws = new shv::broker::rpc::WebSocket(new QWebSocket());
+		ws->setMessageBatchingEnabled(true);
+		m_rpcConnection->setSocket(ws);
+		m_rpcConnection->setHost("ws://" + cli_opts->serverHost());
+		m_rpcConnection->setPort(cli_opts->brokerWsPort());
+#else
+		shvWarning() << "Web socket support is not compiled in, falling back to tcp transport.";
+#endif
+	}
+	connect(m_rpcConnection, &si::rpc::ClientConnection::brokerConnectedChanged, this, &SimClient::onBrokerConnectedChanged);
+	connect(m_rpcConnection, &si::rpc::ClientConnection::rpcMessageReceived, this, &SimClient::onRpcMessageReceived);
+}
+
+void SimClient::open()
+{
+	m_rpcConnection->open();
+}
+
+void SimClient::setReady(bool b)
+{
+	if(b == m_isReady)
+		return;
+	m_isReady = b;
+	emit readyChanged(b);
+}
+
+void SimClient::resetCounters()
+{
+	m_latencyStats.clear();
+	m_receivedCount = 0;
+	m_errorCount = 0;
+}
+
+void SimClient::onBrokerConnectedChanged(bool is_connected)
+{
+	if(!is_connected) {
+		m_pendingRequests.clear();
+		setReady(false);
+		return;
+	}
+	if(m_kind == Kind::Subscriber) {
+		m_subscribeRequestId = m_rpcConnection->callMethodSubscribe("test/bench", cp::Rpc::SIG_VAL_CHANGED);
+	}
+	else {
+		setReady(true);
+		if(m_requestsRunning)
+			startRequests();
+	}
+}
+
+void SimClient::startRequests()
+{
+	m_requestsRunning = true;
+	if(m_kind != Kind::Requester || !m_rpcConnection->isBrokerConnected())
+		return;
+	int depth = std::max(1, m_cliOptions->requestDepth());
+	while(static_cast<int>(m_pendingRequests.size()) < depth)
+		sendNextRequest();
+}
+
+void SimClient::stopRequests()
+{
+	m_requestsRunning = false;
+}
+
+void SimClient::sendNextRequest()
+{
+	int dev_cnt = std::max(1, m_cliOptions->devices());
+	int node_cnt = std::max(1, m_cliOptions->nodesPerDevice());
+	// deterministic walk over the whole fleet, requesters start with different offsets
+	uint64_t n = m_requestCounter++ + static_cast<uint64_t>(m_clientIndex) * 7919;
+	int dev_ix = static_cast<int>(n % static_cast<uint64_t>(dev_cnt));
+	int node_ix = static_cast<int>((n / static_cast<uint64_t>(dev_cnt)) % static_cast<uint64_t>(node_cnt));
+	int rq_id = m_rpcConnection->nextRequestId();
+	m_pendingRequests[rq_id] = LatencyStats::nowUsec();
+	m_rpcConnection->callShvMethod(rq_id, SimDevice::mountPoint(dev_ix) + "/node" + std::to_string(node_ix), cp::Rpc::METH_GET);
+}
+
+void SimClient::onRpcMessageReceived(const cp::RpcMessage &msg)
+{
+	if(msg.isSignal()) {
+		cp::RpcSignal sig(msg);
+		const cp::RpcValue::List &params = sig.params().toList();
+		if(!params.empty()) {
+			m_latencyStats.add(LatencyStats::nowUsec() - params[0].toInt64());
+			m_receivedCount++;
+		}
+		return;
+	}
+	if(!msg.isResponse())
+		return;
+	cp::RpcResponse resp(msg);
+	int rq_id = resp.requestId().toInt();
+	if(m_kind == Kind::Subscriber) {
+		if(rq_id == m_subscribeRequestId) {
+			if(resp.isSuccess())
+				setReady(true);
+			else
+				shvError() << "Subscriber:" << m_clientIndex << "subscribe error:" << resp.errorString();
+		}
+		return;
+	}
+	auto it = m_pendingRequests.find(rq_id);
+	if(it == m_pendingRequests.end())
+		return;
+	m_latencyStats.add(LatencyStats::nowUsec() - it->second);
+	m_pendingRequests.erase(it);
+	if(resp.isSuccess())
+		m_receivedCount++;
+	else
+		m_errorCount++;
+	if(m_requestsRunning)
+		startRequests();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "latencystats.h"
+
+#include <QObject>
+
+#include <map>
+
+class AppCliOptions;
+
+namespace shv { namespace chainpack { class RpcMessage; }}
+namespace shv { namespace iotqt { namespace rpc { class ClientConnection; }}}
+
+/// Simulated HMI client
+/// Subscriber subscribes value changes of all the simulated devices and measures signal fan-out latency,
+/// Requester keeps requestDepth get requests in flight and measures request/response round trip time.
+class SimClient : public QObject
+{
+	Q_OBJECT
+public:
+	enum class Kind {Subscriber, Requester};
+
+	SimClient(Kind kind, int client_index, AppCliOptions *cli_opts, QObject *parent = nullptr);
+
+	Kind kind() const {return m_kind;}
+	shv::iotqt::rpc::ClientConnection *rpcConnection() const {return m_rpcConnection;}
+
+	void open();
+	/// client is connected and subscribed
+	bool isReady() const {return m_isReady;}
+	Q_SIGNAL void readyChanged(bool is_ready);
+
+	void startRequests();
+	void stopRequests();
+
+	LatencyStats& latencyStats() {return m_latencyStats;}
+	int64_t receivedCount() const {return m_receivedCount;}
+	int64_t errorCount() const {return m_errorCount;}
+	void resetCounters();
+private:
+	void onBrokerConnectedChanged(bool is_connected);
+	void onRpcMessageReceived(const shv::chainpack::RpcMessage &msg);
+	void setReady(bool b);
+	void sendNextRequest();
+private:
+	Kind m_kind;
+	int m_clientIndex;
+	AppCliOptions *m_cliOptions;
+	shv::iotqt::rpc::ClientConnection *m_rpcConnection = nullptr;
+	bool m_isReady = false;
+	bool m_requestsRunning = false;
+	int m_subscribeRequestId = 0;
+	/// request id -> send time [usec]
+	std::map<int, int64_t> m_pendingRequests;
+	uint64_t m_requestCounter = 0;
+	LatencyStats m_latencyStats;
+	int64_t m_receivedCount = 0;
+	int64_t m_errorCount = 0;
+};
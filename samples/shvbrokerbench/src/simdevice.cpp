@@ -0,0 +1,145 @@
+#include "simdevice.h"
+#include "appclioptions.h"
+#include "latencystats.h"
+
+#include <shv/iotqt/rpc/clientconnection.h>
+#include <shv/coreqt/log.h>
+#include <shv/core/exception.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#include <QTimer>
+
+namespace cp = shv::chainpack;
+namespace si = shv::iotqt;
+
+static const std::string NODE_PREFIX = "node";
+
+SimDevice::SimDevice(int device_index, AppCliOptions *cli_opts, QObject *parent)
+	: QObject(parent)
+	, m_deviceIndex(device_index)
+	, m_cliOptions(cli_opts)
+{
+	int node_cnt = std::max(1, cli_opts->nodesPerDevice());
+	for (int i = 0; i < node_cnt; ++i)
+		m_values.push_back(generateValue(i));
+
+	m_rpcConnection = new si::rpc::ClientConnection(this);
+	m_rpcConnection->setCliOptions(cli_opts);
+	{
+		cp::RpcValue::Map opts = m_rpcConnection->connectionOptions().toMap();
+		cp::RpcValue::Map dev;
+		dev[cp::Rpc::KEY_DEVICE_ID] = "bench-dev-" + std::to_string(device_index);
+		dev[cp::Rpc::KEY_MOUT_POINT] = mountPoint(device_index);
+		opts[cp::Rpc::KEY_DEVICE] = dev;
+		m_rpcConnection->setConnectionOptions(opts);
+	}
+	connect(m_rpcConnection, &si::rpc::ClientConnection::brokerConnectedChanged, this, &SimDevice::brokerConnectedChanged);
+	connect(m_rpcConnection, &si::rpc::ClientConnection::rpcMessageReceived, this, &SimDevice::onRpcMessageReceived);
+
+	m_signalTimer = new QTimer(this);
+	connect(m_signalTimer, &QTimer::timeout, this, &SimDevice::sendNextSignal);
+}
+
+std::string SimDevice::mountPoint(int device_index)
+{
+	return "test/bench/dev" + std::to_string(device_index);
+}
+
+bool SimDevice::isBrokerConnected() const
+{
+	return m_rpcConnection->isBrokerConnected();
+}
+
+void SimDevice::open()
+{
+	m_rpcConnection->open();
+}
+
+void SimDevice::startSignals()
+{
+	int interval = m_cliOptions->signalInterval();
+	if(interval > 0)
+		m_signalTimer->start(interval);
+}
+
+void SimDevice::stopSignals()
+{
+	m_signalTimer->stop();
+}
+
+void SimDevice::resetCounters()
+{
+	m_sentSignalCount = 0;
+	m_handledRequestCount = 0;
+}
+
+cp::RpcValue SimDevice::generateValue(int64_t n) const
+{
+	const std::string &type = m_cliOptions->valueType();
+	if(type == "double")
+		return n * 0.1;
+	if(type == "string")
+		return "value-" + std::to_string(n) + "-lorem-ipsum-dolor-sit-amet";
+	if(type == "map") {
+		return cp::RpcValue::Map {
+			{"value", n},
+			{"status", (n % 10)? "ok": "warning"},
+			{"ts", cp::RpcValue::DateTime::now()},
+		};
+	}
+	return n;
+}
+
+void SimDevice::sendNextSignal()
+{
+	if(!m_rpcConnection->isBrokerConnected())
+		return;
+	size_t ix = m_nextNode++ % m_values.size();
+	cp::RpcValue val = generateValue(++m_changeCounter);
+	m_values[ix] = val;
+	// send time is carried in signal params, all the simulated clients live in this process so steady clock can be used
+	m_rpcConnection->sendShvSignal(NODE_PREFIX + std::to_string(ix), cp::Rpc::SIG_VAL_CHANGED, cp::RpcValue::List{LatencyStats::nowUsec(), val});
+	m_sentSignalCount++;
+}
+
+cp::RpcValue SimDevice::processRequest(const std::string &shv_path, const std::string &method)
+{
+	if(shv_path.empty()) {
+		if(method == cp::Rpc::METH_LS) {
+			cp::RpcValue::List ret;
+			for (size_t i = 0; i < m_values.size(); ++i)
+				ret.push_back(NODE_PREFIX + std::to_string(i));
+			return ret;
+		}
+		if(method == cp::Rpc::METH_DIR)
+			return cp::RpcValue::List{cp::Rpc::METH_DIR, cp::Rpc::METH_LS};
+	}
+	else if(shv_path.compare(0, NODE_PREFIX.size(), NODE_PREFIX) == 0) {
+		size_t ix = std::stoul(shv_path.substr(NODE_PREFIX.size()));
+		if(ix < m_values.size()) {
+			if(method == cp::Rpc::METH_GET)
+				return m_values[ix];
+			if(method == cp::Rpc::METH_LS)
+				return cp::RpcValue::List{};
+			if(method == cp::Rpc::METH_DIR)
+				return cp::RpcValue::List{cp::Rpc::METH_DIR, cp::Rpc::METH_LS, cp::Rpc::METH_GET};
+		}
+	}
+	SHV_EXCEPTION("Invalid method: " + shv_path + ':' + method);
+}
+
+void SimDevice::onRpcMessageReceived(const cp::RpcMessage &msg)
+{
+	if(!msg.isRequest())
+		return;
+	cp::RpcRequest rq(msg);
+	cp::RpcResponse resp = cp::RpcResponse::forRequest(rq);
+	try {
+		resp.setResult(processRequest(rq.shvPath().toString(), rq.method().toString()));
+	}
+	catch (std::exception &e) {
+		resp.setError(cp::RpcResponse::Error::createMethodCallExceptionError(e.what()));
+	}
+	m_rpcConnection->sendMessage(resp);
+	m_handledRequestCount++;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QObject>
+
+class AppCliOptions;
+class QTimer;
+
+namespace shv { namespace chainpack { class RpcMessage; }}
+namespace shv { namespace iotqt { namespace rpc { class ClientConnection; }}}
+
+/// Simulated device mounted on test/bench/devN
+/// device tree consists of value nodes node0 .. nodeN-1 supporting get,
+/// every signal interval the next node changes its value and chng signal is sent
+class SimDevice : public QObject
+{
+	Q_OBJECT
+public:
+	SimDevice(int device_index, AppCliOptions *cli_opts, QObject *parent = nullptr);
+
+	static std::string mountPoint(int device_index);
+
+	shv::iotqt::rpc::ClientConnection *rpcConnection() const {return m_rpcConnection;}
+	bool isBrokerConnected() const;
+
+	void open();
+	void startSignals();
+	void stopSignals();
+
+	int64_t sentSignalCount() const {return m_sentSignalCount;}
+	int64_t handledRequestCount() const {return m_handledRequestCount;}
+	void resetCounters();
+
+	Q_SIGNAL void brokerConnectedChanged(bool is_connected);
+private:
+	void onRpcMessageReceived(const shv::chainpack::RpcMessage &msg);
+	shv::chainpack::RpcValue processRequest(const std::string &shv_path, const std::string &method);
+	shv::chainpack::RpcValue generateValue(int64_t n) const;
+	void sendNextSignal();
+private:
+	int m_deviceIndex;
+	AppCliOptions *m_cliOptions;
+	shv::iotqt::rpc::ClientConnection *m_rpcConnection = nullptr;
+	QTimer *m_signalTimer = nullptr;
+	std::vector<shv::chainpack::RpcValue> m_values;
+	size_t m_nextNode = 0;
+	int64_t m_changeCounter = 0;
+	int64_t m_sentSignalCount = 0;
+	int64_t m_handledRequestCount = 0;
+};
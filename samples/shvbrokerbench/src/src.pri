@@ -0,0 +1,14 @@
+HEADERS += \
+    $$PWD/appclioptions.h \
+    $$PWD/latencystats.h \
+    $$PWD/simdevice.h \
+    $$PWD/simclient.h \
+    $$PWD/shvbrokerbenchapp.h
+
+SOURCES += \
+    $$PWD/main.cpp\
+    $$PWD/appclioptions.cpp \
+    $$PWD/latencystats.cpp \
+    $$PWD/simdevice.cpp \
+    $$PWD/simclient.cpp \
+    $$PWD/shvbrokerbenchapp.cpp
@@ -0,0 +1,79 @@
+#include <shv/broker/appclioptions.h>
+#include <shv/broker/brokerapp.h>
+#include <shv/iotqt/node/shvnodetree.h>
+#include <shv/chainpack/rpc.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#include <QtTest/QtTest>
+
+using namespace shv::broker;
+using namespace shv::chainpack;
+using shv::iotqt::node::ShvNode;
+using shv::iotqt::node::ShvNodeTree;
+using std::string;
+
+namespace {
+
+constexpr int CALLER_ID = 123;
+
+void send_raw_request(ShvNode *nd, const string &method, const string &grant)
+{
+	RpcRequest rq;
+	rq.setRequestId(1).setMethod(method);
+	rq.setShvPath(Rpc::DIR_BROKER_APP);
+	rq.setParams(RpcValue::Map{{Rpc::PAR_PATH, "test/node"}, {Rpc::PAR_METHOD, Rpc::SIG_VAL_CHANGED}});
+	RpcValue::MetaData meta = rq.value().metaData();
+	RpcMessage::setProtocolType(meta, Rpc::ProtocolType::ChainPack);
+	RpcMessage::setAccessGrant(meta, grant);
+	RpcMessage::pushCallerId(meta, CALLER_ID);
+	RpcValue val = rq.value();
+	val.setMetaData(RpcValue::MetaData());
+	nd->handleRawRpcRequest(std::move(meta), val.toChainPack());
+}
+
+}
+
+class TestBrokerAppNode: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testRawSubscriptionGrant()
+	{
+		int argc = 1;
+		char app_name[] = "tst_brokerappnode";
+		char *argv[] = {app_name, nullptr};
+		AppCliOptions cli_opts;
+		BrokerApp app(argc, argv, &cli_opts);
+		ShvNodeTree *tree = app.findChild<ShvNodeTree*>();
+		QVERIFY(tree != nullptr);
+		std::vector<RpcResponse> responses;
+		connect(tree->root(), &ShvNode::sendRpcMessage, [&responses](const RpcMessage &msg) {
+			responses.emplace_back(msg);
+		});
+
+		// granted request reaches subscription handling, there is no connection with CALLER_ID
+		send_raw_request(tree->root(), Rpc::METH_SUBSCRIBE, Rpc::ROLE_READ);
+		QCOMPARE(responses.size(), static_cast<size_t>(1));
+		QVERIFY(responses[0].isError());
+		QCOMPARE(responses[0].error().code(), static_cast<int>(RpcResponse::Error::MethodCallException));
+		QVERIFY(responses[0].error().message().find("invalid connection ID") != string::npos);
+
+		// request with insufficient grant is rejected before subscription handling
+		send_raw_request(tree->root(), Rpc::METH_SUBSCRIBE, Rpc::ROLE_BROWSE);
+		QCOMPARE(responses.size(), static_cast<size_t>(2));
+		QVERIFY(responses[1].isError());
+		QCOMPARE(responses[1].error().code(), static_cast<int>(RpcResponse::Error::MethodCallException));
+		QVERIFY(responses[1].error().message().find("permission denied") != string::npos);
+
+		send_raw_request(tree->root(), Rpc::METH_UNSUBSCRIBE, Rpc::ROLE_BROWSE);
+		QCOMPARE(responses.size(), static_cast<size_t>(3));
+		QVERIFY(responses[2].error().message().find("permission denied") != string::npos);
+
+		send_raw_request(tree->root(), Rpc::METH_REJECT_NOT_SUBSCRIBED, Rpc::ROLE_BROWSE);
+		QCOMPARE(responses.size(), static_cast<size_t>(4));
+		QVERIFY(responses[3].error().message().find("permission denied") != string::npos);
+	}
+};
+
+QTEST_APPLESS_MAIN(TestBrokerAppNode)
+#include "tst_brokerappnode.moc"
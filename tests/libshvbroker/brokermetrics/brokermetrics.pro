@@ -0,0 +1,7 @@
+include ( ../test_libshvbroker.pri )
+
+TARGET = tst_brokermetrics
+
+
+SOURCES += \
+    $${TARGET}.cpp \
@@ -0,0 +1,123 @@
+#include <shv/broker/appclioptions.h>
+#include <shv/broker/brokerapp.h>
+#include <shv/broker/brokermetrics.h>
+#include <shv/iotqt/node/shvnodetree.h>
+#include <shv/chainpack/rpc.h>
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+using namespace shv::broker;
+using namespace shv::chainpack;
+using shv::iotqt::node::ShvNode;
+using shv::iotqt::node::ShvNodeTree;
+using std::string;
+
+class TestBrokerMetrics: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testBucketBoundaries()
+	{
+		for (int i = 0; i < LatencyHistogram::SUB_BUCKET_COUNT; ++i) {
+			QCOMPARE(LatencyHistogram::bucketIndex(i), i);
+			QCOMPARE(LatencyHistogram::bucketLowerBound(i), static_cast<int64_t>(i));
+		}
+		for (int i = 0; i < LatencyHistogram::BUCKET_COUNT - 1; ++i) {
+			int64_t lo = LatencyHistogram::bucketLowerBound(i);
+			int64_t hi = LatencyHistogram::bucketLowerBound(i + 1);
+			QVERIFY(hi > lo);
+			QCOMPARE(LatencyHistogram::bucketIndex(lo), i);
+			QCOMPARE(LatencyHistogram::bucketIndex(hi - 1), i);
+			// log-linear buckets keep relative error below 1 / SUB_BUCKET_COUNT
+			if(i >= LatencyHistogram::SUB_BUCKET_COUNT)
+				QVERIFY((hi - lo) * LatencyHistogram::SUB_BUCKET_COUNT <= lo);
+		}
+		QCOMPARE(LatencyHistogram::bucketIndex(-1), 0);
+		QCOMPARE(LatencyHistogram::bucketIndex(int64_t(1) << LatencyHistogram::MAX_VALUE_BITS), LatencyHistogram::BUCKET_COUNT - 1);
+		QCOMPARE(LatencyHistogram::bucketIndex(std::numeric_limits<int64_t>::max()), LatencyHistogram::BUCKET_COUNT - 1);
+	}
+	void testPercentile()
+	{
+		LatencyHistogram h;
+		QCOMPARE(h.percentile(0.5), static_cast<int64_t>(0));
+		for (int i = 1; i <= 1000; ++i)
+			h.record(i * 1000);
+		QCOMPARE(h.count(), static_cast<uint64_t>(1000));
+		auto near = [](int64_t val, int64_t expected) {
+			return std::abs(val - expected) * LatencyHistogram::SUB_BUCKET_COUNT <= expected;
+		};
+		QVERIFY(near(h.percentile(0.5), 500000));
+		QVERIFY(near(h.percentile(0.9), 900000));
+		QVERIFY(near(h.percentile(0.99), 990000));
+		QCOMPARE(h.percentile(0), static_cast<int64_t>(1000));
+		QCOMPARE(h.percentile(1), static_cast<int64_t>(1000000));
+		QVERIFY(h.percentile(0.999) <= 1000000);
+
+		RpcValue v = h.toRpcValue();
+		QCOMPARE(v.at("count").toUInt64(), static_cast<uint64_t>(1000));
+		QCOMPARE(v.at("min").toInt64(), static_cast<int64_t>(1000));
+		QCOMPARE(v.at("max").toInt64(), static_cast<int64_t>(1000000));
+		QCOMPARE(v.at("mean").toInt64(), static_cast<int64_t>(500500));
+
+		// sparse histogram percentile stays in recorded range
+		LatencyHistogram h2;
+		h2.record(100);
+		QCOMPARE(h2.percentile(0.5), static_cast<int64_t>(100));
+		h2.record(-5);
+		QCOMPARE(h2.percentile(0), static_cast<int64_t>(0));
+	}
+	void testReset()
+	{
+		BrokerMetrics metrics;
+		metrics.record(BrokerMetrics::Stage::Routing, 10);
+		metrics.record(BrokerMetrics::Stage::Routing, 20);
+		QCOMPARE(metrics.histogram(BrokerMetrics::Stage::Routing).count(), static_cast<uint64_t>(2));
+		QCOMPARE(metrics.histogram(BrokerMetrics::Stage::Decode).count(), static_cast<uint64_t>(0));
+		metrics.reset();
+		QCOMPARE(metrics.histogram(BrokerMetrics::Stage::Routing).count(), static_cast<uint64_t>(0));
+		RpcValue v = metrics.latencyToRpcValue().at(BrokerMetrics::stageName(BrokerMetrics::Stage::Routing));
+		QCOMPARE(v.at("count").toUInt64(), static_cast<uint64_t>(0));
+		QVERIFY(!v.asMap().hasKey("max"));
+		metrics.record(BrokerMetrics::Stage::Routing, 5);
+		QCOMPARE(metrics.histogram(BrokerMetrics::Stage::Routing).toRpcValue().at("min").toInt64(), static_cast<int64_t>(5));
+		QCOMPARE(metrics.histogram(BrokerMetrics::Stage::Routing).toRpcValue().at("max").toInt64(), static_cast<int64_t>(5));
+	}
+	void testMetricsNode()
+	{
+		int argc = 1;
+		char app_name[] = "tst_brokermetrics";
+		char *argv[] = {app_name, nullptr};
+		AppCliOptions cli_opts;
+		BrokerApp app(argc, argv, &cli_opts);
+		ShvNodeTree *tree = app.findChild<ShvNodeTree*>();
+		QVERIFY(tree != nullptr);
+		ShvNode *nd = tree->cd(string(Rpc::DIR_BROKER_APP) + "/metrics");
+		QVERIFY(nd != nullptr);
+
+		QCOMPARE(nd->callMethod(ShvNode::StringViewList(), Rpc::METH_LS, RpcValue()).toCpon(), string("[]"));
+		RpcValue::List dir = nd->callMethod(ShvNode::StringViewList(), Rpc::METH_DIR, RpcValue()).asList();
+		QVERIFY(std::find(dir.begin(), dir.end(), RpcValue("latency")) != dir.end());
+		QVERIFY(std::find(dir.begin(), dir.end(), RpcValue("reset")) != dir.end());
+
+		app.metrics().record(BrokerMetrics::Stage::Decode, 1000);
+		RpcValue snapshot = nd->callMethod(ShvNode::StringViewList(), Rpc::METH_GET, RpcValue());
+		QVERIFY(snapshot.at("timestamp").isDateTime());
+		QVERIFY(snapshot.at("connections").isMap());
+		QVERIFY(snapshot.at("connections").asMap().empty());
+		const RpcValue latency = snapshot.at("latency");
+		for (int i = 0; i < static_cast<int>(BrokerMetrics::Stage::Count); ++i)
+			QVERIFY(latency.asMap().hasKey(BrokerMetrics::stageName(static_cast<BrokerMetrics::Stage>(i))));
+		QCOMPARE(latency.at("decode").at("count").toUInt64(), static_cast<uint64_t>(1));
+		QCOMPARE(latency.at("decode").at("max").toInt64(), static_cast<int64_t>(1000));
+
+		QVERIFY(nd->callMethod(ShvNode::StringViewList(), "reset", RpcValue()).toBool());
+		QCOMPARE(nd->callMethod(ShvNode::StringViewList(), "latency", RpcValue()).at("decode").at("count").toUInt64(), static_cast<uint64_t>(0));
+	}
+};
+
+QTEST_APPLESS_MAIN(TestBrokerMetrics)
+#include "tst_brokermetrics.moc"
@@ -0,0 +1,207 @@
+#include <shv/broker/rpc/commonrpcclienthandle.h>
+#include <shv/chainpack/rpcdriver.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#include <chrono>
+#include <thread>
+
+#include <QtTest/QtTest>
+
+using namespace shv::chainpack;
+using shv::broker::rpc::CommonRpcClientHandle;
+using std::string;
+
+namespace {
+
+constexpr size_t QUEUE_LIMIT = 100;
+constexpr int MIN_INTERVAL = 50;
+
+class TestDriver : public RpcDriver
+{
+public:
+	size_t transportBytesToWrite() const override {return backlog;}
+	size_t backlog = 0;
+protected:
+	bool isOpen() override {return false;}
+	void writeMessageBegin() override {}
+	void writeMessageEnd() override {}
+	int64_t writeBytes(const char *bytes, size_t length) override {Q_UNUSED(bytes) return static_cast<int64_t>(length);}
+	void onProcessReadDataException(std::exception &e) override {Q_UNUSED(e)}
+};
+
+class TestHandle : public CommonRpcClientHandle
+{
+public:
+	int connectionId() const override {return 1;}
+	bool isConnectedAndLoggedIn() const override {return true;}
+	Subscription createSubscription(const string &shv_path, const string &method) override {return Subscription(shv_path, shv_path, method);}
+	string toSubscribedPath(const Subscription &subs, const string &abs_path) const override {Q_UNUSED(subs) return abs_path;}
+	string loggedUserName() override {return "test";}
+	bool isSlaveBrokerConnection() const override {return false;}
+	bool isMasterBrokerConnection() const override {return false;}
+	void sendRawData(const RpcValue::MetaData &meta_data, string &&data) override
+	{
+		Q_UNUSED(meta_data)
+		sent.push_back(RpcValue::fromChainPack(data).at(RpcMessage::MetaType::Key::Params).toCpon());
+	}
+	void sendMessage(const RpcMessage &rpc_msg) override {Q_UNUSED(rpc_msg)}
+	RpcDriver* rpcDriver() override {return &driver;}
+
+	const Subscription& subscribe(const string &path, const SignalPolicy &policy)
+	{
+		Subscription subs = createSubscription(path, Rpc::SIG_VAL_CHANGED);
+		subs.policy = policy;
+		return subscriptionAt(addSubscription(subs));
+	}
+	bool signal(const string &path, const RpcValue &val)
+	{
+		int ix = isSubscribed(path, Rpc::SIG_VAL_CHANGED);
+		if(ix < 0)
+			return false;
+		return signal(subscriptionAt(static_cast<size_t>(ix)), path, val);
+	}
+	bool signal(const Subscription &subs, const string &path, const RpcValue &val)
+	{
+		RpcSignal sig;
+		sig.setMethod(Rpc::SIG_VAL_CHANGED);
+		sig.setShvPath(path);
+		sig.setParams(val);
+		RpcValue::MetaData meta = sig.value().metaData();
+		RpcMessage::setProtocolType(meta, Rpc::ProtocolType::ChainPack);
+		RpcValue msg = sig.value();
+		msg.setMetaData(RpcValue::MetaData());
+		return sendSignal(subs, path, meta, msg.toChainPack(), QUEUE_LIMIT);
+	}
+
+	TestDriver driver;
+	std::vector<string> sent;
+};
+
+void wait_min_interval()
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(MIN_INTERVAL + 10));
+}
+
+}
+
+class TestCommonRpcClientHandle: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testMinInterval()
+	{
+		TestHandle h;
+		CommonRpcClientHandle::SignalPolicy policy;
+		policy.minInterval = MIN_INTERVAL;
+		h.subscribe("a", policy);
+
+		QVERIFY(!h.signal("a/x", 1));
+		QVERIFY(h.signal("a/x", 2));
+		QVERIFY(h.signal("a/x", 3));
+		// other path has its own interval
+		QVERIFY(!h.signal("a/y", 10));
+		QCOMPARE(h.sent, std::vector<string>({"1", "10"}));
+		QCOMPARE(h.pendingSignalCount(), static_cast<size_t>(1));
+		QCOMPARE(h.signalCounters().coalesced, static_cast<uint64_t>(1));
+
+		QVERIFY(h.flushPendingSignals(QUEUE_LIMIT));
+		QCOMPARE(h.sent.size(), static_cast<size_t>(2));
+		wait_min_interval();
+		QVERIFY(!h.flushPendingSignals(QUEUE_LIMIT));
+		QCOMPARE(h.sent, std::vector<string>({"1", "10", "3"}));
+		QCOMPARE(h.pendingSignalCount(), static_cast<size_t>(0));
+	}
+	void testCoalesce()
+	{
+		TestHandle h;
+		CommonRpcClientHandle::SignalPolicy policy;
+		policy.coalesce = true;
+		h.subscribe("a", policy);
+
+		QVERIFY(!h.signal("a/x", 1));
+		h.driver.backlog = QUEUE_LIMIT + 1;
+		for (int i = 2; i <= 5; ++i)
+			QVERIFY(h.signal("a/x", i));
+		QVERIFY(h.signal("a/y", 20));
+		QCOMPARE(h.sent, std::vector<string>({"1"}));
+		QCOMPARE(h.pendingSignalCount(), static_cast<size_t>(2));
+		QCOMPARE(h.signalCounters().coalesced, static_cast<uint64_t>(3));
+
+		QVERIFY(h.flushPendingSignals(QUEUE_LIMIT));
+		QCOMPARE(h.sent.size(), static_cast<size_t>(1));
+		h.driver.backlog = 0;
+		QVERIFY(!h.flushPendingSignals(QUEUE_LIMIT));
+		QCOMPARE(h.sent, std::vector<string>({"1", "5", "20"}));
+		QVERIFY(!h.signal("a/x", 6));
+		QCOMPARE(h.sent.back(), string("6"));
+	}
+	void testDeadband()
+	{
+		TestHandle h;
+		CommonRpcClientHandle::SignalPolicy policy;
+		policy.deadband = 0.5;
+		h.subscribe("a", policy);
+
+		for(const RpcValue &v : {RpcValue(1.), RpcValue(1.2), RpcValue(1.6), RpcValue(1.2), RpcValue(3), RpcValue("foo"), RpcValue("foo")})
+			QVERIFY(!h.signal("a/x", v));
+		QCOMPARE(h.sent, std::vector<string>({"1.", "1.6", "3", "\"foo\"", "\"foo\""}));
+		QCOMPARE(h.signalCounters().dropped, static_cast<uint64_t>(2));
+		QCOMPARE(h.pendingSignalCount(), static_cast<size_t>(0));
+	}
+	void testPolicyChange()
+	{
+		TestHandle h;
+		CommonRpcClientHandle::SignalPolicy policy;
+		policy.minInterval = MIN_INTERVAL;
+		h.subscribe("a", policy);
+		QVERIFY(!h.signal("a/x", 1));
+		QVERIFY(h.signal("a/x", 2));
+
+		// resubscribe without policy sends held signal and forgets its state
+		h.subscribe("a", CommonRpcClientHandle::SignalPolicy());
+		QCOMPARE(h.sent, std::vector<string>({"1", "2"}));
+		QCOMPARE(h.pendingSignalCount(), static_cast<size_t>(0));
+		QVERIFY(!h.signal("a/x", 3));
+		wait_min_interval();
+		QVERIFY(!h.flushPendingSignals(QUEUE_LIMIT));
+		QCOMPARE(h.sent, std::vector<string>({"1", "2", "3"}));
+
+		// held signal of other subscription is superseded by signal routed to subscription without policy
+		h.subscribe("b", policy);
+		QVERIFY(!h.signal("b/x", 1));
+		QVERIFY(h.signal("b/x", 2));
+		const CommonRpcClientHandle::Subscription &subs = h.subscribe("b/x", CommonRpcClientHandle::SignalPolicy());
+		QVERIFY(!h.signal(subs, "b/x", 3));
+		QCOMPARE(h.pendingSignalCount(), static_cast<size_t>(0));
+		QCOMPARE(h.signalCounters().coalesced, static_cast<uint64_t>(1));
+		wait_min_interval();
+		QVERIFY(!h.flushPendingSignals(QUEUE_LIMIT));
+		QCOMPARE(h.sent, std::vector<string>({"1", "2", "3", "1", "3"}));
+	}
+	void testMetrics()
+	{
+		TestHandle h;
+		CommonRpcClientHandle::SignalPolicy policy;
+		policy.minInterval = MIN_INTERVAL;
+		policy.deadband = 1;
+		h.subscribe("a", policy);
+		h.signal("a/x", 1);
+		h.signal("a/x", 1.5);
+		h.signal("a/x", 3);
+		h.signal("a/x", 5);
+		RpcValue metrics = h.metricsToRpcValue();
+		QCOMPARE(metrics.at("signalsPending").toUInt(), 1u);
+		QCOMPARE(metrics.at("signalsCoalesced").toUInt(), 1u);
+		QCOMPARE(metrics.at("signalsDropped").toUInt(), 1u);
+		QCOMPARE(metrics.at("subscriptions").toUInt(), 1u);
+
+		// pending state is pruned with subscription
+		QVERIFY(h.removeSubscription(h.createSubscription("a", Rpc::SIG_VAL_CHANGED)));
+		QCOMPARE(h.pendingSignalCount(), static_cast<size_t>(0));
+		QVERIFY(!h.flushPendingSignals(QUEUE_LIMIT));
+		QCOMPARE(h.sent, std::vector<string>({"1"}));
+	}
+};
+
+QTEST_APPLESS_MAIN(TestCommonRpcClientHandle)
+#include "tst_commonrpcclienthandle.moc"
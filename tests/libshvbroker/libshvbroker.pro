@@ -0,0 +1,14 @@
+TEMPLATE = subdirs
+CONFIG += ordered
+
+unix {
+SUBDIRS += \
+	brokerappnode \
+	brokermetrics \
+	commonrpcclienthandle \
+}
+
+with-shvwebsockets {
+SUBDIRS += \
+	websocket \
+}
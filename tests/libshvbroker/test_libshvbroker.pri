@@ -0,0 +1,33 @@
+include ( $$PWD/../test.pri )
+
+QT -= gui
+QT += network sql
+
+INCLUDEPATH += \
+	$$PWD/../../3rdparty/necrolog/include \
+	$$PWD/../../libshvchainpack/include \
+	$$PWD/../../libshvcore/include \
+	$$PWD/../../libshvcoreqt/include \
+	$$PWD/../../libshviotqt/include \
+	$$PWD/../../libshvbroker/include \
+
+win32:LIB_DIR = $$DESTDIR
+else:LIB_DIR = $$SHV_PROJECT_TOP_BUILDDIR/lib
+
+message (INCLUDEPATH $$INCLUDEPATH)
+message (LIB_DIR $$LIB_DIR)
+message (DESTDIR $$DESTDIR)
+
+LIBS += \
+    -L$$LIB_DIR \
+    -lnecrolog \
+    -lshvcoreqt \
+    -lshvchainpack \
+    -lshvcore \
+    -lshviotqt \
+    -lshvbroker \
+
+unix {
+    LIBS += \
+        -Wl,-rpath,\'$${LIB_DIR}\'
+}
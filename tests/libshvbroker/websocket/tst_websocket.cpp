@@ -0,0 +1,132 @@
+#include <shv/broker/rpc/websocket.h>
+
+#include <QWebSocket>
+#include <QWebSocketServer>
+#include <QtTest/QtTest>
+
+#include <memory>
+
+using shv::broker::rpc::WebSocket;
+
+namespace {
+
+/// batching broker side socket connected to plain QWebSocket client
+struct Connection
+{
+	QWebSocketServer server{QStringLiteral("tst_websocket"), QWebSocketServer::NonSecureMode};
+	QWebSocket client;
+	std::unique_ptr<WebSocket> socket;
+	QList<QByteArray> messages;
+
+	bool open()
+	{
+		if(!server.listen(QHostAddress::LocalHost))
+			return false;
+		QObject::connect(&client, &QWebSocket::binaryMessageReceived, [this](const QByteArray &message) {
+			messages << message;
+		});
+		client.open(server.serverUrl());
+		if(!QTest::qWaitFor([this]() { return server.hasPendingConnections(); }))
+			return false;
+		socket.reset(new WebSocket(server.nextPendingConnection()));
+		socket->setMessageBatchingEnabled(true);
+		return QTest::qWaitFor([this]() { return client.state() == QAbstractSocket::ConnectedState; });
+	}
+	void writeFrame(const QByteArray &frame)
+	{
+		socket->writeMessageBegin();
+		socket->write(frame.constData(), frame.size());
+		socket->writeMessageEnd();
+	}
+};
+
+}
+
+class TestWebSocket: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testFramesBatched()
+	{
+		Connection conn;
+		QVERIFY(conn.open());
+
+		// frames written in one event loop iteration are sent in one message after the last one
+		conn.writeFrame("a");
+		conn.writeFrame("bc");
+		conn.writeFrame("d");
+		QCOMPARE(conn.socket->bytesToWrite(), static_cast<qint64>(4));
+		QTRY_COMPARE(conn.messages.count(), 1);
+		QTest::qWait(50);
+		QCOMPARE(conn.messages, QList<QByteArray>({"abcd"}));
+		QTRY_COMPARE(conn.socket->bytesToWrite(), static_cast<qint64>(0));
+
+		// frame written in next iteration goes in its own message
+		conn.writeFrame("e");
+		QTRY_COMPARE(conn.messages.count(), 2);
+		QCOMPARE(conn.messages[1], QByteArray("e"));
+	}
+	void testFrameWrittenOnBytesWritten()
+	{
+		Connection conn;
+		QVERIFY(conn.open());
+
+		// driver writes next frame from its queue on bytesWritten, pending flush must wait for it
+		int frame_cnt = 0;
+		QObject::connect(conn.socket.get(), &WebSocket::bytesWritten, conn.socket.get(), [&conn, &frame_cnt]() {
+			if(frame_cnt < 3)
+				conn.writeFrame(QByteArray::number(++frame_cnt));
+		});
+		conn.writeFrame("0");
+		QTRY_COMPARE(conn.messages.count(), 1);
+		QTest::qWait(50);
+		QCOMPARE(conn.messages, QList<QByteArray>({"0123"}));
+	}
+	void testMaxBatchSize()
+	{
+		Connection conn;
+		QVERIFY(conn.open());
+
+		const int frame_size = WebSocket::MAX_BATCH_SIZE * 5 / 8;
+		conn.writeFrame(QByteArray(frame_size, 'x'));
+		QCOMPARE(conn.socket->bytesToWrite(), static_cast<qint64>(frame_size));
+		// batch over limit is sent at once, bytes passed to QWebSocket are still counted until written
+		conn.writeFrame(QByteArray(frame_size, 'y'));
+		conn.writeFrame(QByteArray(frame_size, 'z'));
+		QCOMPARE(conn.socket->bytesToWrite(), static_cast<qint64>(3 * frame_size));
+		QTRY_COMPARE(conn.messages.count(), 2);
+		QCOMPARE(conn.messages[0], QByteArray(frame_size, 'x') + QByteArray(frame_size, 'y'));
+		QCOMPARE(conn.messages[1], QByteArray(frame_size, 'z'));
+		QTRY_COMPARE(conn.socket->bytesToWrite(), static_cast<qint64>(0));
+	}
+	void testNotBatched()
+	{
+		Connection conn;
+		QVERIFY(conn.open());
+		conn.socket->setMessageBatchingEnabled(false);
+
+		conn.writeFrame("a");
+		conn.writeFrame("b");
+		QTRY_COMPARE(conn.messages.count(), 2);
+		QCOMPARE(conn.messages, QList<QByteArray>({"a", "b"}));
+	}
+	void testReceive()
+	{
+		Connection conn;
+		QVERIFY(conn.open());
+		QSignalSpy ready_read_spy(conn.socket.get(), &WebSocket::readyRead);
+
+		conn.client.sendBinaryMessage("ab");
+		conn.client.sendTextMessage(QStringLiteral("cd"));
+		QTRY_COMPARE(ready_read_spy.count(), 2);
+		QCOMPARE(conn.socket->readAll(), QByteArray("abcd"));
+		QVERIFY(conn.socket->readAll().isEmpty());
+
+		conn.client.sendTextMessage(QStringLiteral("ef"));
+		QTRY_COMPARE(ready_read_spy.count(), 3);
+		QCOMPARE(conn.socket->readAll(), QByteArray("ef"));
+	}
+};
+
+QTEST_MAIN(TestWebSocket)
+#include "tst_websocket.moc"
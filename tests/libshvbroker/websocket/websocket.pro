@@ -0,0 +1,9 @@
+include ( ../test_libshvbroker.pri )
+
+QT += websockets
+
+TARGET = tst_websocket
+
+
+SOURCES += \
+    $${TARGET}.cpp \
@@ -4,5 +4,14 @@ CONFIG += ordered
 SUBDIRS += \
 	rpcvalue \
 	rpcmessage \
+	rpctracer \
+	reflect \
+	rpcvalueview \
+	rpcdriver \
 	tst_ccpcp \
 
+linux {
+SUBDIRS += \
+	epollreactor \
+}
+
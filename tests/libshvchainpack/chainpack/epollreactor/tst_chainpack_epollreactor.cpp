@@ -0,0 +1,174 @@
+#include <shv/chainpack/epollreactor.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <QtTest/QtTest>
+
+using namespace shv::chainpack;
+
+namespace {
+
+constexpr int TIMEOUT_MSEC = 5000;
+
+class EchoServer
+{
+public:
+	EchoServer(EpollReactor &reactor)
+		: m_reactor(reactor)
+	{
+		port = reactor.listen("127.0.0.1", 0, [this](int socket) {
+			auto *driver = new EpollRpcDriver(&m_reactor);
+			driver->setProtocolType(Rpc::ProtocolType::ChainPack);
+			driver->setMessageReceivedCallback([driver](const RpcValue &msg) {
+				RpcRequest rq(msg);
+				RpcResponse resp = RpcResponse::forRequest(rq);
+				resp.setResult(rq.params());
+				driver->sendRpcValue(resp.value());
+			});
+			driver->setSocketDescriptor(socket);
+			m_drivers.emplace_back(driver);
+		});
+	}
+
+	int port;
+private:
+	EpollReactor &m_reactor;
+	std::vector<std::unique_ptr<EpollRpcDriver>> m_drivers;
+};
+
+void run_echo(unsigned decode_thread_count, const std::string &payload, int message_count)
+{
+	EpollReactor reactor(decode_thread_count);
+	EchoServer server(reactor);
+	QVERIFY(server.port > 0);
+
+	EpollRpcDriver client(&reactor);
+	client.setProtocolType(Rpc::ProtocolType::ChainPack);
+	bool connected = false;
+	client.setConnectedCallback([&connected](bool ok) { connected = ok; });
+	int received = 0;
+	bool in_order = true;
+	client.setMessageReceivedCallback([&](const RpcValue &msg) {
+		RpcResponse resp(msg);
+		in_order = in_order && resp.requestId().toInt() == received + 1;
+		in_order = in_order && resp.result().asString() == payload;
+		if(++received == message_count)
+			reactor.quit();
+	});
+	QVERIFY(client.connectToHost("127.0.0.1", server.port));
+	// messages sent before connection is established must be delivered too
+	for (int i = 1; i <= message_count; ++i) {
+		RpcRequest rq;
+		rq.setRequestId(i);
+		rq.setMethod("echo");
+		rq.setParams(payload);
+		client.sendRpcValue(rq.value());
+	}
+	reactor.addTimer(TIMEOUT_MSEC, [&reactor]() { reactor.quit(); }, true);
+	reactor.exec();
+	QVERIFY(connected);
+	QCOMPARE(received, message_count);
+	QVERIFY(in_order);
+}
+
+}
+
+class TestEpollReactor: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testEcho()
+	{
+		run_echo(0, "hello", 200);
+	}
+	void testEchoLargeMessages()
+	{
+		// exceeds socket buffers, so partial writes and read buffer growth are exercised
+		run_echo(0, std::string(256 * 1024, 'x'), 20);
+	}
+	void testEchoDecodePool()
+	{
+		run_echo(3, std::string(1000, 'y'), 200);
+	}
+	void testWriteBufferBounded()
+	{
+		EpollReactor reactor;
+		// peer accepts connection but never reads it
+		std::vector<int> peer_sockets;
+		int port = reactor.listen("127.0.0.1", 0, [&peer_sockets](int socket) { peer_sockets.push_back(socket); });
+		QVERIFY(port > 0);
+
+		constexpr size_t WATERMARK = 64 * 1024;
+		constexpr int MESSAGE_COUNT = 500;
+		const std::string payload(32 * 1024, 'z');
+		EpollRpcDriver client(&reactor);
+		client.setProtocolType(Rpc::ProtocolType::ChainPack);
+		client.setWriteBufferHighWatermark(WATERMARK);
+		QVERIFY(client.connectToHost("127.0.0.1", port));
+		size_t max_pending_bytes = 0;
+		for (int i = 1; i <= MESSAGE_COUNT; ++i) {
+			RpcRequest rq;
+			rq.setRequestId(i);
+			rq.setMethod("echo");
+			rq.setParams(payload);
+			client.sendRpcValue(rq.value());
+			max_pending_bytes = std::max(max_pending_bytes, client.pendingWriteBytes());
+		}
+		reactor.addTimer(5, [&]() { max_pending_bytes = std::max(max_pending_bytes, client.pendingWriteBytes()); });
+		reactor.addTimer(300, [&reactor]() { reactor.quit(); }, true);
+		reactor.exec();
+		QVERIFY(client.isConnected());
+		// message is moved to write buffer only when it is below watermark
+		QVERIFY(max_pending_bytes < WATERMARK + payload.size() + 1024);
+		QVERIFY(client.sendQueueLength() > 0);
+		QVERIFY(client.sendQueueBytes() > WATERMARK);
+		QCOMPARE(client.trafficCounters().messagesSent + client.sendQueueLength(), static_cast<uint64_t>(MESSAGE_COUNT));
+		for(int socket : peer_sockets)
+			::close(socket);
+	}
+	void testTimers()
+	{
+		EpollReactor reactor;
+		int periodic_cnt = 0;
+		int single_shot_cnt = 0;
+		int periodic_id = reactor.addTimer(5, [&periodic_cnt]() { periodic_cnt++; });
+		reactor.addTimer(1, [&single_shot_cnt]() { single_shot_cnt++; }, true);
+		reactor.addTimer(60, [&]() {
+			reactor.removeTimer(periodic_id);
+			reactor.quit();
+		}, true);
+		reactor.exec();
+		QCOMPARE(single_shot_cnt, 1);
+		QVERIFY(periodic_cnt >= 3);
+	}
+	void testConnectionRefused()
+	{
+		EpollReactor reactor;
+		int port = reactor.listen("127.0.0.1", 0, [](int socket) { ::close(socket); });
+		reactor.closeListeners();
+		EpollRpcDriver client(&reactor);
+		bool result_reported = false;
+		bool connected = true;
+		client.setConnectedCallback([&](bool ok) {
+			result_reported = true;
+			connected = ok;
+			reactor.quit();
+		});
+		if(client.connectToHost("127.0.0.1", port)) {
+			reactor.addTimer(TIMEOUT_MSEC, [&reactor]() { reactor.quit(); }, true);
+			reactor.exec();
+			QVERIFY(result_reported);
+		}
+		QVERIFY(!connected || !result_reported);
+		QVERIFY(!client.isConnected());
+	}
+};
+
+QTEST_MAIN(TestEpollReactor)
+#include "tst_chainpack_epollreactor.moc"
@@ -0,0 +1,167 @@
+#include <shv/chainpack/accessgrant.h>
+#include <shv/chainpack/chainpackwriter.h>
+#include <shv/chainpack/datachange.h>
+#include <shv/chainpack/metamethod.h>
+#include <shv/chainpack/reflect.h>
+#include <shv/chainpack/rpc.h>
+
+#include <sstream>
+
+#include <QtTest/QtTest>
+
+using namespace shv::chainpack;
+
+namespace {
+
+std::string pack(const RpcValue &val)
+{
+	std::ostringstream out;
+	{
+		ChainPackWriter wr(out);
+		wr.write(val);
+	}
+	return out.str();
+}
+
+constexpr unsigned ALL_DIR_ATTRIBUTES = MetaMethod::DirAttribute::Signature
+		| MetaMethod::DirAttribute::Flags
+		| MetaMethod::DirAttribute::AccessGrant
+		| MetaMethod::DirAttribute::Description;
+
+std::vector<MetaMethod> dir_methods()
+{
+	std::vector<MetaMethod> ret;
+	ret.push_back({Rpc::METH_DIR, MetaMethod::Signature::RetParam, 0, Rpc::ROLE_BROWSE});
+	ret.push_back({Rpc::METH_LS, MetaMethod::Signature::RetParam, 0, Rpc::ROLE_BROWSE});
+	for (int i = 0; i < 20; ++i) {
+		ret.push_back({"method" + std::to_string(i), MetaMethod::Signature::RetParam, MetaMethod::Flag::IsGetter
+					   , i % 2? Rpc::ROLE_READ: Rpc::ROLE_WRITE, "description of method " + std::to_string(i)});
+	}
+	return ret;
+}
+
+}
+
+class TestReflect: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testMetaMethod()
+	{
+		MetaMethod mm("setValue", MetaMethod::Signature::VoidParam, MetaMethod::Flag::IsSetter, Rpc::ROLE_WRITE, "set value");
+		std::string data = reflect::toChainPack(mm);
+		QCOMPARE(data, pack(mm.attributes(ALL_DIR_ATTRIBUTES)));
+		MetaMethod mm2 = reflect::fromChainPack<MetaMethod>(data);
+		QCOMPARE(mm2.name(), mm.name());
+		QVERIFY(mm2.signature() == mm.signature());
+		QCOMPARE(mm2.flags(), mm.flags());
+		QCOMPARE(mm2.accessGrant(), mm.accessGrant());
+		QCOMPARE(mm2.description(), mm.description());
+
+		MetaMethod mm3 = reflect::fromChainPack<MetaMethod>(pack(mm.attributes(0)));
+		QCOMPARE(mm3.name(), mm.name());
+		QVERIFY(mm3.signature() == MetaMethod::Signature::VoidVoid);
+	}
+	void testMetaMethodList()
+	{
+		std::vector<MetaMethod> methods = dir_methods();
+		RpcValue::List lst;
+		for(const MetaMethod &mm : methods)
+			lst.push_back(mm.attributes(ALL_DIR_ATTRIBUTES));
+		std::string data = reflect::toChainPack(methods);
+		QCOMPARE(data, pack(lst));
+		auto methods2 = reflect::fromChainPack<std::vector<MetaMethod>>(data);
+		QCOMPARE(methods2.size(), methods.size());
+		QCOMPARE(methods2.back().description(), methods.back().description());
+	}
+	void testDataChange()
+	{
+		RpcValue val_with_meta = 42;
+		val_with_meta.setMetaValue(meta::Tag::USER, "foo");
+		std::vector<DataChange> changes = {
+			DataChange(123, RpcValue::DateTime::fromMSecsSinceEpoch(1600000000123)),
+			DataChange(RpcValue::Decimal(1234, -2), RpcValue::DateTime::fromMSecsSinceEpoch(1600000000123), 7),
+			DataChange("bar", 12u),
+			DataChange(val_with_meta, RpcValue::DateTime()),
+			DataChange(RpcValue(), RpcValue::DateTime()),
+		};
+		for(const DataChange &dc : changes) {
+			std::string data = reflect::toChainPack(dc);
+			QCOMPARE(data, pack(dc.toRpcValue()));
+			DataChange dc2 = reflect::fromChainPack<DataChange>(data);
+			QCOMPARE(dc2.toRpcValue().toCpon(), dc.toRpcValue().toCpon());
+		}
+		DataChange dc = reflect::fromChainPack<DataChange>(pack(RpcValue(5)));
+		QCOMPARE(dc.value(), RpcValue(5));
+		QVERIFY(!dc.hasDateTime());
+	}
+	void testAccessGrant()
+	{
+		AccessGrant login;
+		login.type = AccessGrant::Type::UserLogin;
+		login.login.user = "user";
+		login.login.password = "secret";
+		login.login.loginType = UserLogin::LoginType::Sha1;
+		AccessGrant level;
+		level.type = AccessGrant::Type::AccessLevel;
+		level.accessLevel = MetaMethod::AccessLevel::Write;
+		std::vector<AccessGrant> grants = {AccessGrant(), AccessGrant(Rpc::ROLE_READ), level, login};
+		for(const AccessGrant &ag : grants) {
+			std::string data = reflect::toChainPack(ag);
+			QCOMPARE(data, pack(ag.toRpcValue()));
+			AccessGrant ag2 = reflect::fromChainPack<AccessGrant>(data);
+			QVERIFY(ag2.type == ag.type);
+			QCOMPARE(ag2.toRpcValue().toCpon(), ag.toRpcValue().toCpon());
+		}
+		AccessGrant ag = reflect::fromChainPack<AccessGrant>(pack(login.toRpcValueMap()));
+		QVERIFY(ag.isUserLogin());
+		QCOMPARE(ag.login.user, login.login.user);
+	}
+	void benchmarkDirRpcValue()
+	{
+		std::vector<MetaMethod> methods = dir_methods();
+		size_t n = 0;
+		QBENCHMARK {
+			for (int i = 0; i < 1000; ++i) {
+				RpcValue::List lst;
+				for(const MetaMethod &mm : methods)
+					lst.push_back(mm.attributes(ALL_DIR_ATTRIBUTES));
+				n += pack(lst).size();
+			}
+		}
+		QVERIFY(n > 0);
+	}
+	void benchmarkDirReflect()
+	{
+		std::vector<MetaMethod> methods = dir_methods();
+		size_t n = 0;
+		QBENCHMARK {
+			for (int i = 0; i < 1000; ++i)
+				n += reflect::toChainPack(methods).size();
+		}
+		QVERIFY(n > 0);
+	}
+	void benchmarkDataChangeRpcValue()
+	{
+		DataChange dc(RpcValue::Decimal(1234, -2), RpcValue::DateTime::fromMSecsSinceEpoch(1600000000123), 7);
+		size_t n = 0;
+		QBENCHMARK {
+			for (int i = 0; i < 10000; ++i)
+				n += pack(dc.toRpcValue()).size();
+		}
+		QVERIFY(n > 0);
+	}
+	void benchmarkDataChangeReflect()
+	{
+		DataChange dc(RpcValue::Decimal(1234, -2), RpcValue::DateTime::fromMSecsSinceEpoch(1600000000123), 7);
+		size_t n = 0;
+		QBENCHMARK {
+			for (int i = 0; i < 10000; ++i)
+				n += reflect::toChainPack(dc).size();
+		}
+		QVERIFY(n > 0);
+	}
+};
+
+QTEST_MAIN(TestReflect)
+#include "tst_chainpack_reflect.moc"
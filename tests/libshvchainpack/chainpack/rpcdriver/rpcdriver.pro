@@ -0,0 +1,6 @@
+include ( ../../test_libshvchainpack.pri )
+
+TARGET = tst_chainpack_rpcdriver
+
+SOURCES += \
+    $${TARGET}.cpp \
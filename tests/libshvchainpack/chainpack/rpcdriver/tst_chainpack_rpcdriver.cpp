@@ -0,0 +1,121 @@
+#include <shv/chainpack/rpcdriver.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#include <QtTest/QtTest>
+
+using namespace shv::chainpack;
+
+namespace {
+
+RpcValue sample_params()
+{
+	RpcValue::List rows;
+	for (int i = 0; i < 100; ++i) {
+		RpcValue::Map row;
+		row["path"] = "node/" + std::to_string(i);
+		row["value"] = i * 1.5;
+		row["count"] = static_cast<unsigned>(i);
+		row["ts"] = RpcValue::DateTime::fromMSecsSinceEpoch(1600000000000 + i, 60);
+		row["dec"] = RpcValue::Decimal(1234 + i, -2);
+		row["flags"] = RpcValue::List{true, nullptr, "x\n\"y\"", RpcValue::IMap{{1, -i}}};
+		rows.push_back(row);
+	}
+	RpcValue params = RpcValue::Map{{"rows", rows}, {"long", std::string(3000, 'a')}};
+	params.setMetaValue("unit", "m");
+	return params;
+}
+
+RpcValue::MetaData meta_of(const RpcValue &msg)
+{
+	RpcValue::MetaData md = msg.metaData();
+	RpcMessage::setProtocolType(md, Rpc::ProtocolType::ChainPack);
+	return md;
+}
+
+std::string data_of(const RpcValue &msg)
+{
+	RpcValue val = msg;
+	val.setMetaData(RpcValue::MetaData());
+	return val.toChainPack();
+}
+
+std::string json_by_rpc_value(const RpcValue::MetaData &md, const std::string &data)
+{
+	RpcValue val = RpcDriver::decodeData(Rpc::ProtocolType::ChainPack, data, 0);
+	val.setMetaData(RpcValue::MetaData(md));
+	return RpcDriver::codeRpcValue(Rpc::ProtocolType::JsonRpc, val);
+}
+
+}
+
+class TestRpcDriver: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testTranscode()
+	{
+		RpcValue params = sample_params();
+		std::string chainpack = params.toChainPack();
+		std::string cpon;
+		QVERIFY(RpcDriver::transcodeData(Rpc::ProtocolType::ChainPack, chainpack.data(), chainpack.size(), Rpc::ProtocolType::Cpon, cpon));
+		QCOMPARE(cpon, params.toCpon());
+
+		std::string chainpack2;
+		QVERIFY(RpcDriver::transcodeData(Rpc::ProtocolType::Cpon, cpon.data(), cpon.size(), Rpc::ProtocolType::ChainPack, chainpack2));
+		QVERIFY(RpcValue::fromChainPack(chainpack2) == RpcValue::fromCpon(cpon));
+
+		std::string bad = chainpack.substr(0, chainpack.size() / 2);
+		std::string out;
+		QVERIFY(!RpcDriver::transcodeData(Rpc::ProtocolType::ChainPack, bad.data(), bad.size(), Rpc::ProtocolType::Cpon, out));
+	}
+	void testJsonRpcEnvelope()
+	{
+		RpcRequest rq;
+		rq.setRequestId(123).setMethod("set").setParams(sample_params());
+		rq.setShvPath("test/node");
+		rq.setCallerIds(RpcValue::List{1, 2});
+		RpcRequest sig;
+		sig.setMethod(Rpc::SIG_VAL_CHANGED).setParams(42);
+		sig.setShvPath("test/node");
+		RpcRequest no_params;
+		no_params.setRequestId(5).setMethod("get");
+		RpcResponse resp;
+		resp.setRequestId(123).setResult(sample_params());
+		for(const RpcValue &msg : {rq.value(), sig.value(), no_params.value(), resp.value()}) {
+			RpcValue::MetaData md = meta_of(msg);
+			std::string data = data_of(msg);
+			std::string json;
+			QVERIFY(RpcDriver::codeJsonRpcEnvelope(md, data, json));
+			QCOMPARE(json, json_by_rpc_value(md, data));
+		}
+
+		RpcResponse err;
+		err.setRequestId(7).setError(RpcResponse::Error::create(RpcResponse::Error::MethodNotFound, "not found"));
+		std::string json;
+		QVERIFY(!RpcDriver::codeJsonRpcEnvelope(meta_of(err.value()), data_of(err.value()), json));
+	}
+	void benchmarkJsonRpcByRpcValue()
+	{
+		RpcResponse resp;
+		resp.setRequestId(123).setResult(sample_params());
+		RpcValue::MetaData md = meta_of(resp.value());
+		std::string data = data_of(resp.value());
+		QBENCHMARK {
+			json_by_rpc_value(md, data);
+		}
+	}
+	void benchmarkJsonRpcEnvelope()
+	{
+		RpcResponse resp;
+		resp.setRequestId(123).setResult(sample_params());
+		RpcValue::MetaData md = meta_of(resp.value());
+		std::string data = data_of(resp.value());
+		QBENCHMARK {
+			std::string json;
+			RpcDriver::codeJsonRpcEnvelope(md, data, json);
+		}
+	}
+};
+
+QTEST_MAIN(TestRpcDriver)
+#include "tst_chainpack_rpcdriver.moc"
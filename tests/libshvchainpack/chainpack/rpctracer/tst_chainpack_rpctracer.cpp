@@ -0,0 +1,100 @@
+#include <shv/chainpack/rpctracer.h>
+
+#include <string>
+#include <thread>
+
+#include <QtTest/QtTest>
+
+using namespace shv::chainpack;
+
+namespace {
+
+size_t count_of(const std::string &s, const std::string &what)
+{
+	size_t n = 0;
+	for(size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + what.size()))
+		n++;
+	return n;
+}
+
+}
+
+class TestRpcTracer: public QObject
+{
+	Q_OBJECT
+private:
+	void reset(unsigned sample_rate)
+	{
+		RpcTracer::setEnabled(true);
+		RpcTracer::setSampleRate(sample_rate);
+		RpcTracer::clear();
+	}
+private slots:
+	void testDisabled()
+	{
+		reset(1);
+		RpcTracer::setEnabled(false);
+		{
+			RpcTracer::Span span("test.span", 1, 1);
+		}
+		RpcTracer::instant("test.instant", 1, 1);
+		QVERIFY(RpcTracer::toChromeTraceJson().find("test.") == std::string::npos);
+	}
+	void testSpans()
+	{
+		reset(1);
+		{
+			RpcTracer::Span span("test.span", 0, 0);
+			span.setIds(3, 42);
+		}
+		RpcTracer::asyncBegin("test.async", 3, 42);
+		RpcTracer::asyncEnd("test.async", 3, 42);
+		std::string json = RpcTracer::toChromeTraceJson();
+		QVERIFY(json.find("\"traceEvents\"") != std::string::npos);
+		QVERIFY(json.find("\"name\":\"test.span\",\"cat\":\"rpc\",\"ph\":\"X\"") != std::string::npos);
+		QVERIFY(json.find("\"connectionId\":3,\"requestId\":42") != std::string::npos);
+		QCOMPARE(count_of(json, "\"id\":\"3:42\""), size_t(2));
+		RpcTracer::clear();
+		QCOMPARE(count_of(RpcTracer::toChromeTraceJson(), "\"name\""), size_t(0));
+	}
+	void testSampling()
+	{
+		reset(4);
+		for(int64_t rq_id = 1; rq_id <= 100; ++rq_id)
+			RpcTracer::instant("test.sampled", 1, rq_id);
+		QCOMPARE(count_of(RpcTracer::toChromeTraceJson(), "test.sampled"), size_t(25));
+		reset(1);
+	}
+	void testThreads()
+	{
+		reset(1);
+		std::thread t([]() {
+			for(int i = 0; i < 10; ++i)
+				RpcTracer::instant("test.thread", 2, i + 1);
+		});
+		t.join();
+		RpcTracer::instant("test.thread", 1, 1);
+		// buffer of finished thread is still dumped
+		QCOMPARE(count_of(RpcTracer::toChromeTraceJson(), "test.thread"), size_t(11));
+	}
+	void testRingBufferWrap()
+	{
+		reset(1);
+		RpcTracer::setBufferCapacity(8);
+		std::thread t([]() {
+			for(int i = 0; i < 20; ++i)
+				RpcTracer::instant("test.wrap", 1, i + 1);
+		});
+		t.join();
+		RpcTracer::setBufferCapacity(RpcTracer::DEFAULT_BUFFER_CAPACITY);
+		std::string json = RpcTracer::toChromeTraceJson();
+		QCOMPARE(count_of(json, "test.wrap"), size_t(8));
+		// oldest events are overwritten
+		QVERIFY(json.find("\"requestId\":12}") == std::string::npos);
+		QVERIFY(json.find("\"requestId\":13}") != std::string::npos);
+		QVERIFY(json.find("\"requestId\":20}") != std::string::npos);
+	}
+};
+
+QTEST_MAIN(TestRpcTracer)
+#include "tst_chainpack_rpctracer.moc"
@@ -0,0 +1,157 @@
+#include <shv/chainpack/rpcvalueview.h>
+#include <shv/chainpack/chainpackreader.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#include "../../../../libshvchainpack/c/cchainpack.h"
+
+#include <QtTest/QtTest>
+
+using namespace shv::chainpack;
+
+namespace {
+
+RpcValue big_request()
+{
+	RpcValue::List rows;
+	for (int i = 0; i < 1000; ++i) {
+		RpcValue::Map row;
+		row["path"] = "node/" + std::to_string(i);
+		row["value"] = i * 1.5;
+		row["flags"] = RpcValue::List{i, "x", RpcValue::Map{{"a", i}}};
+		rows.push_back(row);
+	}
+	RpcRequest rq;
+	rq.setRequestId(123);
+	rq.setMethod("set");
+	rq.setShvPath("test/node");
+	rq.setParams(RpcValue::Map{{"rows", rows}, {"path", "a/b/c"}, {"method", "chng"}});
+	return rq.value();
+}
+
+}
+
+class TestRpcValueView: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testScalars()
+	{
+		std::string data = RpcValue(42).toChainPack();
+		QCOMPARE(RpcValueView(data).toInt(), 42);
+		data = RpcValue(-1234567).toChainPack();
+		QCOMPARE(RpcValueView(data).toInt(), -1234567);
+		data = RpcValue(7u).toChainPack();
+		QCOMPARE(RpcValueView(data).toUInt(), 7u);
+		data = RpcValue(1.25).toChainPack();
+		QCOMPARE(RpcValueView(data).toDouble(), 1.25);
+		data = RpcValue(true).toChainPack();
+		QCOMPARE(RpcValueView(data).toBool(), true);
+		data = RpcValue("hello").toChainPack();
+		QCOMPARE(RpcValueView(data).toString(), std::string("hello"));
+		data = RpcValue(nullptr).toChainPack();
+		QVERIFY(RpcValueView(data).isNull());
+		auto dt = RpcValue::DateTime::fromMSecsSinceEpoch(1600000000123, 60);
+		data = RpcValue(dt).toChainPack();
+		QVERIFY(RpcValueView(data).toDateTime() == dt);
+		QVERIFY(!RpcValueView().isValid());
+		QVERIFY(!RpcValueView(nullptr, 0).isValid());
+	}
+	void testCString()
+	{
+		std::string data;
+		data += static_cast<char>(CP_CString);
+		data += std::string(300, 'x');
+		data += '\0';
+		RpcValueView v(data);
+		QVERIFY(v.isString());
+		QCOMPARE(v.toString(), std::string(300, 'x'));
+	}
+	void testContainers()
+	{
+		RpcValue::Map map{{"one", 1}, {"two", RpcValue::List{1, "a", RpcValue::IMap{{3, "c"}}}}, {"three", "3"}};
+		std::string data = RpcValue(map).toChainPack();
+		for(bool with_index : {false, true}) {
+			RpcValueView v(data, with_index);
+			QVERIFY(v.isMap());
+			QCOMPARE(v.count(), static_cast<size_t>(3));
+			QCOMPARE(v.at("one").toInt(), 1);
+			QCOMPARE(v.at("three").toString(), std::string("3"));
+			QVERIFY(!v.has("four"));
+			QVERIFY(!v.has("on"));
+			RpcValueView two = v.at("two");
+			QVERIFY(two.isList());
+			QCOMPARE(two.size(), map.value("two").toChainPack().size());
+			QCOMPARE(two.count(), static_cast<size_t>(3));
+			QCOMPARE(two.at(1).toString(), std::string("a"));
+			QVERIFY(!two.at(3).isValid());
+			QVERIFY(two.at(2).isIMap());
+			QCOMPARE(two.at(2).at(3).toString(), std::string("c"));
+			QVERIFY(!two.at(2).has(4));
+			QVERIFY(v.toRpcValue() == RpcValue(map));
+			QVERIFY(two.toRpcValue() == map.value("two"));
+		}
+	}
+	void testIteration()
+	{
+		RpcValue::Map map{{"a", 1}, {"b", RpcValue::List{2, 3}}, {"c", 4}};
+		std::string data = RpcValue(map).toChainPack();
+		RpcValueView v(data);
+		RpcValue::Map map2;
+		for(auto it = v.begin(); it != v.end(); ++it)
+			map2[it.key().toString()] = it.value().toRpcValue();
+		QVERIFY(map2 == map);
+
+		std::string ldata = RpcValue(RpcValue::List{1, 2, 3}).toChainPack();
+		int sum = 0;
+		for(const RpcValueView &item : RpcValueView(ldata))
+			sum += item.toInt();
+		QCOMPARE(sum, 6);
+
+		std::string edata = RpcValue(RpcValue::List{}).toChainPack();
+		RpcValueView ev(edata);
+		QVERIFY(ev.begin() == ev.end());
+	}
+	void testMetaData()
+	{
+		RpcValue rq = big_request();
+		std::string data = rq.toChainPack();
+		RpcValueView v(data);
+		QVERIFY(v.hasMetaData());
+		QVERIFY(v.isIMap());
+		QVERIFY(v.metaData() == rq.metaData());
+		QCOMPARE(v.metaValue(RpcMessage::MetaType::Tag::Method).toString(), std::string("set"));
+		QCOMPARE(v.metaValue(RpcMessage::MetaType::Tag::RequestId).toInt(), 123);
+		QVERIFY(!v.metaValue("foo").isValid());
+		RpcValueView params = v.at(RpcMessage::MetaType::Key::Params);
+		QCOMPARE(params.at("path").toString(), std::string("a/b/c"));
+		QCOMPARE(params.at("rows").at(999).at("path").toString(), std::string("node/999"));
+	}
+	void testMalformed()
+	{
+		std::string data = RpcValue(RpcValue::Map{{"a", "some string"}, {"b", 2}}).toChainPack();
+		data.resize(data.size() - 5);
+		RpcValueView v(data);
+		QVERIFY(v.isMap());
+		QCOMPARE(v.at("a").toString(), std::string("some string"));
+		QVERIFY_EXCEPTION_THROWN(v.at("b"), ChainPackReader::ParseException);
+	}
+	void benchmarkFullDecode()
+	{
+		std::string data = big_request().toChainPack();
+		QBENCHMARK {
+			RpcValue rq = RpcValue::fromChainPack(data);
+			QCOMPARE(rq.at(RpcMessage::MetaType::Key::Params).at("path").toString(), std::string("a/b/c"));
+		}
+	}
+	void benchmarkView()
+	{
+		std::string data = big_request().toChainPack();
+		QBENCHMARK {
+			RpcValueView rq(data);
+			QCOMPARE(rq.at(RpcMessage::MetaType::Key::Params).at("path").toString(), std::string("a/b/c"));
+		}
+	}
+};
+
+QTEST_MAIN(TestRpcValueView)
+#include "tst_chainpack_rpcvalueview.moc"
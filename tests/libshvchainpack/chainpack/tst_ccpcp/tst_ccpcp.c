@@ -569,12 +569,145 @@ void test_cpons()
 	}
 }
 
+// straightforward UInt encoder following the format description in cchainpack.c
+static int ref_pack_uint_data(uint8_t *buff, uint64_t num)
+{
+	int bitlen = 0;
+	for (uint64_t n = num; n; n >>= 1)
+		bitlen++;
+	int byte_cnt = (bitlen <= 28)? (bitlen == 0? 1: (bitlen - 1) / 7 + 1): (bitlen - 1) / 8 + 2;
+	for (int i = byte_cnt - 1; i >= 0; --i) {
+		buff[i] = num & 0xff;
+		num >>= 8;
+	}
+	if(byte_cnt <= 4)
+		buff[0] |= (uint8_t)(0xff00 >> (byte_cnt - 1));
+	else
+		buff[0] = 0xf0 | (byte_cnt - 5);
+	return byte_cnt;
+}
+
+static void test_uint_data_value(uint64_t n)
+{
+	uint8_t ref[32];
+	int ref_len = ref_pack_uint_data(ref, n);
+	// exact length buffer forces byte by byte path, large one enables fast path
+	for (int exact = 0; exact < 2; ++exact) {
+		char buff[32];
+		size_t buff_len = exact? (size_t)ref_len: sizeof(buff);
+		ccpcp_pack_context pctx;
+		ccpcp_pack_context_init(&pctx, buff, buff_len, NULL);
+		cchainpack_pack_uint_data(&pctx, n);
+		if(pctx.err_no != CCPCP_RC_OK || pctx.current - pctx.start != ref_len || memcmp(buff, ref, ref_len)) {
+			printf("FAIL! pack uint data %llu exact buffer: %d\n", (unsigned long long)n, exact);
+			assert(false);
+		}
+		ccpcp_unpack_context uctx;
+		ccpcp_unpack_context_init(&uctx, buff, exact? (size_t)ref_len: sizeof(buff), NULL, NULL);
+		bool ok;
+		uint64_t n2 = cchainpack_unpack_uint_data(&uctx, &ok);
+		if(!ok || n2 != n || uctx.current - uctx.start != ref_len) {
+			printf("FAIL! unpack uint data %llu have: %llu exact buffer: %d\n", (unsigned long long)n, (unsigned long long)n2, exact);
+			assert(false);
+		}
+	}
+}
+
+static void test_int_value(int64_t n)
+{
+	char buff[32];
+	ccpcp_pack_context pctx;
+	ccpcp_pack_context_init(&pctx, buff, sizeof(buff), NULL);
+	cchainpack_pack_int(&pctx, n);
+	size_t len = pctx.current - pctx.start;
+	for (int exact = 0; exact < 2; ++exact) {
+		ccpcp_unpack_context uctx;
+		ccpcp_unpack_context_init(&uctx, buff, exact? len: sizeof(buff), NULL, NULL);
+		cchainpack_unpack_next(&uctx);
+		if(uctx.err_no != CCPCP_RC_OK || uctx.item.type != CCPCP_ITEM_INT || uctx.item.as.Int != n) {
+			printf("FAIL! unpack int %lld exact buffer: %d\n", (long long)n, exact);
+			assert(false);
+		}
+	}
+}
+
+static void test_uint_data()
+{
+	printf("------------- uint data \n");
+	for (int bits = 0; bits <= 64; ++bits) {
+		uint64_t n = bits == 64? UINT64_MAX: ((uint64_t)1 << bits) - 1;
+		test_uint_data_value(n);
+		test_uint_data_value(n + 1);
+		test_uint_data_value(n / 3);
+		test_int_value((int64_t)(n >> 1));
+		test_int_value(-(int64_t)(n >> 1));
+	}
+	// truncated input must not be read behind buffer end
+	char buff[32];
+	ccpcp_pack_context pctx;
+	ccpcp_pack_context_init(&pctx, buff, sizeof(buff), NULL);
+	cchainpack_pack_uint_data(&pctx, UINT64_MAX);
+	ccpcp_unpack_context uctx;
+	ccpcp_unpack_context_init(&uctx, buff, pctx.current - pctx.start - 1, NULL, NULL);
+	bool ok;
+	cchainpack_unpack_uint_data(&uctx, &ok);
+	assert(!ok);
+}
+
+static double elapsed_nsec(const struct timespec *t1, const struct timespec *t2)
+{
+	return (t2->tv_sec - t1->tv_sec) * 1e9 + (t2->tv_nsec - t1->tv_nsec);
+}
+
+// build with -DCCHAINPACK_NO_VARINT_FAST_PATH to compare with byte by byte path
+static void bench_uint_data()
+{
+	enum { COUNT = 1000000, ROUNDS = 20 };
+	static uint64_t vals[COUNT];
+	static char buff[COUNT * 10];
+	// mix of small numbers (keys, lengths) and long ones (time stamps)
+	uint64_t seed = 12345;
+	for (int i = 0; i < COUNT; ++i) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		int bits = (seed >> 58) % 4 == 0? 42: (int)((seed >> 60) + 1);
+		vals[i] = (seed >> 11) & (((uint64_t)1 << bits) - 1);
+	}
+	struct timespec t1, t2;
+	ccpcp_pack_context pctx;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (int r = 0; r < ROUNDS; ++r) {
+		ccpcp_pack_context_init(&pctx, buff, sizeof(buff), NULL);
+		for (int i = 0; i < COUNT; ++i)
+			cchainpack_pack_uint_data(&pctx, vals[i]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	double pack_ns = elapsed_nsec(&t1, &t2) / COUNT / ROUNDS;
+	size_t packed_len = pctx.current - pctx.start;
+
+	uint64_t sum = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (int r = 0; r < ROUNDS; ++r) {
+		ccpcp_unpack_context uctx;
+		ccpcp_unpack_context_init(&uctx, buff, packed_len, NULL, NULL);
+		for (int i = 0; i < COUNT; ++i)
+			sum += cchainpack_unpack_uint_data(&uctx, NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	double unpack_ns = elapsed_nsec(&t1, &t2) / COUNT / ROUNDS;
+	printf("uint data benchmark, avg %.2f bytes per number, pack: %.2f ns, unpack: %.2f ns (checksum %llu)\n"
+		   , (double)packed_len / COUNT, pack_ns, unpack_ns, (unsigned long long)sum);
+}
+
 int main(int argc, const char * argv[])
 {
+	bool o_bench = false;
 	for (int i = 0; i < argc; ++i) {
 		if(!strcmp(argv[i], "-v")) {
 			o_silent = false;
 		}
+		else if(!strcmp(argv[i], "-b")) {
+			o_bench = true;
+		}
 	}
 
 	for (int i = CP_Null; i <= CP_CString; ++i) {
@@ -591,6 +724,7 @@ int main(int argc, const char * argv[])
 	printf("\nC Cpon test started.\n");
 
 	test_vals();
+	test_uint_data();
 
 	test_pack_int(1, "1");
 	test_pack_int(-1234567890l, "-1234567890");
@@ -673,4 +807,7 @@ int main(int argc, const char * argv[])
 
 	printf("\nPASSED\n");
 
+	if(o_bench)
+		bench_uint_data();
+
 }
@@ -6,3 +6,6 @@ SUBDIRS += \
 	stringview \
 	shvlogfilereader \
 	shvmemoryjournal \
+	shvjournal3 \
+	shvlogmergereader \
+	reflect \
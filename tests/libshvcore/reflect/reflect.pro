@@ -0,0 +1,6 @@
+include ( ../test_libshvcore.pri )
+
+TARGET = tst_reflect
+
+SOURCES += \
+    $${TARGET}.cpp \
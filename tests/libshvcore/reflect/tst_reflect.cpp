@@ -0,0 +1,181 @@
+#include <shv/core/utils/shvjournalentry.h>
+#include <shv/core/utils/shvlogheader.h>
+
+#include <shv/chainpack/chainpackwriter.h>
+#include <shv/chainpack/reflect.h>
+#include <shv/chainpack/rpc.h>
+
+#include <sstream>
+
+#include <QtTest/QtTest>
+
+using namespace std;
+using namespace shv::core::utils;
+using namespace shv::chainpack;
+
+namespace {
+
+template<typename T>
+std::string pack(const T &val)
+{
+	std::ostringstream out;
+	{
+		ChainPackWriter wr(out);
+		wr.write(val);
+	}
+	return out.str();
+}
+
+std::vector<ShvJournalEntry> test_entries()
+{
+	std::vector<ShvJournalEntry> ret;
+	ret.push_back(ShvJournalEntry("zone1/signal/value", 123));
+	ret.back().epochMsec = 1600000000123;
+	ret.push_back(ShvJournalEntry("zone2/signal/status", RpcValue::List{1, "R"}, 42));
+	ret.back().epochMsec = 1600000000456;
+	ret.push_back(ShvJournalEntry("zone3/door", true, ShvJournalEntry::DOMAIN_SHV_COMMAND, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Discrete, 1600000001000));
+	ret.back().userId = "operator";
+	ret.push_back(ShvJournalEntry("zone4/temperature", RpcValue::Decimal(2150, -2), std::string(), ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, 1600000002000));
+	ret.push_back(ShvJournalEntry());
+	return ret;
+}
+
+RpcValue::List get_log_row(const ShvGetLogRow &row)
+{
+	// the same as in ShvFileJournal::getLog()
+	const ShvJournalEntry &e = row.entry;
+	RpcValue::List rec;
+	rec.push_back(e.dateTime());
+	rec.push_back(row.pathId > 0? RpcValue(row.pathId): RpcValue(e.path));
+	rec.push_back(e.value);
+	rec.push_back(e.shortTime == ShvJournalEntry::NO_SHORT_TIME? RpcValue(nullptr): RpcValue(e.shortTime));
+	rec.push_back((e.domain.empty() || e.domain == Rpc::SIG_VAL_CHANGED)? RpcValue(nullptr): e.domain);
+	rec.push_back((int)e.sampleType);
+	rec.push_back(e.userId.empty()? RpcValue(nullptr): RpcValue(e.userId));
+	return rec;
+}
+
+std::vector<ShvGetLogRow> test_rows(size_t count)
+{
+	std::vector<ShvJournalEntry> entries = test_entries();
+	std::vector<ShvGetLogRow> ret;
+	for (size_t i = 0; i < count; ++i) {
+		ShvGetLogRow row;
+		row.entry = entries[i % (entries.size() - 1)];
+		row.entry.epochMsec += static_cast<int64_t>(i);
+		row.pathId = static_cast<int>(i % 3);
+		ret.push_back(row);
+	}
+	return ret;
+}
+
+}
+
+class TestReflect: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testJournalEntry()
+	{
+		for(const ShvJournalEntry &e : test_entries()) {
+			std::string data = reflect::toChainPack(e);
+			QCOMPARE(data, pack(e.toRpcValueMap()));
+			QVERIFY(reflect::fromChainPack<ShvJournalEntry>(data) == e);
+		}
+	}
+	void testGetLogRow()
+	{
+		for(const ShvGetLogRow &row : test_rows(8)) {
+			std::string data = reflect::toChainPack(row);
+			QCOMPARE(data, pack(RpcValue(get_log_row(row))));
+			ShvGetLogRow row2 = reflect::fromChainPack<ShvGetLogRow>(data);
+			QCOMPARE(row2.pathId, row.pathId);
+			if(row.pathId == 0)
+				QCOMPARE(row2.entry.path, row.entry.path);
+			row2.entry.path = row.entry.path;
+			QVERIFY(row2.entry == row.entry);
+		}
+	}
+	void testLogHeader()
+	{
+		ShvLogHeader header;
+		header.setDeviceId("dev1");
+		header.setDeviceType("TestDevice");
+		ShvGetLogParams params;
+		params.since = RpcValue::DateTime::fromMSecsSinceEpoch(1600000000000);
+		params.pathPattern = "zone*/**";
+		header.setLogParams(params);
+		header.setRecordCount(123);
+		header.setRecordCountLimit(1000);
+		header.setFields(RpcValue::List{RpcValue::Map{{"name", "timestamp"}}, RpcValue::Map{{"name", "path"}}});
+		header.setPathDict(RpcValue::IMap{{1, "zone1/signal/value"}, {2, "zone2/signal/status"}});
+		header.setDateTime(RpcValue::DateTime::fromMSecsSinceEpoch(1600000005000));
+		header.setSince(RpcValue::DateTime::fromMSecsSinceEpoch(1600000000000));
+		header.setUntil(RpcValue::DateTime::fromMSecsSinceEpoch(1600000004000));
+		ShvLogTypeInfo ti;
+		ti.paths["zone1/signal/value"] = ShvLogPathDescr("Int", "signal value");
+
+		header.setTypeInfo(ti);
+		std::string data = reflect::toChainPack(header);
+		QCOMPARE(data, pack(header.toMetaData()));
+		ShvLogHeader header2 = reflect::fromChainPack<ShvLogHeader>(data);
+		QCOMPARE(pack(header2.toMetaData()), data);
+
+		header.setTypeInfo(ti, "shv/dev2");
+		data = reflect::toChainPack(header);
+		QCOMPARE(data, pack(header.toMetaData()));
+		header2 = reflect::fromChainPack<ShvLogHeader>(data);
+		QCOMPARE(pack(header2.toMetaData()), data);
+		QVERIFY(header2.withPathsDict());
+
+		QCOMPARE(reflect::toChainPack(ShvLogHeader()), pack(ShvLogHeader().toMetaData()));
+	}
+	void benchmarkGetLogRpcValue()
+	{
+		std::vector<ShvGetLogRow> rows = test_rows(1000);
+		size_t n = 0;
+		QBENCHMARK {
+			RpcValue::List log;
+			for(const ShvGetLogRow &row : rows)
+				log.push_back(get_log_row(row));
+			n += pack(RpcValue(log)).size();
+		}
+		QVERIFY(n > 0);
+	}
+	void benchmarkGetLogReflect()
+	{
+		std::vector<ShvGetLogRow> rows = test_rows(1000);
+		size_t n = 0;
+		QBENCHMARK {
+			n += reflect::toChainPack(rows).size();
+		}
+		QVERIFY(n > 0);
+	}
+	void benchmarkJournalEntryRpcValue()
+	{
+		std::vector<ShvJournalEntry> entries = test_entries();
+		size_t n = 0;
+		QBENCHMARK {
+			for (int i = 0; i < 1000; ++i) {
+				for(const ShvJournalEntry &e : entries)
+					n += pack(e.toRpcValueMap()).size();
+			}
+		}
+		QVERIFY(n > 0);
+	}
+	void benchmarkJournalEntryReflect()
+	{
+		std::vector<ShvJournalEntry> entries = test_entries();
+		size_t n = 0;
+		QBENCHMARK {
+			for (int i = 0; i < 1000; ++i) {
+				for(const ShvJournalEntry &e : entries)
+					n += reflect::toChainPack(e).size();
+			}
+		}
+		QVERIFY(n > 0);
+	}
+};
+
+QTEST_MAIN(TestReflect)
+#include "tst_reflect.moc"
@@ -0,0 +1,217 @@
+#include <shv/core/utils/shvfilejournal.h>
+#include <shv/core/utils/shvjournalentry.h>
+#include <shv/core/utils/shvjournalfilereader.h>
+#include <shv/core/utils/shvjournal3filereader.h>
+#include <shv/core/utils/shvjournal3filewriter.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+#include <QDir>
+
+#include <random>
+#include <thread>
+
+using namespace std;
+using namespace shv::core::utils;
+using namespace shv::chainpack;
+
+namespace {
+
+const string TEST_DIR = "/tmp/TestShvJournal3";
+
+void snapshot_fn(std::vector<ShvJournalEntry> &ev)
+{
+	ev.push_back(ShvJournalEntry("snapshot/int", 1));
+	ev.push_back(ShvJournalEntry("snapshot/string", "foo"));
+}
+
+ShvJournalEntry random_entry(std::mt19937 &mt, int64_t msec, int i)
+{
+	ShvJournalEntry e;
+	e.epochMsec = msec;
+	e.path = "zone" + std::to_string(mt() % 5) + "/signal" + std::to_string(mt() % 20) + "/value";
+	switch (mt() % 4) {
+	case 0: e.value = RpcValue::Decimal(static_cast<int>(mt() % 10000), -2); break;
+	case 1: e.value = static_cast<int>(mt() % 1000); break;
+	case 2: e.value = RpcValue::List{static_cast<int>(mt() % 1000), i % 2? "R": "L"}; break;
+	default: e.value = (mt() % 2) == 0; break;
+	}
+	e.domain = (i % 7)? ShvJournalEntry::DOMAIN_VAL_CHANGE: ShvJournalEntry::DOMAIN_VAL_FASTCHANGE;
+	if(i % 13 == 0)
+		e.shortTime = i % 256;
+	if(i % 101 == 0) {
+		e.userId = "user1";
+		e.sampleType = ShvJournalEntry::SampleType::Discrete;
+	}
+	return e;
+}
+
+RpcValue::List log_without_snapshots(const RpcValue &log)
+{
+	RpcValue::List ret;
+	for(const RpcValue &row : log.toList()) {
+		const string &path = row.toList().value(1).asString();
+		if(path.find("snapshot/") == 0 || path == ShvJournalEntry::PATH_SNAPSHOT_BEGIN || path == ShvJournalEntry::PATH_SNAPSHOT_END)
+			continue;
+		ret.push_back(row);
+	}
+	return ret;
+}
+
+}
+
+class TestShvJournal3: public QObject
+{
+	Q_OBJECT
+private:
+	void testReadWrite()
+	{
+		qDebug() << "------------- read write";
+		string fn = TEST_DIR + "/test.log3";
+		std::mt19937 mt(1);
+		std::vector<ShvJournalEntry> entries;
+		int64_t msec = RpcValue::DateTime::now().msecsSinceEpoch();
+		{
+			ShvJournal3FileWriter wr(fn);
+			wr.setBlockSizeLimit(1024);
+			for (int i = 0; i < 1000; ++i) {
+				msec += mt() % 1000;
+				entries.push_back(random_entry(mt, msec, i));
+				wr.append(entries.back());
+			}
+		}
+		{
+			// reopened writer continues with new block
+			ShvJournal3FileWriter wr(fn);
+			for (int i = 0; i < 10; ++i) {
+				msec += mt() % 1000;
+				entries.push_back(random_entry(mt, msec, i));
+				wr.append(entries.back());
+			}
+		}
+		ShvJournal3FileReader rd(fn);
+		size_t cnt = 0;
+		while(rd.next()) {
+			QVERIFY(cnt < entries.size());
+			QVERIFY(rd.entry() == entries[cnt++]);
+		}
+		QVERIFY(cnt == entries.size());
+		QVERIFY(rd.last());
+		QVERIFY(rd.entry() == entries.back());
+		QVERIFY(ShvJournal3FileReader::findLastEntryDateTime(fn) == entries.back().epochMsec);
+
+		int64_t seek_msec = entries[entries.size() / 2].epochMsec;
+		rd.seek(seek_msec);
+		QVERIFY(rd.next());
+		QVERIFY(rd.entry().epochMsec < seek_msec);
+		while(rd.entry().epochMsec < seek_msec)
+			QVERIFY(rd.next());
+	}
+	void testFileJournal()
+	{
+		qDebug() << "------------- file journal log2 vs log3";
+		ShvFileJournal journal2("testdev", snapshot_fn);
+		journal2.setJournalDir(TEST_DIR + "/journal2");
+		ShvFileJournal journal3("testdev", snapshot_fn);
+		journal3.setJournalDir(TEST_DIR + "/journal3");
+		journal3.setFileFormat(ShvFileJournal::FileFormat::Log3);
+		for(ShvFileJournal *j : {&journal2, &journal3})
+			j->setFileSizeLimit(1024 * 64);
+		std::mt19937 mt(2);
+		int64_t msec = RpcValue::DateTime::now().msecsSinceEpoch();
+		int64_t msec1 = msec;
+		for (int i = 0; i < 20000; ++i) {
+			msec += mt() % 1000;
+			ShvJournalEntry e = random_entry(mt, msec, i);
+			journal2.append(e);
+			journal3.append(e);
+		}
+		ShvGetLogParams params;
+		params.withPathsDict = false;
+		params.since = RpcValue::DateTime::fromMSecsSinceEpoch(msec1 + (msec - msec1) / 3);
+		params.until = RpcValue::DateTime::fromMSecsSinceEpoch(msec - (msec - msec1) / 3);
+		RpcValue log2 = journal2.getLog(params);
+		RpcValue log3 = journal3.getLog(params);
+		qDebug() << "log2 rows:" << log2.toList().size() << "log3 rows:" << log3.toList().size();
+		// snapshots are written to different positions since file sizes differ
+		QVERIFY(log_without_snapshots(log2) == log_without_snapshots(log3));
+
+		qDebug() << "------------- convert log2 -> log3";
+		ShvFileJournal journal2c("testdev", snapshot_fn);
+		journal2c.setJournalDir(TEST_DIR + "/journal2");
+		journal2c.convertLog2JournalDir();
+		journal2c.setFileFormat(ShvFileJournal::FileFormat::Log3);
+		QVERIFY(journal2c.getLog(params).toList() == log2.toList());
+	}
+	void testDirRevalidation()
+	{
+		qDebug() << "------------- journal dir revalidation";
+		const string dir = TEST_DIR + "/revalidation";
+		ShvFileJournal journal("testdev", snapshot_fn);
+		journal.setJournalDir(dir);
+		journal.setFileSizeLimit(1024 * 4);
+		std::mt19937 mt(3);
+		int64_t msec = RpcValue::DateTime::now().msecsSinceEpoch() - 3600 * 1000;
+		int entry_no = 0;
+		auto append = [&](ShvFileJournal &j, int cnt) {
+			for (int i = 0; i < cnt; ++i) {
+				msec += 1000;
+				j.append(random_entry(mt, msec, entry_no++));
+			}
+		};
+		ShvGetLogParams params;
+		params.withPathsDict = false;
+		// fresh journal scans the dir on first getLog
+		auto fresh_log = [&dir, &params]() {
+			ShvFileJournal j("testdev", snapshot_fn);
+			j.setJournalDir(dir);
+			return log_without_snapshots(j.getLog(params));
+		};
+		append(journal, 200);
+		QCOMPARE(log_without_snapshots(journal.getLog(params)).size(), static_cast<size_t>(200));
+		// let dir state settle, it is not trusted when recorded within mtime granularity
+		std::this_thread::sleep_for(std::chrono::seconds(ShvFileJournal::JournalDirState::MTIME_GRANULARITY_SEC + 1));
+		QCOMPARE(log_without_snapshots(journal.getLog(params)).size(), static_cast<size_t>(200));
+
+		qDebug() << "append to the newest file by someone else";
+		ShvFileJournal other("testdev", snapshot_fn);
+		other.setJournalDir(dir);
+		other.setFileSizeLimit(1024 * 1024);
+		append(other, 10);
+		RpcValue::List log = log_without_snapshots(journal.getLog(params));
+		QCOMPARE(log.size(), static_cast<size_t>(210));
+		QVERIFY(log == fresh_log());
+
+		qDebug() << "remove the oldest file";
+		std::vector<int64_t> files = journal.checkJournalContext().files;
+		QVERIFY(files.size() > 2);
+		QCOMPARE(std::remove(journal.checkJournalContext().fileMsecToFilePath(files[0]).c_str()), 0);
+		log = log_without_snapshots(journal.getLog(params));
+		QVERIFY(log.size() < 210);
+		QVERIFY(log == fresh_log());
+
+		qDebug() << "add files by someone else";
+		size_t cnt = log.size();
+		other.setFileSizeLimit(1024 * 2);
+		append(other, 50);
+		log = log_without_snapshots(journal.getLog(params));
+		QCOMPARE(log.size(), cnt + 50);
+		QVERIFY(log == fresh_log());
+		QVERIFY(journal.checkJournalContext().files.size() > files.size());
+	}
+private slots:
+	void initTestCase()
+	{
+		QDir(QString::fromStdString(TEST_DIR)).removeRecursively();
+		QDir().mkpath(QString::fromStdString(TEST_DIR));
+	}
+	void tests()
+	{
+		testReadWrite();
+		testFileJournal();
+		testDirRevalidation();
+	}
+};
+
+QTEST_MAIN(TestShvJournal3)
+#include "tst_shvjournal3.moc"
@@ -0,0 +1,7 @@
+include ( ../test_libshvcore.pri )
+
+TARGET = tst_shvlogmergereader
+
+SOURCES += \
+    $${TARGET}.cpp \
+
@@ -0,0 +1,112 @@
+#include <shv/core/utils/shvjournalentry.h>
+#include <shv/core/utils/shvlogfilter.h>
+#include <shv/core/utils/shvlogmergereader.h>
+#include <shv/core/utils/shvlogrpcvaluereader.h>
+#include <shv/core/utils/shvmemoryjournal.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#include <memory>
+
+using namespace std;
+using namespace shv::core::utils;
+using namespace shv::chainpack;
+
+namespace {
+
+RpcValue make_log(int source_no, int entry_cnt, bool with_snapshot_markers = false)
+{
+	ShvMemoryJournal journal;
+	int64_t msec = 1000;
+	auto append = [&journal](const string &path, const RpcValue &val, int64_t msec) {
+		ShvJournalEntry e(path, val, path.find("SNAPSHOT") == string::npos? ShvJournalEntry::DOMAIN_VAL_CHANGE: ShvJournalEntry::DOMAIN_SHV_SYSTEM, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, msec);
+		journal.append(e);
+	};
+	if(with_snapshot_markers) {
+		append(ShvJournalEntry::PATH_SNAPSHOT_BEGIN, true, msec);
+		append("status", 0, msec);
+		append(ShvJournalEntry::PATH_SNAPSHOT_END, true, msec);
+	}
+	for (int i = 0; i < entry_cnt; ++i) {
+		msec += 1 + (i * 7 + source_no * 13) % 17;
+		append("value" + to_string(i % 10), i, msec);
+	}
+	ShvGetLogParams params;
+	params.withPathsDict = false;
+	params.withSnapshot = false;
+	return journal.getLog(params);
+}
+
+}
+
+class TestShvLogMergeReader: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testMerge()
+	{
+		constexpr int SRC_CNT = 5;
+		constexpr int ENTRY_CNT = 1000;
+		vector<unique_ptr<ShvLogRpcValueReader>> readers;
+		ShvLogMergeReader merge;
+		for (int i = 0; i < SRC_CNT; ++i) {
+			readers.emplace_back(new ShvLogRpcValueReader(make_log(i, ENTRY_CNT)));
+			merge.addSource(readers.back().get(), "dev" + to_string(i));
+		}
+		int cnt = 0;
+		int64_t recent_msec = 0;
+		while(merge.next()) {
+			const ShvJournalEntry &e = merge.entry();
+			QVERIFY(e.epochMsec >= recent_msec);
+			QVERIFY(e.path.find("dev") == 0);
+			recent_msec = e.epochMsec;
+			cnt++;
+		}
+		QCOMPARE(cnt, SRC_CNT * ENTRY_CNT);
+	}
+	void testFilterAndSnapshotDedup()
+	{
+		ShvLogRpcValueReader rd1(make_log(1, 100, true));
+		ShvLogRpcValueReader rd2(make_log(2, 100, true));
+		ShvLogMergeReader merge;
+		merge.addSource(&rd1);
+		merge.addSource(&rd2);
+		merge.setSnapshotDedup(true);
+		ShvGetLogParams params;
+		params.pathPattern = "status";
+		ShvLogFilter filter(params);
+		int cnt = 0;
+		while(merge.next()) {
+			const ShvJournalEntry &e = merge.entry();
+			QVERIFY(e.path != ShvJournalEntry::PATH_SNAPSHOT_BEGIN && e.path != ShvJournalEntry::PATH_SNAPSHOT_END);
+			if(filter.match(e))
+				cnt++;
+		}
+		// second snapshot of the same value is skipped
+		QCOMPARE(cnt, 1);
+	}
+	void benchmarkMerge100Sources()
+	{
+		constexpr int SRC_CNT = 100;
+		constexpr int ENTRY_CNT = 1000;
+		vector<RpcValue> logs;
+		for (int i = 0; i < SRC_CNT; ++i)
+			logs.push_back(make_log(i, ENTRY_CNT));
+		QBENCHMARK {
+			vector<unique_ptr<ShvLogRpcValueReader>> readers;
+			ShvLogMergeReader merge;
+			for (int i = 0; i < SRC_CNT; ++i) {
+				readers.emplace_back(new ShvLogRpcValueReader(logs[static_cast<size_t>(i)]));
+				merge.addSource(readers.back().get(), "dev" + to_string(i));
+			}
+			int cnt = 0;
+			while(merge.next())
+				cnt++;
+			QCOMPARE(cnt, SRC_CNT * ENTRY_CNT);
+		}
+	}
+};
+
+QTEST_MAIN(TestShvLogMergeReader)
+#include "tst_shvlogmergereader.moc"
@@ -3,5 +3,8 @@ CONFIG += ordered
 
 unix {
 SUBDIRS += \
+	localfsnode \
 	shvjournal \
+	shvnodetree \
+	usercommandauditsink \
 }
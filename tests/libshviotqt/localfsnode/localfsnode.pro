@@ -0,0 +1,7 @@
+include ( ../test_libshviotqt.pri )
+
+TARGET = tst_localfsnode
+
+
+SOURCES += \
+    $${TARGET}.cpp \
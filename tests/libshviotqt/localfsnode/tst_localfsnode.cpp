@@ -0,0 +1,113 @@
+#include <shv/iotqt/node/localfsnode.h>
+#include <shv/core/utils/shvpath.h>
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+
+using namespace shv::iotqt::node;
+using shv::chainpack::RpcValue;
+using std::string;
+
+class TestLocalFSNode: public QObject
+{
+	Q_OBJECT
+private:
+	static RpcValue call(LocalFSNode &nd, const string &path, const string &method, const RpcValue &params = RpcValue())
+	{
+		return nd.callMethod(shv::core::utils::ShvPath::split(path), method, params);
+	}
+	static string blobToString(const RpcValue &rv)
+	{
+		const RpcValue::Blob &b = rv.asBlob();
+		return string(b.begin(), b.end());
+	}
+	static RpcValue range(int offset, int size)
+	{
+		RpcValue::Map m;
+		m["offset"] = offset;
+		if(size >= 0)
+			m["size"] = size;
+		return m;
+	}
+private slots:
+	void testRangedRead()
+	{
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		LocalFSNode nd(dir.path());
+		QVERIFY(call(nd, "f.txt", "write", "0123456789").toBool());
+
+		QCOMPARE(blobToString(call(nd, "f.txt", "read")), string("0123456789"));
+		for(bool mmap : {false, true}) {
+			nd.setMemoryMappedReadEnabled(mmap);
+			QCOMPARE(blobToString(call(nd, "f.txt", "read", range(2, 3))), string("234"));
+			QCOMPARE(blobToString(call(nd, "f.txt", "read", range(7, -1))), string("789"));
+			QCOMPARE(blobToString(call(nd, "f.txt", "read", range(8, 100))), string("89"));
+			QCOMPARE(blobToString(call(nd, "f.txt", "read", range(10, 5))), string());
+		}
+		QVERIFY_EXCEPTION_THROWN(call(nd, "f.txt", "read", range(11, 1)), std::exception);
+	}
+	void testChunkedWrite()
+	{
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		LocalFSNode nd(dir.path());
+		QVERIFY(call(nd, "f.bin", "write", "abc").toBool());
+		QVERIFY(call(nd, "f.bin", "append", RpcValue(RpcValue::Blob{'d', 'e'})).toBool());
+		QCOMPARE(blobToString(call(nd, "f.bin", "read")), string("abcde"));
+
+		RpcValue::Map flags;
+		flags["offset"] = 1;
+		QVERIFY(call(nd, "f.bin", "write", RpcValue::List{"XY", flags}).toBool());
+		QCOMPARE(blobToString(call(nd, "f.bin", "read")), string("aXYde"));
+		flags["offset"] = 5;
+		QVERIFY(call(nd, "f.bin", "write", RpcValue::List{"fg", flags}).toBool());
+		QCOMPARE(blobToString(call(nd, "f.bin", "read")), string("aXYdefg"));
+		flags["offset"] = 10;
+		QVERIFY_EXCEPTION_THROWN(call(nd, "f.bin", "write", RpcValue::List{"h", flags}), std::exception);
+	}
+	void testHash()
+	{
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		LocalFSNode nd(dir.path());
+		QVERIFY(call(nd, "f.txt", "write", "xx123456789").toBool());
+		QCOMPARE(call(nd, "f.txt", "crc32", range(2, -1)).toUInt(), 0xcbf43926u);
+		QVERIFY(call(nd, "f.txt", "write", "hello world").toBool());
+		QCOMPARE(call(nd, "f.txt", "sha1").asString(), string("2aae6c35c94fcfb415dbe95f408b9ce91ee846ed"));
+
+		// hash is computed in chunks, compare it with one shot hash of large file
+		QByteArray data;
+		for (int i = 0; i < 200000; ++i)
+			data.append(static_cast<char>(i * 7));
+		QVERIFY(call(nd, "big.bin", "write", RpcValue(RpcValue::Blob(data.constData(), data.constData() + data.size()))).toBool());
+		QCOMPARE(call(nd, "big.bin", "sha1").asString(), QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex().toStdString());
+	}
+	void testPseudoFileRead()
+	{
+#ifdef Q_OS_LINUX
+		// procfs files report size 0, content must be read until EOF
+		QFile f("/proc/version");
+		QVERIFY(f.open(QFile::ReadOnly));
+		QCOMPARE(f.size(), static_cast<qint64>(0));
+		const QByteArray content = f.readAll();
+		QVERIFY(content.size() > 5);
+
+		LocalFSNode nd("/proc");
+		for(bool mmap : {false, true}) {
+			nd.setMemoryMappedReadEnabled(mmap);
+			QCOMPARE(blobToString(call(nd, "version", "read")), content.toStdString());
+			QCOMPARE(blobToString(call(nd, "version", "read", range(2, -1))), content.mid(2).toStdString());
+			QCOMPARE(blobToString(call(nd, "version", "read", range(2, 3))), content.mid(2, 3).toStdString());
+		}
+		QCOMPARE(call(nd, "version", "sha1").asString(), QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex().toStdString());
+		QCOMPARE(call(nd, "version", "sha1", range(1, 2)).asString(), QCryptographicHash::hash(content.mid(1, 2), QCryptographicHash::Sha1).toHex().toStdString());
+#else
+		QSKIP("procfs is not available");
+#endif
+	}
+};
+
+QTEST_MAIN(TestLocalFSNode)
+#include "tst_localfsnode.moc"
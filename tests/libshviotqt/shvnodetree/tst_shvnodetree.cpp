@@ -0,0 +1,200 @@
+#include <shv/iotqt/node/shvnode.h>
+#include <shv/iotqt/node/shvnodetree.h>
+#include <shv/core/utils/shvpath.h>
+#include <shv/chainpack/rpc.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#include <QtTest/QtTest>
+
+using namespace shv::iotqt::node;
+using namespace shv::chainpack;
+using std::string;
+
+namespace {
+
+/// forwards whole subtree somewhere else like ClientShvNode on broker
+class RawHandlerNode : public ShvNode
+{
+public:
+	using ShvNode::ShvNode;
+	void handleRawRpcRequest(RpcValue::MetaData &&meta, string &&data) override
+	{
+		Q_UNUSED(data)
+		paths.push_back(RpcMessage::shvPath(meta).toString());
+	}
+	std::vector<string> paths;
+};
+
+/// routes its subtree itself but lets the default implementation do the work
+class RoutingNode : public ShvNode
+{
+public:
+	using ShvNode::ShvNode;
+	void handleRawRpcRequest(RpcValue::MetaData &&meta, string &&data) override
+	{
+		paths.push_back(RpcMessage::shvPath(meta).toString());
+		ShvNode::handleRawRpcRequest(std::move(meta), std::move(data));
+	}
+	void handleRpcRequest(const RpcRequest &rq) override
+	{
+		paths.push_back(rq.shvPath().toString());
+		ShvNode::handleRpcRequest(rq);
+	}
+	std::vector<string> paths;
+};
+
+/// does not reimplement request handlers
+class OnePassNode : public ShvNode
+{
+public:
+	OnePassNode(const string &node_id, ShvNode *parent) : ShvNode(node_id, parent)
+	{
+		m_isOnePassDispatchEnabled = true;
+	}
+};
+
+void send_raw_request(ShvNode *nd, const string &shv_path, const string &method)
+{
+	RpcRequest rq;
+	rq.setRequestId(1).setMethod(method);
+	rq.setShvPath(shv_path);
+	RpcValue::MetaData meta = rq.value().metaData();
+	RpcMessage::setProtocolType(meta, Rpc::ProtocolType::ChainPack);
+	RpcValue val = rq.value();
+	val.setMetaData(RpcValue::MetaData());
+	nd->handleRawRpcRequest(std::move(meta), val.toChainPack());
+}
+
+}
+
+class TestShvNodeTree: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testChildIndex()
+	{
+		ShvNodeTree tree;
+		ShvNode *a = tree.mkdir("a");
+		ShvNode *b = new ShvNode("b", a);
+		QCOMPARE(a->childNode("b", false), b);
+		QVERIFY(a->childNode("c", false) == nullptr);
+
+		b->setNodeId("c");
+		QVERIFY(a->childNode("b", false) == nullptr);
+		QCOMPARE(a->childNode("c", false), b);
+
+		ShvNode *x = tree.mkdir("x");
+		b->setParentNode(x);
+		QVERIFY(a->childNode("c", false) == nullptr);
+		QCOMPARE(x->childNode("c", false), b);
+
+		// plain QObject reparent must be tracked too
+		b->setParent(a);
+		QCOMPARE(a->childNode("c", false), b);
+		QVERIFY(x->childNode("c", false) == nullptr);
+
+		delete b;
+		QVERIFY(a->childNode("c", false) == nullptr);
+	}
+	void testShvPathCache()
+	{
+		ShvNodeTree tree;
+		ShvNode *c = tree.mkdir("a/b/c");
+		QCOMPARE(c->shvPath().asString(), string("a/b/c"));
+		ShvNode *b = c->parentNode();
+		b->setNodeId("x");
+		QCOMPARE(c->shvPath().asString(), string("a/x/c"));
+		b->setParentNode(tree.root());
+		QCOMPARE(c->shvPath().asString(), string("x/c"));
+	}
+	void testLsDirCache()
+	{
+		ShvNodeTree tree;
+		ShvNode *a = tree.mkdir("a");
+		a->setLsDirCacheEnabled(true);
+		new ShvNode("b", a);
+		auto ls = [a]() {
+			return a->callMethod(ShvNode::StringViewList(), shv::chainpack::Rpc::METH_LS, shv::chainpack::RpcValue()).toCpon();
+		};
+		QCOMPARE(ls(), string("[\"b\"]"));
+		ShvNode *c = new ShvNode("c", a);
+		QCOMPARE(ls(), string("[\"b\",\"c\"]"));
+		c->setNodeId("d");
+		QCOMPARE(ls(), string("[\"b\",\"d\"]"));
+		delete c;
+		QCOMPARE(ls(), string("[\"b\"]"));
+	}
+	void testCd()
+	{
+		ShvNodeTree tree;
+		ShvNode *nd = tree.mkdir("a/b/c");
+		QCOMPARE(tree.cd("a/b/c"), nd);
+		QVERIFY(tree.cd("a/b/c/d") == nullptr);
+
+		string rest;
+		QCOMPARE(tree.cd("a/b/c/d/e", &rest), nd);
+		QCOMPARE(rest, string("d/e"));
+
+		const string path = "a/b/x/y";
+		ShvNode::StringViewList rest_views;
+		ShvNode *b = tree.cd(shv::core::utils::ShvPath::split(path), &rest_views);
+		QCOMPARE(b, nd->parentNode());
+		QCOMPARE(rest_views.join('/'), string("x/y"));
+	}
+	void testRawRequestDispatch()
+	{
+		ShvNodeTree tree;
+		ShvNode *a = tree.mkdir("a");
+		new ShvNode("b", a);
+		RawHandlerNode *dev = new RawHandlerNode("dev", a);
+		std::vector<RpcResponse> responses;
+		QObject::connect(tree.root(), &ShvNode::sendRpcMessage, [&responses](const RpcMessage &msg) {
+			responses.push_back(RpcResponse(msg));
+		});
+
+		// raw handler gets requests for itself and its whole subtree with path relative to it
+		send_raw_request(tree.root(), "a/dev/x/y", Rpc::METH_LS);
+		send_raw_request(tree.root(), "a/dev", Rpc::METH_DIR);
+		QCOMPARE(dev->paths.size(), static_cast<size_t>(2));
+		QCOMPARE(dev->paths[0], string("x/y"));
+		QCOMPARE(dev->paths[1], string());
+		QVERIFY(responses.empty());
+
+		// nodes without raw handler are served by the resolving node
+		send_raw_request(tree.root(), "a", Rpc::METH_LS);
+		QCOMPARE(responses.size(), static_cast<size_t>(1));
+		QCOMPARE(responses[0].result().toCpon(), string("[\"b\",\"dev\"]"));
+		send_raw_request(tree.root(), "a/c", Rpc::METH_LS);
+		QCOMPARE(responses.size(), static_cast<size_t>(2));
+		QVERIFY(responses[1].isError());
+		QCOMPARE(dev->paths.size(), static_cast<size_t>(2));
+	}
+	void testIntermediateHandlerOverride()
+	{
+		ShvNodeTree tree;
+		ShvNode *a = tree.mkdir("a");
+		RoutingNode *r = new RoutingNode("r", a);
+		new ShvNode("x", new OnePassNode("p", r));
+		std::vector<RpcResponse> responses;
+		QObject::connect(tree.root(), &ShvNode::sendRpcMessage, [&responses](const RpcMessage &msg) {
+			responses.push_back(RpcResponse(msg));
+		});
+
+		// overridden handler of intermediate node must run, one pass dispatch continues below it
+		send_raw_request(tree.root(), "a/r/p/x", Rpc::METH_LS);
+		QCOMPARE(r->paths, std::vector<string>({"p/x"}));
+		QCOMPARE(responses.size(), static_cast<size_t>(1));
+		QCOMPARE(responses[0].result().toCpon(), string("[]"));
+
+		RpcRequest rq;
+		rq.setRequestId(2).setMethod(Rpc::METH_LS);
+		rq.setShvPath("a/r/p");
+		tree.root()->handleRpcRequest(rq);
+		QCOMPARE(r->paths, std::vector<string>({"p/x", "p"}));
+		QCOMPARE(responses.size(), static_cast<size_t>(2));
+		QCOMPARE(responses[1].result().toCpon(), string("[\"x\"]"));
+	}
+};
+
+QTEST_MAIN(TestShvNodeTree)
+#include "tst_shvnodetree.moc"
@@ -0,0 +1,83 @@
+#include <shv/iotqt/node/usercommandauditsink.h>
+
+#include <QtTest/QtTest>
+
+#include <future>
+
+using namespace shv::iotqt::node;
+using shv::core::utils::ShvJournalEntry;
+using std::string;
+
+class TestUserCommandAuditSink: public QObject
+{
+	Q_OBJECT
+private:
+	static UserCommandAuditSink::Command command(int64_t msec, const string &path, const shv::chainpack::RpcValue &params)
+	{
+		UserCommandAuditSink::Command cmd;
+		cmd.epochMsec = msec;
+		cmd.shvPath = path;
+		cmd.method = "set";
+		cmd.params = params;
+		cmd.userId = "user";
+		return cmd;
+	}
+private slots:
+	void testFormatAndCoalesce()
+	{
+		std::vector<ShvJournalEntry> entries;
+		UserCommandAuditSink sink([&entries](const std::vector<ShvJournalEntry> &batch) {
+			entries.insert(entries.end(), batch.begin(), batch.end());
+		});
+		sink.enqueue(command(1000, "a/b", 1));
+		sink.enqueue(command(1100, "a/b", 1));
+		sink.enqueue(command(1200, "a/b", 1));
+		sink.enqueue(command(1300, "a/b", 2));
+		sink.enqueue(command(1400, "a/c", 2));
+		// identical command after coalesce interval is written again
+		sink.enqueue(command(5000, "a/c", 2));
+		sink.flush();
+
+		QCOMPARE(sink.coalescedCount(), int64_t(2));
+		QCOMPARE(sink.writtenCount(), int64_t(4));
+		QCOMPARE(entries.size(), size_t(4));
+		QCOMPARE(entries[0].path, string("a/b"));
+		QCOMPARE(entries[0].value.asString(), string("set(1)"));
+		QCOMPARE(entries[0].epochMsec, int64_t(1000));
+		QCOMPARE(entries[0].userId, string("user"));
+		QCOMPARE(entries[0].domain, string(ShvJournalEntry::DOMAIN_SHV_COMMAND));
+		QCOMPARE(entries[1].value.asString(), string("set(2)"));
+		QCOMPARE(entries[2].path, string("a/c"));
+		QCOMPARE(entries[3].epochMsec, int64_t(5000));
+	}
+	void testOverflow()
+	{
+		std::promise<void> entered;
+		std::promise<void> release;
+		std::shared_future<void> released = release.get_future().share();
+		bool is_first_batch = true;
+		int64_t written = 0;
+		UserCommandAuditSink sink([&](const std::vector<ShvJournalEntry> &batch) {
+			if(is_first_batch) {
+				is_first_batch = false;
+				entered.set_value();
+			}
+			released.wait();
+			written += static_cast<int64_t>(batch.size());
+		}, 3);
+		QVERIFY(sink.enqueue(command(1000, "x", 0)));
+		// sink thread takes the first command and blocks in write function
+		entered.get_future().wait();
+		QVERIFY(sink.enqueue(command(2000, "x", 1)));
+		QVERIFY(sink.enqueue(command(3000, "x", 2)));
+		QVERIFY(sink.enqueue(command(4000, "x", 3)));
+		QVERIFY(!sink.enqueue(command(5000, "x", 4)));
+		QCOMPARE(sink.overflowCount(), int64_t(1));
+		release.set_value();
+		sink.flush();
+		QCOMPARE(written, int64_t(4));
+	}
+};
+
+QTEST_MAIN(TestUserCommandAuditSink)
+#include "tst_usercommandauditsink.moc"
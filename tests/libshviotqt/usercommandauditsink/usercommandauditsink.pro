@@ -0,0 +1,7 @@
+include ( ../test_libshviotqt.pri )
+
+TARGET = tst_usercommandauditsink
+
+
+SOURCES += \
+    $${TARGET}.cpp \
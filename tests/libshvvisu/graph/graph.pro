@@ -0,0 +1,7 @@
+include ( ../test_libshvvisu.pri )
+
+TARGET = tst_graph
+
+
+SOURCES += \
+    $${TARGET}.cpp \
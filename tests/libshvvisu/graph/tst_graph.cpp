@@ -0,0 +1,105 @@
+#include <shv/visu/timeline/graph.h>
+#include <shv/visu/timeline/graphmodel.h>
+
+#include <QImage>
+#include <QPainter>
+#include <QtTest/QtTest>
+
+#include <atomic>
+
+using namespace shv::visu::timeline;
+
+namespace {
+
+constexpr timemsec_t T0 = 1600000000000;
+constexpr int SAMPLE_COUNT = 1000;
+
+void init_model(GraphModel &model)
+{
+	model.appendChannel("a", "");
+	model.beginAppendValues();
+	for (int i = 0; i < SAMPLE_COUNT; ++i)
+		model.appendValue(0, Sample{T0 + i * 10, i % 50});
+	model.endAppendValues();
+}
+
+void init_graph(Graph &graph, GraphModel &model)
+{
+	graph.setModel(&model);
+	graph.createChannelsFromModel();
+	graph.showAllChannels();
+	graph.setAsyncSamplesRendering(true);
+	graph.makeLayout(QRect(0, 0, 800, 400));
+}
+
+void draw(Graph &graph)
+{
+	QImage image(graph.rect().size(), QImage::Format_ARGB32_Premultiplied);
+	QPainter painter(&image);
+	graph.draw(&painter, graph.rect(), graph.rect());
+}
+
+}
+
+class TestGraph: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testAsyncRenderDiscardsStaleResult()
+	{
+		GraphModel model;
+		init_model(model);
+		std::atomic<int> render_count{0};
+		Graph graph;
+		init_graph(graph, model);
+		// counted in render thread, before queued result reaches the graph
+		connect(&graph, &Graph::samplesImageRendered, this, [&render_count]() { ++render_count; }, Qt::DirectConnection);
+
+		draw(graph);
+		// channels are recreated while job renders the old ones
+		graph.createChannelsFromModel();
+		graph.showAllChannels();
+		graph.makeLayout(QRect(0, 0, 800, 400));
+		QSignalSpy dirty(&graph, &Graph::presentationDirty);
+		QTRY_COMPARE(render_count.load(), 1);
+		QCoreApplication::processEvents();
+		QCOMPARE(dirty.count(), 0);
+
+		draw(graph);
+		QTRY_COMPARE(dirty.count(), 1);
+		QCOMPARE(render_count.load(), 2);
+		// image is up to date, nothing is rendered
+		draw(graph);
+		QCoreApplication::processEvents();
+		QCOMPARE(render_count.load(), 2);
+	}
+	void testAsyncRenderViewChange()
+	{
+		GraphModel model;
+		init_model(model);
+		std::atomic<int> render_count{0};
+		Graph graph;
+		init_graph(graph, model);
+		connect(&graph, &Graph::samplesImageRendered, this, [&render_count]() { ++render_count; }, Qt::DirectConnection);
+		QSignalSpy dirty(&graph, &Graph::presentationDirty);
+
+		draw(graph);
+		// zoom changes while the first job is pending, no other job is started until it is done
+		graph.setXRangeZoom(XRange{T0, T0 + SAMPLE_COUNT * 5});
+		draw(graph);
+		dirty.clear();
+		QTRY_COMPARE(dirty.count(), 1);
+		QCOMPARE(render_count.load(), 1);
+
+		// result rendered for previous zoom is only a placeholder, current view is rendered next
+		draw(graph);
+		QTRY_COMPARE(dirty.count(), 2);
+		QCOMPARE(render_count.load(), 2);
+		draw(graph);
+		QCoreApplication::processEvents();
+		QCOMPARE(render_count.load(), 2);
+	}
+};
+
+QTEST_MAIN(TestGraph)
+#include "tst_graph.moc"
@@ -0,0 +1,258 @@
+#include <shv/visu/timeline/graph.h>
+#include <shv/visu/timeline/graphmodel.h>
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+using namespace shv::visu::timeline;
+
+namespace {
+
+constexpr timemsec_t T0 = 1600000000000;
+constexpr int SAMPLE_COUNT = 5000;
+
+/// deterministic pseudo random values with spikes
+int sample_value(int ix)
+{
+	uint32_t x = static_cast<uint32_t>(ix) * 2654435761u;
+	int v = static_cast<int>((x >> 8) % 1000) - 500;
+	if(ix % 977 == 0)
+		v *= 100;
+	return v;
+}
+
+void append_samples(GraphModel &model, int channel, int cnt, const std::function<QVariant (int)> &value_fn)
+{
+	model.beginAppendValues();
+	for (int i = 0; i < cnt; ++i)
+		model.appendValue(channel, Sample{T0 + i * 10, value_fn(i)});
+	model.endAppendValues();
+}
+
+YRange brute_force_range(const GraphModel &model, int channel, int ix1, int ix2)
+{
+	const int meta_type_id = model.channelInfo(channel).metaTypeId;
+	const double d1 = GraphModel::valueToDouble(model.sampleAt(channel, ix1).value, meta_type_id);
+	YRange ret(d1, d1);
+	for (int i = ix1 + 1; i < ix2; ++i) {
+		double d = GraphModel::valueToDouble(model.sampleAt(channel, i).value, meta_type_id);
+		ret.min = qMin(ret.min, d);
+		ret.max = qMax(ret.max, d);
+	}
+	return ret;
+}
+
+/// model showing samples with shifted values, storage is not reused
+class OffsetModel : public GraphModel
+{
+public:
+	using GraphModel::GraphModel;
+	Sample sampleAt(int channel, int ix) const override
+	{
+		Sample s = GraphModel::sampleAt(channel, ix);
+		s.value = s.value.toInt() + OFFSET;
+		return s;
+	}
+	static constexpr int OFFSET = 1000;
+};
+constexpr int OffsetModel::OFFSET;
+
+}
+
+class TestGraphModel: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testLodMinMax()
+	{
+		GraphModel model;
+		model.appendChannel();
+		model.channelInfo(0).metaTypeId = QMetaType::Int;
+		append_samples(model, 0, SAMPLE_COUNT, sample_value);
+
+		int bucket_cnt = 0;
+		for (int ix = 0; ix < SAMPLE_COUNT; ) {
+			int n = 0;
+			const GraphModel::LodBucket *b = model.lodBucket(0, ix, SAMPLE_COUNT, T0, &n);
+			if(!b) {
+				ix++;
+				continue;
+			}
+			bucket_cnt++;
+			YRange r = brute_force_range(model, 0, ix, ix + n);
+			QCOMPARE(b->min, r.min);
+			QCOMPARE(b->max, r.max);
+			QCOMPARE(b->first, static_cast<double>(sample_value(ix)));
+			QCOMPARE(b->last, static_cast<double>(sample_value(ix + n - 1)));
+			QCOMPARE(b->firstTime, model.sampleAt(0, ix).time);
+			QCOMPARE(b->lastTime, model.sampleAt(0, ix + n - 1).time);
+			ix += n;
+		}
+		QVERIFY(bucket_cnt > 0);
+
+		YRange r = model.yRange(0);
+		YRange bf = brute_force_range(model, 0, 0, SAMPLE_COUNT);
+		QCOMPARE(r.min, bf.min);
+		QCOMPARE(r.max, bf.max);
+	}
+	void testLodChannelMetaType()
+	{
+		GraphModel model;
+		model.appendChannel();
+		model.channelInfo(0).metaTypeId = QMetaType::Bool;
+		append_samples(model, 0, SAMPLE_COUNT, [](int ix) { return ix % 100; });
+		int n = 0;
+		const GraphModel::LodBucket *b = model.lodBucket(0, 0, SAMPLE_COUNT, T0, &n);
+		QVERIFY(b);
+		QCOMPARE(b->min, 0.);
+		QCOMPARE(b->max, 1.);
+		QCOMPARE(model.yRange(0).max, 1.);
+	}
+	void testLodGuessedMetaType()
+	{
+		GraphModel model;
+		model.appendChannel();
+		// meta type is guessed from the first sample when appending ends, LOD must follow it
+		append_samples(model, 0, SAMPLE_COUNT, [](int ix) { return ix == 0? QVariant(QString()): QVariant(ix); });
+		QCOMPARE(model.channelInfo(0).metaTypeId, static_cast<int>(QMetaType::QString));
+		int n = 0;
+		const GraphModel::LodBucket *b = model.lodBucket(0, 0, SAMPLE_COUNT, T0, &n);
+		QVERIFY(b);
+		QCOMPARE(b->min, 0.);
+		QCOMPARE(b->max, 1.);
+
+		// next batch extends LOD built for guessed type
+		append_samples(model, 0, SAMPLE_COUNT, [](int ix) { return ix + 10; });
+		const int ix = SAMPLE_COUNT + ChannelSamples::LOD_BUCKET_SIZE - SAMPLE_COUNT % ChannelSamples::LOD_BUCKET_SIZE;
+		b = model.lodBucket(0, ix, 2 * SAMPLE_COUNT, T0, &n);
+		QVERIFY(b);
+		QCOMPARE(b->max, 1.);
+		QCOMPARE(model.yRange(0).max, 1.);
+	}
+	void testSubclassAccessors()
+	{
+		OffsetModel model;
+		model.appendChannel("a", "");
+		model.channelInfo(0).metaTypeId = QMetaType::Int;
+		append_samples(model, 0, SAMPLE_COUNT, sample_value);
+		QVERIFY(!model.isChannelSamplesAccessEnabled());
+
+		YRange r = model.yRange(0);
+		YRange bf = brute_force_range(model, 0, 0, SAMPLE_COUNT);
+		QCOMPARE(r.min, bf.min);
+		QCOMPARE(r.max, bf.max);
+
+		Graph graph;
+		graph.setModel(&model);
+		graph.createChannelsFromModel();
+		QCOMPARE(graph.nearestSample(0, T0 + 101).value.toInt(), sample_value(10) + OffsetModel::OFFSET);
+		QCOMPARE(graph.nearestSample(0, T0 + 10 * SAMPLE_COUNT).value.toInt(), sample_value(SAMPLE_COUNT - 1) + OffsetModel::OFFSET);
+	}
+	void testColumnarStorage_data()
+	{
+		QTest::addColumn<QVariantList>("values");
+		QTest::addColumn<int>("valueType");
+
+		QTest::newRow("double") << QVariantList{1.5, -2., 0., 1e300} << static_cast<int>(ChannelSamples::ValueType::Double);
+		QTest::newRow("int") << QVariantList{1, -2, 0, std::numeric_limits<int>::max()} << static_cast<int>(ChannelSamples::ValueType::Int);
+		QTest::newRow("uint") << QVariantList{1u, 0u, std::numeric_limits<uint>::max()} << static_cast<int>(ChannelSamples::ValueType::Int);
+		QTest::newRow("longlong") << QVariantList{qint64{1} << 40, qint64{-1}} << static_cast<int>(ChannelSamples::ValueType::Int);
+		QTest::newRow("bool") << QVariantList{true, false, true} << static_cast<int>(ChannelSamples::ValueType::Bool);
+		QTest::newRow("string") << QVariantList{"a", "", "b"} << static_cast<int>(ChannelSamples::ValueType::Variant);
+		QTest::newRow("map") << QVariantList{QVariantMap{{"a", 1}}, QVariantMap()} << static_cast<int>(ChannelSamples::ValueType::Variant);
+		QTest::newRow("int to double") << QVariantList{1, 2, 2.5, 3} << static_cast<int>(ChannelSamples::ValueType::Variant);
+		QTest::newRow("int to uint") << QVariantList{1, 2u, -3} << static_cast<int>(ChannelSamples::ValueType::Variant);
+		QTest::newRow("bool to string") << QVariantList{true, "x", false} << static_cast<int>(ChannelSamples::ValueType::Variant);
+		QTest::newRow("double to invalid") << QVariantList{1., QVariant(), 2.} << static_cast<int>(ChannelSamples::ValueType::Variant);
+	}
+	void testColumnarStorage()
+	{
+		QFETCH(QVariantList, values);
+		QFETCH(int, valueType);
+
+		// samples as they were stored in QVector<Sample> before columnar storage
+		QVector<Sample> expected;
+		GraphModel model;
+		model.appendChannel();
+		model.beginAppendValues();
+		for (int i = 0; i < values.count(); ++i) {
+			Sample s{T0 + i * 10, values[i]};
+			expected << s;
+			model.appendValue(0, std::move(s));
+		}
+		model.endAppendValues();
+
+		const ChannelSamples &samples = model.channelSamples(0);
+		QCOMPARE(static_cast<int>(samples.valueType()), valueType);
+		QCOMPARE(samples.count(), expected.count());
+		QCOMPARE(model.count(0), expected.count());
+		const int meta_type_id = model.channelInfo(0).metaTypeId;
+		for (int i = 0; i < expected.count(); ++i) {
+			const Sample &e = expected[i];
+			for(const Sample &s : {samples.sampleAt(i), model.sampleAt(0, i), model.sampleValue(0, i)}) {
+				QCOMPARE(s.time, e.time);
+				QCOMPARE(s.value.userType(), e.value.userType());
+				QCOMPARE(s.value, e.value);
+			}
+			QCOMPARE(samples.timeAt(i), e.time);
+			for(int mt : {meta_type_id, static_cast<int>(QMetaType::UnknownType), static_cast<int>(QMetaType::Double)}) {
+				bool ok1, ok2;
+				double d1 = samples.valueToDouble(i, mt, &ok1);
+				double d2 = GraphModel::valueToDouble(e.value, mt, &ok2);
+				QCOMPARE(ok1, ok2);
+				QCOMPARE(d1, d2);
+			}
+		}
+		QVERIFY(!model.sampleValue(0, expected.count()).isValid());
+	}
+	void testLessOrEqualIndex()
+	{
+		GraphModel model;
+		model.appendChannel();
+		QCOMPARE(model.lessOrEqualIndex(0, T0), -1);
+		QCOMPARE(model.channelSamples(0).lessOrEqualIndex(T0, 0), -1);
+
+		// times with gaps and duplicates
+		QVector<timemsec_t> times;
+		model.beginAppendValues();
+		for (int i = 0; i < SAMPLE_COUNT; ++i) {
+			timemsec_t t = T0 + (i / 3) * 10 + ((i % 100 == 0)? 5: 0);
+			if(!times.isEmpty())
+				t = qMax(t, times.last());
+			times << t;
+			model.appendValue(0, Sample{t, i});
+		}
+		model.endAppendValues();
+		auto expected_index = [&times](timemsec_t t) {
+			return static_cast<int>(std::upper_bound(times.begin(), times.end(), t) - times.begin()) - 1;
+		};
+		const ChannelSamples &samples = model.channelSamples(0);
+
+		QCOMPARE(model.lessOrEqualIndex(0, T0 - 1), -1);
+		QCOMPARE(model.lessOrEqualIndex(0, times.first()), expected_index(times.first()));
+		QCOMPARE(model.lessOrEqualIndex(0, times.last()), SAMPLE_COUNT - 1);
+		QCOMPARE(model.lessOrEqualIndex(0, times.last() + 1000), SAMPLE_COUNT - 1);
+		QCOMPARE(model.lessOrEqualIndex(-1, T0), -1);
+		QCOMPARE(model.lessOrEqualIndex(1, T0), -1);
+
+		QVector<timemsec_t> probes{T0 - 1, T0, times.last(), times.last() + 1, std::numeric_limits<timemsec_t>::max()};
+		for (int i = 0; i < SAMPLE_COUNT; i += 7) {
+			// exact match, between samples
+			probes << times[i] << times[i] + 1 << times[i] - 1;
+		}
+		for(timemsec_t t : probes) {
+			const int ix = expected_index(t);
+			QCOMPARE(model.lessOrEqualIndex(0, t), ix);
+			QCOMPARE(samples.lessOrEqualIndex(t), ix);
+			// cursor hint near, far away and invalid
+			for(int cursor_ix : {ix, ix - 1, ix + 1, ix - ChannelSamples::CURSOR_WALK_LIMIT - 1, 0, SAMPLE_COUNT - 1, SAMPLE_COUNT, -1})
+				QCOMPARE(samples.lessOrEqualIndex(t, cursor_ix), ix);
+		}
+	}
+};
+
+QTEST_MAIN(TestGraphModel)
+#include "tst_graphmodel.moc"
@@ -0,0 +1,11 @@
+TEMPLATE = subdirs
+CONFIG += ordered
+
+unix {
+SUBDIRS += \
+	graph \
+	graphmodel \
+	logmodel \
+	logsortfilterproxymodel \
+	svgscene \
+}
@@ -0,0 +1,82 @@
+#include <shv/visu/logview/logmodel.h>
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QSortFilterProxyModel>
+#include <QtTest/QtTest>
+
+using namespace shv::visu::logview;
+using namespace shv::chainpack;
+using std::string;
+
+namespace {
+
+RpcValue make_log(const std::vector<RpcValue> &values)
+{
+	RpcValue::List rows;
+	int64_t msec = 1600000000000;
+	for(const RpcValue &val : values) {
+		RpcValue::List row;
+		row.push_back(RpcValue::DateTime::fromMSecsSinceEpoch(msec++));
+		row.push_back("a");
+		row.push_back(val);
+		rows.push_back(row);
+	}
+	return rows;
+}
+
+QStringList sorted_values(const std::vector<RpcValue> &values, Qt::SortOrder order)
+{
+	LogModel model;
+	model.setLog(make_log(values));
+	QSortFilterProxyModel proxy;
+	proxy.setSourceModel(&model);
+	proxy.setSortRole(LogModel::SortRole);
+	proxy.sort(LogModel::ColValue, order);
+	QStringList ret;
+	for (int i = 0; i < proxy.rowCount(); ++i)
+		ret << proxy.data(proxy.index(i, LogModel::ColValue)).toString();
+	return ret;
+}
+
+}
+
+class TestLogModel: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testSortMixedValueTypes()
+	{
+		const std::vector<RpcValue> values{
+			RpcValue("b"),
+			RpcValue(10),
+			RpcValue(true),
+			RpcValue(-2.5),
+			RpcValue("a"),
+			RpcValue(3u),
+			RpcValue(RpcValue::Decimal(15, -1)),
+			RpcValue(nullptr),
+			RpcValue(-20),
+		};
+		const QStringList asc = sorted_values(values, Qt::AscendingOrder);
+		QCOMPARE(asc.mid(0, 6), QStringList({"-20", "-2.5", "1.5", "3u", "10", "\"a\""}));
+		QCOMPARE(asc.count(), static_cast<int>(values.size()));
+		// non numeric values are after numbers in stable order of their keys
+		QVERIFY(asc.indexOf("\"a\"") < asc.indexOf("\"b\""));
+		QVERIFY(asc.indexOf("true") > asc.indexOf("10"));
+		QVERIFY(asc.indexOf("null") > asc.indexOf("10"));
+
+		QStringList desc = sorted_values(values, Qt::DescendingOrder);
+		std::reverse(desc.begin(), desc.end());
+		QCOMPARE(desc, asc);
+	}
+	void testSortRoleType()
+	{
+		LogModel model;
+		model.setLog(make_log({RpcValue(1), RpcValue("x"), RpcValue(true)}));
+		for (int i = 0; i < model.rowCount(); ++i)
+			QCOMPARE(model.data(model.index(i, LogModel::ColValue), LogModel::SortRole).userType(), static_cast<int>(QMetaType::QString));
+	}
+};
+
+QTEST_MAIN(TestLogModel)
+#include "tst_logmodel.moc"
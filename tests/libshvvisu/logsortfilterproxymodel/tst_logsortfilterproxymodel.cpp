@@ -0,0 +1,140 @@
+#include <shv/visu/logview/logmodel.h>
+#include <shv/visu/logview/logsortfilterproxymodel.h>
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QtTest/QtTest>
+
+using namespace shv::visu::logview;
+using namespace shv::chainpack;
+using std::string;
+
+namespace {
+
+RpcValue make_log(const std::vector<string> &paths)
+{
+	RpcValue::List rows;
+	int64_t msec = 1600000000000;
+	for(const string &path : paths) {
+		RpcValue::List row;
+		row.push_back(RpcValue::DateTime::fromMSecsSinceEpoch(msec++));
+		row.push_back(path);
+		row.push_back(static_cast<int>(rows.size()));
+		rows.push_back(row);
+	}
+	return rows;
+}
+
+RpcValue make_domain_log(const std::vector<std::pair<string, string>> &path_domains)
+{
+	RpcValue::List rows;
+	int64_t msec = 1600000000000;
+	for(const auto &path_domain : path_domains) {
+		RpcValue::List row(LogModel::ColCnt);
+		row[LogModel::ColDateTime] = RpcValue::DateTime::fromMSecsSinceEpoch(msec++);
+		row[LogModel::ColPath] = path_domain.first;
+		row[LogModel::ColValue] = "val";
+		row[LogModel::ColDomain] = path_domain.second;
+		rows.push_back(row);
+	}
+	return rows;
+}
+
+QStringList proxy_paths(const LogSortFilterProxyModel &proxy)
+{
+	QStringList ret;
+	for (int i = 0; i < proxy.rowCount(); ++i)
+		ret << proxy.data(proxy.index(i, LogModel::ColPath)).toString();
+	return ret;
+}
+
+}
+
+class TestLogSortFilterProxyModel: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testSourceReset()
+	{
+		LogModel model;
+		LogSortFilterProxyModel proxy;
+		proxy.setShvPathColumn(LogModel::ColPath);
+		proxy.setValueColumn(LogModel::ColValue);
+		proxy.setSourceModel(&model);
+
+		model.setLog(make_log({"a", "b", "a", "b"}));
+		QSignalSpy finished_spy(&proxy, &LogSortFilterProxyModel::filteringFinished);
+		proxy.setChannelFilter(shv::visu::timeline::ChannelFilter(QSet<QString>{"a"}));
+		QTRY_COMPARE(finished_spy.count(), 1);
+		QCOMPARE(proxy_paths(proxy), QStringList({"a", "a"}));
+
+		// different paths order and row count, path ids and accepted rows of previous log must not be reused
+		model.setLog(make_log({"b", "c", "b", "a", "c"}));
+		QCOMPARE(proxy_paths(proxy), QStringList({"a"}));
+
+		proxy.setChannelFilter(shv::visu::timeline::ChannelFilter(QSet<QString>{"b", "c"}));
+		QTRY_COMPARE(finished_spy.count(), 2);
+		QCOMPARE(proxy_paths(proxy), QStringList({"b", "c", "b", "c"}));
+
+		model.setLog(make_log({"c"}));
+		QCOMPARE(proxy_paths(proxy), QStringList({"c"}));
+		model.setLog(RpcValue());
+		QCOMPARE(proxy.rowCount(), 0);
+	}
+	void testSourceModelChange()
+	{
+		LogModel model1;
+		LogModel model2;
+		model1.setLog(make_log({"a", "b"}));
+		model2.setLog(make_log({"c", "d", "e"}));
+		LogSortFilterProxyModel proxy;
+		proxy.setShvPathColumn(LogModel::ColPath);
+		proxy.setValueColumn(LogModel::ColValue);
+		proxy.setSourceModel(&model1);
+		QCOMPARE(proxy_paths(proxy), QStringList({"a", "b"}));
+
+		proxy.setSourceModel(&model2);
+		QCOMPARE(proxy_paths(proxy), QStringList({"c", "d", "e"}));
+		// old source does not affect proxy any more
+		model1.setLog(make_log({"x"}));
+		QCOMPARE(proxy_paths(proxy), QStringList({"c", "d", "e"}));
+		model2.setLog(make_log({"y"}));
+		QCOMPARE(proxy_paths(proxy), QStringList({"y"}));
+
+		proxy.setSourceModel(&model1);
+		QCOMPARE(proxy_paths(proxy), QStringList({"x"}));
+		model1.setLog(make_log({"x", "z"}));
+		QCOMPARE(proxy_paths(proxy), QStringList({"x", "z"}));
+	}
+	void testValueColumn()
+	{
+		LogModel model;
+		model.setLog(make_domain_log({{"a", "foo"}, {"b", "bar"}, {"c", "foobar"}}));
+		LogSortFilterProxyModel proxy;
+		proxy.setShvPathColumn(LogModel::ColPath);
+		proxy.setValueColumn(LogModel::ColDomain);
+		proxy.setSourceModel(&model);
+		QSignalSpy finished_spy(&proxy, &LogSortFilterProxyModel::filteringFinished);
+		proxy.setChannelFilter(shv::visu::timeline::ChannelFilter(QSet<QString>{"a", "b", "c"}));
+		QTRY_COMPARE(finished_spy.count(), 1);
+
+		shv::visu::timeline::FullTextFilter filter;
+		filter.setPattern("foo");
+		proxy.setFulltextFilter(filter);
+		QTRY_COMPARE(finished_spy.count(), 2);
+		QCOMPARE(proxy_paths(proxy), QStringList({"a", "c"}));
+
+		// value column text does not match
+		filter.setPattern("val");
+		proxy.setFulltextFilter(filter);
+		QTRY_COMPARE(finished_spy.count(), 3);
+		QCOMPARE(proxy.rowCount(), 0);
+
+		proxy.setValueColumn(LogModel::ColValue);
+		proxy.setFulltextFilter(filter);
+		QTRY_COMPARE(finished_spy.count(), 4);
+		QCOMPARE(proxy_paths(proxy), QStringList({"a", "b", "c"}));
+	}
+};
+
+QTEST_MAIN(TestLogSortFilterProxyModel)
+#include "tst_logsortfilterproxymodel.moc"
@@ -0,0 +1,145 @@
+#include <shv/visu/svgscene/saxhandler.h>
+#include <shv/visu/svgscene/sceneindex.h>
+#include <shv/visu/svgscene/svgsceneloader.h>
+#include <shv/visu/svgscene/visucontroller.h>
+
+#include <QGraphicsRectItem>
+#include <QGraphicsScene>
+#include <QXmlStreamReader>
+#include <QtTest/QtTest>
+
+using namespace shv::visu::svgscene;
+
+namespace {
+
+QString svg_doc(const QString &prefix)
+{
+	return QStringLiteral("<svg xmlns=\"http://www.w3.org/2000/svg\">"
+						  "<g id=\"%1-group\"><rect id=\"%1-rect\" x=\"0\" y=\"0\" width=\"10\" height=\"10\"/></g>"
+						  "</svg>").arg(prefix);
+}
+
+QString big_svg_doc(const QString &prefix, int rect_cnt)
+{
+	QString ret = QStringLiteral("<svg xmlns=\"http://www.w3.org/2000/svg\"><g id=\"%1-group\">").arg(prefix);
+	for (int i = 0; i < rect_cnt; ++i)
+		ret += QStringLiteral("<rect id=\"%1-rect-%2\" x=\"%2\" y=\"0\" width=\"1\" height=\"1\"/>").arg(prefix).arg(i);
+	return ret + QStringLiteral("</g></svg>");
+}
+
+void load_svg(SaxHandler &handler, const QString &doc)
+{
+	QXmlStreamReader xml(doc);
+	handler.load(&xml);
+}
+
+class FindController : public VisuController
+{
+public:
+	using VisuController::VisuController;
+
+	template<typename T>
+	static T findChild(const QGraphicsItem *parent_it, const QString &attr_name, const QString &attr_value)
+	{
+		return findChildGraphicsItem<T>(parent_it, attr_name, attr_value);
+	}
+};
+
+}
+
+class TestSvgScene: public QObject
+{
+	Q_OBJECT
+private slots:
+	void testSceneIndexReload()
+	{
+		QGraphicsScene scene;
+		SaxHandler handler(&scene);
+		load_svg(handler, svg_doc("a"));
+		SceneIndex *index = SceneIndex::fromScene(&scene);
+		QVERIFY(index != nullptr);
+		QVERIFY(index->itemById("a-rect") != nullptr);
+
+		scene.clear();
+		load_svg(handler, svg_doc("b"));
+		QCOMPARE(SceneIndex::fromScene(&scene), index);
+		QVERIFY(index->itemById("a-rect") == nullptr);
+		QVERIFY(index->items(Types::ATTR_ID, "a-group").isEmpty());
+		QGraphicsItem *rect = index->itemById("b-rect");
+		QVERIFY(rect != nullptr);
+		QVERIFY(scene.items().contains(rect));
+
+		// items of previous document stay indexed when scene is not cleared
+		load_svg(handler, svg_doc("c"));
+		QCOMPARE(index->itemById("b-rect"), rect);
+		QVERIFY(index->itemById("c-rect") != nullptr);
+		QCOMPARE(index->items(Types::ATTR_ID).count(), 4);
+	}
+	void testNotIndexedItemLookup()
+	{
+		QGraphicsScene scene;
+		SaxHandler handler(&scene);
+		load_svg(handler, svg_doc("a"));
+		const SceneIndex *index = SceneIndex::fromScene(&scene);
+		QGraphicsItem *group = index->itemById("a-group");
+		QVERIFY(group != nullptr);
+
+		auto *indexed_rect = dynamic_cast<QGraphicsRectItem*>(index->itemById("a-rect"));
+		QVERIFY(indexed_rect != nullptr);
+		QCOMPARE(FindController::findChild<QGraphicsRectItem*>(group, Types::ATTR_ID, "a-rect"), indexed_rect);
+
+		auto *extra_rect = new QGraphicsRectItem(group);
+		XmlAttributes attrs;
+		attrs[Types::ATTR_ID] = QStringLiteral("extra-rect");
+		extra_rect->setData(Types::DataKey::XmlAttributes, QVariant::fromValue(attrs));
+		QVERIFY(index->itemById("extra-rect") == nullptr);
+		QCOMPARE(FindController::findChild<QGraphicsRectItem*>(group, Types::ATTR_ID, "extra-rect"), extra_rect);
+		QVERIFY(FindController::findChild<QGraphicsRectItem*>(group, Types::ATTR_ID, "foo") == nullptr);
+	}
+	void testCancelAndReload()
+	{
+		QGraphicsScene scene;
+		SaxHandler handler(&scene);
+		SvgSceneLoader loader(&handler);
+		loader.setTimeSlice(0);
+		bool is_cancelled = false;
+		connect(&loader, &SvgSceneLoader::progress, &loader, [&loader, &is_cancelled](int applied_node_count, int node_count) {
+			if(!is_cancelled && applied_node_count < node_count) {
+				is_cancelled = true;
+				loader.cancel();
+			}
+		});
+		QSignalSpy finished_spy(&loader, &SvgSceneLoader::finished);
+
+		loader.loadData(big_svg_doc("a", 1000).toUtf8());
+		QTRY_VERIFY(is_cancelled);
+		QVERIFY(!loader.isLoading());
+		QCOMPARE(finished_spy.count(), 0);
+
+		// next document is not nested in items of cancelled one
+		loader.loadData(svg_doc("b").toUtf8());
+		QTRY_COMPARE(finished_spy.count(), 1);
+		const SceneIndex *index = SceneIndex::fromScene(&scene);
+		QGraphicsItem *group = index->itemById("b-group");
+		QVERIFY(group != nullptr);
+		QVERIFY(group->parentItem() != nullptr);
+		QVERIFY(group->parentItem()->parentItem() == nullptr);
+
+		// items of cancelled load might be deleted before reload
+		is_cancelled = false;
+		loader.loadData(big_svg_doc("c", 1000).toUtf8());
+		QTRY_VERIFY(is_cancelled);
+		scene.clear();
+		loader.loadData(svg_doc("d").toUtf8());
+		QTRY_COMPARE(finished_spy.count(), 2);
+		group = index->itemById("d-group");
+		QVERIFY(group != nullptr);
+		QVERIFY(group->parentItem() != nullptr);
+		QVERIFY(group->parentItem()->parentItem() == nullptr);
+		QVERIFY(index->itemById("c-group") == nullptr);
+		QCOMPARE(scene.items().count(), 3);
+	}
+};
+
+QTEST_MAIN(TestSvgScene)
+#include "tst_svgscene.moc"
@@ -0,0 +1,32 @@
+include ( $$PWD/../test.pri )
+
+QT += gui widgets
+
+INCLUDEPATH += \
+	$$PWD/../../3rdparty/necrolog/include \
+	$$PWD/../../libshvchainpack/include \
+	$$PWD/../../libshvcore/include \
+	$$PWD/../../libshvcoreqt/include \
+	$$PWD/../../libshviotqt/include \
+	$$PWD/../../libshvvisu/include \
+
+win32:LIB_DIR = $$DESTDIR
+else:LIB_DIR = $$SHV_PROJECT_TOP_BUILDDIR/lib
+
+message (INCLUDEPATH $$INCLUDEPATH)
+message (LIB_DIR $$LIB_DIR)
+message (DESTDIR $$DESTDIR)
+
+LIBS += \
+    -L$$LIB_DIR \
+    -lnecrolog \
+    -lshvcoreqt \
+    -lshvchainpack \
+    -lshvcore \
+    -lshviotqt \
+    -lshvvisu \
+
+unix {
+    LIBS += \
+        -Wl,-rpath,\'$${LIB_DIR}\'
+}
@@ -5,4 +5,9 @@ SUBDIRS += \
 	libshvchainpack \
 	libshvcore \
 	libshviotqt \
+	libshvbroker \
 
+qtHaveModule(gui) {
+SUBDIRS += \
+	libshvvisu \
+}